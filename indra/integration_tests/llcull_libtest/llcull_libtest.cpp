@@ -0,0 +1,402 @@
+/**
+ * @file llcull_libtest.cpp
+ * @brief Benchmark of the frustum culling of an octree shaped like a dense region
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "llcull_libtest.h"
+
+// Linden library includes
+#include "llcamera.h"
+#include "llrand.h"
+#include "llvector4a.h"
+
+// system libraries
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllcull_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -n, --objects <n>\n"
+"        Number of objects in the region. Default is 15000.\n"
+" -c, --capacity <n>\n"
+"        Objects a node holds before it is split, like OctreeMaxNodeCapacity.\n"
+"        Default is 128.\n"
+" -v, --views <n>\n"
+"        Number of random camera positions. Default is 200.\n"
+" -i, --iterations <n>\n"
+"        Number of times each view is culled by each method. Default is 20.\n"
+"\n";
+
+const F32 REGION_WIDTH = 256.f;
+const F32 GROUND_HEIGHT = 22.f;
+const F32 MIN_NODE_SIZE = 1.f;
+
+struct CullObject
+{
+	LLVector4a mCenter;
+	LLVector4a mRadius;
+};
+
+// Node of the synthetic octree, bounds as center and radius like
+// LLViewerOctreeGroup::mBounds
+struct CullNode
+{
+	LLVector4a mBounds[2];
+	U32 mChild[8];
+	U32 mChildCount;
+	U32 mObjects;
+};
+
+struct CullStats
+{
+	CullStats() : mTests(0), mNodes(0), mObjects(0), mTime(0.0) {}
+	U64 mTests;
+	U64 mNodes;
+	U64 mObjects;
+	F64 mTime;
+};
+
+// Builds clustered like a busy region: a few dense build sites, scattered
+// objects on the ground and some skyboxes
+void make_region(U32 count, std::vector<CullObject>& objects)
+{
+	const U32 NUM_SITES = 40;
+	LLVector4a sites[NUM_SITES];
+	F32 site_radius[NUM_SITES];
+	for (U32 i = 0; i < NUM_SITES; ++i)
+	{
+		sites[i].set(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), GROUND_HEIGHT);
+		site_radius[i] = 5.f + ll_frand(30.f);
+	}
+
+	objects.resize(count);
+	for (U32 i = 0; i < count; ++i)
+	{
+		CullObject& object = objects[i];
+		F32 kind = ll_frand();
+		F32 size;
+		if (kind < 0.8f)
+		{	// build site, mostly small parts stacked a few floors high
+			U32 site = ll_rand(NUM_SITES);
+			F32 angle = ll_frand(F_TWO_PI);
+			F32 dist = ll_frand(site_radius[site]);
+			object.mCenter.set(sites[site][0] + dist * cosf(angle),
+							   sites[site][1] + dist * sinf(angle),
+							   GROUND_HEIGHT + ll_frand(30.f));
+			size = 0.05f + ll_frand(1.f) * ll_frand(4.f);
+		}
+		else if (kind < 0.98f)
+		{	// scattered on the ground
+			object.mCenter.set(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), GROUND_HEIGHT + ll_frand(4.f));
+			size = 0.1f + ll_frand(10.f) * ll_frand(1.f);
+		}
+		else
+		{	// skyboxes
+			object.mCenter.set(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), 500.f + ll_frand(2500.f));
+			size = 1.f + ll_frand(20.f);
+		}
+		object.mRadius.set(size * (0.5f + ll_frand()), size * (0.5f + ll_frand()), size * (0.5f + ll_frand()));
+	}
+}
+
+// Splits a cube into octants until nodes hold capacity objects or less.
+// Objects bigger than the octants stay in the node, as in LLOctreeNode.
+U32 build_node(const std::vector<CullObject>& objects, std::vector<U32>& indices,
+			   const LLVector4a& center, F32 half_size, U32 capacity, std::vector<CullNode>& nodes)
+{
+	U32 index = nodes.size();
+	nodes.push_back(CullNode());
+	nodes[index].mChildCount = 0;
+
+	std::vector<U32> octants[8];
+	std::vector<U32> kept;
+	if (indices.size() > capacity && half_size > MIN_NODE_SIZE)
+	{
+		for (U32 i = 0; i < indices.size(); ++i)
+		{
+			const CullObject& object = objects[indices[i]];
+			if (object.mRadius[0] > half_size * 0.5f
+				|| object.mRadius[1] > half_size * 0.5f
+				|| object.mRadius[2] > half_size * 0.5f)
+			{
+				kept.push_back(indices[i]);
+				continue;
+			}
+			U32 octant = (object.mCenter[0] > center[0] ? 1 : 0)
+				| (object.mCenter[1] > center[1] ? 2 : 0)
+				| (object.mCenter[2] > center[2] ? 4 : 0);
+			octants[octant].push_back(indices[i]);
+		}
+	}
+	else
+	{
+		kept.swap(indices);
+	}
+
+	LLVector4a min(F32_MAX, F32_MAX, F32_MAX);
+	LLVector4a max(-F32_MAX, -F32_MAX, -F32_MAX);
+	for (U32 i = 0; i < kept.size(); ++i)
+	{
+		const CullObject& object = objects[kept[i]];
+		LLVector4a lo, hi;
+		lo.setSub(object.mCenter, object.mRadius);
+		hi.setAdd(object.mCenter, object.mRadius);
+		min.setMin(min, lo);
+		max.setMax(max, hi);
+	}
+
+	for (U32 i = 0; i < 8; ++i)
+	{
+		if (octants[i].empty())
+		{
+			continue;
+		}
+		F32 quarter = half_size * 0.5f;
+		LLVector4a child_center(center[0] + ((i & 1) ? quarter : -quarter),
+								center[1] + ((i & 2) ? quarter : -quarter),
+								center[2] + ((i & 4) ? quarter : -quarter));
+		U32 child = build_node(objects, octants[i], child_center, quarter, capacity, nodes);
+		nodes[index].mChild[nodes[index].mChildCount++] = child;
+
+		LLVector4a lo, hi;
+		lo.setSub(nodes[child].mBounds[0], nodes[child].mBounds[1]);
+		hi.setAdd(nodes[child].mBounds[0], nodes[child].mBounds[1]);
+		min.setMin(min, lo);
+		max.setMax(max, hi);
+	}
+
+	CullNode& node = nodes[index];
+	node.mObjects = kept.size();
+	node.mBounds[0].setAdd(min, max);
+	node.mBounds[0].mul(0.5f);
+	node.mBounds[1].setSub(max, min);
+	node.mBounds[1].mul(0.5f);
+	return index;
+}
+
+// Avatar eye height camera looking around, planes set from the frustum corners
+// the way LLViewerCamera::updateFrustumPlanes() does
+void setup_camera(LLCamera& camera)
+{
+	LLVector3 origin(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), GROUND_HEIGHT + 2.f + ll_frand(20.f));
+	F32 yaw = ll_frand(F_TWO_PI);
+	F32 pitch = ll_frand(0.6f) - 0.4f;
+	LLVector3 at(cosf(yaw) * cosf(pitch), sinf(yaw) * cosf(pitch), sinf(pitch));
+	camera.lookAt(origin, origin + at);
+
+	LLVector3 frust[8];
+	F32 dist[2] = { camera.getNear(), camera.getFar() };
+	for (U32 i = 0; i < 2; ++i)
+	{
+		F32 height = dist[i] * tanf(camera.getView() * 0.5f);
+		F32 width = height * camera.getAspect();
+		LLVector3 center = origin + camera.getAtAxis() * dist[i];
+		LLVector3 left = camera.getLeftAxis() * width;
+		LLVector3 up = camera.getUpAxis() * height;
+		frust[i * 4 + 0] = center + left - up;
+		frust[i * 4 + 1] = center - left - up;
+		frust[i * 4 + 2] = center - left + up;
+		frust[i * 4 + 3] = center + left + up;
+	}
+	camera.calcAgentFrustumPlanes(frust);
+}
+
+// One node at a time, the way LLViewerOctreeCull checked each group
+void cull_single(LLCamera& camera, const std::vector<CullNode>& nodes, U32 index, S32 res, CullStats& stats)
+{
+	const CullNode& node = nodes[index];
+	if (res != 2)
+	{
+		res = camera.AABBInFrustumNoFarClip(node.mBounds[0], node.mBounds[1]);
+		stats.mTests++;
+		if (!res)
+		{
+			return;
+		}
+	}
+
+	stats.mNodes++;
+	stats.mObjects += node.mObjects;
+	for (U32 i = 0; i < node.mChildCount; ++i)
+	{
+		cull_single(camera, nodes, node.mChild[i], res, stats);
+	}
+}
+
+// Children of a partly visible node checked together, the way
+// LLViewerOctreeCull::traverseChildren() does
+void cull_batched(const LLCamera::BatchPlanes& planes, const std::vector<CullNode>& nodes, U32 index, S32 res, CullStats& stats)
+{
+	const CullNode& node = nodes[index];
+	stats.mNodes++;
+	stats.mObjects += node.mObjects;
+
+	S32 results[8];
+	if (res != 2)
+	{
+		const LLVector4a* bounds[8];
+		for (U32 i = 0; i < node.mChildCount; ++i)
+		{
+			bounds[i] = nodes[node.mChild[i]].mBounds;
+		}
+		LLCamera::AABBInFrustumBatch(planes, bounds, node.mChildCount, results);
+		stats.mTests += node.mChildCount;
+	}
+
+	for (U32 i = 0; i < node.mChildCount; ++i)
+	{
+		S32 child_res = (res == 2) ? 2 : results[i];
+		if (child_res)
+		{
+			cull_batched(planes, nodes, node.mChild[i], child_res, stats);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	U32 num_objects = 15000;
+	U32 capacity = 128;
+	U32 num_views = 200;
+	U32 iterations = 20;
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--objects") || !strcmp(argv[arg], "-n")) && arg < argc-1)
+		{
+			num_objects = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--capacity") || !strcmp(argv[arg], "-c")) && arg < argc-1)
+		{
+			capacity = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--views") || !strcmp(argv[arg], "-v")) && arg < argc-1)
+		{
+			num_views = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-i")) && arg < argc-1)
+		{
+			iterations = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+	}
+
+	std::vector<CullObject> objects;
+	make_region(num_objects, objects);
+
+	// The region octree is a cube big enough for skyboxes
+	std::vector<U32> indices(objects.size());
+	for (U32 i = 0; i < indices.size(); ++i)
+	{
+		indices[i] = i;
+	}
+	std::vector<CullNode> nodes;
+	LLVector4a center(REGION_WIDTH * 0.5f, REGION_WIDTH * 0.5f, 2048.f);
+	build_node(objects, indices, center, 2048.f, capacity, nodes);
+
+	U32 leaves = 0;
+	for (U32 i = 0; i < nodes.size(); ++i)
+	{
+		if (!nodes[i].mChildCount)
+		{
+			leaves++;
+		}
+	}
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << objects.size() << " objects in " << nodes.size() << " nodes (" << leaves << " leaves)" << std::endl;
+
+	CullStats single_total;
+	CullStats batched_total;
+	U32 mismatches = 0;
+	for (U32 view = 0; view < num_views; ++view)
+	{
+		LLCamera camera;
+		setup_camera(camera);
+
+		CullStats single;
+		LLTimer timer;
+		for (U32 i = 0; i < iterations; ++i)
+		{
+			single = CullStats();
+			cull_single(camera, nodes, 0, 0, single);
+		}
+		single_total.mTime += timer.getElapsedTimeF64();
+
+		CullStats batched;
+		timer.reset();
+		for (U32 i = 0; i < iterations; ++i)
+		{
+			batched = CullStats();
+			LLCamera::BatchPlanes planes;
+			camera.getBatchPlanes(planes, NULL, false);
+			S32 res = camera.AABBInFrustumNoFarClip(nodes[0].mBounds[0], nodes[0].mBounds[1]);
+			batched.mTests++;
+			if (res)
+			{
+				cull_batched(planes, nodes, 0, res, batched);
+			}
+		}
+		batched_total.mTime += timer.getElapsedTimeF64();
+
+		if (single.mNodes != batched.mNodes || single.mObjects != batched.mObjects)
+		{
+			mismatches++;
+		}
+		single_total.mTests += single.mTests;
+		single_total.mNodes += single.mNodes;
+		single_total.mObjects += single.mObjects;
+		batched_total.mTests += batched.mTests;
+	}
+
+	U32 runs = num_views * iterations;
+	std::cout << "Culled " << num_views << " views x " << iterations << " iterations, "
+		<< single_total.mNodes / num_views << " nodes and " << single_total.mObjects / num_views
+		<< " objects visible per view" << std::endl;
+	std::cout << "Single : " << single_total.mTime * 1e6 / runs << " us per cull, "
+		<< single_total.mTests / num_views << " box tests" << std::endl;
+	std::cout << "Batched : " << batched_total.mTime * 1e6 / runs << " us per cull, "
+		<< batched_total.mTests / num_views << " box tests, mismatching views : " << mismatches << std::endl;
+	if (batched_total.mTime > 0.0)
+	{
+		std::cout << "Speedup : " << single_total.mTime / batched_total.mTime << "x" << std::endl;
+	}
+
+	return 0;
+}
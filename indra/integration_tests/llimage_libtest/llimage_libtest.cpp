@@ -38,6 +38,7 @@
 #include "llimagebmp.h"
 #include "llimagetga.h"
 #include "llimagej2c.h"
+#include "llimageworker.h"
 #include "lldir.h"
 #include "lldiriterator.h"
 #include "v4coloru.h"
@@ -97,6 +98,15 @@ static const char USAGE[] = "\n"
 "        Results in <metric>_report.csv\n"
 " -s, --image-stats\n"
 "        Output stats for each input and output image.\n"
+" -aux, --aux-pass\n"
+"        Time the aux channel pass on each j2c input, reusing the codestream decoded by the\n"
+"        color pass and decoding it from scratch.\n"
+"        Only valid for j2c images. Output files are ignored.\n"
+" -bench, --decode_benchmark\n"
+"        Benchmark j2c decoding at 1, 4 and 8 threads: per image latency with the image split\n"
+"        across threads when it has several tiles, then aggregate throughput with all the input\n"
+"        images decoded concurrently by the image decode thread pool.\n"
+"        Only valid for j2c images. Output files are ignored.\n"
 "\n";
 
 // true when all image loading is done. Used by metric logging thread to know when to stop the thread.
@@ -192,6 +202,115 @@ LLPointer<LLImageRaw> load_image(const std::string &src_filename, int discard_le
 	return raw_image;
 }
 
+// Time the aux channel pass over a j2c image with and without the codestream kept from the color pass
+void benchmark_aux_pass(const std::string &src_filename)
+{
+	LLPointer<LLImageJ2C> image = new LLImageJ2C;
+	if (!image->load(src_filename))
+	{
+		std::cout << "Error: Image " << src_filename << " could not be loaded" << std::endl;
+		return;
+	}
+	if (image->getComponents() < 2)
+	{
+		std::cout << "Aux pass for : " << src_filename << " : single channel, skipped" << std::endl;
+		return;
+	}
+
+	LLPointer<LLImageRaw> raw_image = new LLImageRaw;
+	LLPointer<LLImageRaw> channel_image = new LLImageRaw;
+	image->decode(raw_image, 0.0f);
+	LLTimer timer;
+	image->decodeChannels(channel_image, 0.0f, image->getComponents() - 1, 1);
+	F64 kept_time = timer.getElapsedTimeF64();
+	image->releaseAuxPassState();
+	timer.reset();
+	image->decodeChannels(channel_image, 0.0f, image->getComponents() - 1, 1);
+	F64 cold_time = timer.getElapsedTimeF64();
+	image->releaseAuxPassState();
+	std::cout << "Aux pass for : " << src_filename << " : " << kept_time * 1000.0 << " ms reusing the color pass, " << cold_time * 1000.0 << " ms from scratch" << std::endl;
+}
+
+// Counts completed decodes for the throughput benchmark
+class BenchmarkResponder : public LLImageDecodeThread::Responder
+{
+public:
+	BenchmarkResponder(LLAtomicS32* completed) : mCompleted(completed) {}
+	virtual void completed(bool success, LLImageRaw* raw, LLImageRaw* aux)
+	{
+		(*mCompleted)++;
+	}
+private:
+	LLAtomicS32* mCompleted;
+};
+
+// Report per image decode latency and aggregate decode throughput for several thread counts
+void benchmark_decode(const std::list<std::string> &input_filenames)
+{
+	// Keep the codestreams in memory so that only decoding is measured
+	std::vector<LLPointer<LLImageJ2C> > images;
+	std::vector<std::string> names;
+	F64 total_pixels = 0.0;
+	for (std::list<std::string>::const_iterator in_file = input_filenames.begin(); in_file != input_filenames.end(); ++in_file)
+	{
+		LLPointer<LLImageJ2C> image = new LLImageJ2C;
+		if (create_image(*in_file)->getCodec() == IMG_CODEC_J2C && image->load(*in_file))
+		{
+			images.push_back(image);
+			names.push_back(*in_file);
+			total_pixels += image->getWidth() * image->getHeight();
+		}
+	}
+	if (images.empty())
+	{
+		std::cout << "No j2c input, nothing to benchmark" << std::endl;
+		return;
+	}
+
+	const S32 thread_counts[] = { 1, 4, 8 };
+	for (S32 i = 0; i < LL_ARRAY_SIZE(thread_counts); i++)
+	{
+		S32 threads = thread_counts[i];
+		std::cout << "Decode benchmark with " << threads << " thread(s)" << std::endl;
+
+		// Latency: one image at a time
+		LLImageJ2C::setParallelDecode(threads);
+		F64 total_latency = 0.0;
+		for (size_t n = 0; n < images.size(); n++)
+		{
+			LLPointer<LLImageRaw> raw_image = new LLImageRaw;
+			images[n]->updateData();
+			LLTimer timer;
+			images[n]->decode(raw_image, 0.0f);
+			F64 elapsed = timer.getElapsedTimeF64();
+			images[n]->releaseAuxPassState();
+			total_latency += elapsed;
+			std::cout << "    " << names[n] << " : " << elapsed * 1000.0 << " ms" << std::endl;
+		}
+		std::cout << "    mean latency : " << total_latency * 1000.0 / images.size() << " ms" << std::endl;
+
+		// Throughput: all images at once through the decode thread pool
+		LLImageJ2C::setParallelDecode(1);
+		LLImageDecodeThread* decode_thread = new LLImageDecodeThread(true, threads);
+		LLAtomicS32 completed(0);
+		LLTimer timer;
+		for (size_t n = 0; n < images.size(); n++)
+		{
+			decode_thread->decodeImage(images[n], LLQueuedThread::PRIORITY_NORMAL, -1, FALSE, new BenchmarkResponder(&completed));
+		}
+		while (completed.CurrentValue() < (S32)images.size())
+		{
+			decode_thread->update(1);
+			ms_sleep(1);
+		}
+		F64 elapsed = timer.getElapsedTimeF64();
+		delete decode_thread;
+		std::cout << "    aggregate : " << images.size() << " images in " << elapsed * 1000.0 << " ms, "
+				  << images.size() / elapsed << " images/s, " << total_pixels / elapsed / 1000000.0 << " Mpixels/s" << std::endl;
+	}
+	LLImageJ2C::setParallelDecode(1);
+}
+
 // Save a raw image instance into a file
 bool save_image(const std::string &dest_filename, LLPointer<LLImageRaw> raw_image, int blocks_size, int precincts_size, int levels, bool reversible, bool output_stats)
 {
@@ -356,6 +475,8 @@ int main(int argc, char** argv)
 	int blocks_size = -1;
 	int levels = 0;
 	bool reversible = false;
+	bool aux_pass = false;
+	bool decode_benchmark = false;
     std::string filter_name = "";
 
 	// Init whatever is necessary
@@ -557,6 +678,14 @@ int main(int argc, char** argv)
 		{
 			image_stats = true;
 		}
+		else if (!strcmp(argv[arg], "--aux-pass") || !strcmp(argv[arg], "-aux"))
+		{
+			aux_pass = true;
+		}
+		else if (!strcmp(argv[arg], "--decode_benchmark") || !strcmp(argv[arg], "-bench"))
+		{
+			decode_benchmark = true;
+		}
 	}
 		
 	// Check arguments consistency. Exit with proper message if inconsistent.
@@ -572,6 +701,26 @@ int main(int argc, char** argv)
 	}
 	
 
+	if (decode_benchmark)
+	{
+		benchmark_decode(input_filenames);
+		SUBSYSTEM_CLEANUP(LLImage);
+		return 0;
+	}
+
+	if (aux_pass)
+	{
+		for (std::list<std::string>::iterator in_file = input_filenames.begin(); in_file != input_filenames.end(); ++in_file)
+		{
+			if (create_image(*in_file)->getCodec() == IMG_CODEC_J2C)
+			{
+				benchmark_aux_pass(*in_file);
+			}
+		}
+		SUBSYSTEM_CLEANUP(LLImage);
+		return 0;
+	}
+
 	// Create the logging thread if required
 	if (LLFastTimer::sMetricLog)
 	{
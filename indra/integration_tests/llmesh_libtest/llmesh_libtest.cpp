@@ -0,0 +1,929 @@
+/** 
+ * @file llmesh_libtest.cpp
+ * @brief Benchmark of the mesh LoD block decoding, ray casting and vertex cache
+ * optimization in llmath
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+#include "llmesh_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "llrand.h"
+#include "llvertexcache.h"
+#include "llvolume.h"
+#include "llvolumebvh.h"
+#include "llvolumeoctree.h"
+#include "llsdserialize.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+
+// system libraries
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+// doc string provided when invoking the program with --help 
+static const char USAGE[] = "\n"
+"usage:\tllmesh_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -i, --input <file1 .. file2>\n"
+"        List of mesh assets (as stored in the cache) or .slm model files to decode.\n"
+"        Patterns with wild cards can be used.\n"
+" -n, --iterations <n>\n"
+"        Number of times each LoD block is decoded by each method (legacy LLSD, direct\n"
+"        and from the decoded mesh cache layout). Default is 10.\n"
+" -r, --rays <n>\n"
+"        Cast n random segments at a procedural high-poly sphere and at each face of the\n"
+"        high LoD of the input meshes, through the face octree then through the face BVH,\n"
+"        and compare the hits. Input files are optional in this mode.\n"
+" -c, --cache-optimize\n"
+"        Shuffle the triangles of a procedural high-poly sphere and of each face of the\n"
+"        input meshes, then reorder them for the vertex cache with the legacy optimizer\n"
+"        and with ll_optimize_vertex_cache(), best time of n iterations, and print the\n"
+"        average cache miss ratio (ACMR) of each order. Input files are optional in this\n"
+"        mode.\n"
+"\n";
+
+static const char* LOD_NAMES[] =
+{
+	"lowest_lod",
+	"low_lod",
+	"medium_lod",
+	"high_lod"
+};
+
+// One compressed LoD block extracted from a mesh asset
+struct MeshBlock
+{
+	std::string mName;
+	std::string mData;
+	std::vector<U8> mDecoded;	// Faces as stored in the viewer's decoded mesh cache
+};
+
+struct DecodeStats
+{
+	DecodeStats() : mBlocks(0), mFailures(0), mTime(0.0) {}
+	U32 mBlocks;
+	U32 mFailures;
+	F64 mTime;
+};
+
+struct RayStats
+{
+	RayStats() : mFaces(0), mTriangles(0), mRays(0), mHits(0), mMismatches(0),
+				 mOctreeBuild(0.0), mBVHBuild(0.0), mOctreeTime(0.0), mBVHTime(0.0) {}
+	U32 mFaces;
+	U32 mTriangles;
+	U32 mRays;
+	U32 mHits;
+	U32 mMismatches;
+	F64 mOctreeBuild;
+	F64 mBVHBuild;
+	F64 mOctreeTime;
+	F64 mBVHTime;
+};
+
+struct CacheStats
+{
+	CacheStats() : mFaces(0), mTriangles(0), mShuffledMisses(0.0), mLegacyMisses(0.0), mMisses(0.0),
+				   mLegacyTime(0.0), mTime(0.0) {}
+	U32 mFaces;
+	U32 mTriangles;
+	F64 mShuffledMisses;	// Vertices transformed, ACMR times the triangle count
+	F64 mLegacyMisses;
+	F64 mMisses;
+	F64 mLegacyTime;
+	F64 mTime;
+};
+
+void store_input_file(std::list<std::string> &input_filenames, const std::string &path)
+{
+	std::string dir = gDirUtilp->getDirName(path);
+	std::string name = gDirUtilp->getBaseFileName(path);
+
+	if ((name.find('*') != -1) || ((name.find('?') != -1)))
+	{
+		// If file name is a pattern, iterate to get each file name and store
+		std::string next_name;
+		LLDirIterator iter(dir, name);
+		while (iter.next(next_name))
+		{
+			input_filenames.push_back(gDirUtilp->add(dir, next_name));
+		}
+	}
+	else if (gDirUtilp->fileExists(path))
+	{
+		input_filenames.push_back(path);
+	}
+	else
+	{
+		std::cout << "store_input_file : the file " << path << " could not be found" << std::endl;
+	}
+}
+
+// Split a mesh asset into its compressed LoD blocks, the same way LLMeshRepoThread does it:
+// block offsets in the header are relative to the end of the header.
+bool extract_lod_blocks(const std::string& asset, const std::string& label, std::vector<MeshBlock>& blocks)
+{
+	std::string res_str = asset;
+	std::string deprecated_header("<? LLSD/Binary ?>");
+	if (res_str.substr(0, deprecated_header.size()) == deprecated_header)
+	{
+		res_str = res_str.substr(deprecated_header.size() + 1);
+	}
+
+	LLSD header;
+	std::istringstream stream(res_str);
+	if (!LLSDSerialize::fromBinary(header, stream, res_str.size()) || !header.isMap())
+	{
+		return false;
+	}
+	size_t header_size = (size_t)stream.tellg();
+
+	for (U32 i = 0; i < LL_ARRAY_SIZE(LOD_NAMES); ++i)
+	{
+		const LLSD& lod = header[LOD_NAMES[i]];
+		if (!lod.has("offset") || !lod.has("size"))
+		{
+			continue;
+		}
+		size_t offset = header_size + lod["offset"].asInteger();
+		size_t size = lod["size"].asInteger();
+		if (size == 0 || offset + size > res_str.size())
+		{
+			continue;
+		}
+		MeshBlock block;
+		block.mName = label + ":" + LOD_NAMES[i];
+		block.mData = res_str.substr(offset, size);
+		blocks.push_back(block);
+	}
+	return true;
+}
+
+// Load a file as either a raw mesh asset or an .slm model file holding several mesh assets
+bool load_blocks(const std::string& filename, std::vector<MeshBlock>& blocks)
+{
+	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	std::string exten = gDirUtilp->getExtension(filename);
+	if (exten == "slm")
+	{
+		LLSD data;
+		std::istringstream stream(content);
+		if (LLSDSerialize::fromBinary(data, stream, content.size()) <= 0 || !data["mesh"].isArray())
+		{
+			return false;
+		}
+		for (S32 i = 0; i < data["mesh"].size(); ++i)
+		{
+			extract_lod_blocks(data["mesh"][i].asString(), llformat("%s[%d]", filename.c_str(), i), blocks);
+		}
+		return true;
+	}
+	return extract_lod_blocks(content, filename, blocks);
+}
+
+LLPointer<LLVolume> create_volume()
+{
+	LLVolumeParams volume_params;
+	volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+	return new LLVolume(volume_params, 0);
+}
+
+// Reference path: inflate to a full LLSD tree, then walk the tree
+bool decode_legacy(const MeshBlock& block)
+{
+	LLSD mdl;
+	std::istringstream stream(block.mData);
+	if (LLUZipHelper::unzip_llsd(mdl, stream, block.mData.size()) != LLUZipHelper::ZR_OK)
+	{
+		return false;
+	}
+	LLPointer<LLVolume> volume = create_volume();
+	return volume->unpackVolumeFacesLLSD(mdl);
+}
+
+// Direct path: inflate and unpack the face arrays straight from the inflated buffer
+bool decode_direct(const MeshBlock& block)
+{
+	std::istringstream stream(block.mData);
+	LLPointer<LLVolume> volume = create_volume();
+	return volume->unpackVolumeFaces(stream, block.mData.size());
+}
+
+// Cached path: copy the faces out of the decoded mesh cache layout
+bool decode_cached(const MeshBlock& block)
+{
+	LLPointer<LLVolume> volume = create_volume();
+	return !block.mDecoded.empty() && volume->unpackDecodedFaces(&block.mDecoded[0], block.mDecoded.size());
+}
+
+// Build the decoded mesh cache entry for a block, checking it reads back to the same faces
+bool pack_decoded(MeshBlock& block)
+{
+	std::istringstream stream(block.mData);
+	LLPointer<LLVolume> volume = create_volume();
+	if (!volume->unpackVolumeFaces(stream, block.mData.size()) || !volume->packDecodedFaces(block.mDecoded))
+	{
+		return false;
+	}
+
+	LLPointer<LLVolume> cached = create_volume();
+	if (!cached->unpackDecodedFaces(&block.mDecoded[0], block.mDecoded.size())
+		|| cached->getNumVolumeFaces() != volume->getNumVolumeFaces())
+	{
+		return false;
+	}
+	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+	{
+		const LLVolumeFace& face = volume->getVolumeFace(i);
+		const LLVolumeFace& cached_face = cached->getVolumeFace(i);
+		if (face.mNumVertices != cached_face.mNumVertices
+			|| face.mNumIndices != cached_face.mNumIndices
+			|| memcmp(face.mPositions, cached_face.mPositions, face.mNumVertices * sizeof(LLVector4a))
+			|| memcmp(face.mIndices, cached_face.mIndices, face.mNumIndices * sizeof(U16)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Bumpy sphere with as many vertices as a face can index
+void make_sphere_face(LLVolumeFace& face)
+{
+	const S32 RINGS = 180;
+	const S32 SEGMENTS = 360;
+
+	face.resizeVertices((RINGS + 1) * (SEGMENTS + 1));
+	face.resizeIndices(RINGS * SEGMENTS * 6);
+	for (S32 i = 0; i <= RINGS; ++i)
+	{
+		F32 theta = F_PI * i / RINGS;
+		for (S32 j = 0; j <= SEGMENTS; ++j)
+		{
+			F32 phi = F_TWO_PI * j / SEGMENTS;
+			F32 radius = 0.45f + 0.04f * sinf(7.f * theta) * cosf(5.f * phi);
+			S32 v = i * (SEGMENTS + 1) + j;
+			face.mPositions[v].set(radius * sinf(theta) * cosf(phi),
+								   radius * sinf(theta) * sinf(phi),
+								   radius * cosf(theta));
+			face.mNormals[v] = face.mPositions[v];
+			face.mNormals[v].normalize3fast();
+			face.mTexCoords[v].set((F32)j / SEGMENTS, (F32)i / RINGS);
+		}
+	}
+
+	U16* idx = face.mIndices;
+	for (S32 i = 0; i < RINGS; ++i)
+	{
+		for (S32 j = 0; j < SEGMENTS; ++j)
+		{
+			U16 v = i * (SEGMENTS + 1) + j;
+			U16 below = v + SEGMENTS + 1;
+			*idx++ = v;
+			*idx++ = below;
+			*idx++ = v + 1;
+			*idx++ = v + 1;
+			*idx++ = below;
+			*idx++ = below + 1;
+		}
+	}
+
+	face.mExtents[0].splat(-0.5f);
+	face.mExtents[1].splat(0.5f);
+}
+
+// Cast the same random segments at a face through its octree and its BVH, the
+// way LLVolume::lineSegmentIntersect() did before and does now
+void bench_rays(const std::string& name, LLVolumeFace& face, S32 rays, RayStats& total)
+{
+	if (face.mNumIndices < 3)
+	{
+		return;
+	}
+
+	LLVector4a center;
+	center.setAdd(face.mExtents[0], face.mExtents[1]);
+	center.mul(0.5f);
+	LLVector4a size;
+	size.setSub(face.mExtents[1], face.mExtents[0]);
+	F32 radius = llmax(size.getLength3().getF32(), F_APPROXIMATELY_ZERO);
+
+	// Segments from outside the face bounds through a point inside them
+	std::vector<LLVector4a> starts(rays);
+	std::vector<LLVector4a> dirs(rays);
+	for (S32 i = 0; i < rays; ++i)
+	{
+		LLVector4a out(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+		out.normalize3fast();
+		starts[i].setMul(out, radius);
+		starts[i].add(center);
+
+		LLVector4a target(ll_frand() - 0.5f, ll_frand() - 0.5f, ll_frand() - 0.5f);
+		target.mul(size);
+		target.add(center);
+		dirs[i].setSub(target, starts[i]);
+		dirs[i].mul(2.f);
+	}
+
+	LLTimer timer;
+	face.createOctree();
+	F64 octree_build = timer.getElapsedTimeF64();
+
+	timer.reset();
+	face.createBVH();
+	F64 bvh_build = timer.getElapsedTimeF64();
+
+	std::vector<F32> octree_t(rays);
+	timer.reset();
+	for (S32 i = 0; i < rays; ++i)
+	{
+		F32 closest_t = 2.f;
+		LLOctreeTriangleRayIntersect intersect(starts[i], dirs[i], &face, &closest_t, NULL, NULL, NULL, NULL);
+		intersect.traverse(face.mOctree);
+		octree_t[i] = intersect.mHitFace ? closest_t : -1.f;
+	}
+	F64 octree_time = timer.getElapsedTimeF64();
+
+	std::vector<F32> bvh_t(rays);
+	timer.reset();
+	for (S32 i = 0; i < rays; ++i)
+	{
+		F32 closest_t = 2.f;
+		F32 a, b;
+		bvh_t[i] = (face.mBVH->intersect(starts[i], dirs[i], closest_t, a, b) >= 0) ? closest_t : -1.f;
+	}
+	F64 bvh_time = timer.getElapsedTimeF64();
+
+	U32 hits = 0;
+	U32 mismatches = 0;
+	for (S32 i = 0; i < rays; ++i)
+	{
+		if (bvh_t[i] >= 0.f)
+		{
+			hits++;
+		}
+		if ((octree_t[i] < 0.f) != (bvh_t[i] < 0.f) || fabsf(octree_t[i] - bvh_t[i]) > 1e-4f)
+		{
+			mismatches++;
+		}
+	}
+
+	std::cout << name << " : " << face.mNumIndices / 3 << " triangles, build octree "
+		<< octree_build * 1000.0 << " ms, BVH " << bvh_build * 1000.0 << " ms ("
+		<< face.mBVH->getBytes() / 1024 << " KB), " << hits << "/" << rays << " hits, octree "
+		<< octree_time * 1e6 / rays << " us/ray, BVH " << bvh_time * 1e6 / rays << " us/ray";
+	if (mismatches)
+	{
+		std::cout << " (" << mismatches << " mismatches)";
+	}
+	std::cout << std::endl;
+
+	total.mFaces++;
+	total.mTriangles += face.mNumIndices / 3;
+	total.mRays += rays;
+	total.mHits += hits;
+	total.mMismatches += mismatches;
+	total.mOctreeBuild += octree_build;
+	total.mBVHBuild += bvh_build;
+	total.mOctreeTime += octree_time;
+	total.mBVHTime += bvh_time;
+}
+
+// The optimizer LLVolumeFace::cacheOptimize() ran before ll_optimize_vertex_cache(),
+// with per vertex and per triangle objects and a rescan of every triangle when the
+// cache runs dry
+namespace legacy
+{
+	class LLVCacheTriangleData;
+
+	class LLVCacheVertexData
+	{
+	public:
+		S32 mIdx;
+		S32 mCacheTag;
+		F64 mScore;
+		U32 mActiveTriangles;
+		std::vector<LLVCacheTriangleData*> mTriangles;
+
+		LLVCacheVertexData()
+		{
+			mCacheTag = -1;
+			mScore = 0.0;
+			mActiveTriangles = 0;
+			mIdx = -1;
+		}
+	};
+
+	class LLVCacheTriangleData
+	{
+	public:
+		bool mActive;
+		F64 mScore;
+		LLVCacheVertexData* mVertex[3];
+
+		LLVCacheTriangleData()
+		{
+			mActive = true;
+			mScore = 0.0;
+			mVertex[0] = mVertex[1] = mVertex[2] = NULL;
+		}
+
+		void complete()
+		{
+			mActive = false;
+			for (S32 i = 0; i < 3; ++i)
+			{
+				if (mVertex[i])
+				{
+					mVertex[i]->mActiveTriangles--;
+				}
+			}
+		}
+
+		bool operator<(const LLVCacheTriangleData& rhs) const
+		{ //highest score first
+			return rhs.mScore < mScore;
+		}
+	};
+
+	const F64 FindVertexScore_CacheDecayPower = 1.5;
+	const F64 FindVertexScore_LastTriScore = 0.75;
+	const F64 FindVertexScore_ValenceBoostScale = 2.0;
+	const F64 FindVertexScore_ValenceBoostPower = 0.5;
+	const U32 MaxSizeVertexCache = 32;
+	const F64 FindVertexScore_Scaler = 1.0/(MaxSizeVertexCache-3);
+
+	F64 find_vertex_score(LLVCacheVertexData& data)
+	{
+		F64 score = 0.0;
+
+		S32 cache_idx = data.mCacheTag;
+		if (cache_idx >= 0)
+		{
+			if (cache_idx < 3)
+			{ //vertex was in the last triangle
+				score = FindVertexScore_LastTriScore;
+			}
+			else
+			{ //more points for being higher in the cache
+				score = 1.0-((cache_idx-3)*FindVertexScore_Scaler);
+				score = pow(score, FindVertexScore_CacheDecayPower);
+			}
+		}
+
+		//bonus points for having low valence
+		F64 valence_boost = pow((F64)data.mActiveTriangles, -FindVertexScore_ValenceBoostPower);
+		score += FindVertexScore_ValenceBoostScale * valence_boost;
+
+		return score;
+	}
+
+	class LLVCacheLRU
+	{
+	public:
+		LLVCacheVertexData* mCache[MaxSizeVertexCache+3];
+		LLVCacheTriangleData* mBestTriangle;
+
+		LLVCacheLRU()
+		{
+			for (U32 i = 0; i < MaxSizeVertexCache+3; ++i)
+			{
+				mCache[i] = NULL;
+			}
+			mBestTriangle = NULL;
+		}
+
+		void addVertex(LLVCacheVertexData* data)
+		{
+			S32 end = MaxSizeVertexCache+2;
+			if (data->mCacheTag != -1)
+			{ //just moving a vertex to the front of the cache
+				end = data->mCacheTag;
+			}
+			else if (mCache[end])
+			{ //adding a new vertex, vertex at end of cache falls off
+				mCache[end]->mCacheTag = -1;
+			}
+
+			for (S32 i = end; i > 0; --i)
+			{ //adjust cache pointers and tags
+				mCache[i] = mCache[i-1];
+				if (mCache[i])
+				{
+					mCache[i]->mCacheTag = i;
+				}
+			}
+
+			mCache[0] = data;
+			mCache[0]->mCacheTag = 0;
+		}
+
+		void addTriangle(LLVCacheTriangleData* data)
+		{
+			addVertex(data->mVertex[0]);
+			addVertex(data->mVertex[1]);
+			addVertex(data->mVertex[2]);
+		}
+
+		void updateScores()
+		{
+			for (U32 i = MaxSizeVertexCache; i < MaxSizeVertexCache+3; ++i)
+			{ //trailing 3 vertices aren't actually in the cache for scoring purposes
+				if (mCache[i])
+				{
+					mCache[i]->mCacheTag = -1;
+				}
+			}
+
+			for (U32 i = 0; i < MaxSizeVertexCache; ++i)
+			{ //update scores of vertices in cache
+				if (mCache[i])
+				{
+					mCache[i]->mScore = find_vertex_score(*mCache[i]);
+				}
+			}
+
+			mBestTriangle = NULL;
+			for (U32 i = 0; i < MaxSizeVertexCache+3; ++i)
+			{ //update triangle scores
+				LLVCacheVertexData* data = mCache[i];
+				if (!data)
+				{
+					continue;
+				}
+				for (std::vector<LLVCacheTriangleData*>::iterator iter = data->mTriangles.begin(); iter != data->mTriangles.end(); ++iter)
+				{
+					LLVCacheTriangleData* tri = *iter;
+					if (tri->mActive)
+					{
+						tri->mScore = tri->mVertex[0]->mScore + tri->mVertex[1]->mScore + tri->mVertex[2]->mScore;
+						if (!mBestTriangle || mBestTriangle->mScore < tri->mScore)
+						{
+							mBestTriangle = tri;
+						}
+					}
+				}
+			}
+
+			for (U32 i = MaxSizeVertexCache; i < MaxSizeVertexCache+3; ++i)
+			{ //knock trailing 3 vertices off the cache
+				mCache[i] = NULL;
+			}
+		}
+	};
+
+	void cache_optimize(U16* indices, U32 index_count, U32 vertex_count)
+	{
+		U32 triangle_count = index_count / 3;
+		std::vector<LLVCacheVertexData> vertex_data(vertex_count);
+		std::vector<LLVCacheTriangleData> triangle_data(triangle_count);
+		for (U32 i = 0; i < triangle_count * 3; i++)
+		{ //populate vertex data and triangle data arrays
+			U16 idx = indices[i];
+			U32 tri_idx = i/3;
+			vertex_data[idx].mTriangles.push_back(&(triangle_data[tri_idx]));
+			vertex_data[idx].mIdx = idx;
+			triangle_data[tri_idx].mVertex[i%3] = &(vertex_data[idx]);
+		}
+
+		for (U32 i = 0; i < vertex_count; i++)
+		{ //initialize score values
+			LLVCacheVertexData& data = vertex_data[i];
+			data.mScore = find_vertex_score(data);
+			data.mActiveTriangles = data.mTriangles.size();
+			for (U32 j = 0; j < data.mActiveTriangles; ++j)
+			{
+				data.mTriangles[j]->mScore += data.mScore;
+			}
+		}
+
+		//sort triangle data by score
+		std::sort(triangle_data.begin(), triangle_data.end());
+
+		LLVCacheLRU cache;
+		U16* out = indices;
+		for (U32 i = 0; i < triangle_count; ++i)
+		{
+			LLVCacheTriangleData* tri = NULL;
+			if (i)
+			{
+				cache.updateScores();
+				tri = cache.mBestTriangle;
+			}
+			for (U32 j = 0; !tri && j < triangle_data.size(); ++j)
+			{
+				if (triangle_data[j].mActive)
+				{
+					tri = &(triangle_data[j]);
+				}
+			}
+
+			cache.addTriangle(tri);
+			*out++ = tri->mVertex[0]->mIdx;
+			*out++ = tri->mVertex[1]->mIdx;
+			*out++ = tri->mVertex[2]->mIdx;
+			tri->complete();
+		}
+	}
+}
+
+// Put the triangles of a face in random order, keeping the winding of each
+void shuffle_triangles(LLVolumeFace& face)
+{
+	U32 count = face.mNumIndices / 3;
+	for (U32 i = count - 1; i > 0; --i)
+	{
+		U32 j = ll_rand(i + 1);
+		std::swap_ranges(face.mIndices + i * 3, face.mIndices + i * 3 + 3, face.mIndices + j * 3);
+	}
+}
+
+// Reorder the shuffled triangles of a face with both optimizers and compare speed and cache misses
+void bench_cache_optimize(const std::string& name, LLVolumeFace& face, S32 iterations, CacheStats& total)
+{
+	if (face.mNumIndices < 6)
+	{
+		return;
+	}
+
+	U32 index_count = face.mNumIndices - face.mNumIndices % 3;
+	U32 vertex_count = face.mNumVertices;
+	shuffle_triangles(face);
+	std::vector<U16> shuffled(face.mIndices, face.mIndices + index_count);
+	std::vector<U16> legacy_order;
+	std::vector<U16> order;
+
+	F64 legacy_time = 0.0;
+	F64 time = 0.0;
+	LLTimer timer;
+	for (S32 i = 0; i < iterations; ++i)
+	{
+		legacy_order = shuffled;
+		timer.reset();
+		legacy::cache_optimize(&legacy_order[0], index_count, vertex_count);
+		F64 elapsed = timer.getElapsedTimeF64();
+		legacy_time = i ? llmin(legacy_time, elapsed) : elapsed;
+
+		order = shuffled;
+		timer.reset();
+		ll_optimize_vertex_cache(&order[0], index_count, vertex_count);
+		elapsed = timer.getElapsedTimeF64();
+		time = i ? llmin(time, elapsed) : elapsed;
+	}
+
+	U32 triangles = index_count / 3;
+	F32 shuffled_acmr = ll_vertex_cache_acmr(&shuffled[0], index_count, vertex_count, LL_VERTEX_CACHE_SIZE);
+	F32 legacy_acmr = ll_vertex_cache_acmr(&legacy_order[0], index_count, vertex_count, LL_VERTEX_CACHE_SIZE);
+	F32 acmr = ll_vertex_cache_acmr(&order[0], index_count, vertex_count, LL_VERTEX_CACHE_SIZE);
+
+	std::cout << name << " : " << triangles << " triangles, ACMR shuffled " << shuffled_acmr
+		<< ", legacy " << legacy_acmr << " in " << legacy_time * 1000.0 << " ms, new " << acmr
+		<< " in " << time * 1000.0 << " ms" << std::endl;
+
+	total.mFaces++;
+	total.mTriangles += triangles;
+	total.mShuffledMisses += shuffled_acmr * triangles;
+	total.mLegacyMisses += legacy_acmr * triangles;
+	total.mMisses += acmr * triangles;
+	total.mLegacyTime += legacy_time;
+	total.mTime += time;
+}
+
+void run_decode(bool (*decode)(const MeshBlock&), const MeshBlock& block, S32 iterations, DecodeStats& stats)
+{
+	LLTimer timer;
+	bool success = true;
+	for (S32 i = 0; i < iterations; ++i)
+	{
+		success = decode(block) && success;
+	}
+	stats.mTime += timer.getElapsedTimeF64();
+	stats.mBlocks++;
+	if (!success)
+	{
+		stats.mFailures++;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::list<std::string> input_filenames;
+	S32 iterations = 10;
+	S32 rays = 0;
+	bool cache_optimize = false;
+
+	// Init whatever is necessary
+	ll_init_apr();
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--input") || !strcmp(argv[arg], "-i")) && arg < argc-1)
+		{
+			while (arg < argc-1 && argv[arg+1][0] != '-')
+			{
+				store_input_file(input_filenames, argv[arg+1]);
+				arg += 1;
+			}
+		}
+		else if ((!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n")) && arg < argc-1)
+		{
+			iterations = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--rays") || !strcmp(argv[arg], "-r")) && arg < argc-1)
+		{
+			rays = llmax(0, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if (!strcmp(argv[arg], "--cache-optimize") || !strcmp(argv[arg], "-c"))
+		{
+			cache_optimize = true;
+		}
+	}
+
+	if (input_filenames.empty() && !rays && !cache_optimize)
+	{
+		std::cout << "No valid input file, nothing to do -> exit" << std::endl;
+		return 0;
+	}
+
+	std::vector<MeshBlock> blocks;
+	for (std::list<std::string>::iterator in_file = input_filenames.begin(); in_file != input_filenames.end(); ++in_file)
+	{
+		if (!load_blocks(*in_file, blocks))
+		{
+			std::cout << "Error: " << *in_file << " is not a mesh asset" << std::endl;
+		}
+	}
+
+	DecodeStats legacy_total;
+	DecodeStats direct_total;
+	DecodeStats cached_total;
+	std::cout << std::fixed << std::setprecision(3);
+	for (std::vector<MeshBlock>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+	{
+		DecodeStats legacy;
+		DecodeStats direct;
+		DecodeStats cached;
+		run_decode(decode_legacy, *it, iterations, legacy);
+		run_decode(decode_direct, *it, iterations, direct);
+		if (!pack_decoded(*it))
+		{
+			it->mDecoded.clear();
+		}
+		run_decode(decode_cached, *it, iterations, cached);
+
+		std::cout << it->mName << " : " << it->mData.size() << " bytes, legacy "
+			<< legacy.mTime * 1000.0 / iterations << " ms, direct "
+			<< direct.mTime * 1000.0 / iterations << " ms, cached "
+			<< cached.mTime * 1000.0 / iterations << " ms (" << it->mDecoded.size() << " bytes)";
+		if (legacy.mFailures || direct.mFailures || cached.mFailures)
+		{
+			std::cout << " (decode failed: legacy " << legacy.mFailures << ", direct " << direct.mFailures
+				<< ", cached " << cached.mFailures << ")";
+		}
+		std::cout << std::endl;
+
+		legacy_total.mBlocks++;
+		legacy_total.mFailures += legacy.mFailures;
+		legacy_total.mTime += legacy.mTime;
+		direct_total.mBlocks++;
+		direct_total.mFailures += direct.mFailures;
+		direct_total.mTime += direct.mTime;
+		cached_total.mBlocks++;
+		cached_total.mFailures += cached.mFailures;
+		cached_total.mTime += cached.mTime;
+	}
+
+	if (!blocks.empty())
+	{
+		std::cout << "Decoded " << blocks.size() << " LoD blocks x " << iterations << " iterations" << std::endl;
+		std::cout << "Legacy total : " << legacy_total.mTime << " s, failures : " << legacy_total.mFailures << std::endl;
+		std::cout << "Direct total : " << direct_total.mTime << " s, failures : " << direct_total.mFailures << std::endl;
+		if (direct_total.mTime > 0.0)
+		{
+			std::cout << "Speedup : " << legacy_total.mTime / direct_total.mTime << "x" << std::endl;
+		}
+		std::cout << "Cached total : " << cached_total.mTime << " s, failures : " << cached_total.mFailures << std::endl;
+		if (cached_total.mTime > 0.0)
+		{
+			std::cout << "Cached speedup : " << direct_total.mTime / cached_total.mTime << "x" << std::endl;
+		}
+	}
+
+	if (rays)
+	{
+		RayStats ray_total;
+		{
+			LLVolumeFace face;
+			make_sphere_face(face);
+			bench_rays("sphere", face, rays, ray_total);
+		}
+		for (std::vector<MeshBlock>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+		{
+			if (it->mName.find(LOD_NAMES[LL_ARRAY_SIZE(LOD_NAMES) - 1]) == std::string::npos)
+			{
+				continue;
+			}
+			std::istringstream stream(it->mData);
+			LLPointer<LLVolume> volume = create_volume();
+			if (!volume->unpackVolumeFaces(stream, it->mData.size()))
+			{
+				continue;
+			}
+			for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+			{
+				bench_rays(llformat("%s[%d]", it->mName.c_str(), i), volume->getVolumeFace(i), rays, ray_total);
+			}
+		}
+
+		std::cout << "Cast " << ray_total.mRays << " rays at " << ray_total.mFaces << " faces ("
+			<< ray_total.mTriangles << " triangles), " << ray_total.mHits << " hits" << std::endl;
+		std::cout << "Octree : build " << ray_total.mOctreeBuild << " s, cast " << ray_total.mOctreeTime << " s" << std::endl;
+		std::cout << "BVH : build " << ray_total.mBVHBuild << " s, cast " << ray_total.mBVHTime
+			<< " s, mismatches : " << ray_total.mMismatches << std::endl;
+		if (ray_total.mBVHTime > 0.0)
+		{
+			std::cout << "Ray speedup : " << ray_total.mOctreeTime / ray_total.mBVHTime << "x" << std::endl;
+		}
+	}
+
+	if (cache_optimize)
+	{
+		CacheStats cache_total;
+		{
+			LLVolumeFace face;
+			make_sphere_face(face);
+			bench_cache_optimize("sphere", face, iterations, cache_total);
+		}
+		for (std::vector<MeshBlock>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+		{
+			std::istringstream stream(it->mData);
+			LLPointer<LLVolume> volume = create_volume();
+			if (!volume->unpackVolumeFaces(stream, it->mData.size()))
+			{
+				continue;
+			}
+			for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+			{
+				bench_cache_optimize(llformat("%s[%d]", it->mName.c_str(), i), volume->getVolumeFace(i), iterations, cache_total);
+			}
+		}
+
+		F64 triangles = llmax(cache_total.mTriangles, 1U);
+		std::cout << "Optimized " << cache_total.mFaces << " faces (" << cache_total.mTriangles << " triangles) x "
+			<< iterations << " iterations" << std::endl;
+		std::cout << "ACMR : shuffled " << cache_total.mShuffledMisses / triangles << ", legacy "
+			<< cache_total.mLegacyMisses / triangles << ", new " << cache_total.mMisses / triangles << std::endl;
+		std::cout << "Legacy total : " << cache_total.mLegacyTime << " s, new total : " << cache_total.mTime << " s" << std::endl;
+		if (cache_total.mTime > 0.0)
+		{
+			std::cout << "Optimize speedup : " << cache_total.mLegacyTime / cache_total.mTime << "x" << std::endl;
+		}
+	}
+
+	// Cleanup and exit
+	ll_cleanup_apr();
+	return 0;
+}
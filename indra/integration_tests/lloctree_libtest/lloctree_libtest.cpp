@@ -0,0 +1,334 @@
+/**
+ * @file lloctree_libtest.cpp
+ * @brief Benchmark of octrees with heap allocated nodes against pooled nodes
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "lloctree_libtest.h"
+
+// Linden library includes
+#include "lloctree.h"
+#include "llpointer.h"
+#include "llrand.h"
+#include "llrefcount.h"
+#include "llvector4a.h"
+
+// system libraries
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tlloctree_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -n, --elements <n>\n"
+"        Number of elements in the octree. Default is 100000.\n"
+" -c, --capacity <n>\n"
+"        Elements a node holds before it is split, like OctreeMaxNodeCapacity.\n"
+"        Default is 128.\n"
+" -r, --rounds <n>\n"
+"        Number of churn rounds, each moving a tenth of the elements. Default is 50.\n"
+" -i, --iterations <n>\n"
+"        Number of full traversals. Default is 200.\n"
+"\n";
+
+const F32 REGION_WIDTH = 256.f;
+const F32 GROUND_HEIGHT = 22.f;
+
+// Element with what LLOctreeNode needs of LLViewerOctreeEntry
+class OctreeElement : public LLRefCount
+{
+public:
+	OctreeElement() : mBinIndex(-1), mRadius(0.f) {}
+
+	const LLVector4a& getPositionGroup() const	{ return mPosition; }
+	F32 getBinRadius() const					{ return mRadius; }
+	S32 getBinIndex() const						{ return mBinIndex; }
+	void setBinIndex(S32 index)					{ mBinIndex = index; }
+
+	LLVector4a mPosition;
+	S32 mBinIndex;
+	F32 mRadius;
+};
+
+class HeapElement : public OctreeElement {};
+class PooledElement : public OctreeElement {};
+
+template <> struct LLOctreeUsePool<PooledElement> { static const bool value = true; };
+
+struct OctreeStats
+{
+	OctreeStats() : mNodes(0), mVisited(0), mInsert(0.0), mChurn(0.0), mTraverse(0.0), mDestroy(0.0) {}
+	U32 mNodes;
+	U64 mVisited;
+	F64 mInsert;
+	F64 mChurn;		// best round
+	F64 mTraverse;	// best traversal
+	F64 mDestroy;
+};
+
+// Churn rounds and traversals are timed one by one and the best one is
+// reported, which other load on the machine affects less
+
+// Visits every node and element like the viewer does when it rebuilds
+// or culls everything
+template <class T>
+class CountTraveler : public LLOctreeTraveler<T>
+{
+public:
+	CountTraveler() : mNodes(0), mElements(0) {}
+
+	virtual void visit(const LLOctreeNode<T>* node)
+	{
+		mNodes++;
+		for (typename LLOctreeNode<T>::const_element_iter iter = node->getDataBegin(); iter != node->getDataEnd(); ++iter)
+		{
+			mElements += (*iter)->getBinIndex() >= 0;
+		}
+	}
+
+	U32 mNodes;
+	U64 mElements;
+};
+
+// Picks a spot like a busy region: build sites, scattered on the ground
+// and some skyboxes
+void place_element(OctreeElement& element, const std::vector<LLVector4a>& sites)
+{
+	F32 kind = ll_frand();
+	F32 size;
+	if (kind < 0.8f)
+	{
+		const LLVector4a& site = sites[ll_rand(sites.size())];
+		element.mPosition.set(site[0] + ll_frand(40.f) - 20.f,
+							  site[1] + ll_frand(40.f) - 20.f,
+							  GROUND_HEIGHT + ll_frand(30.f));
+		size = 0.05f + ll_frand(1.f) * ll_frand(4.f);
+	}
+	else if (kind < 0.98f)
+	{
+		element.mPosition.set(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), GROUND_HEIGHT + ll_frand(4.f));
+		size = 0.1f + ll_frand(10.f) * ll_frand(1.f);
+	}
+	else
+	{
+		element.mPosition.set(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), 500.f + ll_frand(2500.f));
+		size = 1.f + ll_frand(20.f);
+	}
+	element.mRadius = size;
+}
+
+// One octree and its elements, stepped by main() so that the heap and
+// pooled octrees are timed in turns
+template <class T>
+class OctreeBench
+{
+public:
+	OctreeBench(const std::vector<LLVector4a>& positions, const std::vector<F32>& radii)
+	:	mPositions(positions),
+		mRoot(NULL)
+	{
+		mElements.resize(positions.size());
+		for (U32 i = 0; i < mElements.size(); ++i)
+		{
+			mElements[i] = new T;
+			mElements[i]->mPosition = positions[i];
+			mElements[i]->mRadius = radii[i];
+		}
+	}
+
+	void build()
+	{
+		LLVector4a center(REGION_WIDTH * 0.5f, REGION_WIDTH * 0.5f, REGION_WIDTH * 0.5f);
+		LLVector4a size(REGION_WIDTH * 0.5f);
+
+		LLTimer timer;
+		mRoot = new LLOctreeRoot<T>(center, size, NULL);
+		for (U32 i = 0; i < mElements.size(); ++i)
+		{
+			mRoot->insert(mElements[i]);
+		}
+		mStats.mInsert = timer.getElapsedTimeF64();
+	}
+
+	// Moves a tenth of the elements to where another one was, which
+	// empties nodes and grows others like objects moving around
+	void churn(const std::vector<U32>& moves, U32 round)
+	{
+		U32 per_round = llmax((U32) mElements.size() / 10, 1U);
+
+		LLTimer timer;
+		for (U32 i = 0; i < per_round; ++i)
+		{
+			U32 move = ((round * per_round + i) * 2) % moves.size();
+			T* element = mElements[moves[move]];
+			mRoot->remove(element);
+			element->mPosition = mPositions[moves[move + 1]];
+			mRoot->insert(element);
+		}
+		mRoot->balance();
+		F64 time = timer.getElapsedTimeF64();
+		mStats.mChurn = round ? llmin(mStats.mChurn, time) : time;
+	}
+
+	void traverse(U32 iteration)
+	{
+		CountTraveler<T> traveler;
+		LLTimer timer;
+		traveler.traverse(mRoot);
+		F64 time = timer.getElapsedTimeF64();
+		mStats.mTraverse = iteration ? llmin(mStats.mTraverse, time) : time;
+		mStats.mNodes = traveler.mNodes;
+		mStats.mVisited = traveler.mElements;
+	}
+
+	void destroy()
+	{
+		LLTimer timer;
+		delete mRoot;
+		mRoot = NULL;
+		mStats.mDestroy = timer.getElapsedTimeF64();
+	}
+
+	const OctreeStats& getStats() const		{ return mStats; }
+
+private:
+	const std::vector<LLVector4a>& mPositions;
+	std::vector<LLPointer<T> > mElements;
+	LLOctreeRoot<T>* mRoot;
+	OctreeStats mStats;
+};
+
+int main(int argc, char** argv)
+{
+	U32 num_elements = 100000;
+	U32 capacity = 128;
+	U32 rounds = 50;
+	U32 iterations = 200;
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--elements") || !strcmp(argv[arg], "-n")) && arg < argc-1)
+		{
+			num_elements = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--capacity") || !strcmp(argv[arg], "-c")) && arg < argc-1)
+		{
+			capacity = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--rounds") || !strcmp(argv[arg], "-r")) && arg < argc-1)
+		{
+			rounds = llmax(0, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-i")) && arg < argc-1)
+		{
+			iterations = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+	}
+
+	// Same settings as the viewer
+	gOctreeMaxCapacity = capacity;
+	gOctreeMinSize = 0.01f;
+
+	// Both octrees get the same elements and the same moves
+	std::vector<LLVector4a> sites(40);
+	for (U32 i = 0; i < sites.size(); ++i)
+	{
+		sites[i].set(ll_frand(REGION_WIDTH), ll_frand(REGION_WIDTH), GROUND_HEIGHT);
+	}
+	std::vector<LLVector4a> positions(num_elements);
+	std::vector<F32> radii(num_elements);
+	for (U32 i = 0; i < num_elements; ++i)
+	{
+		OctreeElement element;
+		place_element(element, sites);
+		positions[i] = element.mPosition;
+		radii[i] = element.mRadius;
+	}
+	// Pairs of element to move and element whose spot it takes
+	std::vector<U32> moves(llmax(num_elements / 10, 1U) * llmin(llmax(rounds, 1U), 10U) * 2);
+	for (U32 i = 0; i < moves.size(); ++i)
+	{
+		moves[i] = ll_rand(num_elements);
+	}
+
+	OctreeBench<HeapElement> heap_bench(positions, radii);
+	OctreeBench<PooledElement> pooled_bench(positions, radii);
+	heap_bench.build();
+	pooled_bench.build();
+	for (U32 round = 0; round < rounds; ++round)
+	{
+		heap_bench.churn(moves, round);
+		pooled_bench.churn(moves, round);
+	}
+	for (U32 i = 0; i < iterations; ++i)
+	{
+		heap_bench.traverse(i);
+		pooled_bench.traverse(i);
+	}
+	heap_bench.destroy();
+	pooled_bench.destroy();
+
+	const OctreeStats& heap = heap_bench.getStats();
+	const OctreeStats& pooled = pooled_bench.getStats();
+
+	const LLOctreePool& pool = LLOctreePool::instance<PooledElement>();
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << num_elements << " elements in " << heap.mNodes << " nodes, "
+		<< sizeof(LLOctreeNode<HeapElement>) << " bytes per node, "
+		<< pool.getNumChunks() << " pool chunks (" << (pool.getBytes() >> 10) << " KB)" << std::endl;
+	std::cout << "Heap : insert " << heap.mInsert * 1e3 << " ms, churn " << heap.mChurn * 1e3
+		<< " ms per round, traversal " << heap.mTraverse * 1e6 << " us, destroy "
+		<< heap.mDestroy * 1e3 << " ms" << std::endl;
+	std::cout << "Pooled : insert " << pooled.mInsert * 1e3 << " ms, churn " << pooled.mChurn * 1e3
+		<< " ms per round, traversal " << pooled.mTraverse * 1e6 << " us, destroy "
+		<< pooled.mDestroy * 1e3 << " ms" << std::endl;
+	if (heap.mNodes != pooled.mNodes || heap.mVisited != pooled.mVisited)
+	{
+		std::cout << "Mismatch : heap octree has " << heap.mNodes << " nodes and " << heap.mVisited
+			<< " elements, pooled " << pooled.mNodes << " and " << pooled.mVisited << std::endl;
+		return 1;
+	}
+	if (pooled.mChurn > 0.0 && pooled.mTraverse > 0.0)
+	{
+		std::cout << "Speedup : churn " << heap.mChurn / pooled.mChurn << "x, traversal "
+			<< heap.mTraverse / pooled.mTraverse << "x" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,323 @@
+/**
+ * @file llsculpt_libtest.cpp
+ * @brief Benchmark of sculpt map to vertex position generation
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "llsculpt_libtest.h"
+
+// Linden library includes
+#include "llalignedarray.h"
+#include "llmath.h"
+#include "llrand.h"
+#include "lluuid.h"
+#include "llvector4a.h"
+#include "llvolume.h"
+#include "llvolumesculpt.h"
+
+// system libraries
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllsculpt_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -i, --iterations <n>\n"
+"        Number of times every map is converted at every LOD. Default is 200.\n"
+"\n";
+
+// Vertices along each side at each LOD, as sculpt_sides() picks them,
+// plus the closing vertex
+const S32 LOD_SIZES[] = { 7, 9, 17, 33 };
+const S32 NUM_LODS = sizeof(LOD_SIZES) / sizeof(LOD_SIZES[0]);
+
+const U8 SCULPT_TYPES[] = {
+	LL_SCULPT_TYPE_SPHERE,
+	LL_SCULPT_TYPE_TORUS,
+	LL_SCULPT_TYPE_PLANE,
+	LL_SCULPT_TYPE_CYLINDER,
+	LL_SCULPT_TYPE_SPHERE | LL_SCULPT_FLAG_MIRROR,
+	LL_SCULPT_TYPE_TORUS | LL_SCULPT_FLAG_INVERT
+};
+const S32 NUM_SCULPT_TYPES = sizeof(SCULPT_TYPES) / sizeof(SCULPT_TYPES[0]);
+
+struct SculptMap
+{
+	std::string mName;
+	U16 mWidth;
+	U16 mHeight;
+	S8 mComponents;
+	std::vector<U8> mData;
+	LLUUID mID;
+};
+
+// The conversion LLVolume::sculptGenerateMapVertices() did before, texel
+// by texel
+void legacy_generate_positions(LLVector4a* positions, S32 sizeS, S32 sizeT,
+							   U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+							   const U8* sculpt_data, U8 sculpt_type)
+{
+	U8 sculpt_stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
+	BOOL sculpt_invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
+	BOOL sculpt_mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
+	BOOL reverse_horizontal = (sculpt_invert ? !sculpt_mirror : sculpt_mirror);
+
+	S32 line = 0;
+	for (S32 s = 0; s < sizeS; s++)
+	{
+		for (S32 t = 0; t < sizeT; t++)
+		{
+			LLVector4a& pt = positions[t + line];
+
+			S32 reversed_t = reverse_horizontal ? sizeT - t - 1 : t;
+			U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
+			U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
+
+			if (y == 0 && sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
+			{
+				x = sculpt_width / 2;
+			}
+			if (y == sculpt_height)
+			{
+				y = sculpt_stitching == LL_SCULPT_TYPE_TORUS ? 0 : sculpt_height - 1;
+				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
+				{
+					x = sculpt_width / 2;
+				}
+			}
+			if (x == sculpt_width)
+			{
+				if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
+					(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
+					(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
+				{
+					x = 0;
+				}
+				else
+				{
+					x = sculpt_width - 1;
+				}
+			}
+
+			U32 index = (x + y * sculpt_width) * sculpt_components;
+			LLVector4a sub(0.5f, 0.5f, 0.5f);
+			pt.set(sculpt_data[index], sculpt_data[index+1], sculpt_data[index+2]);
+			pt.mul(1.f/255.f);
+			pt.sub(sub);
+
+			if (sculpt_mirror)
+			{
+				LLVector4a scale(-1.f,1,1,1);
+				pt.mul(scale);
+			}
+		}
+		line += sizeT;
+	}
+}
+
+// Map of a shape wrapped around like the sculpt types expect, with some
+// noise so that neighbouring texels differ like in real maps
+SculptMap make_map(const std::string& name, U16 width, U16 height, S8 components, bool torus)
+{
+	SculptMap map;
+	map.mName = name;
+	map.mWidth = width;
+	map.mHeight = height;
+	map.mComponents = components;
+	map.mData.resize(width * height * components);
+	map.mID.generate();
+
+	for (U16 y = 0; y < height; ++y)
+	{
+		F32 v = (F32) y / height;
+		for (U16 x = 0; x < width; ++x)
+		{
+			F32 u = (F32) x / width;
+			F32 px, py, pz;
+			if (torus)
+			{
+				F32 ring = 0.35f + 0.15f * cosf(v * F_TWO_PI);
+				px = ring * cosf(u * F_TWO_PI);
+				py = ring * sinf(u * F_TWO_PI);
+				pz = 0.15f * sinf(v * F_TWO_PI);
+			}
+			else
+			{
+				px = 0.5f * sinf(v * F_PI) * cosf(u * F_TWO_PI);
+				py = 0.5f * sinf(v * F_PI) * sinf(u * F_TWO_PI);
+				pz = 0.5f * cosf(v * F_PI);
+			}
+			U8* texel = &map.mData[(x + y * width) * components];
+			texel[0] = (U8) llclamp((S32) ((px + 0.5f) * 255.f) + ll_rand(5) - 2, 0, 255);
+			texel[1] = (U8) llclamp((S32) ((py + 0.5f) * 255.f) + ll_rand(5) - 2, 0, 255);
+			texel[2] = (U8) llclamp((S32) ((pz + 0.5f) * 255.f) + ll_rand(5) - 2, 0, 255);
+			if (components == 4)
+			{
+				texel[3] = 255;
+			}
+		}
+	}
+	return map;
+}
+
+int main(int argc, char** argv)
+{
+	U32 iterations = 200;
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-i")) && arg < argc-1)
+		{
+			iterations = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+	}
+
+	// Sizes sculpt maps are usually uploaded at
+	std::vector<SculptMap> maps;
+	maps.push_back(make_map("sphere 32x32", 32, 32, 3, false));
+	maps.push_back(make_map("sphere 64x64", 64, 64, 3, false));
+	maps.push_back(make_map("sphere 64x64 RGBA", 64, 64, 4, false));
+	maps.push_back(make_map("torus 128x128", 128, 128, 3, true));
+	maps.push_back(make_map("torus 64x16", 64, 16, 3, true));
+	maps.push_back(make_map("sphere 16x64", 16, 64, 3, false));
+
+	LLAlignedArray<LLVector4a, 64> legacy;
+	LLAlignedArray<LLVector4a, 64> rows;
+	legacy.resize(LOD_SIZES[NUM_LODS-1] * LOD_SIZES[NUM_LODS-1]);
+	rows.resize(legacy.size());
+
+	LLSculptCache cache;
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Best time to convert a map at all LODs and sculpt types, in us" << std::endl;
+	std::cout << std::setw(20) << "map" << std::setw(12) << "per texel" << std::setw(12) << "per row"
+		<< std::setw(12) << "cached" << std::setw(10) << "speedup" << std::endl;
+
+	F64 total_legacy = 0.0;
+	F64 total_rows = 0.0;
+	F64 total_cached = 0.0;
+	U32 mismatches = 0;
+	for (U32 m = 0; m < maps.size(); ++m)
+	{
+		const SculptMap& map = maps[m];
+
+		// Every map shape goes through each path in turn, timed one by one
+		// so that other load on the machine affects the best time less
+		F64 best_legacy = 0.0;
+		F64 best_rows = 0.0;
+		F64 best_cached = 0.0;
+		for (U32 i = 0; i < iterations; ++i)
+		{
+			LLTimer timer;
+			for (S32 type = 0; type < NUM_SCULPT_TYPES; ++type)
+			{
+				for (S32 lod = 0; lod < NUM_LODS; ++lod)
+				{
+					legacy_generate_positions(legacy.mArray, LOD_SIZES[lod], LOD_SIZES[lod], map.mWidth, map.mHeight,
+											  map.mComponents, &map.mData[0], SCULPT_TYPES[type]);
+				}
+			}
+			F64 time = timer.getElapsedTimeF64();
+			best_legacy = i ? llmin(best_legacy, time) : time;
+
+			timer.reset();
+			for (S32 type = 0; type < NUM_SCULPT_TYPES; ++type)
+			{
+				for (S32 lod = 0; lod < NUM_LODS; ++lod)
+				{
+					ll_sculpt_generate_positions(rows.mArray, LOD_SIZES[lod], LOD_SIZES[lod], map.mWidth, map.mHeight,
+												 map.mComponents, &map.mData[0], SCULPT_TYPES[type]);
+				}
+			}
+			time = timer.getElapsedTimeF64();
+			best_rows = i ? llmin(best_rows, time) : time;
+
+			timer.reset();
+			for (S32 type = 0; type < NUM_SCULPT_TYPES; ++type)
+			{
+				for (S32 lod = 0; lod < NUM_LODS; ++lod)
+				{
+					LLSculptCache::Key key(map.mID, 0, SCULPT_TYPES[type], map.mWidth, map.mHeight, LOD_SIZES[lod], LOD_SIZES[lod]);
+					F32 area = -1.f;
+					if (!cache.find(key, rows.mArray, area))
+					{
+						ll_sculpt_generate_positions(rows.mArray, LOD_SIZES[lod], LOD_SIZES[lod], map.mWidth, map.mHeight,
+													 map.mComponents, &map.mData[0], SCULPT_TYPES[type]);
+						cache.insert(key, rows.mArray, area);
+					}
+				}
+			}
+			time = timer.getElapsedTimeF64();
+			best_cached = i ? llmin(best_cached, time) : time;
+		}
+
+		// Both conversions must give the same bits
+		for (S32 type = 0; type < NUM_SCULPT_TYPES; ++type)
+		{
+			for (S32 lod = 0; lod < NUM_LODS; ++lod)
+			{
+				S32 count = LOD_SIZES[lod] * LOD_SIZES[lod];
+				legacy_generate_positions(legacy.mArray, LOD_SIZES[lod], LOD_SIZES[lod], map.mWidth, map.mHeight,
+										  map.mComponents, &map.mData[0], SCULPT_TYPES[type]);
+				ll_sculpt_generate_positions(rows.mArray, LOD_SIZES[lod], LOD_SIZES[lod], map.mWidth, map.mHeight,
+											 map.mComponents, &map.mData[0], SCULPT_TYPES[type]);
+				if (memcmp(legacy.mArray, rows.mArray, count * sizeof(LLVector4a)))
+				{
+					mismatches++;
+				}
+			}
+		}
+
+		total_legacy += best_legacy;
+		total_rows += best_rows;
+		total_cached += best_cached;
+		std::cout << std::setw(20) << map.mName << std::setw(12) << best_legacy * 1e6 << std::setw(12) << best_rows * 1e6
+			<< std::setw(12) << best_cached * 1e6 << std::setw(9) << best_legacy / llmax(best_rows, 1e-9) << "x" << std::endl;
+	}
+
+	std::cout << std::setw(20) << "total" << std::setw(12) << total_legacy * 1e6 << std::setw(12) << total_rows * 1e6
+		<< std::setw(12) << total_cached * 1e6 << std::setw(9) << total_legacy / llmax(total_rows, 1e-9) << "x" << std::endl;
+	std::cout << "Cache : " << cache.getNumEntries() << " entries, " << cache.getNumHits() << " hits, "
+		<< cache.getNumMisses() << " misses" << std::endl;
+
+	if (mismatches)
+	{
+		std::cout << "Mismatch : " << mismatches << " conversions differ from the per texel ones" << std::endl;
+		return 1;
+	}
+	return 0;
+}
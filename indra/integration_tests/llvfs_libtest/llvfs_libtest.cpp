@@ -0,0 +1,283 @@
+/**
+ * @file llvfs_libtest.cpp
+ * @brief Stress test of the VFS backends in llvfs with concurrent readers and writers
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "llvfs_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "llfile.h"
+#include "llvfs.h"
+#include "lllogvfs.h"
+
+// system libraries
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <random>
+#include <thread>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllvfs_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -d, --dir <path>\n"
+"        Directory where the VFS index and data files are created. Default is the\n"
+"        current directory. The files are removed on exit.\n"
+" -r, --readers <n>\n"
+"        Number of reader threads. Default is 4.\n"
+" -w, --writers <n>\n"
+"        Number of writer threads. Default is 2.\n"
+" -f, --files <n>\n"
+"        Number of files stored before the test starts. Default is 2000.\n"
+" -s, --size <bytes>\n"
+"        Size of each file. Default is 16384.\n"
+" -t, --time <seconds>\n"
+"        Duration of each run. Default is 5.\n"
+"\n";
+
+struct StressOptions
+{
+	StressOptions() : mReaders(4), mWriters(2), mFiles(2000), mFileSize(16384), mDuration(5.0) {}
+	std::string mDir;
+	S32 mReaders;
+	S32 mWriters;
+	S32 mFiles;
+	S32 mFileSize;
+	F64 mDuration;
+};
+
+struct StressStats
+{
+	StressStats() : mReads(0), mReadBytes(0), mWrites(0), mWriteBytes(0), mFailures(0) {}
+	std::atomic<U64> mReads;
+	std::atomic<U64> mReadBytes;
+	std::atomic<U64> mWrites;
+	std::atomic<U64> mWriteBytes;
+	std::atomic<U64> mFailures;
+};
+
+// Every file starts with its own id so that readers can check they got the right data back
+void fill_file(std::vector<U8>& buffer, const LLUUID& id, U32 seed)
+{
+	memcpy(&buffer[0], id.mData, UUID_BYTES);
+	for (size_t i = UUID_BYTES; i < buffer.size(); ++i)
+	{
+		buffer[i] = (U8)(seed + i);
+	}
+}
+
+// Writers mostly rewrite existing files in place, and append to a new file one time in eight,
+// which is what the texture and mesh caches do most of the time
+void run_writer(LLVFS* vfs, const std::vector<LLUUID>& ids, const StressOptions& options, U32 seed,
+				std::atomic<bool>& done, StressStats& stats)
+{
+	std::mt19937 rng(seed);
+	std::vector<U8> buffer(options.mFileSize);
+	while (!done)
+	{
+		if ((rng() & 7) == 0)
+		{
+			LLUUID id;
+			id.generate();
+			fill_file(buffer, id, rng());
+			if (!vfs->setMaxSize(id, LLAssetType::AT_TEXTURE, options.mFileSize)
+				|| vfs->storeData(id, LLAssetType::AT_TEXTURE, &buffer[0], -1, options.mFileSize) != options.mFileSize)
+			{
+				stats.mFailures++;
+			}
+			vfs->removeFile(id, LLAssetType::AT_TEXTURE);
+		}
+		else
+		{
+			const LLUUID& id = ids[rng() % ids.size()];
+			fill_file(buffer, id, rng());
+			if (vfs->storeData(id, LLAssetType::AT_TEXTURE, &buffer[0], 0, options.mFileSize) != options.mFileSize)
+			{
+				stats.mFailures++;
+			}
+		}
+		stats.mWrites++;
+		stats.mWriteBytes += options.mFileSize;
+	}
+}
+
+void run_reader(LLVFS* vfs, const std::vector<LLUUID>& ids, const StressOptions& options, U32 seed,
+				std::atomic<bool>& done, StressStats& stats)
+{
+	std::mt19937 rng(seed);
+	std::vector<U8> buffer(options.mFileSize);
+	while (!done)
+	{
+		const LLUUID& id = ids[rng() % ids.size()];
+		S32 bytes = vfs->getData(id, LLAssetType::AT_TEXTURE, &buffer[0], 0, options.mFileSize);
+		if (bytes != options.mFileSize || memcmp(&buffer[0], id.mData, UUID_BYTES))
+		{
+			stats.mFailures++;
+		}
+		stats.mReads++;
+		stats.mReadBytes += bytes;
+	}
+}
+
+// Store the initial files, then run the readers and writers against the VFS for the set duration
+bool run_stress(const std::string& name, LLVFS* vfs, const StressOptions& options)
+{
+	if (!vfs)
+	{
+		std::cout << name << " : could not be created" << std::endl;
+		return false;
+	}
+
+	LLTimer timer;
+	std::vector<LLUUID> ids(options.mFiles);
+	std::vector<U8> buffer(options.mFileSize);
+	for (S32 i = 0; i < options.mFiles; ++i)
+	{
+		ids[i].generate();
+		fill_file(buffer, ids[i], i);
+		if (!vfs->setMaxSize(ids[i], LLAssetType::AT_TEXTURE, options.mFileSize)
+			|| vfs->storeData(ids[i], LLAssetType::AT_TEXTURE, &buffer[0], 0, options.mFileSize) != options.mFileSize)
+		{
+			std::cout << name << " : could not store the initial files" << std::endl;
+			return false;
+		}
+	}
+	F64 fill_time = timer.getElapsedTimeF64();
+
+	StressStats stats;
+	std::atomic<bool> done(false);
+	std::vector<std::thread> threads;
+	timer.reset();
+	for (S32 i = 0; i < options.mWriters; ++i)
+	{
+		threads.push_back(std::thread(run_writer, vfs, std::cref(ids), std::cref(options), 1000 + i,
+									  std::ref(done), std::ref(stats)));
+	}
+	for (S32 i = 0; i < options.mReaders; ++i)
+	{
+		threads.push_back(std::thread(run_reader, vfs, std::cref(ids), std::cref(options), 2000 + i,
+									  std::ref(done), std::ref(stats)));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds((S64)(options.mDuration * 1000.0)));
+	done = true;
+	for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		it->join();
+	}
+	F64 elapsed = timer.getElapsedTimeF64();
+
+	std::cout << name << " : filled " << options.mFiles << " files in " << fill_time << " s, "
+		<< stats.mReads / elapsed << " reads/s (" << stats.mReadBytes / elapsed / 1048576.0 << " MB/s), "
+		<< stats.mWrites / elapsed << " writes/s (" << stats.mWriteBytes / elapsed / 1048576.0 << " MB/s)";
+	if (stats.mFailures)
+	{
+		std::cout << ", " << stats.mFailures << " failures";
+	}
+	std::cout << std::endl;
+	return stats.mFailures == 0;
+}
+
+int main(int argc, char** argv)
+{
+	StressOptions options;
+
+	// Init whatever is necessary
+	ll_init_apr();
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--dir") || !strcmp(argv[arg], "-d")) && arg < argc-1)
+		{
+			options.mDir = std::string(argv[arg+1]) + "/";
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--readers") || !strcmp(argv[arg], "-r")) && arg < argc-1)
+		{
+			options.mReaders = llmax(0, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--writers") || !strcmp(argv[arg], "-w")) && arg < argc-1)
+		{
+			options.mWriters = llmax(0, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--files") || !strcmp(argv[arg], "-f")) && arg < argc-1)
+		{
+			options.mFiles = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--size") || !strcmp(argv[arg], "-s")) && arg < argc-1)
+		{
+			options.mFileSize = llmax(UUID_BYTES, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--time") || !strcmp(argv[arg], "-t")) && arg < argc-1)
+		{
+			options.mDuration = llmax(0.1, atof(argv[arg+1]));
+			arg += 1;
+		}
+	}
+
+	// Both stores get room for the initial files and the writers' scratch files, with slack
+	// for fragmentation of the legacy one
+	U32 presize = (U32)llmin((U64)U32_MAX, (U64)options.mFiles * options.mFileSize * 2 + (64 << 20));
+	std::string legacy_index = options.mDir + "llvfs_libtest_index.db2";
+	std::string legacy_data = options.mDir + "llvfs_libtest_data.db2";
+	std::string log_index = options.mDir + "llvfs_libtest_logindex.db2";
+	std::string log_data = options.mDir + "llvfs_libtest_logdata.db2";
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << options.mReaders << " readers, " << options.mWriters << " writers, "
+		<< options.mFiles << " files of " << options.mFileSize << " bytes, "
+		<< options.mDuration << " s per run" << std::endl;
+
+	LLVFS* legacy = LLVFS::createLLVFS(legacy_index, legacy_data, FALSE, presize, FALSE);
+	bool success = run_stress("LLVFS", legacy, options);
+	delete legacy;
+
+	LLLogVFS* log = LLLogVFS::createLogVFS(log_index, log_data, FALSE, presize, FALSE);
+	success = run_stress("LLLogVFS", log, options) && success;
+	delete log;
+
+	LLFile::remove(legacy_index);
+	LLFile::remove(legacy_data);
+	LLFile::remove(log_index);
+	LLFile::remove(log_data);
+
+	// Cleanup and exit
+	ll_cleanup_apr();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,491 @@
+/**
+ * @file llvocache_libtest.cpp
+ * @brief Benchmark of region arrival and departure with the object cache file formats
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "llvocache_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "llfile.h"
+#include "llvocachefile.h"
+
+// system libraries
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <set>
+#if LL_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllvocache_libtest [options]\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -d, --dir <path>\n"
+"        Directory where the cache files are written. Default is the current\n"
+"        directory. The files are removed on exit.\n"
+" -n, --objects <n>\n"
+"        Number of objects in the region. Default is 15000.\n"
+" -c, --created <percent>\n"
+"        Share of the objects that get created, i.e. whose update data is\n"
+"        needed, on arrival. Default is 25.\n"
+" -u, --updated <percent>\n"
+"        Share of the objects that changed during the visit. Default is 5.\n"
+" -p, --copies <percent>\n"
+"        Share of the objects that are copies of another one, with the same\n"
+"        shape, textures and extra parameters. Default is 40, a shop or a\n"
+"        sandbox has more.\n"
+" -i, --iterations <n>\n"
+"        Number of visits timed for each format. Default is 5.\n"
+"\n";
+
+// Per object header of the previous format: local id, crc, hit count,
+// dupe count, crc change count and data size
+const S32 LEGACY_ENTRY_HEADER_SIZE = 6 * sizeof(S32);
+
+// Update data unique to an object without angular velocity or parent,
+// see LLViewerObject::getUniqueDataSize().  The rest is its body.
+const U32 UNIQUE_DATA_SIZE = 84;
+
+struct BenchOptions
+{
+	BenchOptions() : mObjects(15000), mCreated(25), mUpdated(5), mCopies(40), mIterations(5) {}
+	std::string mDir;
+	S32 mObjects;
+	S32 mCreated;
+	S32 mUpdated;
+	S32 mCopies;
+	S32 mIterations;
+};
+
+struct BenchObject
+{
+	U32 mLocalID;
+	U32 mCRC;
+	std::vector<U8> mData;
+};
+
+// What the region keeps per cached object
+struct BenchEntry
+{
+	BenchEntry() : mLocalID(0), mCRC(0), mSlot(NULL), mBuffer(NULL), mSize(0) {}
+	~BenchEntry() { delete[] mBuffer; }
+
+	U32 mLocalID;
+	U32 mCRC;
+	const LLVOCacheSlot* mSlot;
+	U8* mBuffer;
+	U32 mSize;
+};
+typedef std::map<U32, BenchEntry*> bench_entry_map_t;
+
+struct BenchStats
+{
+	BenchStats() : mCold(0.0), mColdCreate(0.0), mWarm(0.0), mWarmCreate(0.0), mSave(0.0), mColdRuns(0) {}
+	F64 mCold;			// Reading the cache file on arrival
+	F64 mColdCreate;	// Getting the data of the created objects
+	F64 mWarm;
+	F64 mWarmCreate;
+	F64 mSave;
+	S32 mColdRuns;
+};
+
+void clear_entries(bench_entry_map_t& entries)
+{
+	for (bench_entry_map_t::iterator iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		delete iter->second;
+	}
+	entries.clear();
+}
+
+// Drop a file from the OS page cache so the next read comes from the disk.
+// Returns false where this is not supported.
+bool evict_file(const std::string& filename)
+{
+#if LL_LINUX
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	fdatasync(fd);
+	bool success = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	::close(fd);
+	return success;
+#else
+	return false;
+#endif
+}
+
+// Previous format: every object read and copied on arrival, every object written on departure
+bool legacy_read(const std::string& filename, const LLUUID& cache_id, bench_entry_map_t& entries)
+{
+	LLAPRFile file(filename, APR_READ|APR_BINARY);
+	LLUUID id;
+	S32 num_entries = 0;
+	if (file.read(id.mData, UUID_BYTES) != UUID_BYTES || id != cache_id
+		|| file.read(&num_entries, sizeof(S32)) != sizeof(S32))
+	{
+		return false;
+	}
+	for (S32 i = 0; i < num_entries; ++i)
+	{
+		S32 header[6];
+		if (file.read(header, LEGACY_ENTRY_HEADER_SIZE) != LEGACY_ENTRY_HEADER_SIZE || header[5] < 1 || header[5] > 10000)
+		{
+			return false;
+		}
+		BenchEntry* entry = new BenchEntry();
+		entry->mLocalID = header[0];
+		entry->mCRC = header[1];
+		entry->mSize = header[5];
+		entry->mBuffer = new U8[entry->mSize];
+		entries[entry->mLocalID] = entry;
+		if (file.read(entry->mBuffer, entry->mSize) != (S32)entry->mSize)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool legacy_write(const std::string& filename, const LLUUID& cache_id, const std::vector<BenchObject>& objects)
+{
+	LLAPRFile file(filename, APR_CREATE|APR_WRITE|APR_BINARY);
+	S32 num_entries = objects.size();
+	bool success = file.write(cache_id.mData, UUID_BYTES) == UUID_BYTES
+		&& file.write(&num_entries, sizeof(S32)) == sizeof(S32);
+	for (S32 i = 0; success && i < num_entries; ++i)
+	{
+		S32 header[6] = { (S32)objects[i].mLocalID, (S32)objects[i].mCRC, 0, 0, 0, (S32)objects[i].mData.size() };
+		success = file.write(header, LEGACY_ENTRY_HEADER_SIZE) == LEGACY_ENTRY_HEADER_SIZE
+			&& file.write(&objects[i].mData[0], objects[i].mData.size()) == (S32)objects[i].mData.size();
+	}
+	return success;
+}
+
+// Indexed format: the slot table is walked on arrival, data is copied when an object is created
+bool indexed_read(const std::string& filename, const LLUUID& cache_id, LLPointer<LLVOCacheFile>& cache_file,
+				  bench_entry_map_t& entries)
+{
+	cache_file = new LLVOCacheFile();
+	if (!cache_file->open(filename, cache_id))
+	{
+		return false;
+	}
+	for (U32 i = 0; i < cache_file->getNumSlots(); ++i)
+	{
+		const LLVOCacheSlot& slot = cache_file->getSlot(i);
+		if (slot.mLocalID)
+		{
+			BenchEntry* entry = new BenchEntry();
+			entry->mLocalID = slot.mLocalID;
+			entry->mCRC = slot.mCRC;
+			entry->mSlot = &slot;
+			entries[entry->mLocalID] = entry;
+		}
+	}
+	return true;
+}
+
+void indexed_create(LLVOCacheFile* cache_file, BenchEntry* entry)
+{
+	if (!entry->mBuffer && entry->mSlot)
+	{
+		U32 body_size = cache_file->getBodySize(*entry->mSlot);
+		entry->mSize = entry->mSlot->mSize + body_size;
+		entry->mBuffer = new U8[entry->mSize];
+		memcpy(entry->mBuffer, cache_file->getData(*entry->mSlot), entry->mSlot->mSize);
+		if (body_size)
+		{
+			memcpy(entry->mBuffer + entry->mSlot->mSize, cache_file->getBodyData(*entry->mSlot), body_size);
+		}
+	}
+}
+
+bool indexed_write(const std::string& filename, const LLUUID& cache_id, std::vector<BenchObject>& objects,
+				   std::vector<LLVOCacheFile::Record>& records)
+{
+	if (records.size() != objects.size())
+	{
+		records.resize(objects.size());
+	}
+	for (U32 i = 0; i < objects.size(); ++i)
+	{
+		LLVOCacheFile::Record& record = records[i];
+		record.mSlot.mLocalID = objects[i].mLocalID;
+		record.mSlot.mCRC = objects[i].mCRC;
+		record.mSlot.mSize = llmin(UNIQUE_DATA_SIZE, (U32)objects[i].mData.size());
+		record.mData = &objects[i].mData[0];
+		record.mBodySize = objects[i].mData.size() - record.mSlot.mSize;
+		record.mBodyData = record.mBodySize ? record.mData + record.mSlot.mSize : NULL;
+		record.mBodyHash = record.mBodySize ? LLVOCacheFile::hashBody(record.mBodyData, record.mBodySize) : 0;
+	}
+	return LLVOCacheFile::write(filename, cache_id, records);
+}
+
+// Change the data of some objects, as the simulator would during a visit
+void update_objects(std::vector<BenchObject>& objects, S32 percent, std::vector<LLVOCacheFile::Record>& records,
+					std::mt19937& rng)
+{
+	S32 count = objects.size() * percent / 100;
+	for (S32 i = 0; i < count; ++i)
+	{
+		U32 index = rng() % objects.size();
+		BenchObject& object = objects[index];
+		object.mCRC = rng();
+		object.mData.resize(llclamp((S32)object.mData.size() + (S32)(rng() % 64) - 24, 128, 10000));
+		object.mData[rng() % object.mData.size()] = (U8)rng();
+		if (index < records.size())
+		{
+			records[index].mDirty = true;
+		}
+	}
+}
+
+// Memory the object data takes once read, whole and with identical bodies shared
+void get_resident_bytes(const std::vector<BenchObject>& objects, U64& whole, U64& shared)
+{
+	std::set<std::vector<U8> > bodies;
+	whole = 0;
+	shared = 0;
+	for (U32 i = 0; i < objects.size(); ++i)
+	{
+		const std::vector<U8>& data = objects[i].mData;
+		U32 head_size = llmin(UNIQUE_DATA_SIZE, (U32)data.size());
+		whole += data.size();
+		shared += head_size;
+		if (bodies.insert(std::vector<U8>(data.begin() + head_size, data.end())).second)
+		{
+			shared += data.size() - head_size;
+		}
+	}
+}
+
+bool check_entries(const std::vector<BenchObject>& objects, bench_entry_map_t& entries, LLVOCacheFile* cache_file)
+{
+	if (entries.size() != objects.size())
+	{
+		return false;
+	}
+	for (U32 i = 0; i < objects.size(); ++i)
+	{
+		bench_entry_map_t::iterator iter = entries.find(objects[i].mLocalID);
+		if (iter == entries.end() || iter->second->mCRC != objects[i].mCRC)
+		{
+			return false;
+		}
+		if (cache_file)
+		{
+			indexed_create(cache_file, iter->second);
+		}
+		if (iter->second->mSize != objects[i].mData.size()
+			|| memcmp(iter->second->mBuffer, &objects[i].mData[0], iter->second->mSize))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+
+	// Init whatever is necessary
+	ll_init_apr();
+
+	// Analyze command line arguments
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+		{
+			std::cout << USAGE << std::endl;
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "--dir") || !strcmp(argv[arg], "-d")) && arg < argc-1)
+		{
+			options.mDir = std::string(argv[arg+1]) + "/";
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--objects") || !strcmp(argv[arg], "-n")) && arg < argc-1)
+		{
+			options.mObjects = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--created") || !strcmp(argv[arg], "-c")) && arg < argc-1)
+		{
+			options.mCreated = llclamp(atoi(argv[arg+1]), 0, 100);
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--updated") || !strcmp(argv[arg], "-u")) && arg < argc-1)
+		{
+			options.mUpdated = llclamp(atoi(argv[arg+1]), 0, 100);
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--copies") || !strcmp(argv[arg], "-p")) && arg < argc-1)
+		{
+			options.mCopies = llclamp(atoi(argv[arg+1]), 0, 100);
+			arg += 1;
+		}
+		else if ((!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-i")) && arg < argc-1)
+		{
+			options.mIterations = llmax(1, atoi(argv[arg+1]));
+			arg += 1;
+		}
+	}
+
+	// A region's worth of object updates, with the sizes seen in the wild.
+	// Copies have their own id, position and crc, and the body of the object
+	// they are a copy of.
+	std::mt19937 rng(42);
+	LLUUID cache_id;
+	cache_id.generate();
+	std::vector<BenchObject> objects(options.mObjects);
+	for (S32 i = 0; i < options.mObjects; ++i)
+	{
+		objects[i].mLocalID = 1000 + i * 3;
+		objects[i].mCRC = rng();
+		bool copy = i > 0 && (S32)(rng() % 100) < options.mCopies;
+		if (copy)
+		{
+			objects[i].mData = objects[rng() % i].mData;
+		}
+		else
+		{
+			objects[i].mData.resize(128 + rng() % 896);
+		}
+		for (U32 j = 0; j < (copy ? UNIQUE_DATA_SIZE : objects[i].mData.size()); ++j)
+		{
+			objects[i].mData[j] = (U8)rng();
+		}
+	}
+	U64 whole_bytes, shared_bytes;
+	get_resident_bytes(objects, whole_bytes, shared_bytes);
+
+	std::string legacy_filename = options.mDir + "llvocache_libtest_legacy.slc";
+	std::string indexed_filename = options.mDir + "llvocache_libtest_indexed.slc";
+	std::vector<LLVOCacheFile::Record> records;
+	if (!legacy_write(legacy_filename, cache_id, objects) || !indexed_write(indexed_filename, cache_id, objects, records))
+	{
+		std::cout << "Error: could not write the cache files" << std::endl;
+		return 1;
+	}
+
+	// Each visit: arrive (read the cache and create some objects), get some
+	// updates, leave (write the cache), checking what was read back.  The
+	// legacy format has all the data in memory once read, the indexed one
+	// copies it out as objects get created, over the frames after arrival.
+	BenchStats legacy;
+	BenchStats indexed;
+	bool success = true;
+	for (S32 i = 0; i < options.mIterations; ++i)
+	{
+		for (S32 pass = 0; pass < 2; ++pass)
+		{
+			bool cold = pass == 0;
+
+			bench_entry_map_t entries;
+			if (cold && evict_file(legacy_filename))
+			{
+				legacy.mColdRuns++;
+			}
+			LLTimer timer;
+			success = legacy_read(legacy_filename, cache_id, entries) && success;
+			(cold ? legacy.mCold : legacy.mWarm) += timer.getElapsedTimeF64();
+			success = check_entries(objects, entries, NULL) && success;
+			clear_entries(entries);
+
+			LLPointer<LLVOCacheFile> cache_file;
+			if (cold && evict_file(indexed_filename))
+			{
+				indexed.mColdRuns++;
+			}
+			timer.reset();
+			success = indexed_read(indexed_filename, cache_id, cache_file, entries) && success;
+			(cold ? indexed.mCold : indexed.mWarm) += timer.getElapsedTimeF64();
+			timer.reset();
+			S32 created = entries.size() * options.mCreated / 100;
+			for (bench_entry_map_t::iterator iter = entries.begin(); created > 0 && iter != entries.end(); ++iter, --created)
+			{
+				indexed_create(cache_file, iter->second);
+			}
+			(cold ? indexed.mColdCreate : indexed.mWarmCreate) += timer.getElapsedTimeF64();
+			success = check_entries(objects, entries, cache_file) && success;
+			clear_entries(entries);
+		}
+
+		update_objects(objects, options.mUpdated, records, rng);
+
+		LLTimer timer;
+		success = legacy_write(legacy_filename, cache_id, objects) && success;
+		legacy.mSave += timer.getElapsedTimeF64();
+		timer.reset();
+		success = indexed_write(indexed_filename, cache_id, objects, records) && success;
+		indexed.mSave += timer.getElapsedTimeF64();
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << options.mObjects << " objects, " << options.mCopies << "% copies, " << options.mCreated << "% created on arrival, "
+		<< options.mUpdated << "% updated per visit, " << options.mIterations << " visits" << std::endl;
+	std::cout << "File sizes : legacy " << LLAPRFile::size(legacy_filename) << " bytes, indexed "
+		<< LLAPRFile::size(indexed_filename) << " bytes" << std::endl;
+	std::cout << "Object data in memory, on arrival : whole " << whole_bytes << " bytes, bodies shared "
+		<< shared_bytes << " bytes" << std::endl;
+	if (legacy.mColdRuns && indexed.mColdRuns)
+	{
+		std::cout << "Arrival, cold : legacy " << legacy.mCold * 1000.0 / legacy.mColdRuns << " ms, indexed "
+			<< indexed.mCold * 1000.0 / indexed.mColdRuns << " ms + "
+			<< indexed.mColdCreate * 1000.0 / indexed.mColdRuns << " ms spread over object creation" << std::endl;
+	}
+	else
+	{
+		std::cout << "Arrival, cold : not measured, the page cache can not be dropped on this platform" << std::endl;
+	}
+	std::cout << "Arrival, warm : legacy " << legacy.mWarm * 1000.0 / options.mIterations << " ms, indexed "
+		<< indexed.mWarm * 1000.0 / options.mIterations << " ms + "
+		<< indexed.mWarmCreate * 1000.0 / options.mIterations << " ms spread over object creation" << std::endl;
+	std::cout << "Departure : legacy " << legacy.mSave * 1000.0 / options.mIterations << " ms, indexed "
+		<< indexed.mSave * 1000.0 / options.mIterations << " ms" << std::endl;
+	if (!success)
+	{
+		std::cout << "Error: the cache files did not read back what was written" << std::endl;
+	}
+
+	LLFile::remove(legacy_filename);
+	LLFile::remove(indexed_filename);
+
+	// Cleanup and exit
+	ll_cleanup_apr();
+	return success ? 0 : 1;
+}
@@ -374,11 +374,27 @@ void LLTexLayerSet::deleteCaches()
 	}
 }
 
+//virtual
+S32 LLTexLayerSet::getEvictableImageMemory()
+{
+	S32 bytes = 0;
+	for (layer_list_t::iterator iter = mLayerList.begin(); iter != mLayerList.end(); iter++)
+	{
+		bytes += (*iter)->getCachedImageBytes();
+	}
+	for (layer_list_t::iterator iter = mMaskLayerList.begin(); iter != mMaskLayerList.end(); iter++)
+	{
+		bytes += (*iter)->getCachedImageBytes();
+	}
+	return bytes;
+}
+
 
 BOOL LLTexLayerSet::render( S32 x, S32 y, S32 width, S32 height, LLRenderTarget* bound_target )
 {
 	BOOL success = TRUE;
 	mIsVisible = TRUE;
+	mLastRenderTimer.reset();
 
 	if (mMaskLayerList.size() > 0)
 	{
@@ -1124,6 +1140,17 @@ void LLTexLayer::calculateTexLayerColor(const param_color_list_t &param_list, LL
 	}
 }
 
+/*virtual*/ S32 LLTexLayer::getCachedImageBytes() const
+{
+	S32 bytes = 0;
+	for (param_alpha_list_t::const_iterator iter = mParamAlphaList.begin();
+		 iter != mParamAlphaList.end(); iter++ )
+	{
+		bytes += (*iter)->getCachedImageBytes();
+	}
+	return bytes;
+}
+
 BOOL LLTexLayer::render(S32 x, S32 y, S32 width, S32 height, LLRenderTarget* bound_target)
 {
 	LLGLEnable color_mat(GL_COLOR_MATERIAL);
@@ -1873,6 +1900,21 @@ LLTexLayer* LLTexLayerTemplate::getLayer(U32 i) const
 	}
 }
 
+/*virtual*/ S32 LLTexLayerTemplate::getCachedImageBytes() const
+{
+	S32 bytes = 0;
+	U32 num_wearables = updateWearableCache();
+	for (U32 i = 0; i < num_wearables; i++)
+	{
+		LLTexLayer *layer = getLayer(i);
+		if (layer)
+		{
+			bytes += layer->getCachedImageBytes();
+		}
+	}
+	return bytes;
+}
+
 /*virtual*/ BOOL LLTexLayerTemplate::isInvisibleAlphaMask() const
 {
 	U32 num_wearables = updateWearableCache();
@@ -30,6 +30,8 @@
 #include <deque>
 #include "llglslshader.h"
 #include "llgltexture.h"
+#include "llframetimer.h"
+#include "llimagememory.h"
 #include "llavatarappearancedefines.h"
 #include "lltexlayerparams.h"
 
@@ -67,6 +69,7 @@ public:
 
 	virtual BOOL			render(S32 x, S32 y, S32 width, S32 height, LLRenderTarget* bound_target) = 0;
 	virtual void			deleteCaches() = 0;
+	virtual S32				getCachedImageBytes() const = 0; // decoded images freed by deleteCaches()
 	virtual BOOL			blendAlphaTexture(S32 x, S32 y, S32 width, S32 height) = 0;
 	virtual BOOL			isInvisibleAlphaMask() const = 0;
 
@@ -127,6 +130,7 @@ public:
 	/*virtual*/ void		gatherAlphaMasks(U8 *data, S32 originX, S32 originY, S32 width, S32 height, LLRenderTarget* bound_target);
 	/*virtual*/ void		setHasMorph(BOOL newval);
 	/*virtual*/ void		deleteCaches();
+	/*virtual*/ S32			getCachedImageBytes() const;
 	/*virtual*/ BOOL		isInvisibleAlphaMask() const;
 protected:
 	U32 					updateWearableCache() const;
@@ -155,6 +159,7 @@ public:
 	/*virtual*/ BOOL		render(S32 x, S32 y, S32 width, S32 height, LLRenderTarget* bound_target);
 
 	/*virtual*/ void		deleteCaches();
+	/*virtual*/ S32			getCachedImageBytes() const;
 	const U8*				getAlphaData() const;
 
 	BOOL					findNetColor(LLColor4* color) const;
@@ -183,7 +188,7 @@ protected:
 // An ordered set of texture layers that gets composited into a single texture.
 // Only exists for llvoavatarself.
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-class LLTexLayerSet
+class LLTexLayerSet : public LLImageMemoryHolder
 {
 	friend class LLTexLayerSetBuffer;
 public:
@@ -222,6 +227,12 @@ public:
 
 	virtual void				asLLSD(LLSD& sd) const;
 
+	// LLImageMemoryHolder, gives back the decoded static images of the layers
+	/*virtual*/ S32				getEvictableImageMemory();
+	/*virtual*/ F32				getImageMemoryIdleTime()	{ return mLastRenderTimer.getElapsedTimeF32(); }
+	/*virtual*/ F32				getImageMemoryCost()		{ return 2.f; }
+	/*virtual*/ void			evictImageMemory()			{ deleteCaches(); }
+
 protected:
 	typedef std::vector<LLTexLayerInterface *> layer_list_t;
 	layer_list_t				mLayerList;
@@ -232,6 +243,7 @@ protected:
 
 	LLAvatarAppearanceDefines::EBakedTextureIndex mBakedTexIndex;
 	const LLTexLayerSetInfo* 	mInfo;
+	LLFrameTimer				mLastRenderTimer;
 };
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -178,6 +178,11 @@ void LLTexLayerParamAlpha::deleteCaches()
 	mNeedsCreateTexture = FALSE;
 }
 
+S32 LLTexLayerParamAlpha::getCachedImageBytes() const
+{
+	return mStaticImageRaw.notNull() ? mStaticImageRaw->getDataSize() : 0;
+}
+
 BOOL LLTexLayerParamAlpha::getMultiplyBlend() const
 {
 	return ((LLTexLayerParamAlphaInfo *)getInfo())->mMultiplyBlend; 	
@@ -330,6 +335,7 @@ BOOL LLTexLayerParamAlpha::render(S32 x, S32 y, S32 width, S32 height)
 			// Applies domain and effective weight to data as it is decoded. Also resizes the raw image if needed.
 			mStaticImageRaw = NULL;
 			mStaticImageRaw = new LLImageRaw;
+			mStaticImageRaw->setMemoryCategory(LLImageMemory::BAKE);
 			mStaticImageTGA->decodeAndProcess(mStaticImageRaw, info->mDomain, effective_weight);
 			mNeedsCreateTexture = TRUE;			
 			LL_DEBUGS() << "Built Cached Alpha: " << info->mStaticImageFileName << ": (" << mStaticImageRaw->getWidth() << ", " << mStaticImageRaw->getHeight() << ") " << "Domain: " << info->mDomain << " Weight: " << effective_weight << LL_ENDL;
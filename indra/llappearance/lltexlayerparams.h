@@ -101,6 +101,7 @@ public:
 	BOOL					render( S32 x, S32 y, S32 width, S32 height );
 	BOOL					getSkip() const;
 	void					deleteCaches();
+	S32						getCachedImageBytes() const;
 	BOOL					getMultiplyBlend() const;
 
 private:
@@ -2168,14 +2168,27 @@ std::string zip_llsd(LLSD& data)
 }
 
 //decompress a block of LLSD from provided istream
-// not very efficient -- creats a copy of decompressed LLSD block in memory
-// and deserializes from that copy using LLSDSerialize
 LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is, S32 size)
 {
-	U8* result = NULL;
+	std::vector<U8> buffer;
 	U32 cur_size = 0;
-	z_stream strm;
-		
+	EZipRresult result = unzip(buffer, cur_size, is, size);
+	if (result != ZR_OK)
+	{
+		return result;
+	}
+	return parse_llsd(data, cur_size ? &buffer[0] : NULL, cur_size);
+}
+
+//inflate a zlib block from provided istream into buffer, growing it as needed
+LLUZipHelper::EZipRresult LLUZipHelper::unzip(std::vector<U8>& buffer, U32& out_size, std::istream& is, S32 size)
+{
+	out_size = 0;
+	if (size <= 0)
+	{
+		return ZR_DATA_ERROR;
+	}
+
 	const U32 CHUNK = 65536;
 
 	U8 *in = new(std::nothrow) U8[size];
@@ -2185,8 +2198,7 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 	}
 	is.read((char*) in, size); 
 
-	U8 out[CHUNK];
-		
+	z_stream strm;
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
@@ -2194,16 +2206,34 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 	strm.next_in = in;
 
 	S32 ret = inflateInit(&strm);
-	
+	if (ret != Z_OK)
+	{
+		delete [] in;
+		return ZR_MEM_ERROR;
+	}
+
+	U32 cur_size = 0;
 	do
 	{
-		strm.avail_out = CHUNK;
-		strm.next_out = out;
+		if (buffer.size() - cur_size < CHUNK)
+		{
+			try
+			{
+				buffer.resize(llmax((size_t)(cur_size + CHUNK), buffer.size() * 2));
+			}
+			catch (std::bad_alloc&)
+			{
+				inflateEnd(&strm);
+				delete [] in;
+				return ZR_MEM_ERROR;
+			}
+		}
+		strm.avail_out = buffer.size() - cur_size;
+		strm.next_out = &buffer[cur_size];
 		ret = inflate(&strm, Z_NO_FLUSH);
 		if (ret == Z_STREAM_ERROR)
 		{
 			inflateEnd(&strm);
-			free(result);
 			delete [] in;
 			return ZR_DATA_ERROR;
 		}
@@ -2215,28 +2245,12 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 		case Z_DATA_ERROR:
 		case Z_MEM_ERROR:
 			inflateEnd(&strm);
-			free(result);
 			delete [] in;
 			return ZR_MEM_ERROR;
 			break;
 		}
 
-		U32 have = CHUNK-strm.avail_out;
-
-		U8* new_result = (U8*)realloc(result, cur_size + have);
-		if (new_result == NULL)
-		{
-			inflateEnd(&strm);
-			if (result)
-			{
-				free(result);
-			}
-			delete[] in;
-			return ZR_MEM_ERROR;
-		}
-		result = new_result;
-		memcpy(result+cur_size, out, have);
-		cur_size += have;
+		cur_size = buffer.size() - strm.avail_out;
 
 	} while (ret == Z_OK);
 
@@ -2245,52 +2259,51 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 
 	if (ret != Z_STREAM_END)
 	{
-		free(result);
 		return ZR_DATA_ERROR;
 	}
 
-	//result now points to the decompressed LLSD block
-	{
-		std::istringstream istr;
-		// Since we are using this for meshes, data we are dealing with tend to be large.
-		// So string can potentially fail to allocate, make sure this won't cause problems
-		try
-		{
-			std::string res_str((char*)result, cur_size);
+	out_size = cur_size;
+	return ZR_OK;
+}
 
-			std::string deprecated_header("<? LLSD/Binary ?>");
+//deserialize an inflated block of binary LLSD
+LLUZipHelper::EZipRresult LLUZipHelper::parse_llsd(LLSD& data, const U8* buf, U32 size)
+{
+	std::istringstream istr;
+	// Since we are using this for meshes, data we are dealing with tend to be large.
+	// So string can potentially fail to allocate, make sure this won't cause problems
+	try
+	{
+		std::string res_str((const char*)buf, size);
 
-			if (res_str.substr(0, deprecated_header.size()) == deprecated_header)
-			{
-				res_str = res_str.substr(deprecated_header.size() + 1, cur_size);
-			}
-			cur_size = res_str.size();
+		std::string deprecated_header("<? LLSD/Binary ?>");
 
-			istr.str(res_str);
-		}
-#ifdef LL_WINDOWS
-		catch (std::length_error)
+		if (res_str.substr(0, deprecated_header.size()) == deprecated_header)
 		{
-			free(result);
-			return ZR_SIZE_ERROR;
-		}
-#endif
-		catch (std::bad_alloc&)
-		{
-			free(result);
-			return ZR_MEM_ERROR;
+			res_str = res_str.substr(deprecated_header.size() + 1, size);
 		}
+		size = res_str.size();
 
-		if (!LLSDSerialize::fromBinary(data, istr, cur_size, UNZIP_LLSD_MAX_DEPTH))
-		{
-			free(result);
-			return ZR_PARSE_ERROR;
-		}
+		istr.str(res_str);
+	}
+#ifdef LL_WINDOWS
+	catch (std::length_error)
+	{
+		return ZR_SIZE_ERROR;
+	}
+#endif
+	catch (std::bad_alloc&)
+	{
+		return ZR_MEM_ERROR;
 	}
 
-	free(result);
+	if (!LLSDSerialize::fromBinary(data, istr, size, UNZIP_LLSD_MAX_DEPTH))
+	{
+		return ZR_PARSE_ERROR;
+	}
 	return ZR_OK;
 }
+
 //This unzip function will only work with a gzip header and trailer - while the contents
 //of the actual compressed data is the same for either format (gzip vs zlib ), the headers
 //and trailers are different for the formats.
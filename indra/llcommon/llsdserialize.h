@@ -861,6 +861,11 @@ public:
     } EZipRresult;
     // return OK or reason for failure
     static EZipRresult unzip_llsd(LLSD& data, std::istream& is, S32 size);
+    // Inflates without parsing. buffer only ever grows, so callers that keep it around
+    // avoid reallocating for every block; out_size receives the inflated byte count.
+    static EZipRresult unzip(std::vector<U8>& buffer, U32& out_size, std::istream& is, S32 size);
+    // Deserializes a block inflated by unzip()
+    static EZipRresult parse_llsd(LLSD& data, const U8* buf, U32 size);
 };
 
 //dirty little zip functions -- yell at davep
@@ -0,0 +1,895 @@
+/**
+ * @file http_fetch_replay.cpp
+ * @brief Replay of a viewer fetch trace against core-http
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <vector>
+#if !defined(WIN32)
+#include <pthread.h>
+#endif
+
+#include "linden_common.h"
+
+#include "httpcommon.h"
+#include "httprequest.h"
+#include "httphandler.h"
+#include "httpresponse.h"
+#include "httpoptions.h"
+#include "httpheaders.h"
+#include "bufferarray.h"
+#include "_mutex.h"
+
+#include <curl/curl.h>
+#include <openssl/crypto.h>
+
+#include "lltimer.h"
+
+
+void init_curl();
+void term_curl();
+void ssl_thread_id_callback(CRYPTO_THREADID*);
+void ssl_locking_callback(int mode, int type, const char * file, int line);
+void usage(std::ostream & out);
+
+// Default command line settings, those of the viewer's texture
+// and mesh2 policy classes
+static int texture_concurrency(8);
+static int mesh_concurrency(8);
+static int highwater(1000);
+static int pipeline_depth(0);
+static std::string base_url;
+
+
+// What the trace says of one texture or mesh and what became
+// of it when replayed
+struct Asset
+{
+	Asset()
+		: mType('T'),
+		  mFetchTime(-1),
+		  mSize(0),
+		  mPriority(0.f),
+		  mRecordedFull(-1),
+		  mReplayedFull(-1),
+		  mLastXfer(-1)
+		{}
+
+	char			mType;				// 'T' or 'M'
+	std::string		mID;
+	S64				mFetchTime;			// first fetch or get, -1 if none yet
+	U32				mSize;				// bytes the server has for it
+	F32				mPriority;			// as of the replay clock
+	S64				mRecordedFull;		// end of the last successful transfer, -1 if none
+	S64				mReplayedFull;
+	int				mLastXfer;			// last transfer seen while loading
+};
+
+
+// One HTTP transfer of the trace
+struct Transfer
+{
+	enum EState
+	{
+		WAITING,						// not due yet
+		READY,							// due, waiting for room under the high-water mark
+		ACTIVE,
+		FINISHED
+	};
+
+	Transfer()
+		: mAsset(-1),
+		  mOffset(0),
+		  mSize(0),
+		  mHttpPriority(0),
+		  mGetTime(0),
+		  mDoneTime(-1),
+		  mCancelTime(-1),
+		  mOK(false),
+		  mBytes(0),
+		  mPrev(-1),
+		  mGap(0),
+		  mState(WAITING),
+		  mHandle(LLCORE_HTTP_HANDLE_INVALID),
+		  mIssueTime(0),
+		  mReplayDone(-1),
+		  mReplayOK(false),
+		  mReplayBytes(0),
+		  mCancelled(false)
+		{}
+
+	// Recorded
+	int					mAsset;
+	U32					mOffset;
+	U32					mSize;			// 0 to the end of the asset
+	U32					mHttpPriority;
+	S64					mGetTime;
+	S64					mDoneTime;		// -1 if cancelled or unfinished
+	S64					mCancelTime;	// -1 if not cancelled
+	bool				mOK;
+	U32					mBytes;
+	int					mPrev;			// transfer of the same asset this one followed, -1 if none
+	S64					mGap;			// from the end of mPrev to this get
+
+	// Replayed
+	EState				mState;
+	LLCore::HttpHandle	mHandle;
+	S64					mIssueTime;
+	S64					mReplayDone;
+	bool				mReplayOK;
+	U32					mReplayBytes;
+	bool				mCancelled;		// cancel issued
+};
+
+
+// Trace events other than transfers, in time order
+struct Event
+{
+	S64					mTime;
+	int					mAsset;
+	F32					mPriority;
+};
+
+
+class Replay : public LLCore::HttpHandler
+{
+public:
+	Replay();
+
+	bool load(FILE * in);
+	bool run(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & opt);
+	void report(std::ostream & out);
+
+	virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response);
+
+	typedef std::vector<Asset> asset_list_t;
+	typedef std::vector<Transfer> transfer_list_t;
+	typedef std::vector<Event> event_list_t;
+	typedef std::map<std::string, int> asset_map_t;
+	typedef std::map<U32, int> xfer_map_t;
+	typedef std::map<LLCore::HttpHandle, int> handle_map_t;
+
+	bool						mVerbose;
+	LLCore::HttpRequest::policy_t	mTexturePolicy;
+	LLCore::HttpRequest::policy_t	mMeshPolicy;
+
+protected:
+	int findAsset(char type, const char * id);
+	bool isDue(const Transfer & xfer, S64 now) const;
+	void issue(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & opt, int index, S64 now);
+	S64 getTime() const;
+
+	void reportTimes(std::ostream & out, const char * label, bool replayed);
+
+	asset_list_t				mAssets;
+	transfer_list_t				mTransfers;
+	event_list_t				mEvents;
+	asset_map_t					mAssetMap;
+	handle_map_t				mHandles;
+	std::vector<int>			mPending;			// transfers past their get time, not active yet
+	size_t						mNextEvent;
+	size_t						mNextXfer;
+	U64							mStartTime;
+	S64							mTraceStart;		// time of the first event
+	S64							mWallTime;
+	int							mFailures;
+	LLCore::HttpHeaders::ptr_t	mHeaders;
+};
+
+
+//
+//
+//
+int main(int argc, char** argv)
+{
+	const char * trace_name(NULL);
+	bool do_verbose(false);
+
+	for (int i(1); i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if (arg == "-h" || arg == "-?")
+		{
+			usage(std::cout);
+			return 0;
+		}
+		else if (arg == "-v")
+		{
+			do_verbose = true;
+		}
+		else if ((arg == "-u" || arg == "-c" || arg == "-m" || arg == "-H" || arg == "-p") && i + 1 < argc)
+		{
+			const char * value_str(argv[++i]);
+			if (arg == "-u")
+			{
+				base_url = value_str;
+				continue;
+			}
+
+			char * end;
+			unsigned long value(strtoul(value_str, &end, 10));
+			if (*end != '\0' || value > 1000 || (value < 1 && arg != "-p"))
+			{
+				usage(std::cerr);
+				return 1;
+			}
+			if (arg == "-c")
+			{
+				texture_concurrency = value;
+			}
+			else if (arg == "-m")
+			{
+				mesh_concurrency = value;
+			}
+			else if (arg == "-H")
+			{
+				highwater = value;
+			}
+			else
+			{
+				pipeline_depth = value;
+			}
+		}
+		else if (arg[0] != '-' && ! trace_name)
+		{
+			trace_name = argv[i];
+		}
+		else
+		{
+			usage(std::cerr);
+			return 1;
+		}
+	}
+
+	if (base_url.empty())
+	{
+		// Set by http_fetch_replay_peer.py
+		const char * port(getenv("LL_TEST_PORT"));
+		if (port)
+		{
+			base_url = std::string("http://127.0.0.1:") + port;
+		}
+	}
+	if (! trace_name || base_url.empty())
+	{
+		usage(std::cerr);
+		return 1;
+	}
+
+	FILE * trace(fopen(trace_name, "r"));
+	if (! trace)
+	{
+		const char * errstr(strerror(errno));
+
+		std::cerr << "Couldn't open trace file '" << trace_name << "'.  Reason:  "
+				  << errstr << std::endl;
+		return 1;
+	}
+
+	Replay replay;
+	replay.mVerbose = do_verbose;
+	bool loaded(replay.load(trace));
+	fclose(trace);
+	if (! loaded)
+	{
+		std::cerr << "No transfers found in trace file '" << trace_name << "'." << std::endl;
+		return 1;
+	}
+
+	// Initialization
+	init_curl();
+	LLCore::HttpRequest::createService();
+	replay.mTexturePolicy = LLCore::HttpRequest::createPolicyClass();
+	replay.mMeshPolicy = LLCore::HttpRequest::createPolicyClass();
+	LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
+											   replay.mTexturePolicy,
+											   texture_concurrency,
+											   NULL);
+	LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+											   replay.mTexturePolicy,
+											   texture_concurrency,
+											   NULL);
+	LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
+											   replay.mMeshPolicy,
+											   mesh_concurrency,
+											   NULL);
+	LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+											   replay.mMeshPolicy,
+											   mesh_concurrency,
+											   NULL);
+	if (pipeline_depth)
+	{
+		LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PIPELINING_DEPTH,
+												   replay.mTexturePolicy,
+												   pipeline_depth,
+												   NULL);
+		LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PIPELINING_DEPTH,
+												   replay.mMeshPolicy,
+												   pipeline_depth,
+												   NULL);
+	}
+	LLCore::HttpRequest::startThread();
+
+	// Get service point
+	LLCore::HttpRequest * hr = new LLCore::HttpRequest();
+
+	// Get request options
+	LLCore::HttpOptions::ptr_t opt = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions());
+	opt->setRetries(12);
+	opt->setUseRetryAfter(true);
+
+	// Run it
+	while (! replay.run(hr, opt))
+	{
+		hr->update(0);
+		ms_sleep(1);
+	}
+
+	// Report
+	replay.report(std::cout);
+
+	// Clean up
+	hr->requestStopThread(LLCore::HttpHandler::ptr_t());
+	ms_sleep(1000);
+    opt.reset();
+	delete hr;
+	LLCore::HttpRequest::destroyService();
+	term_curl();
+
+    return 0;
+}
+
+
+void usage(std::ostream & out)
+{
+	out << "\n"
+		"usage:\thttp_fetch_replay [options]  trace_file\n"
+		"\n"
+		"Replays the texture and mesh transfers of a viewer session, as\n"
+		"recorded with the FetchTraceRecord setting, against a local server\n"
+		"standing in for the grid.  Run it under http_fetch_replay_peer.py,\n"
+		"which serves assets from a directory or bytes of the recorded size.\n"
+		"\n"
+		"Only the HTTP layer is replayed:  nothing is decoded or cached and\n"
+		"the viewer's texture and mesh priority logic does not run, the\n"
+		"recorded priorities and cancels stand in for it.\n"
+		"\n"
+		"Each transfer is issued at its recorded time, or as long after the\n"
+		"end of the previous transfer of the same asset as it was recorded,\n"
+		"whichever is later.  Due transfers are fed to llcorehttp highest\n"
+		"asset priority first, following the recorded priority changes.\n"
+		"Transfers the viewer cancelled are cancelled as long after their\n"
+		"start as they were.\n"
+		"\n"
+		"Reported for the recording and the replay:  bytes fetched, time\n"
+		"from the first request for an asset to the end of its last\n"
+		"transfer (the resolution the session ended up wanting), and the\n"
+		"transfer volume the viewer dropped.\n"
+		"\n"
+		"Options:\n"
+		"\n"
+		" -u <url>              Base URL of the server.  Default: http://127.0.0.1:$LL_TEST_PORT\n"
+		" -c <limit>            Texture connection concurrency.  Default:  " << texture_concurrency << "\n"
+		" -m <limit>            Mesh connection concurrency.  Default:  " << mesh_concurrency << "\n"
+		" -H <limit>            Transfers fed to llcorehttp at a time.  Default:  " << highwater << "\n"
+		" -p <depth>            If <depth> is positive, enables and sets pipelining\n"
+		"                       depth on HTTP requests.  Default:  " << pipeline_depth << "\n"
+		" -v                    Verbose mode.  Issue some chatter while running\n"
+		" -h                    print this help\n"
+		"\n"
+		<< std::endl;
+}
+
+
+Replay::Replay()
+	: LLCore::HttpHandler(),
+	  mVerbose(false),
+	  mTexturePolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
+	  mMeshPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
+	  mNextEvent(0),
+	  mNextXfer(0),
+	  mStartTime(0),
+	  mTraceStart(-1),
+	  mWallTime(0),
+	  mFailures(0)
+{
+	mHeaders = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders);
+}
+
+
+int Replay::findAsset(char type, const char * id)
+{
+	std::string key(1, type);
+	key += id;
+	asset_map_t::iterator it(mAssetMap.find(key));
+	if (mAssetMap.end() != it)
+	{
+		return it->second;
+	}
+
+	Asset asset;
+	asset.mType = type;
+	asset.mID = id;
+	mAssets.push_back(asset);
+	mAssetMap[key] = mAssets.size() - 1;
+	return mAssets.size() - 1;
+}
+
+
+bool Replay::load(FILE * in)
+{
+	xfer_map_t xfers;
+	char line[512];
+
+	while (fgets(line, sizeof(line), in))
+	{
+		long long time;
+		char kind[16], type;
+		char id[64];
+		unsigned int xfer;
+		if ('#' == line[0] || 2 != sscanf(line, "%lld %15s", &time, kind))
+		{
+			continue;
+		}
+		if (mTraceStart < 0)
+		{
+			mTraceStart = time;
+		}
+
+		if (! strcmp(kind, "fetch") || ! strcmp(kind, "prio"))
+		{
+			float priority;
+			if (3 == sscanf(line, "%*lld %*s %c %63s %f", &type, id, &priority))
+			{
+				Event event;
+				event.mTime = time;
+				event.mAsset = findAsset(type, id);
+				event.mPriority = priority;
+				mEvents.push_back(event);
+
+				Asset & asset(mAssets[event.mAsset]);
+				if (asset.mFetchTime < 0)
+				{
+					asset.mFetchTime = time;
+				}
+			}
+		}
+		else if (! strcmp(kind, "get"))
+		{
+			unsigned int offset, size, priority;
+			if (6 == sscanf(line, "%*lld %*s %u %c %63s %u %u %u", &xfer, &type, id, &offset, &size, &priority))
+			{
+				Transfer transfer;
+				transfer.mAsset = findAsset(type, id);
+				transfer.mOffset = offset;
+				transfer.mSize = size;
+				transfer.mHttpPriority = priority;
+				transfer.mGetTime = time;
+
+				Asset & asset(mAssets[transfer.mAsset]);
+				if (asset.mFetchTime < 0)
+				{
+					asset.mFetchTime = time;
+				}
+				asset.mSize = (std::max)(asset.mSize, offset + size);
+
+				// Follow on from the last transfer of the asset if it
+				// had ended, the viewer may have waited for it
+				if (asset.mLastXfer >= 0 && mTransfers[asset.mLastXfer].mDoneTime >= 0)
+				{
+					transfer.mPrev = asset.mLastXfer;
+					transfer.mGap = time - mTransfers[asset.mLastXfer].mDoneTime;
+				}
+				asset.mLastXfer = mTransfers.size();
+				xfers[xfer] = mTransfers.size();
+				mTransfers.push_back(transfer);
+			}
+		}
+		else if (! strcmp(kind, "done"))
+		{
+			int ok;
+			char status[64];
+			unsigned int bytes, asset_size;
+			if (5 == sscanf(line, "%*lld %*s %u %d %63s %u %u", &xfer, &ok, status, &bytes, &asset_size)
+				&& xfers.count(xfer))
+			{
+				Transfer & transfer(mTransfers[xfers[xfer]]);
+				transfer.mDoneTime = time;
+				transfer.mOK = ok != 0;
+				transfer.mBytes = bytes;
+
+				Asset & asset(mAssets[transfer.mAsset]);
+				if (asset_size)
+				{
+					asset.mSize = asset_size;
+				}
+				if (transfer.mOK)
+				{
+					asset.mRecordedFull = time;
+				}
+			}
+		}
+		else if (! strcmp(kind, "cancel"))
+		{
+			if (1 == sscanf(line, "%*lld %*s %u", &xfer) && xfers.count(xfer))
+			{
+				mTransfers[xfers[xfer]].mCancelTime = time;
+			}
+		}
+	}
+
+	// Transfers still in flight when the recording stopped are dropped
+	for (transfer_list_t::iterator it(mTransfers.begin()); mTransfers.end() != it; ++it)
+	{
+		if (it->mDoneTime < 0 && it->mCancelTime < 0)
+		{
+			it->mState = Transfer::FINISHED;
+			it->mReplayDone = -1;
+		}
+	}
+
+	return ! mTransfers.empty();
+}
+
+
+S64 Replay::getTime() const
+{
+	return S64(LLTimer::getTotalTime() - mStartTime) + mTraceStart;
+}
+
+
+// Transfers follow on from the previous transfer of their asset as they
+// did in the recording, or are issued at their recorded time
+bool Replay::isDue(const Transfer & xfer, S64 now) const
+{
+	if (now < xfer.mGetTime)
+	{
+		return false;
+	}
+	if (xfer.mPrev < 0)
+	{
+		return true;
+	}
+	const Transfer & prev(mTransfers[xfer.mPrev]);
+	return Transfer::FINISHED == prev.mState
+		&& (prev.mReplayDone < 0 || now >= prev.mReplayDone + xfer.mGap);
+}
+
+
+namespace
+{
+    void NoOpDeletor(LLCore::HttpHandler *)
+    { /*NoOp*/ }
+}
+
+void Replay::issue(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & opt, int index, S64 now)
+{
+	Transfer & xfer(mTransfers[index]);
+	Asset & asset(mAssets[xfer.mAsset]);
+
+	char url[1024];
+	snprintf(url, sizeof(url), "%s/%s/%s?size=%u", base_url.c_str(),
+			 'M' == asset.mType ? "mesh" : "texture", asset.mID.c_str(), asset.mSize);
+
+	LLCore::HttpHandle handle;
+	if (xfer.mOffset || xfer.mSize)
+	{
+		handle = hr->requestGetByteRange('M' == asset.mType ? mMeshPolicy : mTexturePolicy,
+										 xfer.mHttpPriority,
+										 url,
+										 xfer.mOffset,
+										 xfer.mSize,
+										 opt,
+										 mHeaders,
+										 LLCore::HttpHandler::ptr_t(this, NoOpDeletor));
+	}
+	else
+	{
+		handle = hr->requestGet('M' == asset.mType ? mMeshPolicy : mTexturePolicy,
+								xfer.mHttpPriority,
+								url,
+								opt,
+								mHeaders,
+								LLCore::HttpHandler::ptr_t(this, NoOpDeletor));
+	}
+	if (! handle)
+	{
+		// Fatal.  Couldn't queue up something.
+		std::cerr << "Failed to queue work to HTTP Service.  Reason:  "
+				  << hr->getStatus().toString() << std::endl;
+		exit(1);
+	}
+
+	xfer.mState = Transfer::ACTIVE;
+	xfer.mHandle = handle;
+	xfer.mIssueTime = now;
+	mHandles[handle] = index;
+}
+
+
+bool Replay::run(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & opt)
+{
+	if (! mStartTime)
+	{
+		mStartTime = LLTimer::getTotalTime();
+	}
+	S64 now(getTime());
+
+	// Priorities as of now
+	for (; mNextEvent < mEvents.size() && mEvents[mNextEvent].mTime <= now; ++mNextEvent)
+	{
+		mAssets[mEvents[mNextEvent].mAsset].mPriority = mEvents[mNextEvent].mPriority;
+	}
+
+	for (; mNextXfer < mTransfers.size() && mTransfers[mNextXfer].mGetTime <= now; ++mNextXfer)
+	{
+		if (Transfer::WAITING == mTransfers[mNextXfer].mState)
+		{
+			mPending.push_back(mNextXfer);
+		}
+	}
+
+	// Feed the due transfers of the highest priority assets
+	std::vector<std::pair<F32, int> > due;
+	for (std::vector<int>::iterator it(mPending.begin()); mPending.end() != it; ++it)
+	{
+		if (isDue(mTransfers[*it], now))
+		{
+			mTransfers[*it].mState = Transfer::READY;
+			due.push_back(std::make_pair(-mAssets[mTransfers[*it].mAsset].mPriority, *it));
+		}
+	}
+	std::sort(due.begin(), due.end());
+	for (size_t i(0); i < due.size() && int(mHandles.size()) < highwater; ++i)
+	{
+		issue(hr, opt, due[i].second, now);
+	}
+	for (std::vector<int>::iterator it(mPending.begin()); mPending.end() != it; )
+	{
+		if (Transfer::ACTIVE == mTransfers[*it].mState)
+		{
+			it = mPending.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// Drop what the viewer dropped, as long after the start as it did
+	for (handle_map_t::iterator it(mHandles.begin()); mHandles.end() != it; ++it)
+	{
+		Transfer & xfer(mTransfers[it->second]);
+		if (xfer.mCancelTime >= 0 && ! xfer.mCancelled
+			&& now >= xfer.mIssueTime + (xfer.mCancelTime - xfer.mGetTime))
+		{
+			hr->requestCancel(it->first, LLCore::HttpHandler::ptr_t());
+			xfer.mCancelled = true;
+		}
+	}
+
+	if (mVerbose)
+	{
+		static S64 last_report(0);
+		if (now - last_report > 5000000)
+		{
+			last_report = now;
+			std::cout << "At " << (now - mTraceStart) / 1000 << " ms:  " << mNextXfer << " of "
+					  << mTransfers.size() << " transfers due, " << mHandles.size()
+					  << " active, " << mPending.size() << " waiting" << std::endl;
+		}
+	}
+
+	// Are we done?
+	if (mNextXfer < mTransfers.size() || ! mPending.empty() || ! mHandles.empty())
+	{
+		return false;
+	}
+	mWallTime = now - mTraceStart;
+	return true;
+}
+
+
+void Replay::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response)
+{
+	handle_map_t::iterator it(mHandles.find(handle));
+	if (mHandles.end() == it)
+	{
+		// Wha?
+		std::cerr << "Failed to find handle in request list.  Fatal." << std::endl;
+		exit(1);
+	}
+
+	Transfer & xfer(mTransfers[it->second]);
+	LLCore::HttpStatus status(response->getStatus());
+	xfer.mState = Transfer::FINISHED;
+	xfer.mReplayDone = getTime();
+	xfer.mReplayOK = status;
+	xfer.mReplayBytes = response->getBodySize();
+	if (xfer.mReplayOK && xfer.mCancelTime < 0)
+	{
+		mAssets[xfer.mAsset].mReplayedFull = xfer.mReplayDone;
+	}
+	else if (! xfer.mReplayOK && ! xfer.mCancelled)
+	{
+		++mFailures;
+	}
+	mHandles.erase(it);
+}
+
+
+// Percentiles of the time from the first request for an asset to the end
+// of its last successful transfer
+void Replay::reportTimes(std::ostream & out, const char * label, bool replayed)
+{
+	std::vector<S64> times;
+	for (asset_list_t::iterator it(mAssets.begin()); mAssets.end() != it; ++it)
+	{
+		S64 full(replayed ? it->mReplayedFull : it->mRecordedFull);
+		if (full >= 0)
+		{
+			times.push_back(full - it->mFetchTime);
+		}
+	}
+	if (times.empty())
+	{
+		return;
+	}
+
+	std::sort(times.begin(), times.end());
+	out << label << " time to full res (ms, " << times.size() << " assets):  p50 "
+		<< times[times.size() / 2] / 1000 << "  p90 " << times[times.size() * 9 / 10] / 1000
+		<< "  p99 " << times[times.size() * 99 / 100] / 1000 << "  max " << times.back() / 1000
+		<< std::endl;
+}
+
+
+void Replay::report(std::ostream & out)
+{
+	U64 recorded_bytes(0), replayed_bytes(0);
+	U64 recorded_cancels(0), recorded_dropped(0);
+	U64 replayed_cancels(0), replayed_dropped(0), replayed_wasted(0);
+	int recorded_failures(0);
+	S64 recorded_end(mTraceStart);
+
+	for (transfer_list_t::iterator it(mTransfers.begin()); mTransfers.end() != it; ++it)
+	{
+		const Asset & asset(mAssets[it->mAsset]);
+
+		// Cancelled transfers dropped up to the rest of their range
+		U32 range(asset.mSize > it->mOffset ? asset.mSize - it->mOffset : 0);
+		if (it->mSize)
+		{
+			range = (std::min)(range, it->mSize);
+		}
+
+		recorded_end = (std::max)(recorded_end, (std::max)(it->mDoneTime, it->mCancelTime));
+		if (it->mCancelTime >= 0)
+		{
+			++recorded_cancels;
+			recorded_dropped += range;
+		}
+		else if (it->mOK)
+		{
+			recorded_bytes += it->mBytes;
+		}
+		else if (it->mDoneTime >= 0)
+		{
+			++recorded_failures;
+		}
+
+		if (it->mReplayOK)
+		{
+			replayed_bytes += it->mReplayBytes;
+			if (it->mCancelTime >= 0)
+			{
+				// Arrived before the cancel but the viewer
+				// dropped the asset anyway
+				replayed_wasted += it->mReplayBytes;
+			}
+		}
+		else if (it->mCancelled)
+		{
+			++replayed_cancels;
+			replayed_dropped += range;
+		}
+	}
+
+	out << "Recorded:  " << mTransfers.size() << " transfers, " << recorded_bytes << " bytes fetched, "
+		<< recorded_failures << " failed, over " << (recorded_end - mTraceStart) / 1000 << " ms" << std::endl;
+	out << "Recorded:  " << recorded_cancels << " transfers cancelled in flight, up to "
+		<< recorded_dropped << " bytes wasted" << std::endl;
+	reportTimes(out, "Recorded: ", false);
+
+	out << "Replayed:  " << replayed_bytes << " bytes fetched, " << mFailures << " failed, over "
+		<< mWallTime / 1000 << " ms" << std::endl;
+	out << "Replayed:  " << replayed_cancels << " transfers cancelled in flight, up to "
+		<< replayed_dropped << " bytes wasted, " << replayed_wasted
+		<< " bytes of cancelled transfers received" << std::endl;
+	reportTimes(out, "Replayed: ", true);
+}
+
+
+int ssl_mutex_count(0);
+LLCoreInt::HttpMutex ** ssl_mutex_list = NULL;
+
+void init_curl()
+{
+	curl_global_init(CURL_GLOBAL_ALL);
+
+	ssl_mutex_count = CRYPTO_num_locks();
+	if (ssl_mutex_count > 0)
+	{
+		ssl_mutex_list = new LLCoreInt::HttpMutex * [ssl_mutex_count];
+
+		for (int i(0); i < ssl_mutex_count; ++i)
+		{
+			ssl_mutex_list[i] = new LLCoreInt::HttpMutex;
+		}
+
+		CRYPTO_set_locking_callback(ssl_locking_callback);
+		CRYPTO_THREADID_set_callback(ssl_thread_id_callback);
+	}
+}
+
+
+void term_curl()
+{
+	CRYPTO_set_locking_callback(NULL);
+	for (int i(0); i < ssl_mutex_count; ++i)
+	{
+		delete ssl_mutex_list[i];
+	}
+	delete [] ssl_mutex_list;
+}
+
+
+void ssl_thread_id_callback(CRYPTO_THREADID* pthreadid)
+{
+#if defined(WIN32)
+	CRYPTO_THREADID_set_pointer(pthreadid, GetCurrentThread());
+#else
+	CRYPTO_THREADID_set_pointer(pthreadid, pthread_self());
+#endif
+}
+
+
+void ssl_locking_callback(int mode, int type, const char * /* file */, int /* line */)
+{
+	if (type >= 0 && type < ssl_mutex_count)
+	{
+		if (mode & CRYPTO_LOCK)
+		{
+			ssl_mutex_list[type]->lock();
+		}
+		else
+		{
+			ssl_mutex_list[type]->unlock();
+		}
+	}
+}
@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+"""\
+@file   http_fetch_replay_peer.py
+@brief  Runs the executable (with args) specified on the command line,
+        typically http_fetch_replay, while serving texture and mesh
+        assets over HTTP in place of the grid.
+
+$LicenseInfo:firstyear=2026&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2026, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+import os
+import re
+import sys
+import time
+import getopt
+import urlparse
+from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+from SocketServer import ThreadingMixIn
+
+# we're in llcorehttp/examples ; testrunner.py is found in llmessage/tests
+sys.path.append(os.path.join(os.path.dirname(__file__), os.pardir, os.pardir,
+                             "llmessage", "tests"))
+
+from testrunner import freeport, run, debug
+
+# Served when an asset is not in the asset directory
+FILLER = ''.join(chr(i % 251) for i in xrange(65536))
+
+class AssetRequestHandler(BaseHTTPRequestHandler):
+    """Serves '/texture/<id>?size=<bytes>' and '/mesh/<id>?size=<bytes>'
+    with Range support, like the grid's ViewerAsset service.
+
+    The body is the file <id>.texture or <id>.mesh of the asset directory
+    when there is one, else <bytes> bytes of filler so that transfers are
+    the size they were when the trace was recorded.
+    """
+    protocol_version = "HTTP/1.1"
+
+    asset_dir = None
+    latency = 0.0
+
+    def do_GET(self):
+        url = urlparse.urlparse(self.path)
+        parts = url.path.strip('/').split('/')
+        if len(parts) != 2 or parts[0] not in ("texture", "mesh"):
+            self.send_error(404)
+            return
+
+        data = None
+        if self.asset_dir:
+            filename = os.path.join(self.asset_dir, "%s.%s" % (parts[1], parts[0]))
+            if os.path.exists(filename):
+                with open(filename, "rb") as f:
+                    data = f.read()
+        if data is None:
+            query = urlparse.parse_qs(url.query)
+            size = int(query.get("size", ["0"])[0])
+            data = (FILLER * (size // len(FILLER) + 1))[:size]
+
+        if self.latency:
+            time.sleep(self.latency)
+
+        match = re.match(r"bytes=(\d+)-(\d*)$", self.headers.getheader("Range") or "")
+        if not match:
+            self.answer(200, data)
+            return
+
+        first = int(match.group(1))
+        last = int(match.group(2)) if match.group(2) else len(data) - 1
+        last = min(last, len(data) - 1)
+        if first >= len(data):
+            self.send_response(416)
+            self.send_header("Content-Range", "bytes */%d" % len(data))
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+        self.answer(206, data[first:last + 1],
+                    "bytes %d-%d/%d" % (first, last, len(data)))
+
+    def answer(self, status, data, content_range=None):
+        self.send_response(status)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(len(data)))
+        if content_range:
+            self.send_header("Content-Range", content_range)
+        self.end_headers()
+        self.wfile.write(data)
+
+    def log_request(self, code, size=None):
+        # One line per transfer would drown the replay's report
+        pass
+
+    def log_error(self, format, *args):
+        pass
+
+class Server(ThreadingMixIn, HTTPServer):
+    # This pernicious flag is on by default in HTTPServer. But proper
+    # operation of freeport() absolutely depends on it being off.
+    allow_reuse_address = False
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        # Connections dropped by cancelled transfers are expected
+        pass
+
+if __name__ == "__main__":
+    options, args = getopt.getopt(sys.argv[1:], "d:l:", ["assets=", "latency="])
+    for option, value in options:
+        if option in ("-d", "--assets"):
+            AssetRequestHandler.asset_dir = value
+        elif option in ("-l", "--latency"):
+            # milliseconds added to each response
+            AssetRequestHandler.latency = float(value) / 1000.0
+
+    if not args:
+        sys.exit("usage: %s [-d asset_dir] [-l latency_ms] http_fetch_replay [options] trace_file"
+                 % sys.argv[0])
+
+    make_server = lambda port: Server(('127.0.0.1', port), AssetRequestHandler)
+
+    if not sys.platform.startswith("win"):
+        httpd = make_server(0)
+    else:
+        httpd, port = freeport(xrange(8000, 8020), make_server)
+
+    # Pass the selected port number to http_fetch_replay via the environment
+    os.environ["LL_TEST_PORT"] = str(httpd.server_port)
+    debug("$LL_TEST_PORT = %s", httpd.server_port)
+    sys.exit(run(server_inst=httpd, use_path=True, *args))
@@ -803,17 +803,19 @@ U8* LLImageBase::allocateDataSize(S32 width, S32 height, S32 ncomponents, S32 si
 // LLImageRaw
 //---------------------------------------------------------------------------
 
-S32 LLImageRaw::sGlobalRawMemory = 0;
-S32 LLImageRaw::sRawImageCount = 0;
+LLAtomicS32 LLImageRaw::sGlobalRawMemory(0);
+LLAtomicS32 LLImageRaw::sRawImageCount(0);
 
 LLImageRaw::LLImageRaw()
-	: LLImageBase()
+	: LLImageBase(),
+	  mMemoryCategory(LLImageMemory::OTHER)
 {
 	++sRawImageCount;
 }
 
 LLImageRaw::LLImageRaw(U16 width, U16 height, S8 components)
-	: LLImageBase()
+	: LLImageBase(),
+	  mMemoryCategory(LLImageMemory::OTHER)
 {
 	//llassert( S32(width) * S32(height) * S32(components) <= MAX_IMAGE_DATA_SIZE );
 	allocateDataSize(width, height, components);
@@ -821,7 +823,8 @@ LLImageRaw::LLImageRaw(U16 width, U16 height, S8 components)
 }
 
 LLImageRaw::LLImageRaw(U8 *data, U16 width, U16 height, S8 components, bool no_copy)
-	: LLImageBase()
+	: LLImageBase(),
+	  mMemoryCategory(LLImageMemory::OTHER)
 {
 	if(no_copy)
 	{
@@ -853,6 +856,7 @@ U8* LLImageRaw::allocateData(S32 size)
 {
 	U8* res = LLImageBase::allocateData(size);
 	sGlobalRawMemory += getDataSize();
+	LLImageMemory::addBytes(mMemoryCategory, getDataSize());
 	return res;
 }
 
@@ -860,8 +864,10 @@ U8* LLImageRaw::allocateData(S32 size)
 U8* LLImageRaw::reallocateData(S32 size)
 {
 	sGlobalRawMemory -= getDataSize();
+	LLImageMemory::addBytes(mMemoryCategory, -getDataSize());
 	U8* res = LLImageBase::reallocateData(size);
 	sGlobalRawMemory += getDataSize();
+	LLImageMemory::addBytes(mMemoryCategory, getDataSize());
 	return res;
 }
 
@@ -869,9 +875,21 @@ U8* LLImageRaw::reallocateData(S32 size)
 void LLImageRaw::deleteData()
 {
 	sGlobalRawMemory -= getDataSize();
+	LLImageMemory::addBytes(mMemoryCategory, -getDataSize());
 	LLImageBase::deleteData();
 }
 
+void LLImageRaw::setMemoryCategory(S32 category)
+{
+	llassert(category >= 0 && category < LLImageMemory::NUM_CATEGORIES);
+	if (category != mMemoryCategory)
+	{
+		LLImageMemory::addBytes(mMemoryCategory, -getDataSize());
+		mMemoryCategory = category;
+		LLImageMemory::addBytes(mMemoryCategory, getDataSize());
+	}
+}
+
 void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components) 
 { 
 	if(data == getData())
@@ -885,6 +903,7 @@ void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components)
 	LLImageBase::setDataAndSize(data, width * height * components) ;
 	
 	sGlobalRawMemory += getDataSize();
+	LLImageMemory::addBytes(mMemoryCategory, getDataSize());
 }
 
 bool LLImageRaw::resize(U16 width, U16 height, S8 components)
@@ -1918,7 +1937,7 @@ bool LLImageRaw::createFromFile(const std::string &filename, bool j2c_lowest_mip
 //---------------------------------------------------------------------------
 
 //static
-S32 LLImageFormatted::sGlobalFormattedMemory = 0;
+LLAtomicS32 LLImageFormatted::sGlobalFormattedMemory(0);
 
 LLImageFormatted::LLImageFormatted(S8 codec)
 	: LLImageBase(),
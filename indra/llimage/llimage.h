@@ -31,6 +31,8 @@
 #include "llstring.h"
 #include "llpointer.h"
 #include "lltrace.h"
+#include "llatomic.h"
+#include "llimagememory.h"
 
 const S32 MIN_IMAGE_MIP =  2; // 4x4, only used for expand/contract power of 2
 const S32 MAX_IMAGE_MIP = 11; // 2048x2048
@@ -195,6 +197,11 @@ public:
 	
 	bool resize(U16 width, U16 height, S8 components);
 
+	// Category of LLImageMemory the data of this image counts in.  Set by
+	// the holder of the image, on the thread that owns it.
+	void setMemoryCategory(S32 category);
+	S32 getMemoryCategory() const { return mMemoryCategory; }
+
 	//U8 * getSubImage(U32 x_pos, U32 y_pos, U32 width, U32 height) const;
 	bool setSubImage(U32 x_pos, U32 y_pos, U32 width, U32 height,
 					 const U8 *data, U32 stride = 0, bool reverse_y = false);
@@ -270,11 +277,14 @@ protected:
 	void setDataAndSize(U8 *data, S32 width, S32 height, S8 components) ;
 
 public:
-	static S32 sGlobalRawMemory;
-	static S32 sRawImageCount;
+	// Updated from the decode threads as well as the main thread
+	static LLAtomicS32 sGlobalRawMemory;
+	static LLAtomicS32 sRawImageCount;
 
 private:
 	bool validateSrcAndDst(std::string func, LLImageRaw* src, LLImageRaw* dst);
+
+	S8 mMemoryCategory;
 };
 
 // Compressed representation of image.
@@ -323,6 +333,8 @@ public:
 	virtual bool decode(LLImageRaw* raw_image, F32 decode_time) = 0;  
 	// Subclasses that can handle more than 4 channels should override this function.
 	virtual bool decodeChannels(LLImageRaw* raw_image, F32 decode_time, S32 first_channel, S32 max_channel);
+	// Drop any codec state kept for the aux channel pass (see LLImageJ2C).
+	virtual void releaseAuxPassState() {}
 
 	virtual bool encode(const LLImageRaw* raw_image, F32 encode_time) = 0;
 
@@ -349,7 +361,7 @@ protected:
 	S8 mLevels;			// Number of resolution levels in that image. Min is 1. 0 means unknown.
 	
 public:
-	static S32 sGlobalFormattedMemory;
+	static LLAtomicS32 sGlobalFormattedMemory;
 };
 
 #endif
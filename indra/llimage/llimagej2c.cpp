@@ -43,6 +43,11 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
 const std::string sTesterName("ImageCompressionTester");
 
+S32 LLImageJ2C::sMaxAuxPassBytes = 32 * 1024 * 1024;
+LLAtomicS32 LLImageJ2C::sAuxPassBytes(0);
+S32 LLImageJ2C::sParallelDecodeThreads = 1;
+S32 LLImageJ2C::sParallelDecodeMinPixels = PARALLEL_DECODE_MIN_PIXELS;
+
 //static
 std::string LLImageJ2C::getEngineInfo()
 {
@@ -83,6 +88,37 @@ LLImageJ2C::LLImageJ2C() : 	LLImageFormatted(IMG_CODEC_J2C),
 // virtual
 LLImageJ2C::~LLImageJ2C() {}
 
+// virtual
+void LLImageJ2C::releaseAuxPassState()
+{
+	mImpl->releaseAuxPassState();
+}
+
+//static
+bool LLImageJ2C::reserveAuxPassBytes(S32 bytes)
+{
+	// Soft limit: concurrent decoders may overshoot it by one image each
+	if (sAuxPassBytes.CurrentValue() + bytes > sMaxAuxPassBytes)
+	{
+		return false;
+	}
+	sAuxPassBytes += bytes;
+	return true;
+}
+
+//static
+void LLImageJ2C::freeAuxPassBytes(S32 bytes)
+{
+	sAuxPassBytes -= bytes;
+}
+
+//static
+void LLImageJ2C::setParallelDecode(S32 threads, S32 min_pixels)
+{
+	sParallelDecodeThreads = llmax(threads, 1);
+	sParallelDecodeMinPixels = min_pixels;
+}
+
 // virtual
 void LLImageJ2C::resetLastError()
 {
@@ -116,6 +152,8 @@ bool LLImageJ2C::updateData()
 	}
 	else 
 	{
+		// New or changed data, anything decoded from the old data is stale
+		mImpl->releaseAuxPassState();
 		res = mImpl->getMetadata(*this);
 	}
 
@@ -35,6 +35,9 @@
 // JPEG2000 : compression rate used in j2c conversion.
 const F32 DEFAULT_COMPRESSION_RATE = 1.f/8.f;
 
+// Smallest image (in pixels) worth splitting across decode threads
+const S32 PARALLEL_DECODE_MIN_PIXELS = 512 * 512;
+
 class LLImageJ2CImpl;
 class LLImageCompressionTester ;
 
@@ -51,6 +54,7 @@ public:
 	/*virtual*/ bool updateData();
 	/*virtual*/ bool decode(LLImageRaw *raw_imagep, F32 decode_time);
 	/*virtual*/ bool decodeChannels(LLImageRaw *raw_imagep, F32 decode_time, S32 first_channel, S32 max_channel_count);
+	/*virtual*/ void releaseAuxPassState();
 	/*virtual*/ bool encode(const LLImageRaw *raw_imagep, F32 encode_time);
 	/*virtual*/ S32 calcHeaderSize();
 	/*virtual*/ S32 calcDataSize(S32 discard_level = 0);
@@ -79,6 +83,22 @@ public:
 
 	static std::string getEngineInfo();
 
+	// Decoders may keep the decoded codestream from the color channel pass
+	// for the aux channel pass over the same data and discard level, instead
+	// of decoding it again.  This caps the memory all LLImageJ2C instances
+	// can hold that way.
+	static void setMaxAuxPassBytes(S32 max_bytes) { sMaxAuxPassBytes = max_bytes; }
+	static S32 getAuxPassBytes() { return sAuxPassBytes.CurrentValue(); }
+	static bool reserveAuxPassBytes(S32 bytes);
+	static void freeAuxPassBytes(S32 bytes);
+
+	// Decoders that can split a codestream (e.g. by tile) may use up to
+	// this many threads for a single image of at least min_pixels pixels.
+	// The threads - 1 helpers are shared by all images decoded at once.
+	static void setParallelDecode(S32 threads, S32 min_pixels = PARALLEL_DECODE_MIN_PIXELS);
+	static S32 getParallelDecodeThreads() { return sParallelDecodeThreads; }
+	static S32 getParallelDecodeMinPixels() { return sParallelDecodeMinPixels; }
+
 protected:
 	friend class LLImageJ2CImpl;
 	friend class LLImageJ2COJ;
@@ -100,6 +120,12 @@ protected:
 
     // Image compression/decompression tester
 	static LLImageCompressionTester* sTesterp;
+
+	static S32 sMaxAuxPassBytes;
+	static LLAtomicS32 sAuxPassBytes;
+
+	static S32 sParallelDecodeThreads;
+	static S32 sParallelDecodeMinPixels;
 };
 
 // Derive from this class to implement JPEG2000 decoding
@@ -124,6 +150,8 @@ protected:
 							bool reversible=false) = 0;
 	virtual bool initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level = -1, int* region = NULL) = 0;
 	virtual bool initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size = -1, int precincts_size = -1, int levels = 0) = 0;
+	// Free the codestream kept for an aux channel pass, see decodeImpl()
+	virtual void releaseAuxPassState() {}
 
 	virtual std::string getEngineInfo() const = 0;
 
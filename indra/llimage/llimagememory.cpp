@@ -0,0 +1,180 @@
+/**
+ * @file llimagememory.cpp
+ * @brief Shared budget for the memory of decoded images.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagememory.h"
+
+#include "llframetimer.h"
+#include "lltrace.h"
+#include "llunits.h"
+
+#include <algorithm>
+#include <vector>
+
+// Eviction goes down to this fraction of the budget so that it does not
+// run again on the next frame
+const F32 BUDGET_LOW_WATER = 0.9f;
+
+// Images used this recently are left alone
+const F32 MIN_EVICT_IDLE_TIME = 5.f;
+
+// Seconds between two evictions
+const F32 EVICT_PERIOD = 1.f;
+
+static LLTrace::SampleStatHandle<F64Megabytes>
+	IMAGE_MEM_OTHER("imagememother", "Decoded images not claimed by a holder"),
+	IMAGE_MEM_FETCHED("imagememfetched", "Decoded images of textures being fetched or created"),
+	IMAGE_MEM_SAVED("imagememsaved", "Decoded images saved by textures for their callbacks"),
+	IMAGE_MEM_CACHED("imagememcached", "Decoded copies kept by textures to rebuild them"),
+	IMAGE_MEM_FAST_CACHE("imagememfastcache", "Decoded images read from the texture fast cache"),
+	IMAGE_MEM_BAKE("imagemembake", "Decoded avatar bake layers"),
+	IMAGE_MEM_UI("imagememui", "Decoded UI images"),
+	IMAGE_MEM_BUDGET("imagemembudget", "Budget of the decoded images");
+
+static LLTrace::CountStatHandle<F64Megabytes>
+	IMAGE_MEM_EVICTED("imagememevicted", "Decoded images evicted to stay in budget");
+
+static LLTrace::SampleStatHandle<F64Megabytes>* const CATEGORY_STATS[LLImageMemory::NUM_CATEGORIES] =
+{
+	&IMAGE_MEM_OTHER,
+	&IMAGE_MEM_FETCHED,
+	&IMAGE_MEM_SAVED,
+	&IMAGE_MEM_CACHED,
+	&IMAGE_MEM_FAST_CACHE,
+	&IMAGE_MEM_BAKE,
+	&IMAGE_MEM_UI
+};
+
+static const char* const CATEGORY_NAMES[LLImageMemory::NUM_CATEGORIES] =
+{
+	"other",
+	"fetched",
+	"saved",
+	"cached",
+	"fast cache",
+	"bake",
+	"ui"
+};
+
+LLImageMemory::holder_set_t LLImageMemory::sHolders;
+LLAtomicS32 LLImageMemory::sBytes[LLImageMemory::NUM_CATEGORIES];
+S32 LLImageMemory::sBudget = 0;
+U32 LLImageMemory::sNumEvicted = 0;
+
+//static
+const char* LLImageMemory::getCategoryName(S32 category)
+{
+	llassert(category >= 0 && category < NUM_CATEGORIES);
+	return CATEGORY_NAMES[category];
+}
+
+//static
+S32 LLImageMemory::getTotalBytes()
+{
+	S32 total = 0;
+	for (S32 i = 0; i < NUM_CATEGORIES; ++i)
+	{
+		total += sBytes[i].CurrentValue();
+	}
+	return total;
+}
+
+//static
+void LLImageMemory::update()
+{
+	for (S32 i = 0; i < NUM_CATEGORIES; ++i)
+	{
+		sample(*CATEGORY_STATS[i], F64Bytes(sBytes[i].CurrentValue()));
+	}
+	sample(IMAGE_MEM_BUDGET, F64Bytes(sBudget));
+
+	static LLFrameTimer evict_timer;
+	if (sBudget <= 0 || evict_timer.getElapsedTimeF32() < EVICT_PERIOD)
+	{
+		return;
+	}
+
+	S32 total = getTotalBytes();
+	if (total > sBudget)
+	{
+		evict(total - (S32)(sBudget * BUDGET_LOW_WATER));
+		evict_timer.reset();
+	}
+}
+
+//static
+void LLImageMemory::evict(S32 bytes)
+{
+	typedef std::pair<F32, LLImageMemoryHolder*> candidate_t;
+	std::vector<candidate_t> candidates;
+	for (holder_set_t::iterator iter = sHolders.begin(); iter != sHolders.end(); ++iter)
+	{
+		LLImageMemoryHolder* holder = *iter;
+		S32 evictable = holder->getEvictableImageMemory();
+		if (evictable <= 0)
+		{
+			continue;
+		}
+		F32 idle = holder->getImageMemoryIdleTime();
+		if (idle < MIN_EVICT_IDLE_TIME)
+		{
+			continue;
+		}
+		F32 cost = llmax(holder->getImageMemoryCost(), 1.f);
+		candidates.push_back(candidate_t(idle * (F32)evictable / cost, holder));
+	}
+	std::sort(candidates.begin(), candidates.end(), std::greater<candidate_t>());
+
+	S32 evicted = 0;
+	for (std::vector<candidate_t>::iterator iter = candidates.begin();
+		 iter != candidates.end() && evicted < bytes; ++iter)
+	{
+		LLImageMemoryHolder* holder = iter->second;
+		evicted += holder->getEvictableImageMemory();
+		holder->evictImageMemory();
+		sNumEvicted++;
+	}
+
+	if (evicted > 0)
+	{
+		add(IMAGE_MEM_EVICTED, F64Bytes(evicted));
+		LL_DEBUGS("ImageMemory") << "Evicted " << (evicted >> 10) << " KB of decoded images, "
+								 << (getTotalBytes() >> 10) << " KB left for a budget of "
+								 << (sBudget >> 10) << " KB" << LL_ENDL;
+	}
+}
+
+LLImageMemoryHolder::LLImageMemoryHolder()
+{
+	LLImageMemory::sHolders.insert(this);
+}
+
+//virtual
+LLImageMemoryHolder::~LLImageMemoryHolder()
+{
+	LLImageMemory::sHolders.erase(this);
+}
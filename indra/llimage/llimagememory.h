@@ -0,0 +1,118 @@
+/**
+ * @file llimagememory.h
+ * @brief Shared budget for the memory of decoded images.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEMEMORY_H
+#define LL_LLIMAGEMEMORY_H
+
+#include "llatomic.h"
+
+#include <set>
+
+class LLImageMemoryHolder;
+
+// Accounts for the memory of every LLImageRaw by category and keeps the
+// total under one budget by evicting the images of registered holders.
+//
+// Each LLImageRaw counts in the category its holder tagged it with
+// (LLImageRaw::setMemoryCategory()), OTHER until then.  The counts are
+// kept up to date from any thread.
+//
+// Holders that can let go of their images derive from LLImageMemoryHolder.
+// When over budget, update() evicts them by decreasing
+//   idle time * evictable bytes / cost
+// so that big images nobody looked at for a while and which are cheap to
+// get back go first, until the total is back under the low water mark.
+//
+// Threads:  update(), setBudget() and the holders on main, the counts
+// from any thread.
+class LLImageMemory
+{
+public:
+	enum ECategory
+	{
+		OTHER = 0,		// not tagged by a holder
+		FETCHED,		// textures being fetched or waiting for their GL texture
+		SAVED,			// raw images kept by textures for their callbacks
+		CACHED,			// small copies kept by textures to rebuild GL quickly
+		FAST_CACHE,		// read from the texture fast cache
+		BAKE,			// avatar bake layers
+		UI,				// UI images
+		NUM_CATEGORIES
+	};
+
+	static const char* getCategoryName(S32 category);
+
+	static S32 getBytes(S32 category)	{ return sBytes[category].CurrentValue(); }
+	static S32 getTotalBytes();
+
+	// 0 for no budget
+	static void setBudget(S32 bytes)	{ sBudget = bytes; }
+	static S32 getBudget()				{ return sBudget; }
+
+	// Samples the categories and evicts down to the budget
+	static void update();
+
+	static U32 getNumEvicted()			{ return sNumEvicted; }
+
+private:
+	friend class LLImageRaw;
+	friend class LLImageMemoryHolder;
+
+	static void addBytes(S32 category, S32 bytes)	{ sBytes[category] += bytes; }
+
+	static void evict(S32 bytes);
+
+	typedef std::set<LLImageMemoryHolder*> holder_set_t;
+	static holder_set_t sHolders;
+
+	static LLAtomicS32 sBytes[NUM_CATEGORIES];
+	static S32 sBudget;
+	static U32 sNumEvicted;
+};
+
+// Something that keeps decoded images it can drop and get back later.
+// Registers with LLImageMemory for its lifetime, on main.
+class LLImageMemoryHolder
+{
+public:
+	LLImageMemoryHolder();
+	virtual ~LLImageMemoryHolder();
+
+	// Bytes evictImageMemory() would free now, 0 if the images are in use
+	virtual S32 getEvictableImageMemory() = 0;
+
+	// Seconds since the images were last used
+	virtual F32 getImageMemoryIdleTime() = 0;
+
+	// Relative cost of getting the images back once evicted: 1 for a
+	// scaled copy of something still around, more for a fetch and decode
+	virtual F32 getImageMemoryCost() = 0;
+
+	// Drops the images counted by getEvictableImageMemory()
+	virtual void evictImageMemory() = 0;
+};
+
+#endif // LL_LLIMAGEMEMORY_H
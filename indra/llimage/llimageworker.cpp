@@ -28,22 +28,61 @@
 
 #include "llimageworker.h"
 #include "llimagedxt.h"
+#include "lltracethreadrecorder.h"
+
+LLTrace::SampleStatHandle<> LLImageDecodeThread::sDecodeQueueDepth("image_decode_queue_depth", "Images waiting for a decode thread");
+LLTrace::EventStatHandle<F64Milliseconds> LLImageDecodeThread::sDecodeQueueWait("image_decode_queue_wait", "Time an image waited before decoding started");
+LLTrace::EventStatHandle<F64Milliseconds> LLImageDecodeThread::sDecodeTime("image_decode_time", "Time spent decoding an image");
+
+// Upper bound for the automatically chosen number of decode threads
+const U32 MAX_AUTO_DECODE_THREADS = 8;
 
 //----------------------------------------------------------------------------
 
 // MAIN THREAD
-LLImageDecodeThread::LLImageDecodeThread(bool threaded)
-	: LLQueuedThread("imagedecode", threaded)
+LLImageDecodeThread::LLImageDecodeThread(bool threaded, U32 num_threads)
+	: LLQueuedThread("imagedecode", threaded),
+	  mMaxQueueDepth(0)
 {
 	mCreationMutex = new LLMutex();
+
+	if (num_threads == 0)
+	{
+		// Leave the other half of the cores to the main, fetch and cache threads
+		num_threads = llclamp(std::thread::hardware_concurrency() / 2, 1U, MAX_AUTO_DECODE_THREADS);
+	}
+	if (threaded)
+	{
+		for (U32 i = 1; i < num_threads; ++i)
+		{
+			mHelpers.push_back(new DecodeHelper(llformat("imagedecode%d", i), this));
+		}
+	}
+	LL_INFOS() << "Image decode running on " << getNumThreads() << " thread(s)" << LL_ENDL;
 }
 
 //virtual 
 LLImageDecodeThread::~LLImageDecodeThread()
 {
+	// Helpers must be gone before ~LLQueuedThread() deletes the requests they may be working on
+	shutdown();
 	delete mCreationMutex ;
 }
 
+// MAIN THREAD
+//virtual
+void LLImageDecodeThread::shutdown()
+{
+	for (helper_list_t::iterator iter = mHelpers.begin(); iter != mHelpers.end(); ++iter)
+	{
+		DecodeHelper* helper = *iter;
+		helper->shutdown();
+		delete helper;
+	}
+	mHelpers.clear();
+	LLQueuedThread::shutdown();
+}
+
 // MAIN THREAD
 // virtual
 S32 LLImageDecodeThread::update(F32 max_time_ms)
@@ -65,9 +104,35 @@ S32 LLImageDecodeThread::update(F32 max_time_ms)
 	}
 	mCreationList.clear();
 	S32 res = LLQueuedThread::update(max_time_ms);
+	if (res > 0)
+	{
+		for (helper_list_t::iterator iter = mHelpers.begin(); iter != mHelpers.end(); ++iter)
+		{
+			(*iter)->wake();
+		}
+	}
+	sample(sDecodeQueueDepth, res);
 	return res;
 }
 
+// May be called from any thread, the texture fetch thread checks it before decoding
+S32 LLImageDecodeThread::getQueueDepth()
+{
+	S32 creation_count;
+	{
+		LLMutexLock lock(mCreationMutex);
+		creation_count = mCreationList.size();
+	}
+	return creation_count + getPending();
+}
+
+// May be called from any thread
+bool LLImageDecodeThread::isQueueFull()
+{
+	S32 max_depth = mMaxQueueDepth.CurrentValue();
+	return max_depth > 0 && getQueueDepth() >= max_depth;
+}
+
 LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(LLImageFormatted* image, 
 	U32 priority, S32 discard, BOOL needs_aux, Responder* responder)
 {
@@ -92,6 +157,45 @@ LLImageDecodeThread::Responder::~Responder()
 
 //----------------------------------------------------------------------------
 
+LLImageDecodeThread::DecodeHelper::DecodeHelper(const std::string& name, LLImageDecodeThread* owner)
+	: LLThread(name),
+	  mOwner(owner)
+{
+	start();
+}
+
+// virtual
+bool LLImageDecodeThread::DecodeHelper::runCondition()
+{
+	// mRunCondition must be locked here
+	return isQuitting() || (!mOwner->isPaused() && mOwner->getPending() > 0);
+}
+
+// virtual
+void LLImageDecodeThread::DecodeHelper::run()
+{
+	while (1)
+	{
+		checkPause();
+
+		if (isQuitting() || mOwner->isQuitting())
+		{
+			LLTrace::get_thread_recorder()->pushToParent();
+			break;
+		}
+
+		// Shares the owner's request queue; processNextRequest() only ever hands
+		// a given request to one thread at a time.
+		if (mOwner->processNextRequest() == 0)
+		{
+			ms_sleep(1);
+		}
+	}
+	LL_INFOS() << "Image decode helper " << mName << " EXITING." << LL_ENDL;
+}
+
+//----------------------------------------------------------------------------
+
 LLImageDecodeThread::ImageRequest::ImageRequest(handle_t handle, LLImageFormatted* image, 
 												U32 priority, S32 discard, BOOL needs_aux,
 												LLImageDecodeThread::Responder* responder)
@@ -101,7 +205,9 @@ LLImageDecodeThread::ImageRequest::ImageRequest(handle_t handle, LLImageFormatte
 	  mNeedsAux(needs_aux),
 	  mDecodedRaw(FALSE),
 	  mDecodedAux(FALSE),
-	  mResponder(responder)
+	  mResponder(responder),
+	  mStarted(false),
+	  mDecodeSeconds(0.0)
 {
 }
 
@@ -120,6 +226,12 @@ bool LLImageDecodeThread::ImageRequest::processRequest()
 {
 	const F32 decode_time_slice = .1f;
 	bool done = true;
+	if (!mStarted)
+	{
+		record(sDecodeQueueWait, F64Seconds(mQueuedTimer.getElapsedTimeF64()));
+		mStarted = true;
+	}
+	LLTimer decode_timer;
 	if (!mDecodedRaw && mFormattedImage.notNull())
 	{
 		// Decode primary channels
@@ -158,12 +270,22 @@ bool LLImageDecodeThread::ImageRequest::processRequest()
 		done = mFormattedImage->decodeChannels(mDecodedImageAux, decode_time_slice, 4, 4); // 1ms
 		mDecodedAux = done && mDecodedImageAux->getData();
 	}
+	mDecodeSeconds += decode_timer.getElapsedTimeF64();
+	if (done)
+	{
+		record(sDecodeTime, mDecodeSeconds);
+	}
 
 	return done;
 }
 
 void LLImageDecodeThread::ImageRequest::finishRequest(bool completed)
 {
+	if (mFormattedImage.notNull())
+	{
+		// The aux channel pass, if any, is done
+		mFormattedImage->releaseAuxPassState();
+	}
 	if (mResponder.notNull())
 	{
 		bool success = completed && mDecodedRaw && (!mNeedsAux || mDecodedAux);
@@ -27,9 +27,12 @@
 #ifndef LL_LLIMAGEWORKER_H
 #define LL_LLIMAGEWORKER_H
 
+#include "llatomic.h"
 #include "llimage.h"
 #include "llpointer.h"
 #include "llworkerthread.h"
+#include "lltimer.h"
+#include "lltrace.h"
 
 class LLImageDecodeThread : public LLQueuedThread
 {
@@ -69,19 +72,58 @@ public:
 		BOOL mDecodedRaw;
 		BOOL mDecodedAux;
 		LLPointer<LLImageDecodeThread::Responder> mResponder;
+		// stats
+		LLTimer mQueuedTimer;
+		bool mStarted;
+		F64Seconds mDecodeSeconds;
 	};
 	
+	// Additional decode thread that pulls requests from the owning
+	// LLImageDecodeThread's queue.  Requests are still handled one at a
+	// time each, so decoding of separate images proceeds in parallel.
+	class DecodeHelper : public LLThread
+	{
+	public:
+		DecodeHelper(const std::string& name, LLImageDecodeThread* owner);
+
+	protected:
+		/*virtual*/ bool runCondition();
+		/*virtual*/ void run();
+
+	private:
+		LLImageDecodeThread* mOwner;
+	};
+	friend class DecodeHelper;
+
 public:
-	LLImageDecodeThread(bool threaded = true);
+	// num_threads is the total number of decode threads, including this one.
+	// 0 picks a count based on the number of hardware threads.
+	LLImageDecodeThread(bool threaded = true, U32 num_threads = 1);
 	virtual ~LLImageDecodeThread();
+	/*virtual*/ void shutdown();
 
 	handle_t decodeImage(LLImageFormatted* image,
 						 U32 priority, S32 discard, BOOL needs_aux,
 						 Responder* responder);
 	S32 update(F32 max_time_ms);
 
+	// Requests waiting for a decode thread, including ones not yet handed
+	// to the queue by update().  Safe from any thread, both queues are
+	// read under their mutex.
+	S32 getQueueDepth();
+	// Bound the decode stage queue; 0 means unbounded.
+	void setMaxQueueDepth(S32 depth) { mMaxQueueDepth = depth; }
+	S32 getMaxQueueDepth() const { return mMaxQueueDepth.CurrentValue(); }
+	bool isQueueFull();
+
+	U32 getNumThreads() const { return mHelpers.size() + 1; }
+
 	// Used by unit tests to check the consistency of the thread instance
 	S32 tut_size();
+
+	static LLTrace::SampleStatHandle<> sDecodeQueueDepth;
+	static LLTrace::EventStatHandle<F64Milliseconds> sDecodeQueueWait;
+	static LLTrace::EventStatHandle<F64Milliseconds> sDecodeTime;
 	
 private:
 	struct creation_info
@@ -99,6 +141,10 @@ private:
 	typedef std::list<creation_info> creation_list_t;
 	creation_list_t mCreationList;
 	LLMutex* mCreationMutex;
+
+	typedef std::vector<DecodeHelper*> helper_list_t;
+	helper_list_t mHelpers;
+	LLAtomicS32 mMaxQueueDepth;		// set on the main thread, read by isQueueFull() on the fetch thread
 };
 
 #endif
@@ -244,6 +244,44 @@ namespace tut
 		ensure("LLImageDecodeThread: threaded work unit not processed", done == true);
 	}
 
+	template<> template<>
+	void imagedecodethread_object_t::test<3>()
+	{
+		// Test a *threaded* instance using several decode threads
+		mThread = new LLImageDecodeThread(true, 3);
+		ensure("LLImageDecodeThread: pooled constructor failed", mThread != NULL);
+		ensure("LLImageDecodeThread: pooled thread count incorrect", mThread->getNumThreads() == 3);
+		// Queue more work than there are threads
+		const S32 NUM_REQUESTS = 8;
+		bool done[NUM_REQUESTS];
+		for (S32 i = 0; i < NUM_REQUESTS; ++i)
+		{
+			mThread->decodeImage(NULL, LLQueuedThread::PRIORITY_NORMAL, 0, FALSE, new responder_test(&done[i]));
+		}
+		ensure("LLImageDecodeThread: pooled queue depth incorrect", mThread->getQueueDepth() == NUM_REQUESTS);
+		// A bounded queue reports full once the limit is reached
+		mThread->setMaxQueueDepth(NUM_REQUESTS);
+		ensure("LLImageDecodeThread: pooled queue bound not reported", mThread->isQueueFull());
+		mThread->update(1);
+		const U32 INCREMENT_TIME = 500;				// 500 milliseconds
+		const U32 MAX_TIME = 20 * INCREMENT_TIME;	// Do the loop 20 times max, i.e. wait 10 seconds but no more
+		U32 total_time = 0;
+		bool all_done = false;
+		while (!all_done && (total_time < MAX_TIME))
+		{
+			ms_sleep(INCREMENT_TIME);
+			total_time += INCREMENT_TIME;
+			mThread->update(1);
+			all_done = true;
+			for (S32 i = 0; i < NUM_REQUESTS; ++i)
+			{
+				all_done = all_done && done[i];
+			}
+		}
+		// Verifies that every responder has been called
+		ensure("LLImageDecodeThread: pooled work units not processed", all_done);
+	}
+
 	// ---------------------------------------------------------------------------------------
 	// Test the LLImageDecodeThread::ImageRequest interface
 	// ---------------------------------------------------------------------------------------
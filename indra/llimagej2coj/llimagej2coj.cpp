@@ -32,6 +32,15 @@
 
 #include "lltimer.h"
 //#include "llmemory.h"
+#include "llatomic.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // Factory function: see declaration in llimagej2c.cpp
 LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl()
@@ -95,13 +104,69 @@ int ceildivpow2(int a, int b)
 
 
 LLImageJ2COJ::LLImageJ2COJ()
-	: LLImageJ2CImpl()
+	: LLImageJ2CImpl(),
+	  mAuxPassImage(NULL),
+	  mAuxPassData(NULL),
+	  mAuxPassDataSize(0),
+	  mAuxPassDiscard(-1),
+	  mAuxPassBytes(0)
 {
 }
 
 
 LLImageJ2COJ::~LLImageJ2COJ()
 {
+	releaseAuxPassState();
+}
+
+// virtual
+void LLImageJ2COJ::releaseAuxPassState()
+{
+	if (mAuxPassImage)
+	{
+		opj_image_destroy(mAuxPassImage);
+		LLImageJ2C::freeAuxPassBytes(mAuxPassBytes);
+		mAuxPassImage = NULL;
+		mAuxPassData = NULL;
+		mAuxPassDataSize = 0;
+		mAuxPassDiscard = -1;
+		mAuxPassBytes = 0;
+	}
+}
+
+void LLImageJ2COJ::destroyImage(opj_image_t* image)
+{
+	if (image && image != mAuxPassImage)
+	{
+		opj_image_destroy(image);
+	}
+}
+
+void LLImageJ2COJ::keepForAuxPass(LLImageJ2C &base, opj_image_t* image)
+{
+	if (image == mAuxPassImage)
+	{
+		return;
+	}
+	releaseAuxPassState();
+
+	S32 bytes = 0;
+	for (S32 i = 0; i < image->numcomps; i++)
+	{
+		bytes += image->comps[i].w * image->comps[i].h * sizeof(int);
+	}
+	if (LLImageJ2C::reserveAuxPassBytes(bytes))
+	{
+		mAuxPassImage = image;
+		mAuxPassData = base.getData();
+		mAuxPassDataSize = base.getDataSize();
+		mAuxPassDiscard = base.getRawDiscardLevel();
+		mAuxPassBytes = bytes;
+	}
+	else
+	{
+		opj_image_destroy(image);
+	}
 }
 
 bool LLImageJ2COJ::initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level, int* region)
@@ -116,14 +181,9 @@ bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int block
 	return false;
 }
 
-bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count)
+// Decode a whole J2K codestream at the given resolution reduction
+static opj_image_t* decode_j2k(U8* data, S32 size, S32 reduce)
 {
-	//
-	// FIXME: Get the comment field out of the texture
-	//
-
-	LLTimer decode_timer;
-
 	opj_dparameters_t parameters;	/* decompression parameters */
 	opj_event_mgr_t event_mgr;		/* event manager */
 	opj_image_t *image = NULL;
@@ -141,7 +201,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	/* set decoding parameters to default values */
 	opj_set_default_decoder_parameters(&parameters);
 
-	parameters.cp_reduce = base.getRawDiscardLevel();
+	parameters.cp_reduce = reduce;
 
 	/* decode the code-stream */
 	/* ---------------------- */
@@ -158,7 +218,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	opj_setup_decoder(dinfo, &parameters);
 
 	/* open a byte stream */
-	cio = opj_cio_open((opj_common_ptr)dinfo, base.getData(), base.getDataSize());
+	cio = opj_cio_open((opj_common_ptr)dinfo, data, size);
 
 	/* decode the stream and fill the image structure */
 	image = opj_decode(dinfo, cio);
@@ -172,16 +232,467 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 		opj_destroy_decompress(dinfo);
 	}
 
+	return image;
+}
+
+//----------------------------------------------------------------------------
+// Tile parallel decoding
+//
+// OpenJPEG decodes a codestream on a single thread.  When an image is made of
+// several tiles, each tile can be decoded on its own: we rewrite the codestream
+// into one single-tile codestream per tile (the main header with SIZ narrowed
+// to the tile, followed by that tile's tile-parts), decode those concurrently
+// and copy the tiles into one image.  Tile positions stay on the original
+// canvas so the wavelet transform sees the same coordinates.
+
+const U16 J2K_SOC = 0xff4f;
+const U16 J2K_SIZ = 0xff51;
+const U16 J2K_TLM = 0xff55;
+const U16 J2K_PLM = 0xff57;
+const U16 J2K_PPM = 0xff60;
+const U16 J2K_SOT = 0xff90;
+const U16 J2K_EOC = 0xffd9;
+
+// Each tile rescans all tile-parts, past this many tiles the regular decode
+// is the better deal anyway
+const S32 J2K_MAX_PARALLEL_TILES = 1024;
+
+static U16 read_u16(const U8* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static U32 read_u32(const U8* p)
+{
+	return ((U32)p[0] << 24) | ((U32)p[1] << 16) | ((U32)p[2] << 8) | (U32)p[3];
+}
+
+static void write_u16(U8* p, U16 v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xff;
+}
+
+static void write_u32(U8* p, U32 v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;
+	p[3] = v & 0xff;
+}
+
+struct LLJ2KTileLayout
+{
+	struct TilePart
+	{
+		U16 mTile;
+		S32 mOffset;
+		S32 mLength;
+	};
+
+	S32 mSizOffset;
+	U32 mX1, mY1, mX0, mY0;
+	U32 mTileW, mTileH, mTileX0, mTileY0;
+	S32 mTilesX, mTilesY;
+	// Main header without the markers that index the whole codestream
+	std::vector<U8> mMainHeader;
+	std::vector<TilePart> mTileParts;
+};
+
+// Split a complete codestream into its main header and tile-parts.  Returns false
+// for anything we can't rewrite per tile (single tile, subsampled or truncated data...)
+static bool parse_j2k_tiles(const U8* data, S32 size, LLJ2KTileLayout& layout)
+{
+	if (size < 4 || read_u16(data) != J2K_SOC)
+	{
+		return false;
+	}
+	layout.mSizOffset = -1;
+	layout.mMainHeader.assign(data, data + 2);
+	S32 pos = 2;
+	while (pos + 4 <= size)
+	{
+		U16 marker = read_u16(data + pos);
+		if (marker == J2K_SOT)
+		{
+			break;
+		}
+		S32 seg_size = 2 + read_u16(data + pos + 2);
+		if (pos + seg_size > size || (marker >> 8) != 0xff)
+		{
+			return false;
+		}
+		if (marker == J2K_PPM)
+		{
+			// Packet headers for every tile live in the main header
+			return false;
+		}
+		if (marker == J2K_SIZ)
+		{
+			if (seg_size < 41)
+			{
+				return false;
+			}
+			const U8* siz = data + pos;
+			layout.mSizOffset = layout.mMainHeader.size();
+			layout.mX1 = read_u32(siz + 6);
+			layout.mY1 = read_u32(siz + 10);
+			layout.mX0 = read_u32(siz + 14);
+			layout.mY0 = read_u32(siz + 18);
+			layout.mTileW = read_u32(siz + 22);
+			layout.mTileH = read_u32(siz + 26);
+			layout.mTileX0 = read_u32(siz + 30);
+			layout.mTileY0 = read_u32(siz + 34);
+			S32 comps = read_u16(siz + 38);
+			if (seg_size < 40 + 3 * comps || !layout.mTileW || !layout.mTileH)
+			{
+				return false;
+			}
+			// The image has to be on the canvas and the first tile has to overlap it,
+			// or the tile counts below are garbage
+			if (layout.mTileX0 > layout.mX0 || layout.mX0 >= layout.mX1
+				|| layout.mTileY0 > layout.mY0 || layout.mY0 >= layout.mY1
+				|| (U64)layout.mTileX0 + layout.mTileW <= layout.mX0
+				|| (U64)layout.mTileY0 + layout.mTileH <= layout.mY0)
+			{
+				return false;
+			}
+			for (S32 c = 0; c < comps; c++)
+			{
+				if (siz[41 + 3 * c] != 1 || siz[42 + 3 * c] != 1)
+				{
+					// Subsampled components
+					return false;
+				}
+			}
+			U64 tiles_x = ((U64)layout.mX1 - layout.mTileX0 + layout.mTileW - 1) / layout.mTileW;
+			U64 tiles_y = ((U64)layout.mY1 - layout.mTileY0 + layout.mTileH - 1) / layout.mTileH;
+			if (tiles_x * tiles_y > J2K_MAX_PARALLEL_TILES)
+			{
+				return false;
+			}
+			layout.mTilesX = (S32)tiles_x;
+			layout.mTilesY = (S32)tiles_y;
+		}
+		if (marker != J2K_TLM && marker != J2K_PLM)
+		{
+			layout.mMainHeader.insert(layout.mMainHeader.end(), data + pos, data + pos + seg_size);
+		}
+		pos += seg_size;
+	}
+	if (layout.mSizOffset < 0 || layout.mTilesX * layout.mTilesY < 2)
+	{
+		return false;
+	}
+
+	layout.mTileParts.clear();
+	while (pos + 12 <= size && read_u16(data + pos) == J2K_SOT)
+	{
+		LLJ2KTileLayout::TilePart part;
+		part.mTile = read_u16(data + pos + 4);
+		part.mOffset = pos;
+		part.mLength = read_u32(data + pos + 6);
+		if (part.mLength == 0)
+		{
+			// Last tile-part runs to the EOC marker
+			part.mLength = size - pos - 2;
+		}
+		if (part.mLength < 12 || pos + part.mLength > size || part.mTile >= layout.mTilesX * layout.mTilesY)
+		{
+			// Truncated (partially fetched) data: let the regular decode handle it
+			return false;
+		}
+		layout.mTileParts.push_back(part);
+		pos += part.mLength;
+	}
+	return pos + 2 <= size && read_u16(data + pos) == J2K_EOC;
+}
+
+// Build the single tile codestream for tile
+static void build_tile_codestream(const U8* data, const LLJ2KTileLayout& layout, U16 tile, std::vector<U8>& out)
+{
+	U32 tx = tile % layout.mTilesX;
+	U32 ty = tile / layout.mTilesX;
+	U32 x0 = llmax(layout.mTileX0 + tx * layout.mTileW, layout.mX0);
+	U32 y0 = llmax(layout.mTileY0 + ty * layout.mTileH, layout.mY0);
+	U32 x1 = llmin(layout.mTileX0 + (tx + 1) * layout.mTileW, layout.mX1);
+	U32 y1 = llmin(layout.mTileY0 + (ty + 1) * layout.mTileH, layout.mY1);
+
+	out = layout.mMainHeader;
+	U8* siz = &out[layout.mSizOffset];
+	write_u32(siz + 6, x1);
+	write_u32(siz + 10, y1);
+	write_u32(siz + 14, x0);
+	write_u32(siz + 18, y0);
+	write_u32(siz + 22, x1 - x0);
+	write_u32(siz + 26, y1 - y0);
+	write_u32(siz + 30, x0);
+	write_u32(siz + 34, y0);
+
+	for (std::vector<LLJ2KTileLayout::TilePart>::const_iterator iter = layout.mTileParts.begin();
+		 iter != layout.mTileParts.end(); ++iter)
+	{
+		if (iter->mTile == tile)
+		{
+			S32 start = out.size();
+			out.insert(out.end(), data + iter->mOffset, data + iter->mOffset + iter->mLength);
+			write_u16(&out[start + 4], 0);
+			write_u32(&out[start + 6], iter->mLength);
+		}
+	}
+	out.push_back(J2K_EOC >> 8);
+	out.push_back(J2K_EOC & 0xff);
+}
+
+// Tiles of one image, decoded by the thread that split it and by any pool
+// helpers that join in
+struct LLJ2KTileBatch
+{
+	LLJ2KTileBatch(S32 num_tiles, const std::function<void(S32)>& decode)
+	:	mDecode(decode), mNumTiles(num_tiles), mNextTile(0), mHelpers(0) {}
+
+	// Decode tiles until none are left to claim
+	void work()
+	{
+		S32 tile;
+		while ((tile = mNextTile++) < mNumTiles)
+		{
+			mDecode(tile);
+		}
+	}
+
+	std::function<void(S32)> mDecode;
+	S32 mNumTiles;
+	LLAtomicS32 mNextTile;
+	S32 mHelpers;			// pool helpers inside work(), guarded by LLJ2KTilePool::mMutex
+};
+
+// Helper threads shared by every image decoded tile by tile.  However many
+// decode threads split an image at once, no more than the pool's helpers
+// (ImageDecodeTileThreads - 1) decode tiles alongside them.
+class LLJ2KTilePool
+{
+public:
+	static LLJ2KTilePool& instance()
+	{
+		static LLJ2KTilePool sPool;
+		return sPool;
+	}
+
+	// Decode all the tiles of batch on the calling thread and up to helpers
+	// pool threads, returns when they are all done
+	void decode(LLJ2KTileBatch& batch, S32 helpers)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while ((S32)mThreads.size() < helpers)
+			{
+				mThreads.push_back(std::thread(&LLJ2KTilePool::run, this, (S32)mThreads.size()));
+			}
+			mMaxHelpers = helpers;
+			mQueue.push_back(&batch);
+		}
+		mWorkCond.notify_all();
+
+		batch.work();
+
+		// Every tile is claimed, wait for the helpers still decoding theirs
+		std::unique_lock<std::mutex> lock(mMutex);
+		std::deque<LLJ2KTileBatch*>::iterator iter = std::find(mQueue.begin(), mQueue.end(), &batch);
+		if (iter != mQueue.end())
+		{
+			mQueue.erase(iter);
+		}
+		mDoneCond.wait(lock, [&batch]() { return batch.mHelpers == 0; });
+	}
+
+private:
+	LLJ2KTilePool() : mMaxHelpers(0), mQuit(false) {}
+
+	~LLJ2KTilePool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mWorkCond.notify_all();
+		for (size_t i = 0; i < mThreads.size(); i++)
+		{
+			mThreads[i].join();
+		}
+	}
+
+	void run(S32 index)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (true)
+		{
+			// Helpers past the current setting stay idle
+			mWorkCond.wait(lock, [this, index]() { return mQuit || (!mQueue.empty() && index < mMaxHelpers); });
+			if (mQuit)
+			{
+				return;
+			}
+			LLJ2KTileBatch* batch = mQueue.front();
+			batch->mHelpers++;
+			lock.unlock();
+			batch->work();
+			lock.lock();
+			if (!mQueue.empty() && mQueue.front() == batch)
+			{
+				mQueue.pop_front();
+			}
+			if (--batch->mHelpers == 0)
+			{
+				mDoneCond.notify_all();
+			}
+		}
+	}
+
+	std::mutex mMutex;
+	std::condition_variable mWorkCond;
+	std::condition_variable mDoneCond;
+	std::deque<LLJ2KTileBatch*> mQueue;		// batches with tiles left to claim
+	std::vector<std::thread> mThreads;
+	S32 mMaxHelpers;
+	bool mQuit;
+};
+
+opj_image_t* LLImageJ2COJ::decodeTilesParallel(LLImageJ2C &base, S32 threads)
+{
+	LLJ2KTileLayout layout;
+	if (!parse_j2k_tiles(base.getData(), base.getDataSize(), layout))
+	{
+		return NULL;
+	}
+
+	S32 reduce = base.getRawDiscardLevel();
+	S32 num_tiles = layout.mTilesX * layout.mTilesY;
+	std::vector<opj_image_t*> tiles(num_tiles, (opj_image_t*)NULL);
+	const U8* data = base.getData();
+
+	// This thread and the shared pool helpers pull the next tile to decode
+	// until they are all done
+	LLJ2KTileBatch batch(num_tiles, [&](S32 tile)
+	{
+		std::vector<U8> codestream;
+		build_tile_codestream(data, layout, tile, codestream);
+		tiles[tile] = decode_j2k(&codestream[0], codestream.size(), reduce);
+	});
+	LLJ2KTilePool::instance().decode(batch, threads - 1);
+
+	// Assemble the tiles into one image at the reduced resolution
+	opj_image_t* image = NULL;
+	bool ok = tiles[0] && tiles[0]->numcomps > 0;
+	for (S32 t = 1; ok && t < num_tiles; t++)
+	{
+		ok = tiles[t] && tiles[t]->numcomps == tiles[0]->numcomps;
+	}
+	if (ok)
+	{
+		S32 numcomps = tiles[0]->numcomps;
+		S32 width = ceildivpow2(layout.mX1, reduce) - ceildivpow2(layout.mX0, reduce);
+		S32 height = ceildivpow2(layout.mY1, reduce) - ceildivpow2(layout.mY0, reduce);
+		std::vector<opj_image_cmptparm_t> cmptparm(numcomps);
+		for (S32 c = 0; c < numcomps; c++)
+		{
+			memset(&cmptparm[c], 0, sizeof(opj_image_cmptparm_t));
+			cmptparm[c].dx = 1;
+			cmptparm[c].dy = 1;
+			cmptparm[c].w = width;
+			cmptparm[c].h = height;
+			cmptparm[c].prec = tiles[0]->comps[c].prec;
+			cmptparm[c].bpp = tiles[0]->comps[c].bpp;
+			cmptparm[c].sgnd = tiles[0]->comps[c].sgnd;
+		}
+		image = opj_image_create(numcomps, &cmptparm[0], tiles[0]->color_space);
+	}
+	if (image)
+	{
+		image->x0 = layout.mX0;
+		image->y0 = layout.mY0;
+		image->x1 = layout.mX1;
+		image->y1 = layout.mY1;
+		for (S32 c = 0; c < image->numcomps; c++)
+		{
+			opj_image_comp_t& dst = image->comps[c];
+			dst.factor = reduce;
+			for (S32 t = 0; t < num_tiles; t++)
+			{
+				opj_image_t* tile = tiles[t];
+				const opj_image_comp_t& src = tile->comps[c];
+				if (!src.data || src.factor != reduce)
+				{
+					// Let the caller's sanity checks reject the image
+					dst.factor = src.factor;
+					continue;
+				}
+				S32 off_x = ceildivpow2(tile->x0, reduce) - ceildivpow2(layout.mX0, reduce);
+				S32 off_y = ceildivpow2(tile->y0, reduce) - ceildivpow2(layout.mY0, reduce);
+				S32 tile_w = llmin(ceildivpow2(tile->x1, reduce) - ceildivpow2(tile->x0, reduce), dst.w - off_x);
+				S32 tile_h = llmin(ceildivpow2(tile->y1, reduce) - ceildivpow2(tile->y0, reduce), dst.h - off_y);
+				for (S32 y = 0; y < tile_h; y++)
+				{
+					memcpy(dst.data + (off_y + y) * dst.w + off_x, src.data + y * src.w, tile_w * sizeof(int));
+				}
+			}
+		}
+	}
+
+	for (S32 t = 0; t < num_tiles; t++)
+	{
+		if (tiles[t])
+		{
+			opj_image_destroy(tiles[t]);
+		}
+	}
+	return image;
+}
+
+opj_image_t* LLImageJ2COJ::decodeCodestream(LLImageJ2C &base)
+{
+	S32 threads = LLImageJ2C::getParallelDecodeThreads();
+	if (threads > 1 && base.getWidth() * base.getHeight() >= LLImageJ2C::getParallelDecodeMinPixels())
+	{
+		opj_image_t* image = decodeTilesParallel(base, threads);
+		if (image)
+		{
+			return image;
+		}
+	}
+	return decode_j2k(base.getData(), base.getDataSize(), base.getRawDiscardLevel());
+}
+
+bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count)
+{
+	//
+	// FIXME: Get the comment field out of the texture
+	//
+
+	LLTimer decode_timer;
+
+	opj_image_t *image = NULL;
+	if (mAuxPassImage
+		&& mAuxPassData == base.getData()
+		&& mAuxPassDataSize == base.getDataSize()
+		&& mAuxPassDiscard == base.getRawDiscardLevel())
+	{
+		// Aux channel pass over what the color pass just decoded: skip the codec entirely
+		image = mAuxPassImage;
+	}
+	else
+	{
+		releaseAuxPassState();
+		image = decodeCodestream(base);
+	}
+
 	// The image decode failed if the return was NULL or the component
 	// count was zero.  The latter is just a sanity check before we
 	// dereference the array.
 	if(!image || !image->numcomps)
 	{
 		LL_DEBUGS("Texture") << "ERROR -> decodeImpl: failed to decode image!" << LL_ENDL;
-		if (image)
-		{
-			opj_image_destroy(image);
-		}
+		destroyImage(image);
 
 		return true; // done
 	}
@@ -192,7 +703,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 		if (image->comps[i].factor != base.getRawDiscardLevel())
 		{
 			// if we didn't get the discard level we're expecting, fail
-			opj_image_destroy(image);
+			destroyImage(image);
 			base.mDecoding = false;
 			return true;
 		}
@@ -201,10 +712,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	if(image->numcomps <= first_channel)
 	{
 		LL_WARNS() << "trying to decode more channels than are present in image: numcomps: " << image->numcomps << " first_channel: " << first_channel << LL_ENDL;
-		if (image)
-		{
-			opj_image_destroy(image);
-		}
+		destroyImage(image);
 			
 		return true;
 	}
@@ -251,14 +759,14 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 		else // Some rare OpenJPEG versions have this bug.
 		{
 			LL_DEBUGS("Texture") << "ERROR -> decodeImpl: failed to decode image! (NULL comp data - OpenJPEG bug)" << LL_ENDL;
-			opj_image_destroy(image);
+			destroyImage(image);
 
 			return true; // done
 		}
 	}
 
-	/* free image data structure */
-	opj_image_destroy(image);
+	/* keep the image data structure around for the aux channel pass */
+	keepForAuxPass(base, image);
 
 	return true; // done
 }
@@ -29,6 +29,8 @@
 
 #include "llimagej2c.h"
 
+struct opj_image;
+
 class LLImageJ2COJ : public LLImageJ2CImpl
 {	
 public:
@@ -41,7 +43,28 @@ protected:
 								bool reversible = false);
 	virtual bool initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level = -1, int* region = NULL);
 	virtual bool initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size = -1, int precincts_size = -1, int levels = 0);
+	virtual void releaseAuxPassState();
     virtual std::string getEngineInfo() const;
+
+private:
+	opj_image* decodeCodestream(LLImageJ2C &base);
+	// Decode the tiles of a multi-tile codestream on this thread and up to
+	// threads - 1 helpers shared by all decodes, and assemble the result.
+	// Returns NULL if the codestream can't be split.
+	opj_image* decodeTilesParallel(LLImageJ2C &base, S32 threads);
+	// Free image unless it is kept for the aux channel pass
+	void destroyImage(opj_image* image);
+	// Keep image for the aux channel pass over the same data, or free it
+	void keepForAuxPass(LLImageJ2C &base, opj_image* image);
+
+	// Last decoded codestream, reused by the aux channel pass that follows
+	// the color pass on the same data and discard level.  Decodes at other
+	// discard levels start from scratch.
+	opj_image* mAuxPassImage;
+	const U8* mAuxPassData;
+	S32 mAuxPassDataSize;
+	S32 mAuxPassDiscard;
+	S32 mAuxPassBytes;
 };
 
 #endif
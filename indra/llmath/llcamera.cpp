@@ -296,6 +296,93 @@ S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVec
 	return AABBInFrustumNoFarClip(center, radius, mRegionPlanes);
 }
 
+void LLCamera::getBatchPlanes(BatchPlanes& batch_planes, const LLPlane* planes, bool far_clip) const
+{
+	if(!planes)
+	{
+		//use agent space
+		planes = mAgentPlanes;
+	}
+
+	batch_planes.mCount = 0;
+	U32 max_planes = llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM);		// mAgentPlanes[] size is 7
+	for (U32 i = 0; i < max_planes; i++)
+	{
+		if ((far_clip || i != AGENT_PLANE_FAR) && (mPlaneMask[i] < PLANE_MASK_NUM))
+		{
+			const LLPlane& p(planes[i]);
+			U32 n = batch_planes.mCount++;
+			for (U32 j = 0; j < 3; j++)
+			{
+				batch_planes.mNormal[n][j].splat(p[j]);
+				batch_planes.mAbsNormal[n][j].splat(fabsf(p[j]));
+			}
+			batch_planes.mOffset[n].splat(p[3]);
+		}
+	}
+}
+
+//exactly same as the function getBatchPlanes(...)
+//except uses mRegionPlanes instead of mAgentPlanes.
+void LLCamera::getRegionBatchPlanes(BatchPlanes& batch_planes, bool far_clip) const
+{
+	getBatchPlanes(batch_planes, mRegionPlanes, far_clip);
+}
+
+//static
+void LLCamera::AABBInFrustumBatch(const BatchPlanes& planes, const LLVector4a* const* bounds, U32 count, S32* results)
+{
+	for (U32 first = 0; first < count; first += 4)
+	{
+		U32 lanes = llmin(count - first, (U32) 4);
+
+		//gather the boxes into one vector per coordinate, repeating the
+		//last one in unused lanes
+		const LLVector4a* box[4];
+		for (U32 lane = 0; lane < 4; lane++)
+		{
+			box[lane] = bounds[first + llmin(lane, lanes - 1)];
+		}
+		LLQuad cx = box[0][0], cy = box[1][0], cz = box[2][0], cw = box[3][0];
+		LLQuad rx = box[0][1], ry = box[1][1], rz = box[2][1], rw = box[3][1];
+		_MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+		_MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+		const LLVector4a center[3] = { LLVector4a(cx), LLVector4a(cy), LLVector4a(cz) };
+		const LLVector4a radius[3] = { LLVector4a(rx), LLVector4a(ry), LLVector4a(rz) };
+
+		//a box is out when its center is further than |n|.radius in front
+		//of a plane, and crosses it when it is less than that away
+		U32 outside = 0;
+		U32 crossing = 0;
+		for (U32 i = 0; i < planes.mCount && outside != 0xf; i++)
+		{
+			LLVector4a dist, extent, tmp;
+			dist.setMul(planes.mNormal[i][0], center[0]);
+			tmp.setMul(planes.mNormal[i][1], center[1]);
+			dist.add(tmp);
+			tmp.setMul(planes.mNormal[i][2], center[2]);
+			dist.add(tmp);
+			dist.add(planes.mOffset[i]);
+
+			extent.setMul(planes.mAbsNormal[i][0], radius[0]);
+			tmp.setMul(planes.mAbsNormal[i][1], radius[1]);
+			extent.add(tmp);
+			tmp.setMul(planes.mAbsNormal[i][2], radius[2]);
+			extent.add(tmp);
+
+			outside |= dist.greaterThan(extent).getGatheredBits();
+			tmp.setSub(LLVector4a::getZero(), extent);
+			crossing |= dist.greaterThan(tmp).getGatheredBits();
+		}
+
+		for (U32 lane = 0; lane < lanes; lane++)
+		{
+			U32 bit = 1 << lane;
+			results[first + lane] = (outside & bit) ? 0 : ((crossing & bit) ? 1 : 2);
+		}
+	}
+}
+
 int LLCamera::sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius) 
 {
 	LLVector3 dist = sphere_center-mFrustCenter;
@@ -209,6 +209,23 @@ public:
 	S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
 	S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
 
+	// Planes splatted one coordinate per vector for AABBInFrustumBatch(),
+	// without the far plane for the NoFarClip tests
+	struct BatchPlanes
+	{
+		LLVector4a mNormal[AGENT_PLANE_USER_CLIP_NUM][3];
+		LLVector4a mAbsNormal[AGENT_PLANE_USER_CLIP_NUM][3];
+		LLVector4a mOffset[AGENT_PLANE_USER_CLIP_NUM];
+		U32 mCount;
+	};
+	void getBatchPlanes(BatchPlanes& batch_planes, const LLPlane* planes = NULL, bool far_clip = true) const;
+	void getRegionBatchPlanes(BatchPlanes& batch_planes, bool far_clip = true) const;
+
+	// AABBInFrustum() of count boxes at once: bounds[i] points at the center
+	// and radius of box i and results[i] gets its 0/1/2.  Boxes are gathered
+	// four at a time and tested together against each plane.
+	static void AABBInFrustumBatch(const BatchPlanes& planes, const LLVector4a* const* bounds, U32 count, S32* results);
+
 	//does a quick 'n dirty sphere-sphere check
 	S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius); 
 
@@ -27,6 +27,7 @@
 #ifndef LL_LLOCTREE_H
 #define LL_LLOCTREE_H
 
+#include "lloctreepool.h"
 #include "lltreenode.h"
 #include "v3math.h"
 #include "llvector4a.h"
@@ -47,6 +48,29 @@ extern float gOctreeMinSize;
 
 template <class T> class LLOctreeNode;
 
+// Where the nodes of an octree live: on the heap, or in the pool of their
+// element type when that type opted in (see LLOctreeUsePool)
+template <class T, bool POOLED = LLOctreeUsePool<T>::value>
+struct LLOctreeAllocator
+{
+	static void* allocate(size_t size)		{ return ll_aligned_malloc_16(size); }
+	static void release(void* ptr)			{ ll_aligned_free_16(ptr); }
+};
+
+template <class T>
+struct LLOctreeAllocator<T, true>
+{
+	static void* allocate(size_t size)
+	{
+		LLOctreePool& pool = LLOctreePool::instance<T>();
+		// node classes deriving from LLOctreeNode<T> must not add members
+		llassert_always(size <= pool.getNodeSize());
+		return pool.allocate();
+	}
+
+	static void release(void* ptr)			{ LLOctreePool::instance<T>().release(ptr); }
+};
+
 template <class T>
 class LLOctreeListener: public LLTreeListener<T>
 {
@@ -93,12 +117,12 @@ public:
 
 	void* operator new(size_t size)
 	{
-		return ll_aligned_malloc_16(size);
+		return LLOctreeAllocator<T>::allocate(size);
 	}
 
 	void operator delete(void* ptr)
 	{
-		ll_aligned_free_16(ptr);
+		LLOctreeAllocator<T>::release(ptr);
 	}
 
 	LLOctreeNode(	const LLVector4a& center, 
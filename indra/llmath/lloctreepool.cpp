@@ -0,0 +1,88 @@
+/**
+ * @file lloctreepool.cpp
+ * @brief Pool of fixed size slots for the nodes of an octree.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lloctreepool.h"
+
+#include "llmemory.h"
+
+LLOctreePool::LLOctreePool(U32 node_size)
+:	mSlotSize((node_size + 15) & ~15),
+	mNextUnused(CHUNK_SLOTS),
+	mFreeHead(NULL),
+	mNumNodes(0)
+{
+}
+
+LLOctreePool::~LLOctreePool()
+{
+	if (mNumNodes > 0)
+	{
+		LL_WARNS() << mNumNodes << " octree nodes still allocated when destroying their pool" << LL_ENDL;
+	}
+
+	for (U32 i = 0; i < mChunks.size(); ++i)
+	{
+		ll_aligned_free_16(mChunks[i]);
+	}
+}
+
+void* LLOctreePool::allocate()
+{
+	void* node;
+	if (mFreeHead)
+	{
+		node = mFreeHead;
+		mFreeHead = *((void**) node);
+	}
+	else
+	{
+		if (mNextUnused == CHUNK_SLOTS)
+		{
+			mChunks.push_back((U8*) ll_aligned_malloc_16(mSlotSize * CHUNK_SLOTS));
+			mNextUnused = 0;
+		}
+		node = mChunks.back() + mNextUnused * mSlotSize;
+		++mNextUnused;
+	}
+
+	++mNumNodes;
+	return node;
+}
+
+void LLOctreePool::release(void* node)
+{
+	if (!node)
+	{
+		return;
+	}
+
+	llassert(mNumNodes > 0);
+	*((void**) node) = mFreeHead;
+	mFreeHead = node;
+	--mNumNodes;
+}
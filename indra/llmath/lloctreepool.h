@@ -0,0 +1,95 @@
+/**
+ * @file lloctreepool.h
+ * @brief Pool of fixed size slots for the nodes of an octree.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLOCTREEPOOL_H
+#define LL_LLOCTREEPOOL_H
+
+#include "stdtypes.h"
+
+#include <vector>
+
+template <class T> class LLOctreeNode;
+
+// Octree nodes of the element types that set this are allocated from one
+// LLOctreePool per type instead of one by one on the heap (see
+// LLOctreeNode::operator new).  To opt in:
+//
+//   template <> struct LLOctreeUsePool<LLFoo> { static const bool value = true; };
+//
+// before the first LLOctreeNode<LLFoo> is created.  Pooled octrees must
+// only be built and destroyed on one thread.
+template <class T>
+struct LLOctreeUsePool
+{
+	static const bool value = false;
+};
+
+// Fixed size slots for octree nodes, kept in chunks so that nodes built
+// together sit next to each other instead of between the element lists
+// and everything else allocated at the time.  Freed slots are handed out
+// again last in, first out, while they are still in cache, and chunks are
+// never given back before the pool is destroyed.
+class LLOctreePool
+{
+public:
+	LLOctreePool(U32 node_size);
+	~LLOctreePool();
+
+	// Uninitialized, 16 byte aligned memory for one node
+	void* allocate();
+	void release(void* node);
+
+	U32 getNodeSize() const			{ return mSlotSize; }
+	U32 getNumNodes() const			{ return mNumNodes; }
+	U32 getNumChunks() const		{ return (U32) mChunks.size(); }
+
+	// Bytes taken by the chunks
+	U32 getBytes() const			{ return getNumChunks() * mSlotSize * CHUNK_SLOTS; }
+
+	// Pool of the nodes of LLOctreeNode<T>, created on first use and kept
+	// for the life of the process so that octrees may be destroyed at any
+	// time during shutdown
+	template <class T>
+	static LLOctreePool& instance()
+	{
+		static LLOctreePool* pool = new LLOctreePool(sizeof(LLOctreeNode<T>));
+		return *pool;
+	}
+
+private:
+	enum { CHUNK_SLOTS = 256 };
+
+	LLOctreePool(const LLOctreePool&);
+	const LLOctreePool& operator=(const LLOctreePool&);
+
+	std::vector<U8*> mChunks;
+	U32 mSlotSize;
+	U32 mNextUnused;	// first slot of the last chunk never handed out
+	void* mFreeHead;	// last released slot, holds the one released before
+	U32 mNumNodes;
+};
+
+#endif // LL_LLOCTREEPOOL_H
@@ -149,4 +149,53 @@ inline F32 STRING_TO_F32(U8 ival, F32 lower, F32 upper)
 	return val;
 }
 
+// Octahedral encoding of a unit vector in two signed 16 bit components,
+// after Cigolle et al., "A Survey of Efficient Representations for
+// Independent Unit Vectors".  The vector is projected onto the octahedron
+// |x| + |y| + |z| = 1 and the lower half is folded over the upper one.  A
+// zero vector comes back as +Z.
+inline void F32_to_octahedral_S16(const F32* vec, S16* out)
+{
+	F32 l1 = fabsf(vec[0]) + fabsf(vec[1]) + fabsf(vec[2]);
+	if (l1 <= 0.f)
+	{
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+
+	F32 x = vec[0] / l1;
+	F32 y = vec[1] / l1;
+	if (vec[2] < 0.f)
+	{ //fold the lower half over the upper one
+		F32 fold_x = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		F32 fold_y = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = fold_x;
+		y = fold_y;
+	}
+
+	out[0] = (S16)(ll_round(llclamp(x, -1.f, 1.f) * 32767.f));
+	out[1] = (S16)(ll_round(llclamp(y, -1.f, 1.f) * 32767.f));
+}
+
+// Unit vector back from F32_to_octahedral_S16()
+inline void octahedral_S16_to_F32(const S16* in, F32* vec)
+{
+	F32 x = llmax(in[0] * (1.f / 32767.f), -1.f);
+	F32 y = llmax(in[1] * (1.f / 32767.f), -1.f);
+	F32 z = 1.f - fabsf(x) - fabsf(y);
+	if (z < 0.f)
+	{ //unfold the lower half
+		F32 unfold_x = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		F32 unfold_y = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = unfold_x;
+		y = unfold_y;
+	}
+
+	F32 inv_len = 1.f / sqrtf(x * x + y * y + z * z);
+	vec[0] = x * inv_len;
+	vec[1] = y * inv_len;
+	vec[2] = z * inv_len;
+}
+
 #endif
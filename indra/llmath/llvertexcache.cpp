@@ -0,0 +1,296 @@
+/**
+ * @file llvertexcache.cpp
+ * @brief Triangle and vertex reordering for the post transform vertex
+ * cache and for vertex fetch.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvertexcache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	// Same weights as the optimizer LLVolumeFace::cacheOptimize() used to run
+	const F32 CACHE_DECAY_POWER = 1.5f;
+	const F32 LAST_TRI_SCORE = 0.75f;
+	const F32 VALENCE_BOOST_SCALE = 2.f;
+	const F32 VALENCE_BOOST_POWER = 0.5f;
+
+	// Valences past this one all get its (tiny) boost
+	const U32 MAX_SCORED_VALENCE = 64;
+
+	struct ScoreTables
+	{
+		ScoreTables()
+		{
+			for (U32 i = 0; i < LL_VERTEX_CACHE_SIZE; ++i)
+			{
+				if (i < 3)
+				{ //vertex was in the last triangle
+					mCache[i] = LAST_TRI_SCORE;
+				}
+				else
+				{ //more points for being higher in the cache
+					mCache[i] = powf(1.f - (F32) (i - 3) / (LL_VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+				}
+			}
+
+			//bonus points for having low valence, none once every triangle is drawn
+			mValence[0] = 0.f;
+			for (U32 i = 1; i <= MAX_SCORED_VALENCE; ++i)
+			{
+				mValence[i] = VALENCE_BOOST_SCALE * powf((F32) i, -VALENCE_BOOST_POWER);
+			}
+		}
+
+		F32 mCache[LL_VERTEX_CACHE_SIZE];
+		F32 mValence[MAX_SCORED_VALENCE + 1];
+	};
+
+	const ScoreTables sScores;
+
+	inline F32 vertex_score(S32 cache_pos, U32 valence)
+	{
+		F32 score = cache_pos >= 0 ? sScores.mCache[cache_pos] : 0.f;
+		return score + sScores.mValence[llmin(valence, MAX_SCORED_VALENCE)];
+	}
+
+	// Per vertex and per triangle state, kept between calls
+	struct CacheScratch
+	{
+		std::vector<U32> mOffsets;			// First entry of each vertex in mTriangles
+		std::vector<U32> mValences;			// Triangles of each vertex not drawn yet
+		std::vector<S32> mCachePos;			// -1 when not in the cache
+		std::vector<F32> mScores;
+		std::vector<U32> mTriangles;		// Triangles of each vertex, drawn ones moved past its valence
+		std::vector<U8> mDrawn;
+		std::vector<U16> mOutput;
+	};
+}
+
+bool ll_optimize_vertex_cache(U16* indices, U32 index_count, U32 vertex_count)
+{
+	U32 triangle_count = index_count / 3;
+	for (U32 i = 0; i < triangle_count * 3; ++i)
+	{
+		if (indices[i] >= vertex_count)
+		{
+			return false;
+		}
+	}
+
+	if (triangle_count < 2)
+	{ //nothing to do
+		return true;
+	}
+
+	static thread_local CacheScratch scratch;
+	std::vector<U32>& offsets = scratch.mOffsets;
+	std::vector<U32>& valences = scratch.mValences;
+	std::vector<S32>& cache_pos = scratch.mCachePos;
+	std::vector<F32>& scores = scratch.mScores;
+	std::vector<U32>& triangles = scratch.mTriangles;
+	std::vector<U8>& drawn = scratch.mDrawn;
+	std::vector<U16>& output = scratch.mOutput;
+
+	offsets.assign(vertex_count + 1, 0);
+	valences.assign(vertex_count, 0);
+	cache_pos.assign(vertex_count, -1);
+	scores.resize(vertex_count);
+	triangles.resize(triangle_count * 3);
+	drawn.assign(triangle_count, 0);
+	output.resize(triangle_count * 3);
+
+	// Triangles of each vertex, side by side in one array
+	for (U32 i = 0; i < triangle_count * 3; ++i)
+	{
+		valences[indices[i]]++;
+	}
+	for (U32 v = 0; v < vertex_count; ++v)
+	{
+		offsets[v + 1] = offsets[v] + valences[v];
+		valences[v] = 0;
+	}
+	for (U32 i = 0; i < triangle_count * 3; ++i)
+	{
+		U16 v = indices[i];
+		triangles[offsets[v] + valences[v]++] = i / 3;
+	}
+
+	for (U32 v = 0; v < vertex_count; ++v)
+	{
+		scores[v] = vertex_score(-1, valences[v]);
+	}
+
+	// Start from the best scoring triangle, the one with the lowest valences
+	S32 best = 0;
+	F32 best_score = -1.f;
+	for (U32 t = 0; t < triangle_count; ++t)
+	{
+		const U16* tri = indices + t * 3;
+		F32 score = scores[tri[0]] + scores[tri[1]] + scores[tri[2]];
+		if (score > best_score)
+		{
+			best_score = score;
+			best = t;
+		}
+	}
+
+	// LRU cache, plus room for the three vertices that fall off it when a
+	// triangle of new vertices goes in
+	U32 cache[LL_VERTEX_CACHE_SIZE + 3];
+	U32 cache_size = 0;
+	U32 new_cache[LL_VERTEX_CACHE_SIZE + 3];
+
+	U32 next_undrawn = 0;
+	U16* out = &output[0];
+	for (U32 drawn_count = 0; drawn_count < triangle_count; ++drawn_count)
+	{
+		if (best < 0)
+		{ //no triangle left around the cache, go on with the next one not drawn yet
+			while (drawn[next_undrawn])
+			{
+				next_undrawn++;
+			}
+			best = next_undrawn;
+		}
+
+		const U16* tri = indices + best * 3;
+		*out++ = tri[0];
+		*out++ = tri[1];
+		*out++ = tri[2];
+		drawn[best] = 1;
+
+		U32 new_size = 0;
+		for (U32 k = 0; k < 3; ++k)
+		{
+			U16 v = tri[k];
+
+			// Move the triangle past the ones of the vertex still to draw
+			U32* first = &triangles[offsets[v]];
+			U32* last = first + valences[v] - 1;
+			for (U32* iter = first; iter <= last; ++iter)
+			{
+				if (*iter == (U32) best)
+				{
+					std::swap(*iter, *last);
+					valences[v]--;
+					break;
+				}
+			}
+
+			if (std::find(new_cache, new_cache + new_size, v) == new_cache + new_size)
+			{
+				new_cache[new_size++] = v;
+			}
+		}
+
+		for (U32 i = 0; i < cache_size; ++i)
+		{
+			U32 v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+			{
+				new_cache[new_size++] = v;
+			}
+		}
+
+		// Rescore the vertices that moved in the cache or fell off it...
+		for (U32 i = 0; i < new_size; ++i)
+		{
+			U32 v = new_cache[i];
+			cache_pos[v] = i < LL_VERTEX_CACHE_SIZE ? (S32) i : -1;
+			scores[v] = vertex_score(cache_pos[v], valences[v]);
+		}
+
+		// ...and pick the best of their triangles to draw next
+		best = -1;
+		best_score = -1.f;
+		for (U32 i = 0; i < new_size; ++i)
+		{
+			U32 v = new_cache[i];
+			const U32* iter = &triangles[offsets[v]];
+			const U32* end = iter + valences[v];
+			for (; iter != end; ++iter)
+			{
+				const U16* cand = indices + *iter * 3;
+				F32 score = scores[cand[0]] + scores[cand[1]] + scores[cand[2]];
+				if (score > best_score)
+				{
+					best_score = score;
+					best = *iter;
+				}
+			}
+		}
+
+		cache_size = llmin(new_size, LL_VERTEX_CACHE_SIZE);
+		memcpy(cache, new_cache, cache_size * sizeof(U32));
+	}
+
+	memcpy(indices, &output[0], triangle_count * 3 * sizeof(U16));
+	return true;
+}
+
+U32 ll_optimize_vertex_fetch_remap(const U16* indices, U32 index_count, U32 vertex_count, S32* remap)
+{
+	std::fill(remap, remap + vertex_count, -1);
+
+	U32 next = 0;
+	for (U32 i = 0; i < index_count; ++i)
+	{
+		U16 idx = indices[i];
+		if (remap[idx] == -1)
+		{ //this vertex hasn't been used yet
+			remap[idx] = next++;
+		}
+	}
+	return next;
+}
+
+F32 ll_vertex_cache_acmr(const U16* indices, U32 index_count, U32 vertex_count, U32 cache_size)
+{
+	U32 triangle_count = index_count / 3;
+	if (triangle_count == 0)
+	{
+		return 0.f;
+	}
+
+	// A vertex is in the FIFO if fewer than cache_size vertices went in
+	// after it.  Stamps count the misses up to and including its own, 0
+	// for never transformed.
+	std::vector<U32> stamps(vertex_count, 0);
+	U32 misses = 0;
+	for (U32 i = 0; i < triangle_count * 3; ++i)
+	{
+		U32& stamp = stamps[indices[i]];
+		if (stamp == 0 || misses - stamp >= cache_size)
+		{
+			stamp = ++misses;
+		}
+	}
+	return (F32) misses / triangle_count;
+}
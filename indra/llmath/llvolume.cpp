@@ -45,6 +45,11 @@
 #include "lloctree.h"
 #include "llvolume.h"
 #include "llvolumeoctree.h"
+#include "llvolumebvh.h"
+#include "llvolumesculpt.h"
+#include "llvolumetangents.h"
+#include "llvertexcache.h"
+#include "llquantize.h"
 #include "llstl.h"
 #include "llsdserialize.h"
 #include "llvector4a.h"
@@ -682,7 +687,7 @@ LLProfile::Face* LLProfile::addHole(const LLProfileParams& params, BOOL flat, F3
 
 	Face *face = addFace(mTotalOut, mTotal-mTotalOut,0,LL_FACE_INNER_SIDE, flat);
 
-	static LLAlignedArray<LLVector4a,64> pt;
+	static thread_local LLAlignedArray<LLVector4a,64> pt;
 	pt.resize(mTotal) ;
 
 	for (S32 i=mTotalOut;i<mTotal;i++)
@@ -2037,7 +2042,7 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+LLAtomicS32 LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -2053,6 +2058,8 @@ LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL ge
 	mHullIndices = NULL;
 	mNumHullPoints = 0;
 	mNumHullIndices = 0;
+	mCompactFaces = false;
+	mLastFaceAccess = LLFrameTimer::getFrameCount();
 
 	// set defaults
 	if (mParams.getPathParams().getCurveType() == LL_PCODE_PATH_FLEXIBLE)
@@ -2090,12 +2097,13 @@ void LLVolume::regen()
 
 void LLVolume::genTangents(S32 face)
 {
+	expandFaces();
 	mVolumeFaces[face].createTangents();
 }
 
 LLVolume::~LLVolume()
 {
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32) mMesh.size();
 	delete mPathp;
 
 	delete mProfilep;
@@ -2160,9 +2168,9 @@ BOOL LLVolume::generate()
 		S32 sizeS = mPathp->mPath.size();
 		S32 sizeT = mProfilep->mProfile.size();
 
-		sNumMeshPoints -= mMesh.size();
+		sNumMeshPoints -= (S32) mMesh.size();
 		mMesh.resize(sizeT * sizeS);
-		sNumMeshPoints += mMesh.size();		
+		sNumMeshPoints += (S32) mMesh.size();		
 
 		//generate vertex positions
 
@@ -2368,20 +2376,446 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
 	return retval;
 }
 
+// One face of a mesh LoD block. The geometry pointers refer either into the
+// inflated block (direct decode) or into the LLSD::Binary values of a parsed tree.
+struct LLMeshFaceBlock
+{
+	LLMeshFaceBlock()
+	:	mNoGeometry(false),
+		mHasWeights(false),
+		mPosition(NULL), mPositionSize(0),
+		mNormal(NULL), mNormalSize(0),
+		mTexCoord(NULL), mTexCoordSize(0),
+		mIndices(NULL), mIndicesSize(0),
+		mWeights(NULL), mWeightsSize(0)
+	{
+		memset(mPositionMin, 0, sizeof(mPositionMin));
+		memset(mPositionMax, 0, sizeof(mPositionMax));
+		memset(mTexCoordMin, 0, sizeof(mTexCoordMin));
+		memset(mTexCoordMax, 0, sizeof(mTexCoordMax));
+	}
+
+	bool mNoGeometry;
+	bool mHasWeights;
+	const U8* mPosition;	U32 mPositionSize;
+	const U8* mNormal;		U32 mNormalSize;
+	const U8* mTexCoord;	U32 mTexCoordSize;
+	const U8* mIndices;		U32 mIndicesSize;
+	const U8* mWeights;		U32 mWeightsSize;
+	F32 mPositionMin[3];
+	F32 mPositionMax[3];
+	F32 mTexCoordMin[2];
+	F32 mTexCoordMax[2];
+};
+
+// Walks the binary LLSD of a mesh LoD block (as written by LLModel::writeModel) in place:
+// an array of face maps whose geometry is stored as binary values. Returns false on
+// anything it does not expect so the caller can fall back to the generic parser.
+class LLMeshLODReader
+{
+public:
+	LLMeshLODReader(const U8* data, U32 size) : mCur(data), mEnd(data + size) {}
+
+	bool readFaces(std::vector<LLMeshFaceBlock>& faces)
+	{
+		U32 face_count = 0;
+		if (!readType('[') || !readU32(face_count) || face_count > (U32)(mEnd - mCur))
+		{
+			return false;
+		}
+		faces.clear();
+		faces.resize(face_count);
+		for (U32 i = 0; i < face_count; ++i)
+		{
+			if (!readFace(faces[i]))
+			{
+				return false;
+			}
+		}
+		return readType(']');
+	}
+
+private:
+	bool readFace(LLMeshFaceBlock& face)
+	{
+		U32 count = 0;
+		if (!readType('{') || !readU32(count))
+		{
+			return false;
+		}
+		for (U32 i = 0; i < count; ++i)
+		{
+			const char* key = NULL;
+			U32 len = 0;
+			if (!readKey(key, len))
+			{
+				return false;
+			}
+			bool ok;
+			if (isKey(key, len, "Position"))
+			{
+				ok = readBinary(face.mPosition, face.mPositionSize);
+			}
+			else if (isKey(key, len, "Normal"))
+			{
+				ok = readBinary(face.mNormal, face.mNormalSize);
+			}
+			else if (isKey(key, len, "TexCoord0"))
+			{
+				ok = readBinary(face.mTexCoord, face.mTexCoordSize);
+			}
+			else if (isKey(key, len, "TriangleList"))
+			{
+				ok = readBinary(face.mIndices, face.mIndicesSize);
+			}
+			else if (isKey(key, len, "Weights"))
+			{
+				face.mHasWeights = true;
+				ok = readBinary(face.mWeights, face.mWeightsSize);
+			}
+			else if (isKey(key, len, "PositionDomain"))
+			{
+				ok = readDomain(face.mPositionMin, face.mPositionMax, 3);
+			}
+			else if (isKey(key, len, "TexCoord0Domain"))
+			{
+				ok = readDomain(face.mTexCoordMin, face.mTexCoordMax, 2);
+			}
+			else
+			{
+				face.mNoGeometry |= isKey(key, len, "NoGeometry");
+				ok = skipValue(MAX_DEPTH);
+			}
+			if (!ok)
+			{
+				return false;
+			}
+		}
+		return readType('}');
+	}
+
+	bool readDomain(F32* min, F32* max, U32 dim)
+	{
+		U32 count = 0;
+		if (!readType('{') || !readU32(count))
+		{
+			return false;
+		}
+		for (U32 i = 0; i < count; ++i)
+		{
+			const char* key = NULL;
+			U32 len = 0;
+			if (!readKey(key, len))
+			{
+				return false;
+			}
+			bool ok;
+			if (isKey(key, len, "Min"))
+			{
+				ok = readRealArray(min, dim);
+			}
+			else if (isKey(key, len, "Max"))
+			{
+				ok = readRealArray(max, dim);
+			}
+			else
+			{
+				ok = skipValue(MAX_DEPTH);
+			}
+			if (!ok)
+			{
+				return false;
+			}
+		}
+		return readType('}');
+	}
+
+	bool readRealArray(F32* values, U32 dim)
+	{
+		U32 count = 0;
+		if (!readType('[') || !readU32(count))
+		{
+			return false;
+		}
+		for (U32 i = 0; i < count; ++i)
+		{
+			if (i < dim ? !readReal(values[i]) : !skipValue(MAX_DEPTH))
+			{
+				return false;
+			}
+		}
+		return readType(']');
+	}
+
+	bool readReal(F32& value)
+	{
+		if (mCur >= mEnd)
+		{
+			return false;
+		}
+		char type = *mCur++;
+		if (type == 'r' && mEnd - mCur >= 8)
+		{
+			U64 bits = 0;
+			for (U32 i = 0; i < 8; ++i)
+			{
+				bits = (bits << 8) | *mCur++;
+			}
+			F64 real;
+			memcpy(&real, &bits, sizeof(real));
+			value = (F32)real;
+			return true;
+		}
+		U32 integer = 0;
+		if (type == 'i' && readU32(integer))
+		{
+			value = (F32)(S32)integer;
+			return true;
+		}
+		return false;
+	}
+
+	bool readBinary(const U8*& data, U32& size)
+	{
+		if (!readType('b') || !readU32(size) || size > (U32)(mEnd - mCur))
+		{
+			return false;
+		}
+		data = mCur;
+		mCur += size;
+		return true;
+	}
+
+	bool readKey(const char*& key, U32& len)
+	{
+		if (!readType('k') || !readU32(len) || len > (U32)(mEnd - mCur))
+		{
+			return false;
+		}
+		key = (const char*)mCur;
+		mCur += len;
+		return true;
+	}
+
+	static bool isKey(const char* key, U32 len, const char* name)
+	{
+		return strlen(name) == len && !memcmp(key, name, len);
+	}
+
+	bool readType(char type)
+	{
+		if (mCur < mEnd && *mCur == (U8)type)
+		{
+			++mCur;
+			return true;
+		}
+		return false;
+	}
+
+	// sizes are in network byte order
+	bool readU32(U32& value)
+	{
+		if (mEnd - mCur < 4)
+		{
+			return false;
+		}
+		value = ((U32)mCur[0] << 24) | ((U32)mCur[1] << 16) | ((U32)mCur[2] << 8) | (U32)mCur[3];
+		mCur += 4;
+		return true;
+	}
+
+	bool skip(U32 bytes)
+	{
+		if ((U32)(mEnd - mCur) < bytes)
+		{
+			return false;
+		}
+		mCur += bytes;
+		return true;
+	}
+
+	bool skipValue(S32 depth)
+	{
+		if (mCur >= mEnd || depth <= 0)
+		{
+			return false;
+		}
+		U32 count = 0;
+		switch (*mCur++)
+		{
+		case '!':
+		case '0':
+		case '1':
+			return true;
+		case 'i':
+			return skip(4);
+		case 'r':
+		case 'd':
+			return skip(8);
+		case 'u':
+			return skip(16);
+		case 's':
+		case 'l':
+		case 'b':
+			return readU32(count) && skip(count);
+		case '[':
+			if (!readU32(count))
+			{
+				return false;
+			}
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (!skipValue(depth - 1))
+				{
+					return false;
+				}
+			}
+			return readType(']');
+		case '{':
+			if (!readU32(count))
+			{
+				return false;
+			}
+			for (U32 i = 0; i < count; ++i)
+			{
+				const char* key = NULL;
+				U32 len = 0;
+				if (!readKey(key, len) || !skipValue(depth - 1))
+				{
+					return false;
+				}
+			}
+			return readType('}');
+		default:
+			return false;
+		}
+	}
+
+	static const S32 MAX_DEPTH = 16;
+
+	const U8* mCur;
+	const U8* mEnd;
+};
+
+static void set_mesh_face_binary(const LLSD& sd, const U8*& data, U32& size)
+{
+	const LLSD::Binary& binary = sd.asBinary();
+	data = binary.empty() ? NULL : &binary[0];
+	size = binary.size();
+}
+
+// Points the face blocks at the values of a generically parsed LoD block.
+static void get_mesh_face_blocks(const LLSD& mdl, std::vector<LLMeshFaceBlock>& faces)
+{
+	faces.clear();
+	faces.resize(mdl.size());
+	for (U32 i = 0; i < faces.size(); ++i)
+	{
+		const LLSD& sd = mdl[i];
+		LLMeshFaceBlock& face = faces[i];
+
+		face.mNoGeometry = sd.has("NoGeometry");
+		face.mHasWeights = sd.has("Weights");
+		set_mesh_face_binary(sd["Position"], face.mPosition, face.mPositionSize);
+		set_mesh_face_binary(sd["Normal"], face.mNormal, face.mNormalSize);
+		set_mesh_face_binary(sd["TexCoord0"], face.mTexCoord, face.mTexCoordSize);
+		set_mesh_face_binary(sd["TriangleList"], face.mIndices, face.mIndicesSize);
+		set_mesh_face_binary(sd["Weights"], face.mWeights, face.mWeightsSize);
+
+		LLVector3 minp(sd["PositionDomain"]["Min"]);
+		LLVector3 maxp(sd["PositionDomain"]["Max"]);
+		LLVector2 min_tc(sd["TexCoord0Domain"]["Min"]);
+		LLVector2 max_tc(sd["TexCoord0Domain"]["Max"]);
+		memcpy(face.mPositionMin, minp.mV, sizeof(face.mPositionMin));
+		memcpy(face.mPositionMax, maxp.mV, sizeof(face.mPositionMax));
+		memcpy(face.mTexCoordMin, min_tc.mV, sizeof(face.mTexCoordMin));
+		memcpy(face.mTexCoordMax, max_tc.mV, sizeof(face.mTexCoordMax));
+	}
+}
+
+// Loads count (up to 4) little endian U16 values from an unaligned source as floats.
+static inline LLVector4a load_mesh_u16(const U8* src, U32 count)
+{
+	U64 bits = 0;
+	memcpy(&bits, src, count * sizeof(U16));
+	__m128i v = _mm_loadl_epi64((const __m128i*) &bits);
+	return LLVector4a(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128())));
+}
+
+static thread_local LLVolume::UnpackTimes sUnpackTimes;
+
+// static
+const LLVolume::UnpackTimes& LLVolume::getLastUnpackTimes()
+{
+	return sUnpackTimes;
+}
+
 bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 {
+	// Kept per thread so repeated LoD loads reuse their allocations
+	static thread_local std::vector<U8> inflate_buffer;
+	static thread_local std::vector<LLMeshFaceBlock> faces;
+
+	sUnpackTimes.mInflate = sUnpackTimes.mParse = sUnpackTimes.mOptimize = 0.0;
+	LLTimer timer;
+
 	//input stream is now pointing at a zlib compressed block of LLSD
 	//decompress block
-	LLSD mdl;
-	U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, is, size);
+	U32 data_size = 0;
+	U32 uzip_result = LLUZipHelper::unzip(inflate_buffer, data_size, is, size);
+	sUnpackTimes.mInflate = timer.getElapsedTimeAndResetF64();
 	if (uzip_result != LLUZipHelper::ZR_OK)
 	{
 		LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
 		return false;
 	}
-	
+
+	const U8* data = data_size ? &inflate_buffer[0] : NULL;
+	static const char deprecated_header[] = "<? LLSD/Binary ?>\n";
+	const U32 header_size = sizeof(deprecated_header) - 1;
+	if (data_size >= header_size && !memcmp(data, deprecated_header, header_size))
+	{
+		data += header_size;
+		data_size -= header_size;
+	}
+
+	bool success = false;
+	LLMeshLODReader reader(data, data_size);
+	if (reader.readFaces(faces))
+	{
+		success = unpackVolumeFaceBlocks(faces);
+	}
+	else
+	{
+		// Not laid out the way LLModel writes it, take the slow road
+		LLSD mdl;
+		uzip_result = LLUZipHelper::parse_llsd(mdl, data, data_size);
+		if (uzip_result != LLUZipHelper::ZR_OK)
+		{
+			LL_DEBUGS("MeshStreaming") << "Failed to parse LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
+		}
+		else
+		{
+			success = unpackVolumeFacesLLSD(mdl);
+		}
+	}
+	// unpackVolumeFaceBlocks() accounts for its own optimize stage
+	F64 elapsed = timer.getElapsedTimeF64();
+	sUnpackTimes.mParse = llmax(elapsed - sUnpackTimes.mOptimize, 0.0);
+	return success;
+}
+
+bool LLVolume::unpackVolumeFacesLLSD(const LLSD& mdl)
+{
+	std::vector<LLMeshFaceBlock> faces;
+	get_mesh_face_blocks(mdl, faces);
+	return unpackVolumeFaceBlocks(faces);
+}
+
+bool LLVolume::unpackVolumeFaceBlocks(const std::vector<LLMeshFaceBlock>& blocks)
+{
 	{
-		U32 face_count = mdl.size();
+		U32 face_count = blocks.size();
 
 		if (face_count == 0)
 		{ //no faces unpacked, treat as failed decode
@@ -2394,8 +2828,9 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 		for (U32 i = 0; i < face_count; ++i)
 		{
 			LLVolumeFace& face = mVolumeFaces[i];
+			const LLMeshFaceBlock& block = blocks[i];
 
-			if (mdl[i].has("NoGeometry"))
+			if (block.mNoGeometry)
 			{ //face has no geometry, continue
 				face.resizeIndices(3);
 				face.resizeVertices(1);
@@ -2406,85 +2841,68 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 				continue;
 			}
 
-			LLSD::Binary pos = mdl[i]["Position"];
-			LLSD::Binary norm = mdl[i]["Normal"];
-			LLSD::Binary tc = mdl[i]["TexCoord0"];
-			LLSD::Binary idx = mdl[i]["TriangleList"];
-
-			
-
 			//copy out indices
-			face.resizeIndices(idx.size()/2);
+			face.resizeIndices(block.mIndicesSize/2);
 			
-			if (idx.empty() || face.mNumIndices < 3)
+			if (block.mIndicesSize == 0 || face.mNumIndices < 3)
 			{ //why is there an empty index list?
 				LL_WARNS() << "Empty face present! Face index: " << i << " Total: " << face_count << LL_ENDL;
 				continue;
 			}
 
-			U16* indices = (U16*) &(idx[0]);
-			U32 count = idx.size()/2;
-			for (U32 j = 0; j < count; ++j)
-			{
-				face.mIndices[j] = indices[j];
-			}
+			memcpy(face.mIndices, block.mIndices, face.mNumIndices * sizeof(U16));
 
 			//copy out vertices
-			U32 num_verts = pos.size()/(3*2);
+			U32 num_verts = block.mPositionSize/(3*2);
 			face.resizeVertices(num_verts);
 
-			LLVector3 minp;
-			LLVector3 maxp;
-			LLVector2 min_tc; 
-			LLVector2 max_tc; 
-		
-			minp.setValue(mdl[i]["PositionDomain"]["Min"]);
-			maxp.setValue(mdl[i]["PositionDomain"]["Max"]);
 			LLVector4a min_pos, max_pos;
-			min_pos.load3(minp.mV);
-			max_pos.load3(maxp.mV);
+			min_pos.load3(block.mPositionMin);
+			max_pos.load3(block.mPositionMax);
 
-			min_tc.setValue(mdl[i]["TexCoord0Domain"]["Min"]);
-			max_tc.setValue(mdl[i]["TexCoord0Domain"]["Max"]);
+			// (v / 65535) * range + min, folded into one multiply-add per vertex
+			LLVector4a pos_scale;
+			pos_scale.setSub(max_pos, min_pos);
+			pos_scale.mul(1.f / 65535.f);
 
-			LLVector4a pos_range;
-			pos_range.setSub(max_pos, min_pos);
-			LLVector2 tc_range2 = max_tc - min_tc;
+			LLVector2 tc_range2(block.mTexCoordMax[0] - block.mTexCoordMin[0], block.mTexCoordMax[1] - block.mTexCoordMin[1]);
 
-			LLVector4a tc_range;
-			tc_range.set(tc_range2[0], tc_range2[1], tc_range2[0], tc_range2[1]);
-			LLVector4a min_tc4(min_tc[0], min_tc[1], min_tc[0], min_tc[1]);
+			LLVector4a tc_scale;
+			tc_scale.set(tc_range2[0], tc_range2[1], tc_range2[0], tc_range2[1]);
+			tc_scale.mul(1.f / 65535.f);
+			LLVector4a min_tc4(block.mTexCoordMin[0], block.mTexCoordMin[1], block.mTexCoordMin[0], block.mTexCoordMin[1]);
 
 			LLVector4a* pos_out = face.mPositions;
 			LLVector4a* norm_out = face.mNormals;
 			LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
 
 			{
-				U16* v = (U16*) &(pos[0]);
+				const U8* v = block.mPosition;
 				for (U32 j = 0; j < num_verts; ++j)
 				{
-					pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
-					pos_out->div(65535.f);
-					pos_out->mul(pos_range);
+					pos_out->setMul(load_mesh_u16(v, 3), pos_scale);
 					pos_out->add(min_pos);
 					pos_out++;
-					v += 3;
+					v += 3*sizeof(U16);
 				}
 
 			}
 
 			{
-				if (!norm.empty())
+				if (block.mNormalSize >= num_verts*3*sizeof(U16) && block.mNormalSize > 0)
 				{
-					U16* n = (U16*) &(norm[0]);
+					LLVector4a norm_scale;
+					norm_scale.splat(2.f / 65535.f);
+					LLVector4a one;
+					one.splat(1.f);
+
+					const U8* n = block.mNormal;
 					for (U32 j = 0; j < num_verts; ++j)
 					{
-						norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
-						norm_out->div(65535.f);
-						norm_out->mul(2.f);
-						norm_out->sub(1.f);
+						norm_out->setMul(load_mesh_u16(n, 3), norm_scale);
+						norm_out->sub(one);
 						norm_out++;
-						n += 3;
+						n += 3*sizeof(U16);
 					}
 				}
 				else
@@ -2498,26 +2916,16 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 			}
 
 			{
-				if (!tc.empty())
+				if (block.mTexCoordSize >= num_verts*2*sizeof(U16) && block.mTexCoordSize > 0)
 				{
-					U16* t = (U16*) &(tc[0]);
+					// two vertices per LLVector4a
+					const U8* t = block.mTexCoord;
 					for (U32 j = 0; j < num_verts; j+=2)
 					{
-						if (j < num_verts-1)
-						{
-							tc_out->set((F32) t[0], (F32) t[1], (F32) t[2], (F32) t[3]);
-						}
-						else
-						{
-							tc_out->set((F32) t[0], (F32) t[1], 0.f, 0.f);
-						}
-
-						t += 4;
-
-						tc_out->div(65535.f);
-						tc_out->mul(tc_range);
+						tc_out->setMul(load_mesh_u16(t, j < num_verts-1 ? 4 : 2), tc_scale);
 						tc_out->add(min_tc4);
 
+						t += 4*sizeof(U16);
 						tc_out++;
 					}
 				}
@@ -2531,16 +2939,17 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 				}
 			}
 
-			if (mdl[i].has("Weights"))
+			if (block.mHasWeights)
 			{
 				face.allocateWeights(num_verts);
 
-				LLSD::Binary weights = mdl[i]["Weights"];
+				const U8* weights = block.mWeights;
+				const U32 weights_size = block.mWeightsSize;
 
 				U32 idx = 0;
 
 				U32 cur_vertex = 0;
-				while (idx < weights.size() && cur_vertex < num_verts)
+				while (idx < weights_size && cur_vertex < num_verts)
 				{
 					const U8 END_INFLUENCES = 0xFF;
 					U8 joint = weights[idx++];
@@ -2550,7 +2959,7 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
                     U32 joints[4] = {0,0,0,0};
 					LLVector4 joints_with_weights(0,0,0,0);
 
-					while (joint != END_INFLUENCES && idx < weights.size())
+					while (joint != END_INFLUENCES && idx < weights_size)
 					{
 						U16 influence = weights[idx++];
 						influence |= ((U16) weights[idx++] << 8);
@@ -2587,7 +2996,7 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 					cur_vertex++;
 				}
 
-				if (cur_vertex != num_verts || idx != weights.size())
+				if (cur_vertex != num_verts || idx != weights_size)
 				{
 					LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
 				}
@@ -2693,7 +3102,10 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 		}
 	}
 
-	if (!cacheOptimize())
+	LLTimer optimize_timer;
+	bool optimized = cacheOptimize();
+	sUnpackTimes.mOptimize = optimize_timer.getElapsedTimeF64();
+	if (!optimized)
 	{
 		// Out of memory?
 		LL_WARNS() << "Failed to optimize!" << LL_ENDL;
@@ -2706,6 +3118,250 @@ bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 	return true;
 }
 
+// Layout of the block written by LLVolume::packDecodedFaces():
+//
+//   LLDecodedFacesHeader
+//   per face:  LLDecodedFaceHeader, positions, normals, texture coordinates,
+//              indices and, if flagged, weights; each array padded to 16 bytes
+const U32 DECODED_FACES_VERSION = 1;
+const U32 DECODED_FACE_HAS_WEIGHTS = 0x1;
+
+struct LLDecodedFacesHeader
+{
+	U32 mVersion;
+	U32 mFaceCount;
+	U32 mSculptType;
+	U32 mPad;
+};
+
+struct LLDecodedFaceHeader
+{
+	S32 mNumVertices;
+	S32 mNumIndices;
+	U32 mFlags;
+	U32 mPad;
+	F32 mExtents[8];
+	F32 mTexCoordExtents[4];
+};
+
+static inline U64 decoded_pad16(U64 size)
+{
+	return (size + 0xF) & ~(U64)0xF;
+}
+
+static U64 decoded_face_data_size(S32 num_verts, S32 num_indices, bool weights)
+{
+	U64 size = sizeof(LLVector4a) * 2 * (U64)num_verts;
+	size += decoded_pad16(sizeof(LLVector2) * (U64)num_verts);
+	size += decoded_pad16(sizeof(U16) * (U64)num_indices);
+	if (weights)
+	{
+		size += sizeof(LLVector4a) * (U64)num_verts;
+	}
+	return size;
+}
+
+static U8* decoded_copy_out(U8* dst, const void* src, U64 size)
+{
+	if (size)
+	{
+		memcpy(dst, src, size);
+	}
+	U64 padded = decoded_pad16(size);
+	memset(dst + size, 0, padded - size);
+	return dst + padded;
+}
+
+bool LLVolume::packDecodedFaces(std::vector<U8>& out) const
+{
+	expandFaces();
+
+	U64 size = sizeof(LLDecodedFacesHeader);
+	for (S32 i = 0; i < getNumVolumeFaces(); ++i)
+	{
+		const LLVolumeFace& face = mVolumeFaces[i];
+		size += sizeof(LLDecodedFaceHeader) + decoded_face_data_size(face.mNumVertices, face.mNumIndices, face.mWeights != NULL);
+	}
+
+	if (mVolumeFaces.empty() || size > U32_MAX)
+	{
+		return false;
+	}
+
+	try
+	{
+		out.resize(size);
+	}
+	catch (std::bad_alloc&)
+	{
+		LL_WARNS("LLVOLUME") << "Failed to allocate " << size << " bytes for decoded faces" << LL_ENDL;
+		return false;
+	}
+
+	U8* dst = &out[0];
+
+	LLDecodedFacesHeader header;
+	header.mVersion = DECODED_FACES_VERSION;
+	header.mFaceCount = mVolumeFaces.size();
+	header.mSculptType = mParams.getSculptType();
+	header.mPad = 0;
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+
+	for (S32 i = 0; i < getNumVolumeFaces(); ++i)
+	{
+		const LLVolumeFace& face = mVolumeFaces[i];
+		const S32 num_verts = face.mNumVertices;
+
+		LLDecodedFaceHeader face_header;
+		face_header.mNumVertices = num_verts;
+		face_header.mNumIndices = face.mNumIndices;
+		face_header.mFlags = face.mWeights ? DECODED_FACE_HAS_WEIGHTS : 0;
+		face_header.mPad = 0;
+		memcpy(face_header.mExtents, face.mExtents, sizeof(face_header.mExtents));
+		memcpy(face_header.mTexCoordExtents, face.mTexCoordExtents, sizeof(face_header.mTexCoordExtents));
+		memcpy(dst, &face_header, sizeof(face_header));
+		dst += sizeof(face_header);
+
+		dst = decoded_copy_out(dst, face.mPositions, sizeof(LLVector4a) * num_verts);
+		dst = decoded_copy_out(dst, face.mNormals, sizeof(LLVector4a) * num_verts);
+		dst = decoded_copy_out(dst, face.mTexCoords, sizeof(LLVector2) * num_verts);
+		dst = decoded_copy_out(dst, face.mIndices, sizeof(U16) * face.mNumIndices);
+		if (face.mWeights)
+		{
+			dst = decoded_copy_out(dst, face.mWeights, sizeof(LLVector4a) * num_verts);
+		}
+	}
+
+	llassert(dst == &out[0] + out.size());
+	return true;
+}
+
+bool LLVolume::unpackDecodedFaces(const U8* data, U32 size)
+{
+	LLDecodedFacesHeader header;
+	if (!data || size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.mVersion != DECODED_FACES_VERSION
+		|| header.mSculptType != mParams.getSculptType()
+		|| header.mFaceCount == 0
+		|| header.mFaceCount > (size - sizeof(header)) / sizeof(LLDecodedFaceHeader))
+	{
+		return false;
+	}
+
+	std::vector<LLVolumeFace> faces;
+	try
+	{
+		faces.resize(header.mFaceCount);
+	}
+	catch (std::bad_alloc&)
+	{
+		return false;
+	}
+
+	U64 offset = sizeof(header);
+	for (U32 i = 0; i < header.mFaceCount; ++i)
+	{
+		LLDecodedFaceHeader face_header;
+		if (offset + sizeof(face_header) > size)
+		{
+			return false;
+		}
+		memcpy(&face_header, data + offset, sizeof(face_header));
+		offset += sizeof(face_header);
+
+		const S32 num_verts = face_header.mNumVertices;
+		const S32 num_indices = face_header.mNumIndices;
+		const bool has_weights = (face_header.mFlags & DECODED_FACE_HAS_WEIGHTS) != 0;
+		if (num_verts < 0 || num_verts > 65536 || num_indices < 0
+			|| offset + decoded_face_data_size(num_verts, num_indices, has_weights) > size)
+		{
+			return false;
+		}
+
+		const U8* positions = data + offset;
+		offset += sizeof(LLVector4a) * num_verts;
+		const U8* normals = data + offset;
+		offset += sizeof(LLVector4a) * num_verts;
+		const U8* tex_coords = data + offset;
+		offset += decoded_pad16(sizeof(LLVector2) * num_verts);
+		const U8* indices = data + offset;
+		offset += decoded_pad16(sizeof(U16) * num_indices);
+		const U8* weights = data + offset;
+		if (has_weights)
+		{
+			offset += sizeof(LLVector4a) * num_verts;
+		}
+
+		LLVolumeFace& face = faces[i];
+		face.resizeVertices(num_verts);
+		face.resizeIndices(num_indices);
+		if ((num_verts && !face.mPositions) || (num_indices && !face.mIndices))
+		{
+			return false;
+		}
+
+		if (num_verts)
+		{
+			memcpy(face.mPositions, positions, sizeof(LLVector4a) * num_verts);
+			memcpy(face.mNormals, normals, sizeof(LLVector4a) * num_verts);
+			memcpy(face.mTexCoords, tex_coords, sizeof(LLVector2) * num_verts);
+		}
+		if (num_indices)
+		{
+			memcpy(face.mIndices, indices, sizeof(U16) * num_indices);
+		}
+
+		// Rendering trusts the indices, never let a bad cache entry through
+		if (num_verts > 0)
+		{
+			for (S32 j = 0; j < num_indices; ++j)
+			{
+				if (face.mIndices[j] >= num_verts)
+				{
+					return false;
+				}
+			}
+		}
+		else if (num_indices >= 3)
+		{
+			return false;
+		}
+
+		if (has_weights)
+		{
+			face.allocateWeights(num_verts);
+			if (num_verts)
+			{
+				memcpy(face.mWeights, weights, sizeof(LLVector4a) * num_verts);
+
+				// Joint index in the integer part, weight in the fraction, as unpackVolumeFaces() writes them
+				const F32* w = face.mWeights[0].getF32ptr();
+				for (S32 j = 0; j < num_verts * 4; ++j)
+				{
+					if (!(w[j] >= 0.f && w[j] < 255.f))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		memcpy(face.mExtents, face_header.mExtents, sizeof(face_header.mExtents));
+		memcpy(face.mTexCoordExtents, face_header.mTexCoordExtents, sizeof(face_header.mTexCoordExtents));
+		face.mOptimized = TRUE;
+	}
+
+	mVolumeFaces.swap(faces);
+	mSculptLevel = 0;
+	return true;
+}
+
 
 BOOL LLVolume::isMeshAssetLoaded()
 {
@@ -2736,6 +3392,7 @@ void LLVolume::copyVolumeFaces(const LLVolume* volume)
 
 bool LLVolume::cacheOptimize()
 {
+	expandFaces();
 	for (S32 i = 0; i < mVolumeFaces.size(); ++i)
 	{
 		if (!mVolumeFaces[i].cacheOptimize())
@@ -2746,6 +3403,41 @@ bool LLVolume::cacheOptimize()
 	return true;
 }
 
+void LLVolume::compactFaces()
+{
+	for (S32 i = 0; i < mVolumeFaces.size(); ++i)
+	{
+		mVolumeFaces[i].compact();
+		mCompactFaces = mCompactFaces || mVolumeFaces[i].isCompact();
+	}
+}
+
+void LLVolume::expandFaces() const
+{
+	if (!mCompactFaces)
+	{
+		return;
+	}
+
+	//decoding doesn't change what the faces hold, only how
+	face_list_t& faces = const_cast<face_list_t&>(mVolumeFaces);
+	for (S32 i = 0; i < faces.size(); ++i)
+	{
+		faces[i].expand();
+	}
+	mCompactFaces = false;
+}
+
+S32 LLVolume::getCompactSavings() const
+{
+	S32 savings = 0;
+	for (S32 i = 0; i < mVolumeFaces.size(); ++i)
+	{
+		savings += mVolumeFaces[i].getCompactSavings();
+	}
+	return savings;
+}
+
 
 S32	LLVolume::getNumFaces() const
 {
@@ -2755,6 +3447,9 @@ S32	LLVolume::getNumFaces() const
 
 void LLVolume::createVolumeFaces()
 {
+	//partial builds write over the vertex data in place
+	expandFaces();
+
 	if (mGenerateSingleFace)
 	{
 		// do nothing
@@ -2980,112 +3675,31 @@ void LLVolume::sculptGenerateSpherePlaceholder()
 
 
 			F32 u = (F32)s / (sizeS - 1);
-			F32 v = (F32)t / (sizeT - 1);
-
-			const F32 RADIUS = (F32) 0.3;
-
-			F32* p = pt.getF32ptr();
-
-			p[0] = (F32)(sin(F_PI * v) * cos(2.0 * F_PI * u) * RADIUS);
-			p[1] = (F32)(sin(F_PI * v) * sin(2.0 * F_PI * u) * RADIUS);
-			p[2] = (F32)(cos(F_PI * v) * RADIUS);
-
-			llassert(pt.isFinite3());
-		}
-		line += sizeT;
-	}
-}
-
-// create the vertices from the map
-void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type)
-{
-	U8 sculpt_stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
-	BOOL sculpt_invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
-	BOOL sculpt_mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
-	BOOL reverse_horizontal = (sculpt_invert ? !sculpt_mirror : sculpt_mirror);  // XOR
-	
-	S32 sizeS = mPathp->mPath.size();
-	S32 sizeT = mProfilep->mProfile.size();
-	
-	S32 line = 0;
-	for (S32 s = 0; s < sizeS; s++)
-	{
-		// Run along the profile.
-		for (S32 t = 0; t < sizeT; t++)
-		{
-			S32 i = t + line;
-			LLVector4a& pt = mMesh[i];
-
-			S32 reversed_t = t;
-
-			if (reverse_horizontal)
-			{
-				reversed_t = sizeT - t - 1;
-			}
-			
-			U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
-			U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
-
-			
-			if (y == 0)  // top row stitching
-			{
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
-			}
-
-			if (y == sculpt_height)  // bottom row stitching
-			{
-				// wrap?
-				if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
-				{
-					y = 0;
-				}
-				else
-				{
-					y = sculpt_height - 1;
-				}
-
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
-			}
-
-			if (x == sculpt_width)   // side stitching
-			{
-				// wrap?
-				if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
-				{
-					x = 0;
-				}
-					
-				else
-				{
-					x = sculpt_width - 1;
-				}
-			}
+			F32 v = (F32)t / (sizeT - 1);
 
-			pt = sculpt_xy_to_vector(x, y, sculpt_width, sculpt_height, sculpt_components, sculpt_data);
+			const F32 RADIUS = (F32) 0.3;
 
-			if (sculpt_mirror)
-			{
-				LLVector4a scale(-1.f,1,1,1);
-				pt.mul(scale);
-			}
+			F32* p = pt.getF32ptr();
+
+			p[0] = (F32)(sin(F_PI * v) * cos(2.0 * F_PI * u) * RADIUS);
+			p[1] = (F32)(sin(F_PI * v) * sin(2.0 * F_PI * u) * RADIUS);
+			p[2] = (F32)(cos(F_PI * v) * RADIUS);
 
 			llassert(pt.isFinite3());
 		}
-		
 		line += sizeT;
 	}
 }
 
+// create the vertices from the map
+void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type)
+{
+	S32 sizeS = mPathp->mPath.size();
+	S32 sizeT = mProfilep->mProfile.size();
+
+	ll_sculpt_generate_positions(mMesh.mArray, sizeS, sizeT, sculpt_width, sculpt_height, sculpt_components, sculpt_data, sculpt_type);
+}
+
 
 const S32 SCULPT_REZ_1 = 6;  // changed from 4 to 6 - 6 looks round whereas 4 looks square
 const S32 SCULPT_REZ_2 = 8;
@@ -3182,19 +3796,31 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 		LL_WARNS() << "sculpt bad mesh size " << sizeS << " " << sizeT << LL_ENDL;
 	}
 	
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32) mMesh.size();
 	mMesh.resize(sizeS * sizeT);
-	sNumMeshPoints += mMesh.size();
+	sNumMeshPoints += (S32) mMesh.size();
 
 	//generate vertex positions
 	if (!data_is_empty)
 	{
-		sculptGenerateMapVertices(sculpt_width, sculpt_height, sculpt_components, sculpt_data, sculpt_type);
+		// other sculpties with the same map at the same resolution may have
+		// generated the positions already
+		LLSculptCache::Key key(mParams.getSculptID(), sculpt_level, sculpt_type, sculpt_width, sculpt_height, sizeS, sizeT);
+		bool cacheable = mParams.getSculptID().notNull();
+		F32 area = -1.f;
+		bool cached = cacheable && LLSculptCache::instance().find(key, mMesh.mArray, area);
+		if (!cached)
+		{
+			sculptGenerateMapVertices(sculpt_width, sculpt_height, sculpt_components, sculpt_data, sculpt_type);
+		}
 
 		// don't test lowest LOD to support legacy content DEV-33670
 		if (mDetail > SCULPT_MIN_AREA_DETAIL)
 		{
-			F32 area = sculptGetSurfaceArea();
+			if (area < 0.f)
+			{
+				area = sculptGetSurfaceArea();
+			}
 
 			mSurfaceArea = area;
 
@@ -3206,6 +3832,11 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 				visible_placeholder = true;
 			}
 		}
+
+		if (cacheable && !cached)
+		{
+			LLSculptCache::instance().insert(key, mMesh.mArray, area);
+		}
 	}
 
 	if (data_is_empty)
@@ -3736,6 +4367,8 @@ void LLVolume::generateSilhouetteVertices(std::vector<LLVector3> &vertices,
 	{
 		return;
 	}
+
+	expandFaces();
 	
 	S32 cur_index = 0;
 	//for each face
@@ -3975,6 +4608,70 @@ void LLVolume::generateSilhouetteVertices(std::vector<LLVector3> &vertices,
 	}
 }
 
+// Fills in what the caller of lineSegmentIntersect() asked for about a hit
+// at start + t * dir on the triangle idx0 idx1 idx2 of face, a and b being
+// the barycentric coordinates of the hit
+static void fill_hit_attributes(const LLVolumeFace& face, U16 idx0, U16 idx1, U16 idx2,
+								const LLVector4a& start, const LLVector4a& dir, F32 t, F32 a, F32 b,
+								LLVector4a* intersection, LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent_out)
+{
+	if (intersection != NULL)
+	{
+		LLVector4a intersect = dir;
+		intersect.mul(t);
+		intersect.add(start);
+		*intersection = intersect;
+	}
+
+	if (tex_coord != NULL)
+	{
+		LLVector2* tc = (LLVector2*) face.mTexCoords;
+		*tex_coord = ((1.f - a - b)  * tc[idx0] +
+			a              * tc[idx1] +
+			b              * tc[idx2]);
+	}
+
+	if (normal!= NULL)
+	{
+		LLVector4a* norm = face.mNormals;
+		
+		LLVector4a n1,n2,n3;
+		n1 = norm[idx0];
+		n1.mul(1.f-a-b);
+		
+		n2 = norm[idx1];
+		n2.mul(a);
+		
+		n3 = norm[idx2];
+		n3.mul(b);
+
+		n1.add(n2);
+		n1.add(n3);
+		
+		*normal		= n1; 
+	}
+
+	if (tangent_out != NULL)
+	{
+		LLVector4a* tangents = face.mTangents;
+		
+		LLVector4a t1,t2,t3;
+		t1 = tangents[idx0];
+		t1.mul(1.f-a-b);
+		
+		t2 = tangents[idx1];
+		t2.mul(a);
+		
+		t3 = tangents[idx2];
+		t3.mul(b);
+
+		t1.add(t2);
+		t1.add(t3);
+		
+		*tangent_out = t1; 
+	}
+}
+
 S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& end, 
 								   S32 face,
 								   LLVector4a* intersection,LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent_out)
@@ -3995,6 +4692,8 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 		end_face = face;
 	}
 
+	expandFaces();
+
 	LLVector4a dir;
 	dir.setSub(end, start);
 
@@ -4021,7 +4720,7 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 			}
 
 			if (isUnique())
-			{ //don't bother with an octree for flexi volumes
+			{ //don't bother with a BVH for flexi volumes
 				U32 tri_count = face.mNumIndices/3;
 
 				for (U32 j = 0; j < tri_count; ++j)
@@ -4046,79 +4745,28 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 							closest_t = t;
 							hit_face = i;
 
-							if (intersection != NULL)
-							{
-								LLVector4a intersect = dir;
-								intersect.mul(closest_t);
-								intersect.add(start);
-								*intersection = intersect;
-							}
-
-
-							if (tex_coord != NULL)
-							{
-								LLVector2* tc = (LLVector2*) face.mTexCoords;
-								*tex_coord = ((1.f - a - b)  * tc[idx0] +
-									a              * tc[idx1] +
-									b              * tc[idx2]);
-
-							}
-
-							if (normal!= NULL)
-							{
-								LLVector4a* norm = face.mNormals;
-								
-								LLVector4a n1,n2,n3;
-								n1 = norm[idx0];
-								n1.mul(1.f-a-b);
-								
-								n2 = norm[idx1];
-								n2.mul(a);
-								
-								n3 = norm[idx2];
-								n3.mul(b);
-
-								n1.add(n2);
-								n1.add(n3);
-								
-								*normal		= n1; 
-							}
-
-							if (tangent_out != NULL)
-							{
-								LLVector4a* tangents = face.mTangents;
-								
-								LLVector4a t1,t2,t3;
-								t1 = tangents[idx0];
-								t1.mul(1.f-a-b);
-								
-								t2 = tangents[idx1];
-								t2.mul(a);
-								
-								t3 = tangents[idx2];
-								t3.mul(b);
-
-								t1.add(t2);
-								t1.add(t3);
-								
-								*tangent_out = t1; 
-							}
+							fill_hit_attributes(face, idx0, idx1, idx2, start, dir, t, a, b,
+												intersection, tex_coord, normal, tangent_out);
 						}
 					}
 				}
 			}
 			else
 			{
-				if (!face.mOctree)
+				if (!face.mBVH)
 				{
-					face.createOctree();
+					face.createBVH();
 				}
-			
-				LLOctreeTriangleRayIntersect intersect(start, dir, &face, &closest_t, intersection, tex_coord, normal, tangent_out);
-				intersect.traverse(face.mOctree);
-				if (intersect.mHitFace)
+
+				F32 a,b;
+				S32 tri = face.mBVH->intersect(start, dir, closest_t, a, b);
+				if (tri >= 0)
 				{
 					hit_face = i;
+
+					fill_hit_attributes(face, face.mIndices[tri*3+0], face.mIndices[tri*3+1], face.mIndices[tri*3+2],
+										start, dir, closest_t, a, b,
+										intersection, tex_coord, normal, tangent_out);
 				}
 			}
 		}		
@@ -4670,7 +5318,11 @@ LLVolumeFace::LLVolumeFace() :
 #endif
     mWeightsScrubbed(FALSE),
 	mOctree(NULL),
-	mOptimized(FALSE)
+	mBVH(NULL),
+	mOptimized(FALSE),
+	mCompactVertices(NULL),
+	mCompactTexCoords(NULL),
+	mCompactTangents(FALSE)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mExtents[0].splat(-0.5f);
@@ -4699,7 +5351,11 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
     mJointIndices(NULL),
 #endif
     mWeightsScrubbed(FALSE),
-	mOctree(NULL)
+	mOctree(NULL),
+	mBVH(NULL),
+	mCompactVertices(NULL),
+	mCompactTexCoords(NULL),
+	mCompactTangents(FALSE)
 { 
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mCenter = mExtents+2;
@@ -4736,28 +5392,39 @@ LLVolumeFace& LLVolumeFace::operator=(const LLVolumeFace& src)
 	{
 		S32 vert_size = mNumVertices*sizeof(LLVector4a);
 		S32 tc_size = (mNumVertices*sizeof(LLVector2)+0xF) & ~0xF;
-			
-		LLVector4a::memcpyNonAliased16((F32*) mPositions, (F32*) src.mPositions, vert_size);
 
-		if (src.mNormals)
-		{
-		LLVector4a::memcpyNonAliased16((F32*) mNormals, (F32*) src.mNormals, vert_size);
-		}
-
-		if(src.mTexCoords)
-		{
-			LLVector4a::memcpyNonAliased16((F32*) mTexCoords, (F32*) src.mTexCoords, tc_size);
-		}
-
-		if (src.mTangents)
-		{
-			allocateTangents(src.mNumVertices);
-			LLVector4a::memcpyNonAliased16((F32*) mTangents, (F32*) src.mTangents, vert_size);
+		if (src.isCompact())
+		{ //copies get the decoded vertex data
+			if (src.mCompactTangents)
+			{
+				allocateTangents(src.mNumVertices);
+			}
+			decodeCompact(src);
 		}
 		else
 		{
-			ll_aligned_free_16(mTangents);
-			mTangents = NULL;
+			LLVector4a::memcpyNonAliased16((F32*) mPositions, (F32*) src.mPositions, vert_size);
+
+			if (src.mNormals)
+			{
+			LLVector4a::memcpyNonAliased16((F32*) mNormals, (F32*) src.mNormals, vert_size);
+			}
+
+			if(src.mTexCoords)
+			{
+				LLVector4a::memcpyNonAliased16((F32*) mTexCoords, (F32*) src.mTexCoords, tc_size);
+			}
+
+			if (src.mTangents)
+			{
+				allocateTangents(src.mNumVertices);
+				LLVector4a::memcpyNonAliased16((F32*) mTangents, (F32*) src.mTangents, vert_size);
+			}
+			else
+			{
+				ll_aligned_free_16(mTangents);
+				mTangents = NULL;
+			}
 		}
 
 		if (src.mWeights)
@@ -4842,6 +5509,8 @@ void LLVolumeFace::freeData()
 
 	delete mOctree;
 	mOctree = NULL;
+	destroyBVH();
+	freeCompact();
 }
 
 BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
@@ -4849,6 +5518,7 @@ BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
 	//tree for this face is no longer valid
 	delete mOctree;
 	mOctree = NULL;
+	destroyBVH();
 
 	LL_CHECK_MEMORY
 	BOOL ret = FALSE ;
@@ -4911,366 +5581,102 @@ bool LLVolumeFace::VertexMapData::ComparePosition::operator()(const LLVector3& a
 		return a.mV[1] < b.mV[1];
 	}
 	
-	return a.mV[2] < b.mV[2];
-}
-
-void LLVolumeFace::optimize(F32 angle_cutoff)
-{
-	LLVolumeFace new_face;
-
-	//map of points to vector of vertices at that point
-	std::map<U64, std::vector<VertexMapData> > point_map;
-
-	LLVector4a range;
-	range.setSub(mExtents[1],mExtents[0]);
-
-	//remove redundant vertices
-	for (U32 i = 0; i < mNumIndices; ++i)
-	{
-		U16 index = mIndices[i];
-
-		LLVolumeFace::VertexData cv;
-		getVertexData(index, cv);
-		
-		BOOL found = FALSE;
-
-		LLVector4a pos;
-		pos.setSub(mPositions[index], mExtents[0]);
-		pos.div(range);
-
-		U64 pos64 = 0;
-
-		pos64 = (U16) (pos[0]*65535);
-		pos64 = pos64 | (((U64) (pos[1]*65535)) << 16);
-		pos64 = pos64 | (((U64) (pos[2]*65535)) << 32);
-
-		std::map<U64, std::vector<VertexMapData> >::iterator point_iter = point_map.find(pos64);
-		
-		if (point_iter != point_map.end())
-		{ //duplicate point might exist
-			for (U32 j = 0; j < point_iter->second.size(); ++j)
-			{
-				LLVolumeFace::VertexData& tv = (point_iter->second)[j];
-				if (tv.compareNormal(cv, angle_cutoff))
-				{
-					found = TRUE;
-					new_face.pushIndex((point_iter->second)[j].mIndex);
-					break;
-				}
-			}
-		}
-
-		if (!found)
-		{
-			new_face.pushVertex(cv);
-			U16 index = (U16) new_face.mNumVertices-1;
-			new_face.pushIndex(index);
-
-			VertexMapData d;
-			d.setPosition(cv.getPosition());
-			d.mTexCoord = cv.mTexCoord;
-			d.setNormal(cv.getNormal());
-			d.mIndex = index;
-			if (point_iter != point_map.end())
-			{
-				point_iter->second.push_back(d);
-			}
-			else
-			{
-				point_map[pos64].push_back(d);
-			}
-		}
-	}
-
-
-	if (angle_cutoff > 1.f && !mNormals)
-	{
-		// Now alloc'd with positions
-		//ll_aligned_free_16(new_face.mNormals);
-		new_face.mNormals = NULL;
-	}
-
-	if (!mTexCoords)
-	{
-		// Now alloc'd with positions
-		//ll_aligned_free_16(new_face.mTexCoords);
-		new_face.mTexCoords = NULL;
-	}
-
-	// Only swap data if we've actually optimized the mesh
-	//
-	if (new_face.mNumVertices <= mNumVertices)
-	{
-        llassert(new_face.mNumIndices == mNumIndices);
-		swapData(new_face);
-	}
-
-}
-
-class LLVCacheTriangleData;
-
-class LLVCacheVertexData
-{
-public:
-	S32 mIdx;
-	S32 mCacheTag;
-	F64 mScore;
-	U32 mActiveTriangles;
-	std::vector<LLVCacheTriangleData*> mTriangles;
-
-	LLVCacheVertexData()
-	{
-		mCacheTag = -1;
-		mScore = 0.0;
-		mActiveTriangles = 0;
-		mIdx = -1;
-	}
-};
-
-class LLVCacheTriangleData
-{
-public:
-	bool mActive;
-	F64 mScore;
-	LLVCacheVertexData* mVertex[3];
-
-	LLVCacheTriangleData()
-	{
-		mActive = true;
-		mScore = 0.0;
-		mVertex[0] = mVertex[1] = mVertex[2] = NULL;
-	}
-
-	void complete()
-	{
-		mActive = false;
-		for (S32 i = 0; i < 3; ++i)
-		{
-			if (mVertex[i])
-			{
-				llassert(mVertex[i]->mActiveTriangles > 0);
-				mVertex[i]->mActiveTriangles--;
-			}
-		}
-	}
-
-	bool operator<(const LLVCacheTriangleData& rhs) const
-	{ //highest score first
-		return rhs.mScore < mScore;
-	}
-};
-
-const F64 FindVertexScore_CacheDecayPower = 1.5;
-const F64 FindVertexScore_LastTriScore = 0.75;
-const F64 FindVertexScore_ValenceBoostScale = 2.0;
-const F64 FindVertexScore_ValenceBoostPower = 0.5;
-const U32 MaxSizeVertexCache = 32;
-const F64 FindVertexScore_Scaler = 1.0/(MaxSizeVertexCache-3);
-
-F64 find_vertex_score(LLVCacheVertexData& data)
-{
-	F64 score = -1.0;
-
-	score = 0.0;
-
-	S32 cache_idx = data.mCacheTag;
-
-	if (cache_idx < 0)
-	{
-		//not in cache
-	}
-	else
-	{
-		if (cache_idx < 3)
-		{ //vertex was in the last triangle
-			score = FindVertexScore_LastTriScore;
-		}
-		else
-		{ //more points for being higher in the cache
-				score = 1.0-((cache_idx-3)*FindVertexScore_Scaler);
-				score = pow(score, FindVertexScore_CacheDecayPower);
-		}
-	}
-
-	//bonus points for having low valence
-	F64 valence_boost = pow((F64)data.mActiveTriangles, -FindVertexScore_ValenceBoostPower);
-	score += FindVertexScore_ValenceBoostScale * valence_boost;
-
-	return score;
-}
-
-class LLVCacheFIFO
-{
-public:
-	LLVCacheVertexData* mCache[MaxSizeVertexCache];
-	U32 mMisses;
-
-	LLVCacheFIFO()
-	{
-		mMisses = 0;
-		for (U32 i = 0; i < MaxSizeVertexCache; ++i)
-		{
-			mCache[i] = NULL;
-		}
-	}
-
-	void addVertex(LLVCacheVertexData* data)
-	{
-		if (data->mCacheTag == -1)
-		{
-			mMisses++;
-
-			S32 end = MaxSizeVertexCache-1;
-
-			if (mCache[end])
-			{
-				mCache[end]->mCacheTag = -1;
-			}
-
-			for (S32 i = end; i > 0; --i)
-			{
-				mCache[i] = mCache[i-1];
-				if (mCache[i])
-				{
-					mCache[i]->mCacheTag = i;
-				}
-			}
-
-			mCache[0] = data;
-			data->mCacheTag = 0;
-		}
-	}
-};
-
-class LLVCacheLRU
-{
-public:
-	LLVCacheVertexData* mCache[MaxSizeVertexCache+3];
-
-	LLVCacheTriangleData* mBestTriangle;
-	
-	U32 mMisses;
-
-	LLVCacheLRU()
-	{
-		for (U32 i = 0; i < MaxSizeVertexCache+3; ++i)
-		{
-			mCache[i] = NULL;
-		}
-
-		mBestTriangle = NULL;
-		mMisses = 0;
-	}
-
-	void addVertex(LLVCacheVertexData* data)
-	{
-		S32 end = MaxSizeVertexCache+2;
-		if (data->mCacheTag != -1)
-		{ //just moving a vertex to the front of the cache
-			end = data->mCacheTag;
-		}
-		else
-		{
-			mMisses++;
-			if (mCache[end])
-			{ //adding a new vertex, vertex at end of cache falls off
-				mCache[end]->mCacheTag = -1;
-			}
-		}
-
-		for (S32 i = end; i > 0; --i)
-		{ //adjust cache pointers and tags
-			mCache[i] = mCache[i-1];
+	return a.mV[2] < b.mV[2];
+}
 
-			if (mCache[i])
-			{
-				mCache[i]->mCacheTag = i;			
-			}
-		}
+void LLVolumeFace::optimize(F32 angle_cutoff)
+{
+	LLVolumeFace new_face;
 
-		mCache[0] = data;
-		mCache[0]->mCacheTag = 0;
-	}
+	//map of points to vector of vertices at that point
+	std::map<U64, std::vector<VertexMapData> > point_map;
 
-	void addTriangle(LLVCacheTriangleData* data)
-	{
-		addVertex(data->mVertex[0]);
-		addVertex(data->mVertex[1]);
-		addVertex(data->mVertex[2]);
-	}
+	LLVector4a range;
+	range.setSub(mExtents[1],mExtents[0]);
 
-	void updateScores()
+	//remove redundant vertices
+	for (U32 i = 0; i < mNumIndices; ++i)
 	{
-		LLVCacheVertexData** data_iter = mCache+MaxSizeVertexCache;
-		LLVCacheVertexData** end_data = mCache+MaxSizeVertexCache+3;
+		U16 index = mIndices[i];
 
-		while(data_iter != end_data)
-		{
-			LLVCacheVertexData* data = *data_iter++;
-			//trailing 3 vertices aren't actually in the cache for scoring purposes
-			if (data)
-			{
-				data->mCacheTag = -1;
-			}
-		}
+		LLVolumeFace::VertexData cv;
+		getVertexData(index, cv);
+		
+		BOOL found = FALSE;
 
-		data_iter = mCache;
-		end_data = mCache+MaxSizeVertexCache;
+		LLVector4a pos;
+		pos.setSub(mPositions[index], mExtents[0]);
+		pos.div(range);
 
-		while (data_iter != end_data)
-		{ //update scores of vertices in cache
-			LLVCacheVertexData* data = *data_iter++;
-			if (data)
-			{
-				data->mScore = find_vertex_score(*data);
-			}
-		}
+		U64 pos64 = 0;
 
-		mBestTriangle = NULL;
-		//update triangle scores
-		data_iter = mCache;
-		end_data = mCache+MaxSizeVertexCache+3;
+		pos64 = (U16) (pos[0]*65535);
+		pos64 = pos64 | (((U64) (pos[1]*65535)) << 16);
+		pos64 = pos64 | (((U64) (pos[2]*65535)) << 32);
 
-		while (data_iter != end_data)
-		{
-			LLVCacheVertexData* data = *data_iter++;
-			if (data)
+		std::map<U64, std::vector<VertexMapData> >::iterator point_iter = point_map.find(pos64);
+		
+		if (point_iter != point_map.end())
+		{ //duplicate point might exist
+			for (U32 j = 0; j < point_iter->second.size(); ++j)
 			{
-				for (std::vector<LLVCacheTriangleData*>::iterator iter = data->mTriangles.begin(), end_iter = data->mTriangles.end(); iter != end_iter; ++iter)
+				LLVolumeFace::VertexData& tv = (point_iter->second)[j];
+				if (tv.compareNormal(cv, angle_cutoff))
 				{
-					LLVCacheTriangleData* tri = *iter;
-					if (tri->mActive)
-					{
-						tri->mScore = tri->mVertex[0] ? tri->mVertex[0]->mScore : 0;
-						tri->mScore += tri->mVertex[1] ? tri->mVertex[1]->mScore : 0;
-						tri->mScore += tri->mVertex[2] ? tri->mVertex[2]->mScore : 0;
-
-						if (!mBestTriangle || mBestTriangle->mScore < tri->mScore)
-						{
-							mBestTriangle = tri;
-						}
-					}
+					found = TRUE;
+					new_face.pushIndex((point_iter->second)[j].mIndex);
+					break;
 				}
 			}
 		}
 
-		//knock trailing 3 vertices off the cache
-		data_iter = mCache+MaxSizeVertexCache;
-		end_data = mCache+MaxSizeVertexCache+3;
-		while (data_iter != end_data)
+		if (!found)
 		{
-			LLVCacheVertexData* data = *data_iter;
-			if (data)
+			new_face.pushVertex(cv);
+			U16 index = (U16) new_face.mNumVertices-1;
+			new_face.pushIndex(index);
+
+			VertexMapData d;
+			d.setPosition(cv.getPosition());
+			d.mTexCoord = cv.mTexCoord;
+			d.setNormal(cv.getNormal());
+			d.mIndex = index;
+			if (point_iter != point_map.end())
+			{
+				point_iter->second.push_back(d);
+			}
+			else
 			{
-				llassert(data->mCacheTag == -1);
-				*data_iter = NULL;
+				point_map[pos64].push_back(d);
 			}
-			++data_iter;
 		}
 	}
-};
 
 
+	if (angle_cutoff > 1.f && !mNormals)
+	{
+		// Now alloc'd with positions
+		//ll_aligned_free_16(new_face.mNormals);
+		new_face.mNormals = NULL;
+	}
+
+	if (!mTexCoords)
+	{
+		// Now alloc'd with positions
+		//ll_aligned_free_16(new_face.mTexCoords);
+		new_face.mTexCoords = NULL;
+	}
+
+	// Only swap data if we've actually optimized the mesh
+	//
+	if (new_face.mNumVertices <= mNumVertices)
+	{
+        llassert(new_face.mNumIndices == mNumIndices);
+		swapData(new_face);
+	}
+
+}
+
 bool LLVolumeFace::cacheOptimize()
 { //optimize for vertex cache according to Forsyth method: 
   // http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
@@ -5278,132 +5684,17 @@ bool LLVolumeFace::cacheOptimize()
 	llassert(!mOptimized);
 	mOptimized = TRUE;
 
-	LLVCacheLRU cache;
-	
 	if (mNumVertices < 3 || mNumIndices < 3)
 	{ //nothing to do
 		return true;
 	}
 
-	//mapping of vertices to triangles and indices
-	std::vector<LLVCacheVertexData> vertex_data;
-
-	//mapping of triangles do vertices
-	std::vector<LLVCacheTriangleData> triangle_data;
-
-	try
-	{
-		triangle_data.resize(mNumIndices / 3);
-		vertex_data.resize(mNumVertices);
-	}
-	catch (std::bad_alloc&)
+	if (!ll_optimize_vertex_cache(mIndices, mNumIndices, mNumVertices))
 	{
-		LL_WARNS("LLVOLUME") << "Resize failed" << LL_ENDL;
+		LL_WARNS("LLVOLUME") << "Index out of range of " << mNumVertices << " vertices" << LL_ENDL;
 		return false;
 	}
 
-	for (U32 i = 0; i < mNumIndices; i++)
-	{ //populate vertex data and triangle data arrays
-		U16 idx = mIndices[i];
-		U32 tri_idx = i/3;
-
-		vertex_data[idx].mTriangles.push_back(&(triangle_data[tri_idx]));
-		vertex_data[idx].mIdx = idx;
-		triangle_data[tri_idx].mVertex[i%3] = &(vertex_data[idx]);
-	}
-
-	/*F32 pre_acmr = 1.f;
-	//measure cache misses from before rebuild
-	{
-		LLVCacheFIFO test_cache;
-		for (U32 i = 0; i < mNumIndices; ++i)
-		{
-			test_cache.addVertex(&vertex_data[mIndices[i]]);
-		}
-
-		for (U32 i = 0; i < mNumVertices; i++)
-		{
-			vertex_data[i].mCacheTag = -1;
-		}
-
-		pre_acmr = (F32) test_cache.mMisses/(mNumIndices/3);
-	}*/
-
-	for (U32 i = 0; i < mNumVertices; i++)
-	{ //initialize score values (no cache -- might try a fifo cache here)
-		LLVCacheVertexData& data = vertex_data[i];
-
-		data.mScore = find_vertex_score(data);
-		data.mActiveTriangles = data.mTriangles.size();
-
-		for (U32 j = 0; j < data.mActiveTriangles; ++j)
-		{
-			data.mTriangles[j]->mScore += data.mScore;
-		}
-	}
-
-	//sort triangle data by score
-	std::sort(triangle_data.begin(), triangle_data.end());
-
-	std::vector<U16> new_indices;
-
-	LLVCacheTriangleData* tri;
-
-	//prime pump by adding first triangle to cache;
-	tri = &(triangle_data[0]);
-	cache.addTriangle(tri);
-	new_indices.push_back(tri->mVertex[0]->mIdx);
-	new_indices.push_back(tri->mVertex[1]->mIdx);
-	new_indices.push_back(tri->mVertex[2]->mIdx);
-	tri->complete();
-
-	U32 breaks = 0;
-	for (U32 i = 1; i < mNumIndices/3; ++i)
-	{
-		cache.updateScores();
-		tri = cache.mBestTriangle;
-		if (!tri)
-		{
-			breaks++;
-			for (U32 j = 0; j < triangle_data.size(); ++j)
-			{
-				if (triangle_data[j].mActive)
-				{
-					tri = &(triangle_data[j]);
-					break;
-				}
-			}
-		}	
-		
-		cache.addTriangle(tri);
-		new_indices.push_back(tri->mVertex[0]->mIdx);
-		new_indices.push_back(tri->mVertex[1]->mIdx);
-		new_indices.push_back(tri->mVertex[2]->mIdx);
-		tri->complete();
-	}
-
-	for (U32 i = 0; i < mNumIndices; ++i)
-	{
-		mIndices[i] = new_indices[i];
-	}
-
-	/*F32 post_acmr = 1.f;
-	//measure cache misses from after rebuild
-	{
-		LLVCacheFIFO test_cache;
-		for (U32 i = 0; i < mNumVertices; i++)
-		{
-			vertex_data[i].mCacheTag = -1;
-		}
-
-		for (U32 i = 0; i < mNumIndices; ++i)
-		{
-			test_cache.addVertex(&vertex_data[mIndices[i]]);
-		}
-		
-		post_acmr = (F32) test_cache.mMisses/(mNumIndices/3);
-	}*/
-
 	//optimize for pre-TnL cache
 	
 	//allocate space for new buffer
@@ -5459,15 +5750,12 @@ bool LLVolumeFace::cacheOptimize()
 		return false;
 	}
 
-	S32 cur_idx = 0;
-	for (U32 i = 0; i < mNumIndices; ++i)
+	ll_optimize_vertex_fetch_remap(mIndices, mNumIndices, mNumVertices, &new_idx[0]);
+	for (S32 idx = 0; idx < mNumVertices; ++idx)
 	{
-		U16 idx = mIndices[i];
-		if (new_idx[idx] == -1)
-		{ //this vertex hasn't been added yet
-			new_idx[idx] = cur_idx;
-
-			//copy vertex data
+		S32 cur_idx = new_idx[idx];
+		if (cur_idx != -1)
+		{ //copy vertex data
 			pos[cur_idx] = mPositions[idx];
 			norm[cur_idx] = mNormals[idx];
 			tc[cur_idx] = mTexCoords[idx];
@@ -5479,8 +5767,6 @@ bool LLVolumeFace::cacheOptimize()
 			{
 				binorm[cur_idx] = mTangents[idx];
 			}
-
-			cur_idx++;
 		}
 	}
 
@@ -5506,12 +5792,151 @@ bool LLVolumeFace::cacheOptimize()
 	mWeights = wght;    
 	mTangents = binorm;
 
-	//std::string result = llformat("ACMR pre/post: %.3f/%.3f  --  %d triangles %d breaks", pre_acmr, post_acmr, mNumIndices/3, breaks);
-	//LL_INFOS() << result << LL_ENDL;
-
 	return true;
 }
 
+void LLVolumeFace::compact()
+{
+	if (isCompact() || mNumVertices <= 0 || !mPositions || !mNormals)
+	{
+		return;
+	}
+
+	LLVector4a min = mPositions[0];
+	LLVector4a max = mPositions[0];
+	for (S32 i = 1; i < mNumVertices; ++i)
+	{
+		min.setMin(min, mPositions[i]);
+		max.setMax(max, mPositions[i]);
+	}
+
+	//grid steps per meter, 0 across axes the face is flat along
+	F32 to_grid[3];
+	for (U32 k = 0; k < 3; ++k)
+	{
+		F32 range = max.getF32ptr()[k] - min.getF32ptr()[k];
+		mCompactOrigin[k] = min.getF32ptr()[k];
+		mCompactScale[k] = range / 65535.f;
+		to_grid[k] = range > 0.f ? 65535.f / range : 0.f;
+	}
+
+	S32 tc_size = ((mNumVertices*sizeof(LLVector2)) + 0xF) & ~0xF;
+	U8* buffer = (U8*) ll_aligned_malloc_16(sizeof(CompactVertex)*mNumVertices + tc_size);
+	mCompactVertices = (CompactVertex*) buffer;
+	mCompactTexCoords = (LLVector2*) (buffer + sizeof(CompactVertex)*mNumVertices);
+	mCompactTangents = mTangents != NULL;
+
+	for (S32 i = 0; i < mNumVertices; ++i)
+	{
+		CompactVertex& cv = mCompactVertices[i];
+		const F32* pos = mPositions[i].getF32ptr();
+		for (U32 k = 0; k < 3; ++k)
+		{
+			cv.mPosition[k] = (U16) llclamp(ll_round((pos[k] - mCompactOrigin[k]) * to_grid[k]), 0, 65535);
+		}
+
+		F32_to_octahedral_S16(mNormals[i].getF32ptr(), cv.mNormal);
+
+		if (mTangents)
+		{
+			F32_to_octahedral_S16(mTangents[i].getF32ptr(), cv.mTangent);
+			cv.mTangentSign = mTangents[i].getF32ptr()[3] < 0.f ? 1 : 0;
+		}
+		else
+		{
+			cv.mTangent[0] = 0;
+			cv.mTangent[1] = 0;
+			cv.mTangentSign = 0;
+		}
+	}
+	memcpy(mCompactTexCoords, mTexCoords, mNumVertices*sizeof(LLVector2));
+
+	//mNormals and mTexCoords are part of the mPositions buffer
+	ll_aligned_free<64>(mPositions);
+	mPositions = NULL;
+	mNormals = NULL;
+	mTexCoords = NULL;
+	ll_aligned_free_16(mTangents);
+	mTangents = NULL;
+
+	//rebuilt from the decoded positions when needed again
+	delete mOctree;
+	mOctree = NULL;
+	destroyBVH();
+}
+
+void LLVolumeFace::expand()
+{
+	if (!isCompact())
+	{
+		return;
+	}
+
+	//same layout as resizeVertices(), which would also throw away the rigging info
+	S32 tc_size = ((mNumVertices*sizeof(LLVector2)) + 0xF) & ~0xF;
+	mPositions = (LLVector4a*) ll_aligned_malloc<64>(sizeof(LLVector4a)*2*mNumVertices+tc_size);
+	mNormals = mPositions+mNumVertices;
+	mTexCoords = (LLVector2*) (mNormals+mNumVertices);
+	mNumAllocatedVertices = mNumVertices;
+
+	if (mCompactTangents)
+	{
+		allocateTangents(mNumVertices);
+	}
+
+	decodeCompact(*this);
+	freeCompact();
+}
+
+S32 LLVolumeFace::getCompactSavings() const
+{
+	if (!isCompact())
+	{
+		return 0;
+	}
+
+	//positions and normals, and tangents when there were some, against one compact vertex
+	S32 full_size = sizeof(LLVector4a) * (mCompactTangents ? 3 : 2);
+	return mNumVertices * (full_size - (S32) sizeof(CompactVertex));
+}
+
+void LLVolumeFace::freeCompact()
+{
+	//mCompactTexCoords is part of the mCompactVertices buffer
+	ll_aligned_free_16(mCompactVertices);
+	mCompactVertices = NULL;
+	mCompactTexCoords = NULL;
+	mCompactTangents = FALSE;
+}
+
+void LLVolumeFace::decodeCompact(const LLVolumeFace& src)
+{
+	LLVector4a origin(src.mCompactOrigin[0], src.mCompactOrigin[1], src.mCompactOrigin[2]);
+	LLVector4a scale(src.mCompactScale[0], src.mCompactScale[1], src.mCompactScale[2]);
+
+	for (S32 i = 0; i < src.mNumVertices; ++i)
+	{
+		const CompactVertex& cv = src.mCompactVertices[i];
+
+		LLVector4a& pos = mPositions[i];
+		pos.set(cv.mPosition[0], cv.mPosition[1], cv.mPosition[2]);
+		pos.mul(scale);
+		pos.add(origin);
+
+		F32* normal = mNormals[i].getF32ptr();
+		octahedral_S16_to_F32(cv.mNormal, normal);
+		normal[3] = 0.f;
+
+		if (mTangents)
+		{
+			F32* tangent = mTangents[i].getF32ptr();
+			octahedral_S16_to_F32(cv.mTangent, tangent);
+			tangent[3] = cv.mTangentSign ? -1.f : 1.f;
+		}
+	}
+	memcpy(mTexCoords, src.mCompactTexCoords, src.mNumVertices*sizeof(LLVector2));
+}
+
 void LLVolumeFace::createOctree(F32 scaler, const LLVector4a& center, const LLVector4a& size)
 {
 	if (mOctree)
@@ -5581,6 +6006,19 @@ void LLVolumeFace::createOctree(F32 scaler, const LLVector4a& center, const LLVe
 	}
 }
 
+void LLVolumeFace::createBVH()
+{
+	if (!mBVH)
+	{
+		mBVH = new LLVolumeBVH(*this);
+	}
+}
+
+void LLVolumeFace::destroyBVH()
+{
+	delete mBVH;
+	mBVH = NULL;
+}
 
 void LLVolumeFace::swapData(LLVolumeFace& rhs)
 {
@@ -5591,6 +6029,12 @@ void LLVolumeFace::swapData(LLVolumeFace& rhs)
 	llswap(rhs.mIndices,mIndices);
 	llswap(rhs.mNumVertices, mNumVertices);
 	llswap(rhs.mNumIndices, mNumIndices);
+	llswap(rhs.mBVH, mBVH);
+	llswap(rhs.mCompactVertices, mCompactVertices);
+	llswap(rhs.mCompactTexCoords, mCompactTexCoords);
+	std::swap(rhs.mCompactOrigin, mCompactOrigin);
+	std::swap(rhs.mCompactScale, mCompactScale);
+	llswap(rhs.mCompactTangents, mCompactTangents);
 }
 
 void	LerpPlanarVertex(LLVolumeFace::VertexData& v0,
@@ -6282,9 +6726,6 @@ BOOL LLVolumeFace::createCap(LLVolume* volume, BOOL partial_build)
 	return TRUE;
 }
 
-void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
-        const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent);
-
 void LLVolumeFace::createTangents()
 {
 	if (!mTangents)
@@ -6292,32 +6733,16 @@ void LLVolumeFace::createTangents()
 		allocateTangents(mNumVertices);
 
 		//generate tangents
-		//LLVector4a* pos = mPositions;
-		//LLVector2* tc = (LLVector2*) mTexCoords;
-		LLVector4a* binorm = (LLVector4a*) mTangents;
-
-		LLVector4a* end = mTangents+mNumVertices;
-		while (binorm < end)
-		{
-			(*binorm++).clear();
-		}
-
-		binorm = mTangents;
+		ll_calc_tangents(mNumVertices, mPositions, mNormals, mTexCoords, mNumIndices/3, mIndices, mTangents);
 
-		CalculateTangentArray(mNumVertices, mPositions, mNormals, mTexCoords, mNumIndices/3, mIndices, mTangents);
-
-		//normalize tangents
-		for (U32 i = 0; i < mNumVertices; i++) 
-		{
-			//binorm[i].normalize3fast();
-			//bump map/planar projection code requires normals to be normalized
-			mNormals[i].normalize3fast();
-		}
+		//bump map/planar projection code requires normals to be normalized
+		ll_normalize3fast_array(mNormals, mNumVertices);
 	}
 }
 
 void LLVolumeFace::resizeVertices(S32 num_verts)
 {
+	freeCompact();
 	ll_aligned_free<64>(mPositions);
 	//DO NOT free mNormals and mTexCoords as they are part of mPositions buffer
 	ll_aligned_free_16(mTangents);
@@ -6741,7 +7166,7 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 
 	LLVector4a* norm = mNormals;
 
-	static LLAlignedArray<LLVector4a, 64> triangle_normals;
+	static thread_local LLAlignedArray<LLVector4a, 64> triangle_normals;
 	triangle_normals.resize(count);
 	LLVector4a* output = triangle_normals.mArray;
 	LLVector4a* end_output = output+count;
@@ -6970,107 +7395,4 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 	return TRUE;
 }
 
-//adapted from Lengyel, Eric. "Computing Tangent Space Basis Vectors for an Arbitrary Mesh". Terathon Software 3D Graphics Library, 2001. http://www.terathon.com/code/tangent.html
-void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
-        const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent)
-{
-    //LLVector4a *tan1 = new LLVector4a[vertexCount * 2];
-	LLVector4a* tan1 = (LLVector4a*) ll_aligned_malloc_16(vertexCount*2*sizeof(LLVector4a));
-	// new(tan1) LLVector4a;
-
-    LLVector4a* tan2 = tan1 + vertexCount;
-
-    U32 count = vertexCount * 2;
-    for (U32 i = 0; i < count; i++)
-    {
-        tan1[i].clear();
-    }
-
-    for (U32 a = 0; a < triangleCount; a++)
-    {
-        U32 i1 = *index_array++;
-        U32 i2 = *index_array++;
-        U32 i3 = *index_array++;
-        
-        const LLVector4a& v1 = vertex[i1];
-        const LLVector4a& v2 = vertex[i2];
-        const LLVector4a& v3 = vertex[i3];
-        
-        const LLVector2& w1 = texcoord[i1];
-        const LLVector2& w2 = texcoord[i2];
-        const LLVector2& w3 = texcoord[i3];
-        
-		const F32* v1ptr = v1.getF32ptr();
-		const F32* v2ptr = v2.getF32ptr();
-		const F32* v3ptr = v3.getF32ptr();
-		
-        float x1 = v2ptr[0] - v1ptr[0];
-        float x2 = v3ptr[0] - v1ptr[0];
-        float y1 = v2ptr[1] - v1ptr[1];
-        float y2 = v3ptr[1] - v1ptr[1];
-        float z1 = v2ptr[2] - v1ptr[2];
-        float z2 = v3ptr[2] - v1ptr[2];
-        
-        float s1 = w2.mV[0] - w1.mV[0];
-        float s2 = w3.mV[0] - w1.mV[0];
-        float t1 = w2.mV[1] - w1.mV[1];
-        float t2 = w3.mV[1] - w1.mV[1];
-        
-		F32 rd = s1*t2-s2*t1;
-
-		float r = ((rd*rd) > FLT_EPSILON) ? (1.0f / rd)
-													 : ((rd > 0.0f) ? 1024.f : -1024.f); //some made up large ratio for division by zero
-
-		llassert(llfinite(r));
-		llassert(!llisnan(r));
-
-		LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-				(t2 * z1 - t1 * z2) * r);
-		LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-				(s1 * z2 - s2 * z1) * r);
-        
-		tan1[i1].add(sdir);
-		tan1[i2].add(sdir);
-		tan1[i3].add(sdir);
-        
-		tan2[i1].add(tdir);
-		tan2[i2].add(tdir);
-		tan2[i3].add(tdir);
-    }
-    
-    for (U32 a = 0; a < vertexCount; a++)
-    {
-        LLVector4a n = normal[a];
-
-		const LLVector4a& t = tan1[a];
-
-		LLVector4a ncrosst;
-		ncrosst.setCross3(n,t);
-
-        // Gram-Schmidt orthogonalize
-        n.mul(n.dot3(t).getF32());
-
-		LLVector4a tsubn;
-		tsubn.setSub(t,n);
-
-		if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
-		{
-			tsubn.normalize3fast();
-		
-			// Calculate handedness
-			F32 handedness = ncrosst.dot3(tan2[a]).getF32() < 0.f ? -1.f : 1.f;
-		
-			tsubn.getF32ptr()[3] = handedness;
-
-			tangent[a] = tsubn;
-		}
-		else
-		{ //degenerate, make up a value
-			tangent[a].set(0,0,1,1);
-		}
-    }
-    
-	ll_aligned_free_16(tan1);
-}
-
 
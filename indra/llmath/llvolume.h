@@ -36,10 +36,12 @@ class LLProfile;
 class LLPath;
 
 template <class T> class LLOctreeNode;
+class LLVolumeBVH;
 
 class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
+struct LLMeshFaceBlock;
 
 #include "lluuid.h"
 #include "v4color.h"
@@ -58,6 +60,8 @@ class LLVolumeTriangle;
 #include "llfile.h"
 #include "llalignedarray.h"
 #include "llrigginginfo.h"
+#include "llatomic.h"
+#include "llframetimer.h"
 
 //============================================================================
 
@@ -905,8 +909,33 @@ public:
 	void optimize(F32 angle_cutoff = 2.f);
 	bool cacheOptimize();
 
+	// Quantized vertex, see compact()
+	struct CompactVertex
+	{
+		U16 mPosition[3];		// inside the bounds of the face positions
+		U16 mTangentSign;		// 1 when the bitangent is flipped (tangent w of -1)
+		S16 mNormal[2];			// octahedral, see F32_to_octahedral_S16()
+		S16 mTangent[2];
+	};
+
+	// Replaces the positions, normals and tangents with 16 bit positions
+	// relative to the face bounds and octahedral normals and tangents, and
+	// drops the octree and BVH.  mPositions, mNormals, mTexCoords and
+	// mTangents are NULL until expand() decodes them again; indices and
+	// weights are left alone.
+	void compact();
+	void expand();
+	bool isCompact() const { return mCompactVertices != NULL; }
+	// Bytes of vertex data compact() saved on this face, 0 when not compact
+	S32 getCompactSavings() const;
+
 	void createOctree(F32 scaler = 0.25f, const LLVector4a& center = LLVector4a(0,0,0), const LLVector4a& size = LLVector4a(0.5f,0.5f,0.5f));
 
+	// BVH for ray casts, built on first use, must be destroyed when the
+	// positions or indices change
+	void createBVH();
+	void destroyBVH();
+
 	enum
 	{
 		SINGLE_MASK =	0x0001,
@@ -969,6 +998,7 @@ public:
     LLJointRiggingInfoTab mJointRiggingInfoTab;
     
 	LLOctreeNode<LLVolumeTriangle>* mOctree;
+	LLVolumeBVH* mBVH;
 
 	//whether or not face has been cache optimized
 	BOOL mOptimized;
@@ -977,6 +1007,16 @@ private:
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createSide(LLVolume* volume, BOOL partial_build = FALSE);
+
+	void freeCompact();
+	// Fills the vertex data, allocated for src.mNumVertices, from the compact data of src
+	void decodeCompact(const LLVolumeFace& src);
+
+	CompactVertex* mCompactVertices;
+	LLVector2* mCompactTexCoords;	// part of the mCompactVertices buffer
+	F32 mCompactOrigin[3];
+	F32 mCompactScale[3];
+	BOOL mCompactTangents;
 };
 
 class LLVolume : public LLRefCount
@@ -1054,16 +1094,16 @@ public:
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
-	static S32 sNumMeshPoints;
+	static LLAtomicS32 sNumMeshPoints;	// updated by volume generation threads too
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
 																				// conversion if *(LLVolume*) to LLVolume&
-	const LLVolumeFace &getVolumeFace(const S32 f) const {return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
+	const LLVolumeFace &getVolumeFace(const S32 f) const {touchFaces(); return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
 	
-	LLVolumeFace &getVolumeFace(const S32 f) {return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
+	LLVolumeFace &getVolumeFace(const S32 f) {touchFaces(); return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
 
-	face_list_t& getVolumeFaces() { return mVolumeFaces; }
+	face_list_t& getVolumeFaces() { touchFaces(); return mVolumeFaces; }
 
 	U32					mFaceMask;			// bit array of which faces exist in this volume
 	LLVector3			mLODScaleBias;		// vector for biasing LOD based on scale
@@ -1074,7 +1114,28 @@ public:
 	void copyFacesFrom(const std::vector<LLVolumeFace> &faces);
 	bool cacheOptimize();
 
+	// Compact storage of the faces, see LLVolumeFace::compact().  Faces are
+	// decoded again as soon as getVolumeFace() or getVolumeFaces() hands
+	// one out, so callers never see compact faces.  Only compact volumes
+	// no other thread reads.
+	void compactFaces();
+	void expandFaces() const;
+	bool isCompact() const { return mCompactFaces; }
+	S32 getCompactSavings() const;
+	// LLFrameTimer frame count when a face was last handed out
+	U32 getLastFaceAccess() const { return mLastFaceAccess; }
+
 private:
+	void touchFaces() const
+	{
+		mLastFaceAccess = LLFrameTimer::getFrameCount();
+		if (mCompactFaces)
+		{
+			expandFaces();
+		}
+	}
+
+
 	void sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type);
 	F32 sculptGetSurfaceArea();
 	void sculptGenerateEmptyPlaceholder();
@@ -1087,6 +1148,27 @@ protected:
 	void createVolumeFaces();
 public:
 	virtual bool unpackVolumeFaces(std::istream& is, S32 size);
+	// Same as unpackVolumeFaces() for a LoD block that has already been parsed into LLSD
+	bool unpackVolumeFacesLLSD(const LLSD& mdl);
+
+	// Seconds spent in each stage of the last unpackVolumeFaces() call made by the calling thread
+	struct UnpackTimes
+	{
+		F64 mInflate;
+		F64 mParse;
+		F64 mOptimize;
+	};
+	static const UnpackTimes& getLastUnpackTimes();
+
+	// Flat copy of unpacked mesh faces, laid out as they are held in memory
+	// (16 byte aligned position, normal, texture coordinate, index and weight
+	// arrays) so they can be cached and restored without decoding again.
+	// unpackDecodedFaces() validates the block before using any of it.
+	bool packDecodedFaces(std::vector<U8>& out) const;
+	bool unpackDecodedFaces(const U8* data, U32 size);
+private:
+	bool unpackVolumeFaceBlocks(const std::vector<LLMeshFaceBlock>& blocks);
+public:
 
 	virtual void setMeshAssetLoaded(BOOL loaded);
 	virtual BOOL isMeshAssetLoaded();
@@ -1106,6 +1188,8 @@ public:
 	
 	BOOL mGenerateSingleFace;
 	face_list_t mVolumeFaces;
+	mutable bool mCompactFaces;
+	mutable U32 mLastFaceAccess;
 
 public:
 	LLVector4a* mHullPoints;
@@ -0,0 +1,559 @@
+/**
+ * @file llvolumebvh.cpp
+ * @brief Bounding volume hierarchy of the triangles of a volume face.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumebvh.h"
+
+#include "llmemory.h"
+#include "llvolume.h"
+
+#include <algorithm>
+#include <vector>
+
+// Lanes of a packet
+const U32 PACKET_SIZE = 4;
+
+// Nodes with this many triangles or less are leaves
+const U32 MIN_SPLIT_TRIANGLES = PACKET_SIZE;
+
+// Leaves are split past this even when SAH would rather not
+const U32 MAX_LEAF_TRIANGLES = 4 * PACKET_SIZE;
+
+// Bounds the traversal stack
+const U32 MAX_DEPTH = 48;
+
+// Cost of visiting a node relative to testing a triangle
+const F32 TRAVERSAL_COST = 1.f;
+
+const U32 NUM_BINS = 16;
+
+const U32 NO_TRIANGLE = 0xFFFFFFFF;
+
+namespace
+{
+	struct Bounds
+	{
+		F32 mMin[3];
+		F32 mMax[3];
+
+		void init()
+		{
+			mMin[0] = mMin[1] = mMin[2] = F32_MAX;
+			mMax[0] = mMax[1] = mMax[2] = -F32_MAX;
+		}
+
+		void grow(const F32* min, const F32* max)
+		{
+			for (U32 i = 0; i < 3; ++i)
+			{
+				mMin[i] = llmin(mMin[i], min[i]);
+				mMax[i] = llmax(mMax[i], max[i]);
+			}
+		}
+
+		void grow(const Bounds& rhs)
+		{
+			grow(rhs.mMin, rhs.mMax);
+		}
+
+		F32 getArea() const
+		{
+			F32 x = mMax[0] - mMin[0];
+			F32 y = mMax[1] - mMin[1];
+			F32 z = mMax[2] - mMin[2];
+			return (x < 0.f) ? 0.f : 2.f * (x * y + y * z + z * x);
+		}
+	};
+
+	struct BuildTriangle
+	{
+		Bounds mBounds;
+		F32 mCenter[3];
+	};
+
+	class Builder
+	{
+	public:
+		Builder(const LLVolumeFace& face);
+
+		U32 build(U32 begin, U32 end, U32 depth);
+
+		std::vector<BuildTriangle> mTriangles;
+		std::vector<U32> mOrder;
+		std::vector<LLVolumeBVH::Node> mNodes;
+		std::vector<U32> mLeafTriangles;	// packet lanes in order, padded
+
+	private:
+		void makeLeaf(U32 node, U32 begin, U32 end);
+	};
+
+	Builder::Builder(const LLVolumeFace& face)
+	{
+		U32 count = face.mNumIndices / 3;
+		mTriangles.resize(count);
+		mOrder.resize(count);
+		for (U32 i = 0; i < count; ++i)
+		{
+			BuildTriangle& tri = mTriangles[i];
+			tri.mBounds.init();
+			for (U32 j = 0; j < 3; ++j)
+			{
+				const F32* v = face.mPositions[face.mIndices[i * 3 + j]].getF32ptr();
+				tri.mBounds.grow(v, v);
+			}
+			for (U32 j = 0; j < 3; ++j)
+			{
+				tri.mCenter[j] = 0.5f * (tri.mBounds.mMin[j] + tri.mBounds.mMax[j]);
+			}
+			mOrder[i] = i;
+		}
+	}
+
+	void Builder::makeLeaf(U32 node, U32 begin, U32 end)
+	{
+		LLVolumeBVH::Node& leaf = mNodes[node];
+		leaf.mOffset = mLeafTriangles.size() / PACKET_SIZE;
+		leaf.mCount = (end - begin + PACKET_SIZE - 1) / PACKET_SIZE;
+		for (U32 i = begin; i < end; ++i)
+		{
+			mLeafTriangles.push_back(mOrder[i]);
+		}
+		while (mLeafTriangles.size() % PACKET_SIZE)
+		{
+			mLeafTriangles.push_back(NO_TRIANGLE);
+		}
+	}
+
+	U32 Builder::build(U32 begin, U32 end, U32 depth)
+	{
+		U32 node = mNodes.size();
+		mNodes.push_back(LLVolumeBVH::Node());
+
+		Bounds bounds;
+		Bounds centers;
+		bounds.init();
+		centers.init();
+		for (U32 i = begin; i < end; ++i)
+		{
+			const BuildTriangle& tri = mTriangles[mOrder[i]];
+			bounds.grow(tri.mBounds);
+			centers.grow(tri.mCenter, tri.mCenter);
+		}
+		for (U32 i = 0; i < 3; ++i)
+		{
+			mNodes[node].mMin[i] = bounds.mMin[i];
+			mNodes[node].mMax[i] = bounds.mMax[i];
+		}
+
+		U32 count = end - begin;
+		if (count <= MIN_SPLIT_TRIANGLES || depth >= MAX_DEPTH)
+		{
+			makeLeaf(node, begin, end);
+			return node;
+		}
+
+		U32 axis = 0;
+		for (U32 i = 1; i < 3; ++i)
+		{
+			if (centers.mMax[i] - centers.mMin[i] > centers.mMax[axis] - centers.mMin[axis])
+			{
+				axis = i;
+			}
+		}
+
+		U32 mid = begin + count / 2;
+		F32 extent = centers.mMax[axis] - centers.mMin[axis];
+		if (extent > 0.f)
+		{
+			// Bin the centers along the axis and sweep for the cheapest split
+			Bounds bin_bounds[NUM_BINS];
+			U32 bin_count[NUM_BINS];
+			for (U32 i = 0; i < NUM_BINS; ++i)
+			{
+				bin_bounds[i].init();
+				bin_count[i] = 0;
+			}
+
+			F32 scale = (F32)NUM_BINS / extent;
+			F32 origin = centers.mMin[axis];
+			for (U32 i = begin; i < end; ++i)
+			{
+				const BuildTriangle& tri = mTriangles[mOrder[i]];
+				U32 bin = llmin((U32)((tri.mCenter[axis] - origin) * scale), NUM_BINS - 1);
+				bin_bounds[bin].grow(tri.mBounds);
+				bin_count[bin]++;
+			}
+
+			F32 right_area[NUM_BINS];
+			U32 right_count[NUM_BINS];
+			Bounds sweep;
+			sweep.init();
+			U32 sweep_count = 0;
+			for (U32 i = NUM_BINS - 1; i > 0; --i)
+			{
+				sweep.grow(bin_bounds[i]);
+				sweep_count += bin_count[i];
+				right_area[i] = sweep.getArea();
+				right_count[i] = sweep_count;
+			}
+
+			F32 best_cost = F32_MAX;
+			U32 best_split = 0;
+			sweep.init();
+			sweep_count = 0;
+			for (U32 i = 1; i < NUM_BINS; ++i)
+			{
+				sweep.grow(bin_bounds[i - 1]);
+				sweep_count += bin_count[i - 1];
+				F32 cost = sweep.getArea() * sweep_count + right_area[i] * right_count[i];
+				if (sweep_count && right_count[i] && cost < best_cost)
+				{
+					best_cost = cost;
+					best_split = i;
+				}
+			}
+
+			F32 area = bounds.getArea();
+			F32 split_cost = TRAVERSAL_COST + (area > 0.f ? best_cost / area : 0.f);
+			if (!best_split || (split_cost >= (F32)count && count <= MAX_LEAF_TRIANGLES))
+			{
+				if (count <= MAX_LEAF_TRIANGLES)
+				{
+					makeLeaf(node, begin, end);
+					return node;
+				}
+			}
+			else
+			{
+				U32* split = std::partition(&mOrder[0] + begin, &mOrder[0] + end,
+					[&](U32 i)
+					{
+						const BuildTriangle& tri = mTriangles[i];
+						return (U32)((tri.mCenter[axis] - origin) * scale) < best_split;
+					});
+				mid = split - &mOrder[0];
+				if (mid == begin || mid == end)
+				{
+					mid = begin + count / 2;
+				}
+			}
+		}
+		else if (count <= MAX_LEAF_TRIANGLES)
+		{
+			makeLeaf(node, begin, end);
+			return node;
+		}
+
+		// Triangles all at the same spot, or no good split: halve the range
+		build(begin, mid, depth + 1);
+		U32 right = build(mid, end, depth + 1);
+		mNodes[node].mOffset = right;
+		mNodes[node].mCount = 0;
+		return node;
+	}
+
+	// Entry of the ray in the box, false if it misses it before max_t
+	inline bool intersect_box(const LLVolumeBVH::Node& node, const LLVector4a& start, const LLVector4a& inv_dir,
+							  F32 max_t, F32& t_in)
+	{
+		LLVector4a min;
+		LLVector4a max;
+		min.load4a(node.mMin);
+		max.load4a(node.mMax);
+
+		min.sub(start);
+		min.mul(inv_dir);
+		max.sub(start);
+		max.mul(inv_dir);
+
+		LLVector4a t_near;
+		LLVector4a t_far;
+		t_near.setMin(min, max);
+		t_far.setMax(min, max);
+
+		t_in = llmax(llmax(t_near[0], t_near[1]), llmax(t_near[2], 0.f));
+		F32 t_out = llmin(llmin(t_far[0], t_far[1]), llmin(t_far[2], max_t));
+		return t_in <= t_out;
+	}
+}
+
+LLVolumeBVH::LLVolumeBVH(const LLVolumeFace& face)
+:	mNodes(NULL),
+	mPackets(NULL),
+	mTriangles(NULL),
+	mNumNodes(0),
+	mNumPackets(0)
+{
+	if (face.mNumIndices < 3 || !face.mPositions || !face.mIndices)
+	{
+		return;
+	}
+
+	Builder builder(face);
+	builder.build(0, builder.mOrder.size(), 0);
+
+	mNumNodes = builder.mNodes.size();
+	mNodes = (Node*) ll_aligned_malloc_16(mNumNodes * sizeof(Node));
+	memcpy(mNodes, &builder.mNodes[0], mNumNodes * sizeof(Node));
+
+	mNumPackets = builder.mLeafTriangles.size() / PACKET_SIZE;
+	mPackets = (Packet*) ll_aligned_malloc_16(mNumPackets * sizeof(Packet));
+	mTriangles = (U32*) ll_aligned_malloc_16(mNumPackets * PACKET_SIZE * sizeof(U32));
+	memcpy(mTriangles, &builder.mLeafTriangles[0], mNumPackets * PACKET_SIZE * sizeof(U32));
+
+	for (U32 i = 0; i < mNumPackets; ++i)
+	{
+		Packet& packet = mPackets[i];
+		for (U32 j = 0; j < 3; ++j)
+		{
+			packet.mV0[j].clear();
+			packet.mEdge1[j].clear();
+			packet.mEdge2[j].clear();
+		}
+
+		for (U32 lane = 0; lane < PACKET_SIZE; ++lane)
+		{
+			U32 tri = mTriangles[i * PACKET_SIZE + lane];
+			if (tri == NO_TRIANGLE)
+			{	// zero edges never pass the determinant test
+				continue;
+			}
+
+			const LLVector4a& v0 = face.mPositions[face.mIndices[tri * 3]];
+			LLVector4a edge1;
+			LLVector4a edge2;
+			edge1.setSub(face.mPositions[face.mIndices[tri * 3 + 1]], v0);
+			edge2.setSub(face.mPositions[face.mIndices[tri * 3 + 2]], v0);
+			for (U32 j = 0; j < 3; ++j)
+			{
+				packet.mV0[j].getF32ptr()[lane] = v0[j];
+				packet.mEdge1[j].getF32ptr()[lane] = edge1[j];
+				packet.mEdge2[j].getF32ptr()[lane] = edge2[j];
+			}
+		}
+	}
+}
+
+LLVolumeBVH::~LLVolumeBVH()
+{
+	ll_aligned_free_16(mNodes);
+	ll_aligned_free_16(mPackets);
+	ll_aligned_free_16(mTriangles);
+}
+
+U32 LLVolumeBVH::getBytes() const
+{
+	return mNumNodes * sizeof(Node) + mNumPackets * (sizeof(Packet) + PACKET_SIZE * sizeof(U32));
+}
+
+S32 LLVolumeBVH::intersect(const LLVector4a& start, const LLVector4a& dir, F32& closest_t, F32& a, F32& b) const
+{
+	if (!mNumNodes)
+	{
+		return -1;
+	}
+
+	// Slabs of axis parallel rays still need a finite inverse
+	LLVector4a inv_dir;
+	for (U32 i = 0; i < 3; ++i)
+	{
+		F32 d = dir[i];
+		if (fabsf(d) < 1e-20f)
+		{
+			d = (d < 0.f) ? -1e-20f : 1e-20f;
+		}
+		inv_dir.getF32ptr()[i] = 1.f / d;
+	}
+	inv_dir.getF32ptr()[3] = 0.f;
+
+	// Ray, one coordinate per vector for the packets
+	LLVector4a org[3];
+	LLVector4a ray[3];
+	for (U32 i = 0; i < 3; ++i)
+	{
+		org[i].splat(start[i]);
+		ray[i].splat(dir[i]);
+	}
+
+	F32 max_t = llmin(closest_t, 1.f);
+	S32 hit = -1;
+
+	U32 stack[MAX_DEPTH + 1];
+	F32 stack_near[MAX_DEPTH + 1];
+	U32 depth = 0;
+
+	F32 t_in;
+	if (!intersect_box(mNodes[0], start, inv_dir, max_t, t_in))
+	{
+		return -1;
+	}
+
+	U32 index = 0;
+	while (true)
+	{
+		const Node& node = mNodes[index];
+		if (node.mCount)
+		{
+			for (U32 i = node.mOffset; i < node.mOffset + node.mCount; ++i)
+			{
+				const Packet& packet = mPackets[i];
+
+				// Moller-Trumbore, one sided, like LLTriangleRayIntersect
+				LLVector4a pvec[3];
+				LLVector4a tmp;
+				pvec[0].setMul(ray[1], packet.mEdge2[2]);
+				tmp.setMul(ray[2], packet.mEdge2[1]);
+				pvec[0].sub(tmp);
+				pvec[1].setMul(ray[2], packet.mEdge2[0]);
+				tmp.setMul(ray[0], packet.mEdge2[2]);
+				pvec[1].sub(tmp);
+				pvec[2].setMul(ray[0], packet.mEdge2[1]);
+				tmp.setMul(ray[1], packet.mEdge2[0]);
+				pvec[2].sub(tmp);
+
+				LLVector4a det;
+				det.setMul(packet.mEdge1[0], pvec[0]);
+				tmp.setMul(packet.mEdge1[1], pvec[1]);
+				det.add(tmp);
+				tmp.setMul(packet.mEdge1[2], pvec[2]);
+				det.add(tmp);
+
+				U32 mask = det.greaterEqual(LLVector4a::getEpsilon()).getGatheredBits();
+				if (!mask)
+				{
+					continue;
+				}
+
+				LLVector4a tvec[3];
+				tvec[0].setSub(org[0], packet.mV0[0]);
+				tvec[1].setSub(org[1], packet.mV0[1]);
+				tvec[2].setSub(org[2], packet.mV0[2]);
+
+				LLVector4a u;
+				u.setMul(tvec[0], pvec[0]);
+				tmp.setMul(tvec[1], pvec[1]);
+				u.add(tmp);
+				tmp.setMul(tvec[2], pvec[2]);
+				u.add(tmp);
+
+				mask &= u.greaterEqual(LLVector4a::getZero()).getGatheredBits();
+				mask &= u.lessEqual(det).getGatheredBits();
+				if (!mask)
+				{
+					continue;
+				}
+
+				LLVector4a qvec[3];
+				qvec[0].setMul(tvec[1], packet.mEdge1[2]);
+				tmp.setMul(tvec[2], packet.mEdge1[1]);
+				qvec[0].sub(tmp);
+				qvec[1].setMul(tvec[2], packet.mEdge1[0]);
+				tmp.setMul(tvec[0], packet.mEdge1[2]);
+				qvec[1].sub(tmp);
+				qvec[2].setMul(tvec[0], packet.mEdge1[1]);
+				tmp.setMul(tvec[1], packet.mEdge1[0]);
+				qvec[2].sub(tmp);
+
+				LLVector4a v;
+				v.setMul(ray[0], qvec[0]);
+				tmp.setMul(ray[1], qvec[1]);
+				v.add(tmp);
+				tmp.setMul(ray[2], qvec[2]);
+				v.add(tmp);
+
+				LLVector4a sum_uv;
+				sum_uv.setAdd(u, v);
+				mask &= v.greaterEqual(LLVector4a::getZero()).getGatheredBits();
+				mask &= sum_uv.lessEqual(det).getGatheredBits();
+				if (!mask)
+				{
+					continue;
+				}
+
+				LLVector4a t;
+				t.setMul(packet.mEdge2[0], qvec[0]);
+				tmp.setMul(packet.mEdge2[1], qvec[1]);
+				t.add(tmp);
+				tmp.setMul(packet.mEdge2[2], qvec[2]);
+				t.add(tmp);
+				t.div(det);
+
+				for (U32 lane = 0; lane < PACKET_SIZE; ++lane)
+				{
+					if ((mask & (1 << lane)) && t[lane] >= 0.f && t[lane] <= max_t && t[lane] < closest_t)
+					{
+						closest_t = t[lane];
+						max_t = closest_t;
+						a = u[lane] / det[lane];
+						b = v[lane] / det[lane];
+						hit = mTriangles[i * PACKET_SIZE + lane];
+					}
+				}
+			}
+		}
+		else
+		{
+			U32 left = index + 1;
+			U32 right = node.mOffset;
+			F32 t_left;
+			F32 t_right;
+			bool hit_left = intersect_box(mNodes[left], start, inv_dir, max_t, t_left);
+			bool hit_right = intersect_box(mNodes[right], start, inv_dir, max_t, t_right);
+			if (hit_left && hit_right)
+			{	// nearest first, the other one may be culled by a hit in it
+				if (t_right < t_left)
+				{
+					std::swap(left, right);
+					std::swap(t_left, t_right);
+				}
+				llassert(depth <= MAX_DEPTH);
+				stack[depth] = right;
+				stack_near[depth] = t_right;
+				depth++;
+				index = left;
+				continue;
+			}
+			if (hit_left || hit_right)
+			{
+				index = hit_left ? left : right;
+				continue;
+			}
+		}
+
+		// Next node left on the stack that may still be closer than the hit
+		do
+		{
+			if (!depth)
+			{
+				return hit;
+			}
+			depth--;
+		}
+		while (stack_near[depth] > max_t);
+		index = stack[depth];
+	}
+}
@@ -0,0 +1,89 @@
+/**
+ * @file llvolumebvh.h
+ * @brief Bounding volume hierarchy of the triangles of a volume face.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEBVH_H
+#define LL_LLVOLUMEBVH_H
+
+#include "llmath.h"
+#include "llvector4a.h"
+
+class LLVolumeFace;
+
+// Flattened BVH over the triangles of an LLVolumeFace, for ray casts.
+//
+// Built with binned SAH.  Nodes are kept depth first in one array, the
+// left child of an inner node right after it.  Leaves point to packets
+// of four triangles stored as structures of arrays (one LLVector4a per
+// coordinate), which are tested against the ray four at a time.
+//
+// Triangles are copied in, the BVH does not point to the face, but it
+// must be rebuilt when the positions or indices of the face change (see
+// LLVolumeFace::destroyBVH()).
+class LLVolumeBVH
+{
+public:
+	LLVolumeBVH(const LLVolumeFace& face);
+	~LLVolumeBVH();
+
+	// Closest front facing triangle hit by start + t * dir for t in
+	// [0, min(1, closest_t)).  Returns its index in the face (the first
+	// of its vertex indices is at 3 * index) and sets closest_t and the
+	// barycentric coordinates a and b of the hit, or returns -1.
+	S32 intersect(const LLVector4a& start, const LLVector4a& dir, F32& closest_t, F32& a, F32& b) const;
+
+	U32 getNumNodes() const		{ return mNumNodes; }
+	U32 getNumPackets() const	{ return mNumPackets; }
+
+	// Bytes taken by the nodes and packets
+	U32 getBytes() const;
+
+	struct Node
+	{
+		F32 mMin[3];
+		U32 mOffset;	// right child of an inner node, first packet of a leaf
+		F32 mMax[3];
+		U32 mCount;		// packets of a leaf, 0 for an inner node
+	};
+
+	struct Packet
+	{
+		LLVector4a mV0[3];		// first vertex, x y z of the four triangles
+		LLVector4a mEdge1[3];	// second vertex - first vertex
+		LLVector4a mEdge2[3];	// third vertex - first vertex
+	};
+
+private:
+	LLVolumeBVH(const LLVolumeBVH&);
+	const LLVolumeBVH& operator=(const LLVolumeBVH&);
+
+	Node* mNodes;
+	Packet* mPackets;
+	U32* mTriangles;	// triangle of each packet lane, NO_TRIANGLE for padding
+	U32 mNumNodes;
+	U32 mNumPackets;
+};
+
+#endif // LL_LLVOLUMEBVH_H
@@ -27,6 +27,9 @@
 
 #include "llvolumemgr.h"
 #include "llvolume.h"
+#include "lltracethreadrecorder.h"
+
+#include <thread>
 
 
 const F32 BASE_THRESHOLD = 0.03f;
@@ -40,11 +43,19 @@ F32 LLVolumeLODGroup::mDetailThresholds[NUM_LODS] = {BASE_THRESHOLD,
 //static
 F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 
+LLTrace::SampleStatHandle<> LLVolumeMgr::sGenerationQueueDepth("volume_gen_queue_depth", "Prim LODs waiting for a generation thread");
+LLTrace::EventStatHandle<F64Milliseconds> LLVolumeMgr::sGenerationQueueWait("volume_gen_queue_wait", "Time prim LODs waited for a generation thread");
+LLTrace::EventStatHandle<F64Milliseconds> LLVolumeMgr::sGenerationTime("volume_gen_time", "Time spent building a prim LOD on a generation thread");
+
+// Upper bound for the automatically chosen number of generation threads
+const U32 MAX_AUTO_VOLUME_GENERATION_THREADS = 2;
+
 
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
-:	mDataMutex(NULL)
+:	mDataMutex(NULL),
+	mCompactCursorValid(false)
 {
 	// the LLMutex magic interferes with easy unit testing,
 	// so you now must manually call useMutex() to use it
@@ -61,6 +72,8 @@ LLVolumeMgr::~LLVolumeMgr()
 
 BOOL LLVolumeMgr::cleanup()
 {
+	stopGenerationThreads();
+
 	BOOL no_refs = TRUE;
 	if (mDataMutex)
 	{
@@ -78,6 +91,7 @@ BOOL LLVolumeMgr::cleanup()
  		delete volgroupp;
 	}
 	mVolumeLODGroups.clear();
+	mGenerationQ.clear();
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
@@ -105,11 +119,99 @@ LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32
 	{
 		volgroupp = iter->second;
 	}
+	// Counted under the lock, generation threads add LODs to the group
+	// and unrefVolume() may delete it from another thread
+	LLVolume* volumep = volgroupp->refLOD(detail);
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
 	}
-	return volgroupp->refLOD(detail);
+	return volumep;
+}
+
+bool LLVolumeMgr::requestVolume(const LLVolumeParams &volume_params, const S32 detail)
+{
+	if (mGenerationThreads.empty()
+		|| volume_params.isSculpt()
+		|| volume_params.getPathParams().getCurveType() == LL_PCODE_PATH_FLEXIBLE)
+	{
+		return true;
+	}
+
+	S32 depth = -1;
+	{
+		LLMutexLock lock(mDataMutex);
+		volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+		if (iter == mVolumeLODGroups.end() || iter->second->getNumRefs() == 0)
+		{
+			// Nothing to show meanwhile
+			return true;
+		}
+
+		LLVolumeLODGroup* volgroupp = iter->second;
+		if (volgroupp->hasLOD(detail))
+		{
+			return true;
+		}
+
+		if (!volgroupp->mLODQueued[detail])
+		{
+			volgroupp->mLODQueued[detail] = true;
+			mGenerationQ.push_back(GenerationRequest());
+			mGenerationQ.back().mVolumeParams = volume_params;
+			mGenerationQ.back().mDetail = detail;
+			depth = mGenerationQ.size();
+		}
+	}
+
+	if (depth >= 0)
+	{
+		sample(sGenerationQueueDepth, depth);
+		for (std::vector<GenerationThread*>::iterator iter = mGenerationThreads.begin();
+			 iter != mGenerationThreads.end(); ++iter)
+		{
+			(*iter)->wake();
+		}
+	}
+	return false;
+}
+
+void LLVolumeMgr::compactIdleVolumes(U32 min_idle_frames, U32 max_groups)
+{
+	U32 frame = LLFrameTimer::getFrameCount();
+	LLMutexLock lock(mDataMutex);
+	if (mVolumeLODGroups.empty())
+	{
+		return;
+	}
+
+	// Groups come and go between calls, so pick up after the last params
+	// rather than at a saved iterator
+	volume_lod_group_map_t::iterator iter = mCompactCursorValid
+		? mVolumeLODGroups.upper_bound(&mCompactCursor)
+		: mVolumeLODGroups.begin();
+	for (U32 i = 0; i < max_groups && i < mVolumeLODGroups.size(); ++i)
+	{
+		if (iter == mVolumeLODGroups.end())
+		{
+			iter = mVolumeLODGroups.begin();
+		}
+
+		LLVolumeLODGroup* volgroupp = iter->second;
+		for (S32 detail = 0; detail < LLVolumeLODGroup::NUM_LODS; ++detail)
+		{
+			LLVolume* volumep = volgroupp->mVolumeLODs[detail];
+			if (volumep && !volumep->isCompact()
+				&& frame - volumep->getLastFaceAccess() >= min_idle_frames)
+			{
+				volumep->compactFaces();
+			}
+		}
+
+		mCompactCursor = *iter->first;
+		mCompactCursorValid = true;
+		++iter;
+	}
 }
 
 // virtual
@@ -218,6 +320,132 @@ void LLVolumeMgr::useMutex()
 	}
 }
 
+void LLVolumeMgr::startGenerationThreads(U32 num_threads)
+{
+	llassert_always(mDataMutex);
+	if (!mGenerationThreads.empty())
+	{
+		return;
+	}
+
+	if (num_threads == 0)
+	{
+		// Leave most cores to the main, texture and mesh threads
+		num_threads = llclamp(std::thread::hardware_concurrency() / 4, 1U, MAX_AUTO_VOLUME_GENERATION_THREADS);
+	}
+	for (U32 i = 0; i < num_threads; ++i)
+	{
+		mGenerationThreads.push_back(new GenerationThread(llformat("volume generation %d", i), this));
+	}
+	LL_INFOS() << "Prim LODs generated on " << getNumGenerationThreads() << " thread(s)" << LL_ENDL;
+}
+
+void LLVolumeMgr::stopGenerationThreads()
+{
+	for (std::vector<GenerationThread*>::iterator iter = mGenerationThreads.begin();
+		 iter != mGenerationThreads.end(); ++iter)
+	{
+		GenerationThread* thread = *iter;
+		thread->shutdown();
+		delete thread;
+	}
+	mGenerationThreads.clear();
+}
+
+S32 LLVolumeMgr::getGenerationQueueDepth()
+{
+	LLMutexLock lock(mDataMutex);
+	return mGenerationQ.size();
+}
+
+bool LLVolumeMgr::hasGenerationRequests()
+{
+	LLMutexLock lock(mDataMutex);
+	return !mGenerationQ.empty();
+}
+
+bool LLVolumeMgr::popGenerationRequest(GenerationRequest& request)
+{
+	S32 depth;
+	{
+		LLMutexLock lock(mDataMutex);
+		if (mGenerationQ.empty())
+		{
+			return false;
+		}
+		request = mGenerationQ.front();
+		mGenerationQ.pop_front();
+		depth = mGenerationQ.size();
+	}
+	sample(sGenerationQueueDepth, depth);
+	return true;
+}
+
+// Runs on a generation thread
+void LLVolumeMgr::generate(const GenerationRequest& request)
+{
+	record(sGenerationQueueWait, F64Seconds(request.mQueuedTimer.getElapsedTimeF64()));
+
+	LLTimer timer;
+	LLVolume* volumep = new LLVolume(request.mVolumeParams,
+									 LLVolumeLODGroup::getVolumeScaleFromDetail(request.mDetail));
+	record(sGenerationTime, F64Seconds(timer.getElapsedTimeF64()));
+
+	// LLVolume reference counts are not atomic: the volume gets its only
+	// reference under the lock, before any other thread can see it, and
+	// none from this thread afterwards
+	LLMutexLock lock(mDataMutex);
+	LLPointer<LLVolume> discard = volumep;
+	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&request.mVolumeParams);
+	if (iter != mVolumeLODGroups.end())
+	{
+		LLVolumeLODGroup* volgroupp = iter->second;
+		volgroupp->mLODQueued[request.mDetail] = false;
+		if (!volgroupp->hasLOD(request.mDetail))
+		{
+			volgroupp->mVolumeLODs[request.mDetail] = volumep;
+		}
+	}
+	// Otherwise the group was let go of or refVolume() built the LOD
+	// meanwhile, and the volume goes with discard
+}
+
+LLVolumeMgr::GenerationThread::GenerationThread(const std::string& name, LLVolumeMgr* mgr)
+	: LLThread(name),
+	  mMgr(mgr)
+{
+	start();
+}
+
+// virtual
+bool LLVolumeMgr::GenerationThread::runCondition()
+{
+	return isQuitting() || mMgr->hasGenerationRequests();
+}
+
+// virtual
+void LLVolumeMgr::GenerationThread::run()
+{
+	while (1)
+	{
+		checkPause();
+
+		if (isQuitting())
+		{
+			LLTrace::get_thread_recorder()->pushToParent();
+			break;
+		}
+
+		GenerationRequest request;
+		if (mMgr->popGenerationRequest(request))
+		{
+			mMgr->generate(request);
+			// Hand this request's queue and build stats to the main thread
+			LLTrace::get_thread_recorder()->pushToParent();
+		}
+	}
+}
+
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
 	s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
@@ -253,6 +481,7 @@ LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	{
 		mLODRefs[i] = 0;
 		mAccessCount[i] = 0;
+		mLODQueued[i] = false;
 	}
 }
 
@@ -27,11 +27,15 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <deque>
 #include <map>
+#include <vector>
 
 #include "llvolume.h"
 #include "llpointer.h"
 #include "llthread.h"
+#include "lltimer.h"
+#include "lltrace.h"
 
 class LLVolumeParams;
 class LLVolumeLODGroup;
@@ -51,6 +55,7 @@ public:
 	bool cleanupRefs();
 
 	static S32 getDetailFromTan(const F32 tan_angle);
+	static F32 getDetailThreshold(const S32 detail) { return mDetailThresholds[detail]; }
 	static void getDetailProximity(const F32 tan_angle, F32 &to_lower, F32& to_higher);
 	static F32 getVolumeScaleFromDetail(const S32 detail);
 	static S32 getVolumeDetailFromScale(F32 scale);
@@ -58,6 +63,8 @@ public:
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
 	S32 getNumRefs() const { return mRefs; }
+
+	bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
 
@@ -73,6 +80,9 @@ protected:
 	static F32 mDetailThresholds[NUM_LODS];
 	static F32 mDetailScales[NUM_LODS];
 	S32		mAccessCount[NUM_LODS];
+	bool	mLODQueued[NUM_LODS];	// waiting for a generation thread
+
+	friend class LLVolumeMgr;
 };
 
 class LLVolumeMgr
@@ -90,11 +100,37 @@ public:
 	virtual LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail);
 	virtual void unrefVolume(LLVolume *volumep);
 
+	// True when refVolume() would return the LOD without building it.
+	// Otherwise queues the LOD on the generation threads and returns false,
+	// and the caller keeps the LOD it has until a later call returns true.
+	// Only LODs of groups somebody holds another LOD of, and of volumes
+	// that are neither sculpted nor unique, are built in the background;
+	// this returns true for the others and when no generation threads run.
+	bool requestVolume(const LLVolumeParams &volume_params, const S32 detail);
+
+	// Compacts the faces (see LLVolume::compactFaces()) of the volumes that
+	// have not handed out a face for min_idle_frames, going through up to
+	// max_groups LOD groups from where the last call stopped.  Main thread
+	// only, the volumes of the groups are only read there.
+	void compactIdleVolumes(U32 min_idle_frames, U32 max_groups);
+
 	void dump();
 
 	// manually call this for mutex magic
 	void useMutex();
 
+	// Threads building the LODs queued by requestVolume(), num_threads of
+	// 0 picks a count based on the number of hardware threads.  Needs
+	// useMutex().  cleanup() stops them.
+	void startGenerationThreads(U32 num_threads);
+	void stopGenerationThreads();
+	U32 getNumGenerationThreads() const { return mGenerationThreads.size(); }
+	S32 getGenerationQueueDepth();
+
+	static LLTrace::SampleStatHandle<> sGenerationQueueDepth;
+	static LLTrace::EventStatHandle<F64Milliseconds> sGenerationQueueWait;
+	static LLTrace::EventStatHandle<F64Milliseconds> sGenerationTime;
+
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -107,6 +143,38 @@ protected:
 	volume_lod_group_map_t mVolumeLODGroups;
 
 	LLMutex* mDataMutex;
+
+private:
+	struct GenerationRequest
+	{
+		LLVolumeParams mVolumeParams;
+		S32 mDetail;
+		LLTimer mQueuedTimer;
+	};
+
+	class GenerationThread : public LLThread
+	{
+	public:
+		GenerationThread(const std::string& name, LLVolumeMgr* mgr);
+
+	protected:
+		/*virtual*/ bool runCondition();
+		/*virtual*/ void run();
+
+	private:
+		LLVolumeMgr* mMgr;
+	};
+	friend class GenerationThread;
+
+	bool hasGenerationRequests();
+	bool popGenerationRequest(GenerationRequest& request);
+	void generate(const GenerationRequest& request);
+
+	std::deque<GenerationRequest> mGenerationQ;	// guarded by mDataMutex
+	std::vector<GenerationThread*> mGenerationThreads;
+
+	LLVolumeParams mCompactCursor;	// last group compactIdleVolumes() went through
+	bool mCompactCursorValid;
 };
 
 #endif // LL_LLVOLUMEMGR_H
@@ -0,0 +1,218 @@
+/**
+ * @file llvolumesculpt.cpp
+ * @brief Sculpt map to vertex position conversion and its cache.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumesculpt.h"
+
+#include "llvolume.h"
+
+#include <vector>
+
+void ll_sculpt_generate_positions(LLVector4a* positions, S32 sizeS, S32 sizeT,
+								  U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+								  const U8* sculpt_data, U8 sculpt_type)
+{
+	U8 sculpt_stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
+	bool sculpt_invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
+	bool sculpt_mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
+	bool reverse_horizontal = sculpt_invert != sculpt_mirror;
+
+	bool pinch = sculpt_stitching == LL_SCULPT_TYPE_SPHERE;
+	bool wrap_x = pinch ||
+		sculpt_stitching == LL_SCULPT_TYPE_TORUS ||
+		sculpt_stitching == LL_SCULPT_TYPE_CYLINDER;
+	bool wrap_y = sculpt_stitching == LL_SCULPT_TYPE_TORUS;
+
+	// Byte offset in its row of the texel each column reads
+	static thread_local std::vector<U32> columns;	// kept between calls
+	columns.resize(sizeT);
+	for (S32 t = 0; t < sizeT; t++)
+	{
+		S32 reversed_t = reverse_horizontal ? sizeT - t - 1 : t;
+		U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
+		if (x == sculpt_width)	// side stitching
+		{
+			x = wrap_x ? 0 : sculpt_width - 1;
+		}
+		columns[t] = x * sculpt_components;
+	}
+
+	// [0..255] -> [-0.5..0.5], x negated when mirrored.  Negating the
+	// scale and the bias gives the same bits as negating the result.
+	const F32 to_unit = 1.f/255.f;
+	LLVector4a scale(sculpt_mirror ? -to_unit : to_unit, to_unit, to_unit, 0.f);
+	LLVector4a bias(sculpt_mirror ? 0.5f : -0.5f, -0.5f, -0.5f, 0.f);
+
+	U32 row_bytes = sculpt_width * sculpt_components;
+	LLVector4a* pos = positions;
+	for (S32 s = 0; s < sizeS; s++)
+	{
+		U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
+		bool pinch_row = pinch && (y == 0 || y == sculpt_height);
+		if (y == sculpt_height)	// bottom row stitching
+		{
+			y = wrap_y ? 0 : sculpt_height - 1;
+		}
+		const U8* row = sculpt_data + y * row_bytes;
+
+		if (pinch_row)
+		{
+			// Top and bottom of a sphere meet at the middle of the row
+			const U8* texel = row + (sculpt_width / 2) * sculpt_components;
+			LLVector4a rgb(_mm_cvtepi32_ps(_mm_setr_epi32(texel[0], texel[1], texel[2], 0)));
+			LLVector4a pt;
+			pt.setMul(rgb, scale);
+			pt.add(bias);
+			for (S32 t = 0; t < sizeT; t++)
+			{
+				*pos++ = pt;
+			}
+			continue;
+		}
+
+		const U32* column = &columns[0];
+		for (S32 t = 0; t < sizeT; t++)
+		{
+			const U8* texel = row + column[t];
+			LLVector4a rgb(_mm_cvtepi32_ps(_mm_setr_epi32(texel[0], texel[1], texel[2], 0)));
+			pos->setMul(rgb, scale);
+			pos->add(bias);
+			pos++;
+		}
+	}
+}
+
+LLSculptCache::Key::Key(const LLUUID& sculpt_id, S32 sculpt_level, U8 sculpt_type,
+						U16 sculpt_width, U16 sculpt_height, S32 sizeS, S32 sizeT)
+:	mSculptID(sculpt_id),
+	mSculptLevel(sculpt_level),
+	mSculptType(sculpt_type),
+	mWidth(sculpt_width),
+	mHeight(sculpt_height),
+	mSizeS(sizeS),
+	mSizeT(sizeT)
+{
+}
+
+bool LLSculptCache::Key::operator<(const Key& rhs) const
+{
+	if (mSculptID != rhs.mSculptID)
+	{
+		return mSculptID < rhs.mSculptID;
+	}
+	if (mSculptLevel != rhs.mSculptLevel)
+	{
+		return mSculptLevel < rhs.mSculptLevel;
+	}
+	if (mSculptType != rhs.mSculptType)
+	{
+		return mSculptType < rhs.mSculptType;
+	}
+	if (mWidth != rhs.mWidth)
+	{
+		return mWidth < rhs.mWidth;
+	}
+	if (mHeight != rhs.mHeight)
+	{
+		return mHeight < rhs.mHeight;
+	}
+	if (mSizeS != rhs.mSizeS)
+	{
+		return mSizeS < rhs.mSizeS;
+	}
+	return mSizeT < rhs.mSizeT;
+}
+
+LLSculptCache::LLSculptCache()
+:	mHits(0),
+	mMisses(0)
+{
+}
+
+bool LLSculptCache::find(const Key& key, LLVector4a* positions, F32& area)
+{
+	LLMutexLock lock(&mMutex);
+	entry_map_t::iterator iter = mEntryMap.find(key);
+	if (iter == mEntryMap.end())
+	{
+		mMisses++;
+		return false;
+	}
+
+	mHits++;
+	mEntries.splice(mEntries.begin(), mEntries, iter->second);
+	const Entry& entry = *iter->second;
+	LLVector4a::memcpyNonAliased16((F32*) positions, (const F32*) entry.mPositions.mArray,
+								   entry.mPositions.size() * sizeof(LLVector4a));
+	if (entry.mArea >= 0.f)
+	{
+		area = entry.mArea;
+	}
+	return true;
+}
+
+void LLSculptCache::insert(const Key& key, const LLVector4a* positions, F32 area)
+{
+	LLMutexLock lock(&mMutex);
+	if (mEntryMap.find(key) != mEntryMap.end())
+	{
+		return;
+	}
+
+	if (mEntries.size() >= MAX_ENTRIES)
+	{
+		mEntryMap.erase(mEntries.back().mKey);
+		mEntries.pop_back();
+	}
+
+	mEntries.emplace_front(key, area);
+	Entry& entry = mEntries.front();
+	entry.mPositions.resize(key.mSizeS * key.mSizeT);
+	LLVector4a::memcpyNonAliased16((F32*) entry.mPositions.mArray, (const F32*) positions,
+								   entry.mPositions.size() * sizeof(LLVector4a));
+	mEntryMap[key] = mEntries.begin();
+}
+
+void LLSculptCache::clear()
+{
+	LLMutexLock lock(&mMutex);
+	mEntryMap.clear();
+	mEntries.clear();
+}
+
+U32 LLSculptCache::getNumEntries()
+{
+	LLMutexLock lock(&mMutex);
+	return mEntries.size();
+}
+
+// static
+LLSculptCache& LLSculptCache::instance()
+{
+	static LLSculptCache* cache = new LLSculptCache();
+	return *cache;
+}
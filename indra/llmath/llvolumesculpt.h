@@ -0,0 +1,120 @@
+/**
+ * @file llvolumesculpt.h
+ * @brief Sculpt map to vertex position conversion and its cache.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMESCULPT_H
+#define LL_LLVOLUMESCULPT_H
+
+#include "llalignedarray.h"
+#include "llmath.h"
+#include "llmutex.h"
+#include "lluuid.h"
+#include "llvector4a.h"
+
+#include <list>
+#include <map>
+
+// Writes the sizeS * sizeT vertex positions of a sculpted volume, one
+// row of sizeT per path point, from a sculpt map of sculpt_components
+// bytes per texel with the stitching and flags of sculpt_type.
+//
+// Works a row at a time: the texel each column reads is worked out once
+// for all rows, and every row is then converted without branches, the
+// RGB bytes turned into positions with one SSE multiply and add.  The
+// positions are the same, bit for bit, as converting texel by texel.
+void ll_sculpt_generate_positions(LLVector4a* positions, S32 sizeS, S32 sizeT,
+								  U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+								  const U8* sculpt_data, U8 sculpt_type);
+
+// Positions generated from sculpt maps, so that sculpties using the same
+// map at the same resolution share the work.  The least recently used
+// entries are dropped past MAX_ENTRIES.  Thread safe.
+class LLSculptCache
+{
+public:
+	// The map is known by its texture and discard level, the resolution
+	// by the path and profile sizes of the volume
+	struct Key
+	{
+		Key(const LLUUID& sculpt_id, S32 sculpt_level, U8 sculpt_type,
+			U16 sculpt_width, U16 sculpt_height, S32 sizeS, S32 sizeT);
+
+		bool operator<(const Key& rhs) const;
+
+		LLUUID mSculptID;
+		S32 mSculptLevel;
+		U8 mSculptType;
+		U16 mWidth;
+		U16 mHeight;
+		S32 mSizeS;
+		S32 mSizeT;
+	};
+
+	enum { MAX_ENTRIES = 256 };
+
+	LLSculptCache();
+
+	// Copies the sizeS * sizeT positions of key to positions and sets
+	// area to the surface area stored with them, or leaves area alone if
+	// none was.  Returns false when key is not cached.
+	bool find(const Key& key, LLVector4a* positions, F32& area);
+
+	// area < 0 when it was not computed
+	void insert(const Key& key, const LLVector4a* positions, F32 area);
+
+	void clear();
+
+	U32 getNumEntries();
+	U32 getNumHits() const		{ return mHits; }
+	U32 getNumMisses() const	{ return mMisses; }
+
+	// Cache shared by all volumes, kept for the life of the process
+	static LLSculptCache& instance();
+
+private:
+	LLSculptCache(const LLSculptCache&);
+	const LLSculptCache& operator=(const LLSculptCache&);
+
+	// Built in place, never copied
+	struct Entry
+	{
+		Entry(const Key& key, F32 area) : mKey(key), mArea(area) {}
+
+		Key mKey;
+		LLAlignedArray<LLVector4a, 64> mPositions;
+		F32 mArea;
+	};
+
+	typedef std::list<Entry> entry_list_t;	// most recently used first
+	typedef std::map<Key, entry_list_t::iterator> entry_map_t;
+
+	LLMutex mMutex;
+	entry_list_t mEntries;
+	entry_map_t mEntryMap;
+	U32 mHits;
+	U32 mMisses;
+};
+
+#endif // LL_LLVOLUMESCULPT_H
@@ -0,0 +1,271 @@
+/**
+ * @file llvolumetangents.cpp
+ * @brief Tangent frames of volume faces, four triangles or vertices
+ * at a time.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumetangents.h"
+
+#include "llalignedarray.h"
+#include "v2math.h"
+
+#include <float.h>
+
+namespace
+{
+	// Indices of the triangles in the four lanes of the batch at first,
+	// the last triangle repeated in the lanes past count
+	struct TriangleBatch
+	{
+		TriangleBatch(const U16* indices, U32 first, U32 count)
+		{
+			mCount = llmin(count - first, 4U);
+			for (U32 k = 0; k < 4; ++k)
+			{
+				const U16* idx = indices + (first + llmin(k, mCount - 1)) * 3;
+				mIdx[0][k] = idx[0];
+				mIdx[1][k] = idx[1];
+				mIdx[2][k] = idx[2];
+			}
+		}
+
+		// s and t of corner of the four triangles
+		void gather(const LLVector2* tc, U32 corner, LLQuad& s, LLQuad& t) const
+		{
+			const U32* idx = mIdx[corner];
+			LLQuad st01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) tc[idx[0]].mV), (const __m64*) tc[idx[1]].mV);
+			LLQuad st23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) tc[idx[2]].mV), (const __m64*) tc[idx[3]].mV);
+			s = _mm_shuffle_ps(st01, st23, _MM_SHUFFLE(2, 0, 2, 0));
+			t = _mm_shuffle_ps(st01, st23, _MM_SHUFFLE(3, 1, 3, 1));
+		}
+
+		U32 mIdx[3][4];
+		U32 mCount;
+	};
+
+	inline LLQuad select(const LLQuad& mask, const LLQuad& a, const LLQuad& b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	// Lane k of v in every lane
+	inline LLQuad splat(const LLQuad& v, U32 k)
+	{
+		switch (k)
+		{
+			case 0: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+			case 1: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+			case 2: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+			default: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	}
+
+	// Tangent of one vertex from its accumulated texture space directions,
+	// for the vertices past the last group of four
+	void finish_tangent(const LLVector4a& normal, const LLVector4a& sdir, const LLVector4a& tdir, LLVector4a& tangent)
+	{
+		LLVector4a n = normal;
+
+		LLVector4a ncrosst;
+		ncrosst.setCross3(n, sdir);
+
+		// Gram-Schmidt orthogonalize
+		n.mul(n.dot3(sdir).getF32());
+
+		LLVector4a tsubn;
+		tsubn.setSub(sdir, n);
+
+		if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
+		{
+			tsubn.normalize3fast();
+
+			// Calculate handedness
+			F32 handedness = ncrosst.dot3(tdir).getF32() < 0.f ? -1.f : 1.f;
+
+			tsubn.getF32ptr()[3] = handedness;
+
+			tangent = tsubn;
+		}
+		else
+		{ //degenerate, make up a value
+			tangent.set(0, 0, 1, 1);
+		}
+	}
+}
+
+void ll_calc_tangents(U32 vertex_count, const LLVector4a* positions, const LLVector4a* normals,
+					  const LLVector2* texcoords, U32 triangle_count, const U16* indices,
+					  LLVector4a* tangents)
+{
+	// Texture space s and t directions accumulated per vertex
+	static thread_local LLAlignedArray<LLVector4a, 64> scratch;
+	scratch.resize(vertex_count * 2);
+	LLVector4a* tan1 = scratch.mArray;
+	LLVector4a* tan2 = tan1 + vertex_count;
+	for (U32 i = 0; i < vertex_count * 2; ++i)
+	{
+		tan1[i].clear();
+	}
+
+	const LLQuad epsilon = _mm_set1_ps(FLT_EPSILON);
+	const LLQuad big = _mm_set1_ps(1024.f);	// some made up large ratio for division by zero
+	const LLQuad one = _mm_set1_ps(1.f);
+	const LLQuad zero = _mm_setzero_ps();
+
+	for (U32 first = 0; first < triangle_count; first += 4)
+	{
+		TriangleBatch batch(indices, first, triangle_count);
+
+		// Texture coordinate deltas and their ratio side by side for the
+		// four triangles...
+		LLQuad ws[3];
+		LLQuad wt[3];
+		for (U32 c = 0; c < 3; ++c)
+		{
+			batch.gather(texcoords, c, ws[c], wt[c]);
+		}
+
+		LLVector4a s1 = _mm_sub_ps(ws[1], ws[0]);
+		LLVector4a s2 = _mm_sub_ps(ws[2], ws[0]);
+		LLVector4a t1 = _mm_sub_ps(wt[1], wt[0]);
+		LLVector4a t2 = _mm_sub_ps(wt[2], wt[0]);
+
+		LLQuad rd = _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1));
+		LLVector4a r = select(_mm_cmpgt_ps(_mm_mul_ps(rd, rd), epsilon),
+							  _mm_div_ps(one, rd),
+							  select(_mm_cmpgt_ps(rd, zero), big, _mm_sub_ps(zero, big)));
+
+		// ...and the edges one triangle at a time, x y and z side by side,
+		// which saves transposing the positions in and the directions out
+		for (U32 k = 0; k < batch.mCount; ++k)
+		{
+			U32 i1 = batch.mIdx[0][k];
+			U32 i2 = batch.mIdx[1][k];
+			U32 i3 = batch.mIdx[2][k];
+
+			LLVector4a e1;
+			LLVector4a e2;
+			e1.setSub(positions[i2], positions[i1]);
+			e2.setSub(positions[i3], positions[i1]);
+
+			LLVector4a ks1 = splat(s1, k);
+			LLVector4a ks2 = splat(s2, k);
+			LLVector4a kt1 = splat(t1, k);
+			LLVector4a kt2 = splat(t2, k);
+			LLVector4a kr = splat(r, k);
+
+			LLVector4a sdir;
+			LLVector4a tdir;
+			sdir.setMul(_mm_sub_ps(_mm_mul_ps(kt2, e1), _mm_mul_ps(kt1, e2)), kr);
+			tdir.setMul(_mm_sub_ps(_mm_mul_ps(ks1, e2), _mm_mul_ps(ks2, e1)), kr);
+
+			tan1[i1].add(sdir);
+			tan1[i2].add(sdir);
+			tan1[i3].add(sdir);
+
+			tan2[i1].add(tdir);
+			tan2[i2].add(tdir);
+			tan2[i3].add(tdir);
+		}
+	}
+
+	const LLQuad min_length = _mm_set1_ps(F_APPROXIMATELY_ZERO);
+	const LLQuad degenerate_z = one;	// (0, 0, 1, 1) when the tangent is lost
+	const LLQuad minus_one = _mm_set1_ps(-1.f);
+
+	U32 a = 0;
+	for (; a + 4 <= vertex_count; a += 4)
+	{
+		LLQuad nx = normals[a], ny = normals[a+1], nz = normals[a+2], nw = normals[a+3];
+		_MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+		LLQuad tx = tan1[a], ty = tan1[a+1], tz = tan1[a+2], tw = tan1[a+3];
+		_MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+		LLQuad bx = tan2[a], by = tan2[a+1], bz = tan2[a+2], bw = tan2[a+3];
+		_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+		// n x t
+		LLQuad cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+		LLQuad cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+		LLQuad cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+
+		// Gram-Schmidt orthogonalize
+		LLQuad n_dot_t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+		LLQuad ox = _mm_sub_ps(tx, _mm_mul_ps(nx, n_dot_t));
+		LLQuad oy = _mm_sub_ps(ty, _mm_mul_ps(ny, n_dot_t));
+		LLQuad oz = _mm_sub_ps(tz, _mm_mul_ps(nz, n_dot_t));
+
+		LLQuad length_sqrd = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+		LLQuad valid = _mm_cmpgt_ps(length_sqrd, min_length);
+		LLQuad rsqrt = _mm_rsqrt_ps(length_sqrd);
+
+		// Handedness
+		LLQuad c_dot_b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, bx), _mm_mul_ps(cy, by)), _mm_mul_ps(cz, bz));
+		LLQuad handedness = select(_mm_cmplt_ps(c_dot_b, zero), minus_one, one);
+
+		LLQuad rx = _mm_and_ps(valid, _mm_mul_ps(ox, rsqrt));
+		LLQuad ry = _mm_and_ps(valid, _mm_mul_ps(oy, rsqrt));
+		LLQuad rz = select(valid, _mm_mul_ps(oz, rsqrt), degenerate_z);
+		LLQuad rw = select(valid, handedness, one);
+		_MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+		tangents[a] = rx;
+		tangents[a+1] = ry;
+		tangents[a+2] = rz;
+		tangents[a+3] = rw;
+	}
+
+	for (; a < vertex_count; a++)
+	{
+		finish_tangent(normals[a], tan1[a], tan2[a], tangents[a]);
+	}
+}
+
+void ll_normalize3fast_array(LLVector4a* vectors, U32 count)
+{
+	U32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		LLQuad x = vectors[i], y = vectors[i+1], z = vectors[i+2], w = vectors[i+3];
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		// LLVector4a::normalize3fast() scales w too
+		LLQuad rsqrt = _mm_rsqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		x = _mm_mul_ps(x, rsqrt);
+		y = _mm_mul_ps(y, rsqrt);
+		z = _mm_mul_ps(z, rsqrt);
+		w = _mm_mul_ps(w, rsqrt);
+
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		vectors[i] = x;
+		vectors[i+1] = y;
+		vectors[i+2] = z;
+		vectors[i+3] = w;
+	}
+
+	for (; i < count; i++)
+	{
+		vectors[i].normalize3fast();
+	}
+}
@@ -0,0 +1,56 @@
+/**
+ * @file llvolumetangents.h
+ * @brief Tangent frames of volume faces, four triangles or vertices
+ * at a time.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMETANGENTS_H
+#define LL_LLVOLUMETANGENTS_H
+
+#include "llmath.h"
+#include "llvector4a.h"
+
+class LLVector2;
+
+// Tangent of each vertex of an indexed triangle list (as in LLVolumeFace)
+// from its normal and the texture coordinates around it, orthogonal to the
+// normal, with the handedness of the bitangent in w.  Vertices without
+// usable texture coordinates get (0, 0, 1, 1).  Adapted from Lengyel, Eric.
+// "Computing Tangent Space Basis Vectors for an Arbitrary Mesh".
+//
+// Triangles are taken four at a time: their texture coordinate ratios are
+// computed side by side, and the tangent frames are finished four vertices
+// side by side.  What each triangle adds to its vertices is still added
+// triangle by triangle, so the results are the same bits as one triangle
+// at a time.  The scratch buffer is kept per thread, so faces may be
+// processed on any number of threads at once (e.g. on the mesh decode
+// threads), each face on one thread.
+void ll_calc_tangents(U32 vertex_count, const LLVector4a* positions, const LLVector4a* normals,
+					  const LLVector2* texcoords, U32 triangle_count, const U16* indices,
+					  LLVector4a* tangents);
+
+// normalize3fast() of every vector, four at a time
+void ll_normalize3fast_array(LLVector4a* vectors, U32 count);
+
+#endif // LL_LLVOLUMETANGENTS_H
@@ -0,0 +1,165 @@
+/**
+ * @file llvertexcache_test.cpp
+ * @brief Vertex cache and vertex fetch optimization test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llvertexcache.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace tut
+{
+	struct vertexcache_data
+	{
+		// Triangles of a width x height grid of quads, row after row
+		static std::vector<U16> make_grid(U32 width, U32 height)
+		{
+			std::vector<U16> indices;
+			for (U32 y = 0; y < height; ++y)
+			{
+				for (U32 x = 0; x < width; ++x)
+				{
+					U16 v = y * (width + 1) + x;
+					U16 below = v + width + 1;
+					U16 quad[] = { v, below, (U16) (v + 1), (U16) (v + 1), below, (U16) (below + 1) };
+					indices.insert(indices.end(), quad, quad + 6);
+				}
+			}
+			return indices;
+		}
+
+		// Same triangles in a scrambled order
+		static void shuffle_triangles(std::vector<U16>& indices)
+		{
+			U32 seed = 777;
+			U32 count = indices.size() / 3;
+			for (U32 i = count - 1; i > 0; --i)
+			{
+				seed = seed * 1664525 + 1013904223;
+				U32 j = (seed >> 8) % (i + 1);
+				std::swap_ranges(indices.begin() + i * 3, indices.begin() + i * 3 + 3, indices.begin() + j * 3);
+			}
+		}
+
+		// Triangles as sorted triples, to compare triangle sets in any order
+		static std::vector<U64> triangle_keys(const std::vector<U16>& indices)
+		{
+			std::vector<U64> keys;
+			for (U32 i = 0; i + 2 < indices.size(); i += 3)
+			{
+				keys.push_back(((U64) indices[i] << 32) | ((U64) indices[i+1] << 16) | indices[i+2]);
+			}
+			std::sort(keys.begin(), keys.end());
+			return keys;
+		}
+	};
+	typedef test_group<vertexcache_data> vertexcache_test;
+	typedef vertexcache_test::object vertexcache_object;
+	tut::vertexcache_test vertexcache_testcase("LLVertexCache");
+
+	template<> template<>
+	void vertexcache_object::test<1>()
+	{
+		// two triangles sharing an edge: 4 vertices transformed for 2 triangles
+		U16 quad[] = { 0, 1, 2, 2, 1, 3 };
+		ensure_equals("quad", ll_vertex_cache_acmr(quad, 6, 4, 32), 2.f);
+
+		// the fan center falls out of a FIFO of 3 every other triangle
+		U16 fan[] = { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+		ensure_equals("small cache", ll_vertex_cache_acmr(fan, 9, 5, 3), 2.f);
+		ensure_equals("large cache", ll_vertex_cache_acmr(fan, 9, 5, 32), 5.f / 3.f);
+		ensure_equals("nothing to draw", ll_vertex_cache_acmr(fan, 2, 5, 32), 0.f);
+	}
+
+	template<> template<>
+	void vertexcache_object::test<2>()
+	{
+		const U32 sizes[][2] = { { 1, 1 }, { 3, 2 }, { 16, 16 }, { 64, 8 }, { 100, 100 } };
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			U32 width = sizes[s][0];
+			U32 height = sizes[s][1];
+			U32 vertex_count = (width + 1) * (height + 1);
+			std::vector<U16> indices = make_grid(width, height);
+			shuffle_triangles(indices);
+			std::vector<U16> optimized = indices;
+
+			ensure("optimized", ll_optimize_vertex_cache(&optimized[0], optimized.size(), vertex_count));
+
+			// Same triangles, each with its corners in the same winding
+			std::vector<U16> rotated = optimized;
+			for (U32 i = 0; i < rotated.size(); i += 3)
+			{
+				U16* tri = &rotated[i];
+				std::rotate(tri, std::min_element(tri, tri + 3), tri + 3);
+			}
+			std::vector<U16> expected = indices;
+			for (U32 i = 0; i < expected.size(); i += 3)
+			{
+				U16* tri = &expected[i];
+				std::rotate(tri, std::min_element(tri, tri + 3), tri + 3);
+			}
+			ensure("same triangles", triangle_keys(expected) == triangle_keys(rotated));
+
+			if (width * height >= 256)
+			{
+				F32 before = ll_vertex_cache_acmr(&indices[0], indices.size(), vertex_count, LL_VERTEX_CACHE_SIZE);
+				F32 after = ll_vertex_cache_acmr(&optimized[0], optimized.size(), vertex_count, LL_VERTEX_CACHE_SIZE);
+				ensure("scrambled grid misses the cache", before > 1.5f);
+				ensure("optimized grid reuses the cache", after < 0.8f);
+			}
+		}
+	}
+
+	template<> template<>
+	void vertexcache_object::test<3>()
+	{
+		// degenerate triangles and an unused vertex
+		U16 indices[] = { 0, 0, 1, 1, 2, 3, 3, 2, 4, 5, 5, 5 };
+		const U32 count = LL_ARRAY_SIZE(indices);
+		std::vector<U16> optimized(indices, indices + count);
+		ensure("optimized", ll_optimize_vertex_cache(&optimized[0], count, 7));
+		ensure("same triangles", triangle_keys(std::vector<U16>(indices, indices + count)) == triangle_keys(optimized));
+
+		// out of range index
+		std::vector<U16> bad(indices, indices + count);
+		ensure("rejected", !ll_optimize_vertex_cache(&bad[0], count, 5));
+		ensure("left alone", std::equal(bad.begin(), bad.end(), indices));
+
+		// vertices in order of first use
+		U16 used[] = { 4, 2, 4, 0, 2, 1 };
+		S32 remap[6];
+		ensure_equals("used vertices", ll_optimize_vertex_fetch_remap(used, 6, 6, remap), 4U);
+		ensure_equals("first", remap[4], 0);
+		ensure_equals("second", remap[2], 1);
+		ensure_equals("third", remap[0], 2);
+		ensure_equals("fourth", remap[1], 3);
+		ensure_equals("unused", remap[3], -1);
+		ensure_equals("unused", remap[5], -1);
+	}
+}
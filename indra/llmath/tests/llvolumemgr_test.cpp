@@ -0,0 +1,219 @@
+/**
+ * @file llvolumemgr_test.cpp
+ * @brief LLVolumeMgr test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "../llvolumemgr.h"
+
+#include "llframetimer.h"
+
+namespace tut
+{
+	struct volumemgr_data
+	{
+		volumemgr_data()
+		{
+			mParams.setType(LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE);
+			mParams.setBeginAndEndS(0.f, 1.f);
+			mParams.setBeginAndEndT(0.f, 1.f);
+			mParams.setRatio(1.f, 1.f);
+			mParams.setShear(0.f, 0.f);
+		}
+
+		// Asks for the LOD until a generation thread has built it
+		bool waitForLOD(LLVolumeMgr& mgr, S32 detail)
+		{
+			LLFrameTimer timer;
+			while (!mgr.requestVolume(mParams, detail))
+			{
+				if (timer.getElapsedTimeF32() > 10.f)
+				{
+					return false;
+				}
+				ms_sleep(1);
+			}
+			return true;
+		}
+
+		// Largest position error and smallest normal and tangent cosines of a
+		// decoded face against the one it was encoded from
+		void compareDecoded(const LLVolumeFace& face, const LLVolumeFace& ref)
+		{
+			ensure("decoded", face.mPositions && face.mNormals && face.mTexCoords);
+			ensure_equals("vertices", face.mNumVertices, ref.mNumVertices);
+			ensure_equals("indices", face.mNumIndices, ref.mNumIndices);
+			ensure("same indices", !memcmp(face.mIndices, ref.mIndices, face.mNumIndices * sizeof(U16)));
+			ensure_equals("tangents", face.mTangents != NULL, ref.mTangents != NULL);
+			ensure("same texture coordinates", !memcmp(face.mTexCoords, ref.mTexCoords, face.mNumVertices * sizeof(LLVector2)));
+
+			for (S32 i = 0; i < face.mNumVertices; ++i)
+			{
+				LLVector4a delta;
+				delta.setSub(face.mPositions[i], ref.mPositions[i]);
+				mMaxPositionError = llmax(mMaxPositionError, delta.getLength3().getF32());
+
+				LLVector4a normal = ref.mNormals[i];
+				normal.normalize3();
+				mMinNormalDot = llmin(mMinNormalDot, normal.dot3(face.mNormals[i]).getF32());
+
+				if (ref.mTangents)
+				{
+					LLVector4a tangent = ref.mTangents[i];
+					tangent.normalize3();
+					mMinTangentDot = llmin(mMinTangentDot, tangent.dot3(face.mTangents[i]).getF32());
+					ensure_equals("bitangent sign", face.mTangents[i][3], ref.mTangents[i][3]);
+				}
+			}
+		}
+
+		LLVolumeParams mParams;
+		F32 mMaxPositionError;
+		F32 mMinNormalDot;
+		F32 mMinTangentDot;
+	};
+	typedef test_group<volumemgr_data> volumemgr_test;
+	typedef volumemgr_test::object volumemgr_object;
+	tut::volumemgr_test volumemgr_testcase("LLVolumeMgr");
+
+	template<> template<>
+	void volumemgr_object::test<1>()
+	{
+		LLVolumeMgr mgr;
+		mgr.useMutex();
+		ensure("LOD available without generation threads", mgr.requestVolume(mParams, 3));
+
+		LLVolume* volumep = mgr.refVolume(mParams, 0);
+		ensure("LOD available without generation threads", mgr.requestVolume(mParams, 3));
+		mgr.unrefVolume(volumep);
+		ensure("no references left", mgr.cleanup());
+	}
+
+	template<> template<>
+	void volumemgr_object::test<2>()
+	{
+		LLVolumeMgr mgr;
+		mgr.useMutex();
+		mgr.startGenerationThreads(2);
+		ensure_equals("generation threads", mgr.getNumGenerationThreads(), 2U);
+
+		// Nobody holds the group, the LOD is built by refVolume()
+		ensure("LOD of unknown group", mgr.requestVolume(mParams, 3));
+
+		LLVolume* low = mgr.refVolume(mParams, 0);
+		ensure("held LOD", mgr.requestVolume(mParams, 0));
+		ensure("LOD queued", !mgr.requestVolume(mParams, 3));
+		ensure("LOD built", waitForLOD(mgr, 3));
+		ensure_equals("queue drained", mgr.getGenerationQueueDepth(), 0);
+
+		LLVolume* high = mgr.refVolume(mParams, 3);
+		LLPointer<LLVolume> expected = new LLVolume(mParams, LLVolumeLODGroup::getVolumeScaleFromDetail(3));
+		ensure_equals("detail", high->getDetail(), expected->getDetail());
+		ensure_equals("faces", high->getNumVolumeFaces(), expected->getNumVolumeFaces());
+		for (S32 i = 0; i < expected->getNumVolumeFaces(); ++i)
+		{
+			ensure_equals("vertices", high->getVolumeFace(i).mNumVertices, expected->getVolumeFace(i).mNumVertices);
+			ensure_equals("indices", high->getVolumeFace(i).mNumIndices, expected->getVolumeFace(i).mNumIndices);
+		}
+
+		mgr.unrefVolume(low);
+		mgr.unrefVolume(high);
+		ensure("no references left", mgr.cleanup());
+		ensure_equals("generation threads stopped", mgr.getNumGenerationThreads(), 0U);
+	}
+
+	template<> template<>
+	void volumemgr_object::test<3>()
+	{
+		LLVolumeMgr mgr;
+		mgr.useMutex();
+		mgr.startGenerationThreads(1);
+
+		// Sculpted volumes are always built by refVolume()
+		mParams.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_SPHERE);
+		LLVolume* volumep = mgr.refVolume(mParams, 0);
+		ensure("sculpted LOD", mgr.requestVolume(mParams, 3));
+		mgr.unrefVolume(volumep);
+
+		// Letting go of the group while its LOD is queued
+		mParams.setSculptID(LLUUID::null, LL_SCULPT_TYPE_NONE);
+		volumep = mgr.refVolume(mParams, 0);
+		mgr.requestVolume(mParams, 2);
+		mgr.unrefVolume(volumep);
+		ensure("no references left", mgr.cleanup());
+	}
+
+	template<> template<>
+	void volumemgr_object::test<4>()
+	{
+		LLVolumeMgr mgr;
+		mgr.useMutex();
+
+		LLVolume* volumep = mgr.refVolume(mParams, 3);
+		volumep->genTangents(0);
+		std::vector<LLVolumeFace> expected;
+		volumep->copyFacesTo(expected);
+
+		// Volumes that handed out a face this frame are left alone
+		mgr.compactIdleVolumes(1, 10);
+		ensure("in use", !volumep->isCompact());
+
+		LLFrameTimer::updateFrameCount();
+		mgr.compactIdleVolumes(1, 10);
+		ensure("compact", volumep->isCompact());
+		ensure("memory saved", volumep->getCompactSavings() > 0);
+
+		mMaxPositionError = 0.f;
+		mMinNormalDot = 1.f;
+		mMinTangentDot = 1.f;
+
+		// Copies of compact faces are decoded
+		std::vector<LLVolumeFace> copies;
+		volumep->copyFacesTo(copies);
+		ensure("still compact", volumep->isCompact());
+		for (S32 i = 0; i < copies.size(); ++i)
+		{
+			compareDecoded(copies[i], expected[i]);
+		}
+
+		// and so are the faces handed out
+		for (S32 i = 0; i < volumep->getNumVolumeFaces(); ++i)
+		{
+			compareDecoded(volumep->getVolumeFace(i), expected[i]);
+		}
+		ensure("decoded on demand", !volumep->isCompact());
+		ensure_equals("nothing saved once decoded", volumep->getCompactSavings(), 0);
+
+		// A unit sphere, 16 bit steps across it are 1/65535 apart
+		ensure("positions", mMaxPositionError < 2e-5f);
+		ensure("normals", mMinNormalDot > 0.99999f);
+		ensure("tangents", mMinTangentDot > 0.99999f);
+
+		mgr.unrefVolume(volumep);
+		ensure("no references left", mgr.cleanup());
+	}
+}
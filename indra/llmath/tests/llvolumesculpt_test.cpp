@@ -0,0 +1,224 @@
+/**
+ * @file llvolumesculpt_test.cpp
+ * @brief Sculpt map conversion and LLSculptCache test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "../llvolumesculpt.h"
+
+#include <vector>
+
+namespace tut
+{
+	struct volumesculpt_data
+	{
+		// Positions as LLVolume::sculptGenerateMapVertices() produced them
+		// texel by texel, which the row conversion must match bit for bit
+		static void golden_positions(LLVector4a* positions, S32 sizeS, S32 sizeT,
+									 U16 width, U16 height, S8 components, const U8* data, U8 sculpt_type)
+		{
+			U8 stitching = sculpt_type & LL_SCULPT_TYPE_MASK;
+			BOOL invert = sculpt_type & LL_SCULPT_FLAG_INVERT;
+			BOOL mirror = sculpt_type & LL_SCULPT_FLAG_MIRROR;
+			BOOL reverse_horizontal = (invert ? !mirror : mirror);
+
+			for (S32 s = 0; s < sizeS; s++)
+			{
+				for (S32 t = 0; t < sizeT; t++)
+				{
+					S32 reversed_t = reverse_horizontal ? sizeT - t - 1 : t;
+					U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) width);
+					U32 y = (U32) ((F32)s/(sizeS-1) * (F32) height);
+					if (y == 0 && stitching == LL_SCULPT_TYPE_SPHERE)
+					{
+						x = width / 2;
+					}
+					if (y == height)
+					{
+						y = stitching == LL_SCULPT_TYPE_TORUS ? 0 : height - 1;
+						if (stitching == LL_SCULPT_TYPE_SPHERE)
+						{
+							x = width / 2;
+						}
+					}
+					if (x == width)
+					{
+						bool wrap = stitching == LL_SCULPT_TYPE_SPHERE || stitching == LL_SCULPT_TYPE_TORUS ||
+							stitching == LL_SCULPT_TYPE_CYLINDER;
+						x = wrap ? 0 : width - 1;
+					}
+
+					U32 index = (x + y * width) * components;
+					LLVector4a& pt = positions[s * sizeT + t];
+					LLVector4a sub(0.5f, 0.5f, 0.5f);
+					pt.set(data[index], data[index+1], data[index+2]);
+					pt.mul(1.f/255.f);
+					pt.sub(sub);
+					if (mirror)
+					{
+						LLVector4a scale(-1.f, 1, 1, 1);
+						pt.mul(scale);
+					}
+				}
+			}
+		}
+
+		static std::vector<U8> make_map(U16 width, U16 height, S8 components)
+		{
+			std::vector<U8> data(width * height * components);
+			U32 seed = 12345;
+			for (U32 i = 0; i < data.size(); ++i)
+			{
+				seed = seed * 1664525 + 1013904223;
+				data[i] = (U8) (seed >> 24);
+			}
+			return data;
+		}
+	};
+	typedef test_group<volumesculpt_data> volumesculpt_test;
+	typedef volumesculpt_test::object volumesculpt_object;
+	tut::volumesculpt_test volumesculpt_testcase("LLVolumeSculpt");
+
+	template<> template<>
+	void volumesculpt_object::test<1>()
+	{
+		// 2x2 map, texels (0,0,0) (255,255,255) / (255,0,128) (0,255,0)
+		const U8 data[] = { 0, 0, 0,  255, 255, 255,  255, 0, 128,  0, 255, 0 };
+		LLVector4a positions[4];
+
+		ll_sculpt_generate_positions(positions, 2, 2, 2, 2, 3, data, LL_SCULPT_TYPE_PLANE);
+		ensure_equals("first texel x", positions[0][0], -0.5f);
+		ensure_equals("first texel z", positions[0][2], -0.5f);
+		ensure_equals("second texel x", positions[1][0], 0.5f);
+		ensure_equals("clamped to the last row", positions[2][0], 0.5f);
+		ensure_equals("clamped to the last row", positions[2][1], -0.5f);
+		ensure_equals("128", positions[2][2], 128.f * (1.f/255.f) - 0.5f);
+		ensure_equals("w", positions[3][3], 0.f);
+
+		ll_sculpt_generate_positions(positions, 2, 2, 2, 2, 3, data, LL_SCULPT_TYPE_PLANE | LL_SCULPT_FLAG_MIRROR);
+		ensure_equals("mirrored and reversed", positions[0][0], -0.5f);
+		ensure_equals("mirrored and reversed", positions[1][0], 0.5f);
+
+		ll_sculpt_generate_positions(positions, 2, 2, 2, 2, 3, data, LL_SCULPT_TYPE_TORUS);
+		ensure_equals("wrapped to the first row", positions[2][0], -0.5f);
+		ensure_equals("wrapped to the first column", positions[3][0], -0.5f);
+
+		ll_sculpt_generate_positions(positions, 2, 2, 2, 2, 3, data, LL_SCULPT_TYPE_SPHERE);
+		ensure_equals("pinched top", positions[0][0], 0.5f);
+		ensure_equals("pinched top", positions[1][0], 0.5f);
+	}
+
+	template<> template<>
+	void volumesculpt_object::test<2>()
+	{
+		const U8 types[] = { LL_SCULPT_TYPE_SPHERE, LL_SCULPT_TYPE_TORUS, LL_SCULPT_TYPE_PLANE, LL_SCULPT_TYPE_CYLINDER };
+		const U8 flags[] = { 0, LL_SCULPT_FLAG_INVERT, LL_SCULPT_FLAG_MIRROR, LL_SCULPT_FLAG_INVERT | LL_SCULPT_FLAG_MIRROR };
+		const U16 map_sizes[][2] = { { 32, 32 }, { 64, 16 }, { 16, 64 }, { 13, 7 } };
+		const S32 mesh_sizes[][2] = { { 7, 7 }, { 9, 9 }, { 17, 17 }, { 33, 33 }, { 5, 41 }, { 41, 5 } };
+
+		for (S32 m = 0; m < 4; ++m)
+		{
+			for (S8 components = 3; components <= 4; ++components)
+			{
+				U16 width = map_sizes[m][0];
+				U16 height = map_sizes[m][1];
+				std::vector<U8> data = make_map(width, height, components);
+				for (S32 type = 0; type < 4; ++type)
+				{
+					for (S32 flag = 0; flag < 4; ++flag)
+					{
+						for (S32 size = 0; size < 6; ++size)
+						{
+							S32 sizeS = mesh_sizes[size][0];
+							S32 sizeT = mesh_sizes[size][1];
+							LLAlignedArray<LLVector4a, 64> expected;
+							LLAlignedArray<LLVector4a, 64> positions;
+							expected.resize(sizeS * sizeT);
+							positions.resize(sizeS * sizeT);
+							U8 sculpt_type = types[type] | flags[flag];
+							golden_positions(expected.mArray, sizeS, sizeT, width, height, components, &data[0], sculpt_type);
+							ll_sculpt_generate_positions(positions.mArray, sizeS, sizeT, width, height, components, &data[0], sculpt_type);
+							ensure("same bits as the texel by texel conversion",
+								   !memcmp(expected.mArray, positions.mArray, sizeS * sizeT * sizeof(LLVector4a)));
+						}
+					}
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void volumesculpt_object::test<3>()
+	{
+		std::vector<U8> data = make_map(32, 32, 3);
+		LLVector4a generated[81];
+		LLVector4a cached[81];
+		ll_sculpt_generate_positions(generated, 9, 9, 32, 32, 3, &data[0], LL_SCULPT_TYPE_SPHERE);
+
+		LLSculptCache cache;
+		LLUUID id;
+		id.generate();
+		LLSculptCache::Key key(id, 0, LL_SCULPT_TYPE_SPHERE, 32, 32, 9, 9);
+		F32 area = -1.f;
+		ensure("empty cache", !cache.find(key, cached, area));
+
+		cache.insert(key, generated, 2.f);
+		ensure("cached", cache.find(key, cached, area));
+		ensure_equals("area", area, 2.f);
+		ensure("same positions", !memcmp(generated, cached, sizeof(generated)));
+
+		LLSculptCache::Key mirrored(id, 0, LL_SCULPT_TYPE_SPHERE | LL_SCULPT_FLAG_MIRROR, 32, 32, 9, 9);
+		LLSculptCache::Key finer(id, 0, LL_SCULPT_TYPE_SPHERE, 32, 32, 17, 17);
+		LLSculptCache::Key sharper(id, 1, LL_SCULPT_TYPE_SPHERE, 32, 32, 9, 9);
+		ensure("other sculpt type", !cache.find(mirrored, cached, area));
+		ensure("other LOD", !cache.find(finer, cached, area));
+		ensure("other discard level", !cache.find(sharper, cached, area));
+		ensure_equals("hits", cache.getNumHits(), 1U);
+		ensure_equals("misses", cache.getNumMisses(), 4U);
+
+		// least recently used entries go first
+		LLUUID first;
+		for (S32 i = 0; i < LLSculptCache::MAX_ENTRIES; ++i)
+		{
+			LLUUID other;
+			other.generate();
+			if (i == 0)
+			{
+				first = other;
+			}
+			cache.insert(LLSculptCache::Key(other, 0, LL_SCULPT_TYPE_SPHERE, 32, 32, 9, 9), generated, -1.f);
+			if (i == LLSculptCache::MAX_ENTRIES / 2)
+			{
+				ensure("still cached", cache.find(key, cached, area));
+			}
+		}
+		ensure_equals("bounded", cache.getNumEntries(), (U32) LLSculptCache::MAX_ENTRIES);
+		ensure("recently used kept", cache.find(key, cached, area));
+		LLSculptCache::Key first_key(first, 0, LL_SCULPT_TYPE_SPHERE, 32, 32, 9, 9);
+		ensure("least recently used dropped", !cache.find(first_key, cached, area));
+	}
+}
@@ -0,0 +1,243 @@
+/**
+ * @file llvolumetangents_test.cpp
+ * @brief Tangent generation test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llvolumetangents.h"
+#include "../llalignedarray.h"
+#include "../v2math.h"
+
+#include <float.h>
+#include <vector>
+
+namespace tut
+{
+	struct volumetangents_data
+	{
+		// Tangents as CalculateTangentArray() in llvolume.cpp computed them
+		// one triangle at a time, which the batched code must match bit for bit
+		static void golden_tangents(U32 vertexCount, const LLVector4a* vertex, const LLVector4a* normal,
+									const LLVector2* texcoord, U32 triangleCount, const U16* index_array,
+									LLVector4a* tangent)
+		{
+			LLAlignedArray<LLVector4a, 64> scratch;
+			scratch.resize(vertexCount * 2);
+			LLVector4a* tan1 = scratch.mArray;
+			LLVector4a* tan2 = tan1 + vertexCount;
+			for (U32 i = 0; i < vertexCount * 2; i++)
+			{
+				tan1[i].clear();
+			}
+
+			for (U32 a = 0; a < triangleCount; a++)
+			{
+				U32 i1 = *index_array++;
+				U32 i2 = *index_array++;
+				U32 i3 = *index_array++;
+
+				const F32* v1ptr = vertex[i1].getF32ptr();
+				const F32* v2ptr = vertex[i2].getF32ptr();
+				const F32* v3ptr = vertex[i3].getF32ptr();
+				const LLVector2& w1 = texcoord[i1];
+				const LLVector2& w2 = texcoord[i2];
+				const LLVector2& w3 = texcoord[i3];
+
+				float x1 = v2ptr[0] - v1ptr[0];
+				float x2 = v3ptr[0] - v1ptr[0];
+				float y1 = v2ptr[1] - v1ptr[1];
+				float y2 = v3ptr[1] - v1ptr[1];
+				float z1 = v2ptr[2] - v1ptr[2];
+				float z2 = v3ptr[2] - v1ptr[2];
+
+				float s1 = w2.mV[0] - w1.mV[0];
+				float s2 = w3.mV[0] - w1.mV[0];
+				float t1 = w2.mV[1] - w1.mV[1];
+				float t2 = w3.mV[1] - w1.mV[1];
+
+				F32 rd = s1*t2-s2*t1;
+				float r = ((rd*rd) > FLT_EPSILON) ? (1.0f / rd) : ((rd > 0.0f) ? 1024.f : -1024.f);
+
+				LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+				LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+
+				tan1[i1].add(sdir);
+				tan1[i2].add(sdir);
+				tan1[i3].add(sdir);
+
+				tan2[i1].add(tdir);
+				tan2[i2].add(tdir);
+				tan2[i3].add(tdir);
+			}
+
+			for (U32 a = 0; a < vertexCount; a++)
+			{
+				LLVector4a n = normal[a];
+				const LLVector4a& t = tan1[a];
+
+				LLVector4a ncrosst;
+				ncrosst.setCross3(n,t);
+				n.mul(n.dot3(t).getF32());
+
+				LLVector4a tsubn;
+				tsubn.setSub(t,n);
+				if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
+				{
+					tsubn.normalize3fast();
+					F32 handedness = ncrosst.dot3(tan2[a]).getF32() < 0.f ? -1.f : 1.f;
+					tsubn.getF32ptr()[3] = handedness;
+					tangent[a] = tsubn;
+				}
+				else
+				{
+					tangent[a].set(0,0,1,1);
+				}
+			}
+		}
+
+		struct Mesh
+		{
+			LLAlignedArray<LLVector4a, 64> mPositions;
+			LLAlignedArray<LLVector4a, 64> mNormals;
+			std::vector<LLVector2> mTexCoords;
+			std::vector<U16> mIndices;
+		};
+
+		// Wavy grid of width x height vertices, with a few collapsed texture
+		// coordinates and repeated corners to exercise the degenerate paths
+		static void make_grid(Mesh& mesh, U32 width, U32 height)
+		{
+			U32 seed = 4321;
+			U32 count = width * height;
+			mesh.mPositions.resize(count);
+			mesh.mNormals.resize(count);
+			mesh.mTexCoords.resize(count);
+			for (U32 y = 0; y < height; ++y)
+			{
+				for (U32 x = 0; x < width; ++x)
+				{
+					seed = seed * 1664525 + 1013904223;
+					F32 jitter = (F32) (seed >> 8) / (F32) (1 << 24) - 0.5f;
+					U32 i = y * width + x;
+					mesh.mPositions[i].set((F32) x * 0.1f, (F32) y * 0.1f, sinf(x * 0.7f) * cosf(y * 0.3f) + jitter * 0.05f);
+					mesh.mNormals[i].set(jitter, 0.2f, 1.f);
+					mesh.mTexCoords[i].set((F32) x / width, (seed & 7) ? (F32) y / height : 0.f);
+				}
+			}
+
+			for (U32 y = 0; y + 1 < height; ++y)
+			{
+				for (U32 x = 0; x + 1 < width; ++x)
+				{
+					U16 i = y * width + x;
+					U16 quad[] = { i, (U16) (i + 1), (U16) (i + width), (U16) (i + 1), (U16) (i + width + 1), (U16) (i + width) };
+					mesh.mIndices.insert(mesh.mIndices.end(), quad, quad + 6);
+				}
+			}
+
+			// degenerate triangle sharing one vertex twice
+			U16 degenerate[] = { 0, 0, 1 };
+			mesh.mIndices.insert(mesh.mIndices.end(), degenerate, degenerate + 3);
+		}
+	};
+	typedef test_group<volumetangents_data> volumetangents_test;
+	typedef volumetangents_test::object volumetangents_object;
+	tut::volumetangents_test volumetangents_testcase("LLVolumeTangents");
+
+	template<> template<>
+	void volumetangents_object::test<1>()
+	{
+		// unit right triangle in the xy plane, texture coordinates along x and y
+		LLVector4a positions[3];
+		positions[0].set(0.f, 0.f, 0.f);
+		positions[1].set(1.f, 0.f, 0.f);
+		positions[2].set(0.f, 1.f, 0.f);
+		LLVector4a normals[3];
+		for (S32 i = 0; i < 3; ++i)
+		{
+			normals[i].set(0.f, 0.f, 1.f);
+		}
+		LLVector2 texcoords[] = { LLVector2(0.f, 0.f), LLVector2(1.f, 0.f), LLVector2(0.f, 1.f) };
+		U16 indices[] = { 0, 1, 2 };
+
+		LLVector4a tangents[3];
+		ll_calc_tangents(3, positions, normals, texcoords, 1, indices, tangents);
+		ensure("tangent along x", fabsf(tangents[0][0] - 1.f) < 0.001f);
+		ensure_equals("tangent y", tangents[0][1], 0.f);
+		ensure_equals("right handed", tangents[2][3], 1.f);
+
+		// mirrored texture
+		texcoords[1].set(-1.f, 0.f);
+		ll_calc_tangents(3, positions, normals, texcoords, 1, indices, tangents);
+		ensure("tangent along -x", fabsf(tangents[1][0] + 1.f) < 0.001f);
+		ensure_equals("left handed", tangents[1][3], -1.f);
+
+		// no texture coordinates
+		texcoords[1].set(0.f, 0.f);
+		texcoords[2].set(0.f, 0.f);
+		normals[0].set(1.f, 0.f, 0.f);
+		ll_calc_tangents(3, positions, normals, texcoords, 1, indices, tangents);
+		ensure_equals("made up x", tangents[0][0], 0.f);
+		ensure_equals("made up z", tangents[0][2], 1.f);
+		ensure_equals("made up w", tangents[0][3], 1.f);
+	}
+
+	template<> template<>
+	void volumetangents_object::test<2>()
+	{
+		// sizes around multiples of four triangles and vertices
+		const U32 sizes[][2] = { { 2, 2 }, { 3, 2 }, { 2, 5 }, { 4, 4 }, { 7, 3 }, { 16, 16 }, { 33, 17 } };
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			Mesh mesh;
+			make_grid(mesh, sizes[s][0], sizes[s][1]);
+			U32 vertex_count = mesh.mPositions.size();
+			U32 triangle_count = mesh.mIndices.size() / 3;
+			const U16* indices = &mesh.mIndices[0];
+
+			LLAlignedArray<LLVector4a, 64> expected;
+			LLAlignedArray<LLVector4a, 64> actual;
+
+			expected.resize(vertex_count);
+			actual.resize(vertex_count);
+			golden_tangents(vertex_count, mesh.mPositions.mArray, mesh.mNormals.mArray, &mesh.mTexCoords[0],
+							triangle_count, indices, expected.mArray);
+			ll_calc_tangents(vertex_count, mesh.mPositions.mArray, mesh.mNormals.mArray, &mesh.mTexCoords[0],
+							 triangle_count, indices, actual.mArray);
+			ensure("tangents, same bits as one triangle at a time",
+				   !memcmp(expected.mArray, actual.mArray, vertex_count * sizeof(LLVector4a)));
+
+			for (U32 i = 0; i < vertex_count; ++i)
+			{
+				expected[i] = mesh.mNormals[i];
+				expected[i].normalize3fast();
+			}
+			ll_normalize3fast_array(mesh.mNormals.mArray, vertex_count);
+			ensure("normalized, same bits as normalize3fast()",
+				   !memcmp(expected.mArray, mesh.mNormals.mArray, vertex_count * sizeof(LLVector4a)));
+		}
+	}
+}
@@ -35,6 +35,7 @@
 
 #include "../llline.h"
 #include "../llmath.h"
+#include "../llquantize.h"
 #include "../llsphere.h"
 #include "../v3math.h"
 
@@ -168,6 +169,54 @@ namespace tut
 		angle =  llsimple_angle(angle);
 		ensure("llsimple_angle  value 1", (angle <=F_PI && angle >= -F_PI));
 	}
+
+	template<> template<>
+	void math_object::test<12>()
+	{
+		// axes, diagonals of both halves and points spread over the sphere
+		F32 max_error = 0.f;
+		for (S32 i = 0; i < 2000; ++i)
+		{
+			F32 vec[3];
+			if (i < 27)
+			{
+				vec[0] = (F32) (i % 3 - 1);
+				vec[1] = (F32) (i / 3 % 3 - 1);
+				vec[2] = (F32) (i / 9 - 1);
+			}
+			else
+			{
+				F32 z = 2.f * ((i * 0.618034f) - floorf(i * 0.618034f)) - 1.f;
+				F32 angle = i * 2.399963f;
+				F32 r = sqrtf(1.f - z * z);
+				vec[0] = r * cosf(angle);
+				vec[1] = r * sinf(angle);
+				vec[2] = z;
+			}
+
+			F32 len = sqrtf(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]);
+			S16 encoded[2];
+			F32 decoded[3];
+			F32_to_octahedral_S16(vec, encoded);
+			octahedral_S16_to_F32(encoded, decoded);
+
+			if (len == 0.f)
+			{
+				ensure("zero vector decodes to +Z", decoded[0] == 0.f && decoded[1] == 0.f && decoded[2] == 1.f);
+				continue;
+			}
+
+			// sine of the angle between the two
+			F32 cross[3] = { vec[1] * decoded[2] - vec[2] * decoded[1],
+							 vec[2] * decoded[0] - vec[0] * decoded[2],
+							 vec[0] * decoded[1] - vec[1] * decoded[0] };
+			F32 error = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]) / len;
+			max_error = llmax(max_error, error);
+			ensure("same hemisphere", vec[0] * decoded[0] + vec[1] * decoded[1] + vec[2] * decoded[2] > 0.f);
+		}
+		// within a ten thousandth of a radian
+		ensure("octahedral round trip", max_error < 0.0001f);
+	}
 }
 
 namespace tut
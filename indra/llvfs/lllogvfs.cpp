@@ -0,0 +1,1527 @@
+/** 
+ * @file lllogvfs.cpp
+ * @brief Log structured virtual file system backend
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lllogvfs.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "llapr.h"
+#include "llcrc.h"
+#include "llthread.h"
+#include "lltimer.h"
+
+const U32 LOG_VFS_INDEX_MAGIC = 0x5346564c;		// "LVFS"
+const U32 LOG_VFS_INDEX_VERSION = 1;
+const S32 LOG_VFS_BLOCK_MASK = 0x000003FF;		// 1024-byte blocks, as LLVFS
+const S64 LOG_VFS_MIN_COMPACT_BYTES = 16 * 1024 * 1024;
+const U32 LOG_VFS_MIN_INDEX_REWRITE = 1024;
+
+struct LLLogVFSIndexHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U32 mCreationTime;
+	U32 mPad;
+};
+
+// One index record, the last one for a file wins.  mLength of 0 removes it.
+struct LLLogVFS::Record
+{
+	U8 mFileID[UUID_BYTES];
+	S32 mFileType;
+	S32 mSize;
+	S32 mLength;
+	U32 mAccessTime;
+	S64 mLocation;
+	U32 mPad;
+	U32 mCRC;			// Of everything above
+};
+
+class LLLogVFS::Entry
+{
+public:
+	Entry(const LLVFSFileSpecifier& spec, S64 location, S32 length, S32 size, U32 access_time)
+		: mSpec(spec),
+		  mLocation(location),
+		  mLength(length),
+		  mSize(size),
+		  mAccessTime(access_time),
+		  mDirty(false)
+	{
+	}
+
+	LLVFSFileSpecifier mSpec;
+	S64 mLocation;				// Extent, only changed with mIndexLock exclusive
+	S32 mLength;
+	std::atomic<S32> mSize;		// May grow with mIndexLock shared
+	std::atomic<U32> mAccessTime;
+	std::atomic<bool> mDirty;	// Written since the running compaction copied it
+};
+
+class LLLogVFS::CompactThread : public LLThread
+{
+public:
+	CompactThread(LLLogVFS* vfs)
+		: LLThread("VFS compaction"),
+		  mVFS(vfs),
+		  mRequested(false)
+	{
+		start();
+	}
+
+	void request()
+	{
+		mRequested = true;
+		wake();
+	}
+
+	/*virtual*/ bool runCondition()
+	{
+		return isQuitting() || mRequested;
+	}
+
+	/*virtual*/ void run()
+	{
+		while (1)
+		{
+			checkPause();
+
+			if (isQuitting())
+			{
+				break;
+			}
+
+			mRequested = false;
+			mVFS->compact();
+		}
+	}
+
+private:
+	LLLogVFS* mVFS;
+	std::atomic<bool> mRequested;
+};
+
+namespace
+{
+	// Positional reads and writes, so they need no lock on the file position.
+	// The stdio buffers of the data file are never used.
+	S32 read_at(LLFILE* fp, U8* buffer, S32 length, S64 location)
+	{
+		S32 total = 0;
+#if LL_WINDOWS
+		HANDLE handle = (HANDLE)_get_osfhandle(_fileno(fp));
+		while (total < length)
+		{
+			OVERLAPPED overlapped;
+			memset(&overlapped, 0, sizeof(overlapped));
+			overlapped.Offset = (DWORD)((location + total) & 0xffffffff);
+			overlapped.OffsetHigh = (DWORD)((location + total) >> 32);
+			DWORD bytes = 0;
+			if (!ReadFile(handle, buffer + total, length - total, &bytes, &overlapped) || bytes == 0)
+			{
+				break;
+			}
+			total += bytes;
+		}
+#else
+		while (total < length)
+		{
+			ssize_t bytes = pread(fileno(fp), buffer + total, length - total, location + total);
+			if (bytes < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (bytes <= 0)
+			{
+				break;
+			}
+			total += bytes;
+		}
+#endif
+		return total;
+	}
+
+	S32 write_at(LLFILE* fp, const U8* buffer, S32 length, S64 location)
+	{
+		S32 total = 0;
+#if LL_WINDOWS
+		HANDLE handle = (HANDLE)_get_osfhandle(_fileno(fp));
+		while (total < length)
+		{
+			OVERLAPPED overlapped;
+			memset(&overlapped, 0, sizeof(overlapped));
+			overlapped.Offset = (DWORD)((location + total) & 0xffffffff);
+			overlapped.OffsetHigh = (DWORD)((location + total) >> 32);
+			DWORD bytes = 0;
+			if (!WriteFile(handle, buffer + total, length - total, &bytes, &overlapped) || bytes == 0)
+			{
+				break;
+			}
+			total += bytes;
+		}
+#else
+		while (total < length)
+		{
+			ssize_t bytes = pwrite(fileno(fp), buffer + total, length - total, location + total);
+			if (bytes < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (bytes <= 0)
+			{
+				break;
+			}
+			total += bytes;
+		}
+#endif
+		return total;
+	}
+
+	S64 file_size(LLFILE* fp)
+	{
+#if LL_WINDOWS
+		struct _stat64 file_status;
+		return _fstat64(_fileno(fp), &file_status) ? 0 : file_status.st_size;
+#else
+		struct stat file_status;
+		return fstat(fileno(fp), &file_status) ? 0 : file_status.st_size;
+#endif
+	}
+
+	U32 record_crc(const void* record, size_t size)
+	{
+		LLCRC crc;
+		crc.update((const U8*)record, size - sizeof(U32));
+		return crc.getCRC();
+	}
+
+	bool older_access(const std::pair<U32, LLVFSFileSpecifier>& lhs, const std::pair<U32, LLVFSFileSpecifier>& rhs)
+	{
+		return lhs.first < rhs.first;
+	}
+}
+
+LLLogVFS::LLLogVFS(const std::string& index_filename, const std::string& data_filename, const BOOL read_only, const U32 max_size, const BOOL remove_after_crash)
+:	LLVFS(),
+	mTail(0),
+	mLiveBytes(0),
+	mMaxSize(max_size),
+	mIndexRecords(0),
+	mCompacting(false),
+	mShuttingDown(false),
+	mCompactThread(NULL)
+{
+	mIndexFileMutex = new LLMutex();
+	mIndexFilename = index_filename;
+	mDataFilename = data_filename;
+	mReadOnly = read_only;
+	mRemoveAfterCrash = remove_after_crash;
+
+	const char *file_mode = mReadOnly ? "rb" : "r+b";
+
+	LL_INFOS("VFS") << "Attempting to open log VFS index file " << mIndexFilename << LL_ENDL;
+	LL_INFOS("VFS") << "Attempting to open log VFS data file " << mDataFilename << LL_ENDL;
+
+	// Did we leave this file open for writing last time?
+	// If so, start over.
+	std::string marker = mDataFilename + ".open";
+	llstat marker_info;
+	if (!mReadOnly && mRemoveAfterCrash && !LLFile::stat(marker, &marker_info))
+	{
+		LL_WARNS("VFS") << "VFS: File left open on last run, removing old VFS file " << mDataFilename << LL_ENDL;
+		LLFile::remove(mIndexFilename);
+		LLFile::remove(mDataFilename);
+		LLFile::remove(mIndexFilename + ".compact", ENOENT);
+		LLFile::remove(mDataFilename + ".compact", ENOENT);
+		LLFile::remove(marker);
+	}
+
+	if (!mReadOnly)
+	{
+		// A compaction that got as far as writing its index is finished here,
+		// anything else it or an index rewrite left behind is dropped
+		if (!finishCompaction())
+		{
+			LL_WARNS("VFS") << "Couldn't finish the compaction of vfs data file " << mDataFilename << LL_ENDL;
+			mValid = VFSVALID_BAD_CANNOT_CREATE;
+			return;
+		}
+		LLFile::remove(mDataFilename + ".compact", ENOENT);
+		LLFile::remove(mIndexFilename + ".compact.tmp", ENOENT);
+		LLFile::remove(mIndexFilename + ".tmp", ENOENT);
+	}
+
+	mDataFP = openAndLock(mDataFilename, file_mode, mReadOnly);
+	if (!mDataFP)
+	{
+		if (mReadOnly)
+		{
+			LL_WARNS("VFS") << "Can't find " << mDataFilename << " to open read-only VFS" << LL_ENDL;
+			mValid = VFSVALID_BAD_CANNOT_OPEN_READONLY;
+			return;
+		}
+
+		mDataFP = openAndLock(mDataFilename, "w+b", FALSE);
+		if (!mDataFP)
+		{
+			LL_WARNS("VFS") << "Couldn't open vfs data file " << mDataFilename << LL_ENDL;
+			mValid = VFSVALID_BAD_CANNOT_CREATE;
+			return;
+		}
+
+		// Since we're creating this data file, assume any index file is bogus
+		LLFile::remove(mIndexFilename);
+	}
+
+	if (!loadIndex())
+	{
+		if (mReadOnly)
+		{
+			LL_WARNS("VFS") << "Can't read index " << mIndexFilename << " of read-only VFS" << LL_ENDL;
+			mValid = VFSVALID_BAD_CORRUPT;
+			return;
+		}
+
+		// Start over with an empty data file
+		unlockAndClose(mDataFP);
+		mDataFP = openAndLock(mDataFilename, "w+b", FALSE);
+		if (!mDataFP)
+		{
+			LL_WARNS("VFS") << "Couldn't recreate vfs data file " << mDataFilename << LL_ENDL;
+			mValid = VFSVALID_BAD_CANNOT_CREATE;
+			return;
+		}
+		mTail = 0;
+		if (!writeIndex())
+		{
+			mValid = VFSVALID_BAD_CANNOT_CREATE;
+			return;
+		}
+	}
+
+	if (!mReadOnly)
+	{
+		if (mRemoveAfterCrash)
+		{
+			LLFILE* marker_fp = LLFile::fopen(marker, "w");	/* Flawfinder: ignore */
+			if (marker_fp)
+			{
+				fclose(marker_fp);
+				marker_fp = NULL;
+			}
+		}
+	}
+
+	LL_INFOS("VFS") << "Using log VFS data file " << mDataFilename << ", " << mEntries.size() << " files, "
+					<< mLiveBytes << " bytes live of " << mTail << LL_ENDL;
+
+	mValid = VFSVALID_OK;
+
+	if (!mReadOnly)
+	{
+		mCompactThread = new CompactThread(this);
+		requestCompaction();
+	}
+}
+
+LLLogVFS::~LLLogVFS()
+{
+	if (mCompactThread)
+	{
+		mShuttingDown = true;
+		mCompactThread->shutdown();
+		delete mCompactThread;
+		mCompactThread = NULL;
+	}
+
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+		// Persist access times and drop the removed records
+		if (isValid() && !mReadOnly)
+		{
+			writeIndex();
+		}
+
+		for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		{
+			delete iter->second;
+		}
+		mEntries.clear();
+	}
+
+	unlockAndClose(mIndexFP);
+	mIndexFP = NULL;
+	unlockAndClose(mDataFP);
+	mDataFP = NULL;
+
+	delete mIndexFileMutex;
+	mIndexFileMutex = NULL;
+}
+
+// Will append digits to the end of the filename with multiple re-trys, as createLLVFS()
+// static
+LLLogVFS* LLLogVFS::createLogVFS(const std::string& index_filename,
+		const std::string& data_filename,
+		const BOOL read_only,
+		const U32 max_size,
+		const BOOL remove_after_crash)
+{
+	LLLogVFS* new_vfs = new LLLogVFS(index_filename, data_filename, read_only, max_size, remove_after_crash);
+
+	S32 count = 0;
+	while (!new_vfs->isValid() && count < 256)
+	{	// Append '.<number>' to end of filenames
+		std::string retry_vfs_index_name = index_filename + llformat(".%u", count);
+		std::string retry_vfs_data_name = data_filename + llformat(".%u", count);
+
+		delete new_vfs;	// Delete bad VFS and try again
+		new_vfs = new LLLogVFS(retry_vfs_index_name, retry_vfs_data_name, read_only, max_size, remove_after_crash);
+
+		count++;
+	}
+
+	if (!new_vfs->isValid())
+	{
+		delete new_vfs;		// Delete bad VFS
+		new_vfs = NULL;		// Total failure
+	}
+
+	return new_vfs;
+}
+
+BOOL LLLogVFS::getExists(const LLUUID &file_id, const LLAssetType::EType file_type)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	entry_map_t::iterator iter = mEntries.find(LLVFSFileSpecifier(file_id, file_type));
+	if (iter == mEntries.end())
+	{
+		return FALSE;
+	}
+	iter->second->mAccessTime = (U32)time(NULL);
+	return TRUE;
+}
+
+S32 LLLogVFS::getSize(const LLUUID &file_id, const LLAssetType::EType file_type)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	entry_map_t::iterator iter = mEntries.find(LLVFSFileSpecifier(file_id, file_type));
+	if (iter == mEntries.end())
+	{
+		return 0;
+	}
+	iter->second->mAccessTime = (U32)time(NULL);
+	return iter->second->mSize;
+}
+
+BOOL LLLogVFS::checkAvailable(S32 max_size)
+{
+	// Anything that fits can be made room for without waiting
+	return (mMaxSize == 0 || max_size <= mMaxSize) ? TRUE : FALSE;
+}
+
+S32 LLLogVFS::getMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	entry_map_t::iterator iter = mEntries.find(LLVFSFileSpecifier(file_id, file_type));
+	if (iter == mEntries.end())
+	{
+		return 0;
+	}
+	iter->second->mAccessTime = (U32)time(NULL);
+	return iter->second->mLength;
+}
+
+BOOL LLLogVFS::setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type, S32 max_size)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+	if (mReadOnly)
+	{
+		LL_ERRS() << "Attempt to write to read-only VFS" << LL_ENDL;
+	}
+	if (max_size <= 0)
+	{
+		LL_WARNS() << "VFS: Attempt to assign size " << max_size << " to vfile " << file_id << LL_ENDL;
+		return FALSE;
+	}
+
+	// round all sizes upward to KB increments, except textures (see LLVFS::setMaxSize())
+	if (file_type != LLAssetType::AT_TEXTURE)
+	{
+		if (max_size & LOG_VFS_BLOCK_MASK)
+		{
+			max_size += LOG_VFS_BLOCK_MASK;
+			max_size &= ~LOG_VFS_BLOCK_MASK;
+		}
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	LLVFSFileSpecifier spec(file_id, file_type);
+	Entry* entry = NULL;
+	entry_map_t::iterator iter = mEntries.find(spec);
+	if (iter != mEntries.end())
+	{
+		entry = iter->second;
+		entry->mAccessTime = (U32)time(NULL);
+	}
+
+	if (entry && max_size == entry->mLength)
+	{
+		return TRUE;
+	}
+
+	if (entry && max_size < entry->mLength)
+	{
+		// this file is shrinking, the rest of the extent is dead
+		if (entry->mSize > max_size)
+		{
+			// JC: Was a warning, but Ian says it's bad.
+			LL_ERRS() << "Truncating virtual file " << file_id << " to " << max_size << " bytes" << LL_ENDL;
+			entry->mSize = max_size;
+		}
+		mLiveBytes -= entry->mLength - max_size;
+		entry->mLength = max_size;
+		appendRecord(entry);
+		requestCompaction();
+		return TRUE;
+	}
+
+	// this file is new or growing
+	S32 old_length = entry ? entry->mLength : 0;
+	if ((mMaxSize > 0 && max_size > mMaxSize) || !makeRoom(max_size - old_length, entry))
+	{
+		LL_WARNS() << "VFS: No space (" << max_size << ") for vfile " << file_id << LL_ENDL;
+		return FALSE;
+	}
+
+	if (entry && entry->mLocation + entry->mLength == mTail)
+	{
+		// last extent in the data file, grow it in place
+		mTail += max_size - old_length;
+	}
+	else
+	{
+		S64 location = mTail;
+		mTail += max_size;
+		if (entry)
+		{
+			// move the file to the tail, the old extent is dead
+			if (entry->mSize > 0 && !copyData(mDataFP, entry->mLocation, mDataFP, location, entry->mSize))
+			{
+				LL_WARNS() << "VFS: Short copy moving vfile " << file_id << LL_ENDL;
+			}
+			entry->mLocation = location;
+			entry->mDirty = true;
+			requestCompaction();
+		}
+		else
+		{
+			entry = new Entry(spec, location, max_size, 0, (U32)time(NULL));
+			mEntries.insert(entry_map_t::value_type(spec, entry));
+		}
+	}
+
+	mLiveBytes += max_size - old_length;
+	entry->mLength = max_size;
+	appendRecord(entry);
+	return TRUE;
+}
+
+// The locks in LLVFS stay with the names, see LLVFile::rename()
+void LLLogVFS::renameFile(const LLUUID &file_id, const LLAssetType::EType file_type,
+						  const LLUUID &new_id, const LLAssetType::EType &new_type)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+	if (mReadOnly)
+	{
+		LL_ERRS() << "Attempt to write to read-only VFS" << LL_ENDL;
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	LLVFSFileSpecifier old_spec(file_id, file_type);
+	LLVFSFileSpecifier new_spec(new_id, new_type);
+	entry_map_t::iterator iter = mEntries.find(old_spec);
+	if (iter == mEntries.end())
+	{
+		LL_WARNS() << "VFS: Attempt to rename nonexistent vfile " << file_id << ":" << file_type << LL_ENDL;
+		return;
+	}
+	if (old_spec == new_spec)
+	{
+		return;
+	}
+
+	Entry* entry = iter->second;
+	mEntries.erase(iter);
+
+	entry_map_t::iterator dest = mEntries.find(new_spec);
+	if (dest != mEntries.end())
+	{
+		removeEntry(dest);
+	}
+
+	entry->mSpec = new_spec;
+	entry->mAccessTime = (U32)time(NULL);
+	mEntries.insert(entry_map_t::value_type(new_spec, entry));
+
+	appendRemoveRecord(old_spec);
+	appendRecord(entry);
+}
+
+void LLLogVFS::removeFile(const LLUUID &file_id, const LLAssetType::EType file_type)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+	if (mReadOnly)
+	{
+		LL_ERRS() << "Attempt to write to read-only VFS" << LL_ENDL;
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	entry_map_t::iterator iter = mEntries.find(LLVFSFileSpecifier(file_id, file_type));
+	if (iter != mEntries.end())
+	{
+		removeEntry(iter);
+		requestCompaction();
+	}
+	else
+	{
+		LL_WARNS() << "VFS: attempting to remove nonexistent file " << file_id << " type " << file_type << LL_ENDL;
+	}
+}
+
+S32 LLLogVFS::getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+	llassert(location >= 0);
+	llassert(length >= 0);
+
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	entry_map_t::iterator iter = mEntries.find(LLVFSFileSpecifier(file_id, file_type));
+	if (iter == mEntries.end())
+	{
+		return 0;
+	}
+
+	Entry* entry = iter->second;
+	entry->mAccessTime = (U32)time(NULL);
+
+	S32 size = entry->mSize;
+	if (location > size)
+	{
+		LL_WARNS() << "VFS: Attempt to read location " << location << " in file " << file_id << " of length " << size << LL_ENDL;
+		return 0;
+	}
+
+	length = llmin(length, size - location);
+	return read_at(mDataFP, buffer, length, entry->mLocation + location);
+}
+
+S32 LLLogVFS::storeData(const LLUUID &file_id, const LLAssetType::EType file_type, const U8 *buffer, S32 location, S32 length)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+	if (mReadOnly)
+	{
+		LL_ERRS() << "Attempt to write to read-only VFS" << LL_ENDL;
+	}
+
+	llassert(length > 0);
+
+	// Appends need the size to stay put until they're written
+	std::shared_lock<std::shared_timed_mutex> shared_lock(mIndexLock, std::defer_lock);
+	std::unique_lock<std::shared_timed_mutex> unique_lock(mIndexLock, std::defer_lock);
+	if (location == -1)
+	{
+		unique_lock.lock();
+	}
+	else
+	{
+		shared_lock.lock();
+	}
+
+	entry_map_t::iterator iter = mEntries.find(LLVFSFileSpecifier(file_id, file_type));
+	if (iter == mEntries.end())
+	{
+		return 0;
+	}
+
+	Entry* entry = iter->second;
+	entry->mAccessTime = (U32)time(NULL);
+
+	S32 in_loc = location;
+	if (location == -1)
+	{
+		location = entry->mSize;
+	}
+	llassert(location >= 0);
+
+	if (location > entry->mLength)
+	{
+		LL_WARNS() << "VFS: Attempt to write to location " << location
+				<< " in file " << file_id
+				<< " type " << S32(file_type)
+				<< " of size " << entry->mSize
+				<< " block length " << entry->mLength
+				<< " (requested " << in_loc << ")"
+				<< LL_ENDL;
+		return length;
+	}
+
+	if (length > entry->mLength - location)
+	{
+		LL_WARNS() << "VFS: Truncating write to virtual file " << file_id << " type " << S32(file_type) << LL_ENDL;
+		length = entry->mLength - location;
+	}
+
+	S32 write_len = write_at(mDataFP, buffer, length, entry->mLocation + location);
+	if (write_len != length)
+	{
+		LL_WARNS() << llformat("VFS Write Error: %d != %d", write_len, length) << LL_ENDL;
+	}
+	entry->mDirty = true;
+
+	S32 new_size = location + write_len;
+	S32 old_size = entry->mSize;
+	while (new_size > old_size && !entry->mSize.compare_exchange_weak(old_size, new_size))
+	{
+	}
+	if (new_size > old_size)
+	{
+		appendRecord(entry);
+	}
+
+	return write_len;
+}
+
+void LLLogVFS::pokeFiles()
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	U32 word;
+	if (!mReadOnly && read_at(mDataFP, (U8*)&word, sizeof(word), 0) == sizeof(word))
+	{
+		if (write_at(mDataFP, (const U8*)&word, sizeof(word), 0) != sizeof(word))
+		{
+			LL_WARNS() << "Could not write to data file" << LL_ENDL;
+		}
+	}
+}
+
+// Check the in-memory index against the index file and the extents against each other.
+// Very slow, do not call routinely.
+void LLLogVFS::audit()
+{
+	std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	record_map_t records;
+	U32 num_records = 0;
+	S64 good_length = 0;
+	bool vfs_corrupt = !readIndex(records, num_records, good_length);
+
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		const Entry* entry = iter->second;
+		record_map_t::iterator found = records.find(iter->first);
+		if (found == records.end())
+		{
+			LL_WARNS("VFS") << "VFile " << entry->mSpec.mFileID << ":" << entry->mSpec.mFileType << " in memory, not in index" << LL_ENDL;
+			vfs_corrupt = true;
+		}
+		else
+		{
+			if (found->second.mLocation != entry->mLocation
+				|| found->second.mLength != entry->mLength
+				|| found->second.mSize != entry->mSize)
+			{
+				LL_WARNS("VFS") << "VFile " << entry->mSpec.mFileID << ":" << entry->mSpec.mFileType << " index mismatch, memory "
+								<< entry->mLocation << ":" << entry->mLength << ":" << entry->mSize << " index "
+								<< found->second.mLocation << ":" << found->second.mLength << ":" << found->second.mSize << LL_ENDL;
+				vfs_corrupt = true;
+			}
+			records.erase(found);
+		}
+	}
+
+	for (record_map_t::iterator iter = records.begin(); iter != records.end(); ++iter)
+	{
+		LL_WARNS("VFS") << "VFile " << iter->first.mFileID << ":" << iter->first.mFileType << " in index, not in memory" << LL_ENDL;
+		vfs_corrupt = true;
+	}
+
+	vfs_corrupt = !checkExtents() || vfs_corrupt;
+
+	if (vfs_corrupt)
+	{
+		LL_WARNS("VFS") << "VFS corruption: index and memory disagree" << LL_ENDL;
+	}
+	else
+	{
+		LL_INFOS("VFS") << "Index file matches memory, " << num_records << " records for " << mEntries.size() << " files" << LL_ENDL;
+	}
+}
+
+void LLLogVFS::checkMem()
+{
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+	if (checkExtents())
+	{
+		LL_INFOS("VFS") << "VFS extents OK" << LL_ENDL;
+	}
+}
+
+void LLLogVFS::dumpMap()
+{
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	LL_INFOS() << "Files:" << LL_ENDL;
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		const Entry* entry = iter->second;
+		LL_INFOS() << "Location: " << entry->mLocation << "\tLength: " << entry->mLength << "\t" << entry->mSpec.mFileID << "\t" << entry->mSpec.mFileType << LL_ENDL;
+	}
+	LL_INFOS() << "Tail: " << mTail << "\tDead: " << mTail - mLiveBytes << LL_ENDL;
+}
+
+void LLLogVFS::dumpStatistics()
+{
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	std::map<LLAssetType::EType, std::pair<S32, S64> > filetype_counts;
+	S64 total_file_size = 0;
+	S32 max_file_size = 0;
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		const Entry* entry = iter->second;
+		S32 size = entry->mSize;
+		std::pair<S32, S64>& counts = filetype_counts[entry->mSpec.mFileType];
+		counts.first++;
+		counts.second += size;
+		total_file_size += size;
+		max_file_size = llmax(max_file_size, size);
+	}
+
+	for (std::map<LLAssetType::EType, std::pair<S32, S64> >::iterator iter = filetype_counts.begin();
+		 iter != filetype_counts.end(); ++iter)
+	{
+		LL_INFOS() << "Type: " << LLAssetType::getDesc(iter->first)
+				<< " Count: " << iter->second.first
+				<< " Bytes: " << (iter->second.second >> 20) << " MB" << LL_ENDL;
+	}
+
+	LL_INFOS() << "Total files: " << mEntries.size() << LL_ENDL;
+	LL_INFOS() << "Max file size: " << max_file_size / 1024 << "K" << LL_ENDL;
+	LL_INFOS() << "Total file size: " << (total_file_size >> 20) << " MB" << LL_ENDL;
+	LL_INFOS() << "Reserved: " << (mLiveBytes >> 20) << " MB, data file: " << (mTail >> 20)
+			<< " MB, dead: " << ((mTail - mLiveBytes) >> 20) << " MB, index records: " << mIndexRecords << LL_ENDL;
+}
+
+void LLLogVFS::listFiles()
+{
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		const Entry* entry = iter->second;
+		if (entry->mSize > 0)
+		{
+			LL_INFOS() << " File: " << entry->mSpec.mFileID
+					<< " Type: " << LLAssetType::getDesc(entry->mSpec.mFileType)
+					<< " Size: " << entry->mSize
+					<< LL_ENDL;
+		}
+	}
+}
+
+void LLLogVFS::dumpFiles()
+{
+	std::vector<LLVFSFileSpecifier> specs;
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+		for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		{
+			specs.push_back(iter->first);
+		}
+	}
+
+	S32 files_extracted = 0;
+	for (std::vector<LLVFSFileSpecifier>::iterator iter = specs.begin(); iter != specs.end(); ++iter)
+	{
+		S32 size = getSize(iter->mFileID, iter->mFileType);
+		if (size > 0)
+		{
+			std::vector<U8> buffer(size);
+			size = getData(iter->mFileID, iter->mFileType, &buffer[0], 0, size);
+
+			std::string filename = iter->mFileID.asString() + "." + LLAssetType::lookup(iter->mFileType);
+			LL_INFOS() << " Writing " << filename << LL_ENDL;
+
+			LLAPRFile outfile;
+			outfile.open(filename, LL_APR_WB);
+			outfile.write(&buffer[0], size);
+			outfile.close();
+
+			files_extracted++;
+		}
+	}
+
+	LL_INFOS() << "Extracted " << files_extracted << " files out of " << specs.size() << LL_ENDL;
+}
+
+bool LLLogVFS::compact(bool force)
+{
+	if (!isValid() || mReadOnly)
+	{
+		return false;
+	}
+
+	LLTimer timer;
+
+	struct Extent
+	{
+		LLVFSFileSpecifier mSpec;
+		S64 mLocation;
+		S32 mLength;
+		S32 mSize;
+		S64 mNewLocation;
+
+		bool operator<(const Extent& rhs) const { return mLocation < rhs.mLocation; }
+	};
+	std::vector<Extent> extents;
+	S64 old_size;
+
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+		old_size = mTail;
+		if (mCompacting || (!force && mTail - mLiveBytes < llmax(LOG_VFS_MIN_COMPACT_BYTES, mMaxSize / 4)))
+		{
+			return false;
+		}
+		mCompacting = true;
+
+		extents.reserve(mEntries.size());
+		for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		{
+			Entry* entry = iter->second;
+			entry->mDirty = false;
+			Extent extent = { entry->mSpec, entry->mLocation, entry->mLength, entry->mSize, 0 };
+			extents.push_back(extent);
+		}
+	}
+
+	std::string temp_filename = mDataFilename + ".compact";
+	LLFILE* new_fp = openAndLock(temp_filename, "w+b", FALSE);
+	bool success = (new_fp != NULL);
+
+	// Copy everything with no lock held.  Extents are never reused until
+	// the data file is replaced, so the worst a concurrent write can do is
+	// leave a stale copy, and those files are marked dirty.
+	std::sort(extents.begin(), extents.end());
+	S64 new_tail = 0;
+	for (std::vector<Extent>::iterator iter = extents.begin(); success && iter != extents.end(); ++iter)
+	{
+		iter->mNewLocation = new_tail;
+		new_tail += iter->mLength;
+		success = !mShuttingDown && copyData(mDataFP, iter->mLocation, new_fp, iter->mNewLocation, iter->mSize);
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(mIndexLock);
+
+	// Catch up with what changed during the copy
+	struct Move
+	{
+		Entry* mEntry;
+		S64 mOldLocation;
+		S64 mNewLocation;
+	};
+	std::vector<Move> moves;
+	if (success)
+	{
+		std::map<LLVFSFileSpecifier, const Extent*> copied;
+		for (std::vector<Extent>::iterator iter = extents.begin(); iter != extents.end(); ++iter)
+		{
+			copied[iter->mSpec] = &(*iter);
+		}
+
+		moves.reserve(mEntries.size());
+		for (entry_map_t::iterator iter = mEntries.begin(); success && iter != mEntries.end(); ++iter)
+		{
+			Entry* entry = iter->second;
+			std::map<LLVFSFileSpecifier, const Extent*>::iterator found = copied.find(iter->first);
+			if (found != copied.end()
+				&& found->second->mLocation == entry->mLocation
+				&& found->second->mLength == entry->mLength)
+			{
+				// Same extent, copy it again if it was written to
+				if (entry->mDirty)
+				{
+					success = copyData(mDataFP, entry->mLocation, new_fp, found->second->mNewLocation, entry->mSize);
+				}
+				Move move = { entry, entry->mLocation, found->second->mNewLocation };
+				moves.push_back(move);
+			}
+			else
+			{
+				// Created, resized or renamed since the snapshot
+				success = copyData(mDataFP, entry->mLocation, new_fp, new_tail, entry->mSize);
+				Move move = { entry, entry->mLocation, new_tail };
+				moves.push_back(move);
+				new_tail += entry->mLength;
+			}
+		}
+	}
+
+	unlockAndClose(new_fp);
+	new_fp = NULL;
+
+	// The index of the new data file goes next to it, the old pair stays
+	// untouched until both are complete
+	if (success)
+	{
+		for (std::vector<Move>::iterator iter = moves.begin(); iter != moves.end(); ++iter)
+		{
+			iter->mEntry->mLocation = iter->mNewLocation;
+		}
+		success = writeIndexFile(mIndexFilename + ".compact");
+		if (!success)
+		{
+			for (std::vector<Move>::iterator iter = moves.begin(); iter != moves.end(); ++iter)
+			{
+				iter->mEntry->mLocation = iter->mOldLocation;
+			}
+		}
+	}
+
+	if (!success)
+	{
+		if (!mShuttingDown)
+		{
+			LL_WARNS("VFS") << "VFS compaction of " << mDataFilename << " failed" << LL_ENDL;
+		}
+		LLFile::remove(temp_filename);
+		mCompacting = false;
+		return false;
+	}
+
+	for (std::vector<Move>::iterator iter = moves.begin(); iter != moves.end(); ++iter)
+	{
+		iter->mEntry->mDirty = false;
+	}
+	mTail = new_tail;
+
+	// Swap both files.  Windows won't rename over an open file, so close them first.
+	{
+		LLMutexLock index_lock(mIndexFileMutex);
+		unlockAndClose(mIndexFP);
+		mIndexFP = NULL;
+		unlockAndClose(mDataFP);
+		mDataFP = NULL;
+		if (finishCompaction())
+		{
+			mDataFP = openAndLock(mDataFilename, "r+b", FALSE);
+			mIndexFP = openAndLock(mIndexFilename, "r+b", FALSE);
+		}
+		if (mIndexFP)
+		{
+			fseek(mIndexFP, 0, SEEK_END);
+		}
+		mIndexRecords = mEntries.size();
+	}
+
+	if (!mDataFP || !mIndexFP)
+	{
+		// Whatever is on disk is a consistent pair, or a complete compacted
+		// one the next startup moves into place.  Nothing in memory can be
+		// trusted to match it any more.
+		LL_WARNS("VFS") << "Couldn't reopen " << mDataFilename << " after compaction, VFS unusable until restart" << LL_ENDL;
+		mValid = VFSVALID_BAD_CORRUPT;
+		mCompacting = false;
+		return false;
+	}
+	mCompacting = false;
+
+	LL_INFOS("VFS") << "Compacted " << mDataFilename << " from " << (old_size >> 20) << " MB to " << (mTail >> 20)
+					<< " MB in " << timer.getElapsedTimeF32() << " seconds" << LL_ENDL;
+	return true;
+}
+
+S64 LLLogVFS::getLiveBytes()
+{
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+	return mLiveBytes;
+}
+
+S64 LLLogVFS::getDataFileSize()
+{
+	std::shared_lock<std::shared_timed_mutex> lock(mIndexLock);
+	return mTail;
+}
+
+//============================================================================
+// private
+//============================================================================
+
+bool LLLogVFS::loadIndex()
+{
+	mIndexFP = openAndLock(mIndexFilename, mReadOnly ? "rb" : "r+b", mReadOnly);
+	if (!mIndexFP)
+	{
+		return false;
+	}
+
+	record_map_t records;
+	U32 num_records = 0;
+	S64 good_length = 0;
+	if (!readIndex(records, num_records, good_length))
+	{
+		unlockAndClose(mIndexFP);
+		mIndexFP = NULL;
+		return false;
+	}
+
+	S64 data_size = file_size(mDataFP);
+	mTail = data_size;
+	for (record_map_t::iterator iter = records.begin(); iter != records.end(); ++iter)
+	{
+		const Record& record = iter->second;
+
+		// The end of an extent may never have been written, the data has to be there
+		if (record.mLocation < 0 || record.mLength <= 0
+			|| record.mSize < 0 || record.mSize > record.mLength
+			|| record.mLocation + record.mSize > data_size)
+		{
+			LL_WARNS("VFS") << "Dropping bad vfile " << iter->first.mFileID << ":" << iter->first.mFileType
+							<< " at " << record.mLocation << ", " << record.mSize << " of " << record.mLength
+							<< " bytes, data file " << data_size << LL_ENDL;
+			continue;
+		}
+
+		Entry* entry = new Entry(iter->first, record.mLocation, record.mLength, record.mSize, record.mAccessTime);
+		mEntries.insert(entry_map_t::value_type(iter->first, entry));
+		mLiveBytes += record.mLength;
+		mTail = llmax(mTail, record.mLocation + record.mLength);
+	}
+
+	if (!checkExtents())
+	{
+		// Overlapping extents, nothing can be trusted
+		for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+		{
+			delete iter->second;
+		}
+		mEntries.clear();
+		mLiveBytes = 0;
+		unlockAndClose(mIndexFP);
+		mIndexFP = NULL;
+		return false;
+	}
+
+	mIndexRecords = num_records;
+	if (!mReadOnly)
+	{
+		if (good_length < file_size(mIndexFP) || mIndexRecords > 2 * mEntries.size() + LOG_VFS_MIN_INDEX_REWRITE)
+		{
+			// Torn or mostly dead records, start a fresh log
+			writeIndex();
+		}
+		else
+		{
+			fseek(mIndexFP, 0, SEEK_END);
+		}
+	}
+	return true;
+}
+
+bool LLLogVFS::readIndex(record_map_t& records, U32& num_records, S64& good_length)
+{
+	LLMutexLock lock(mIndexFileMutex);
+
+	if (!mIndexFP)
+	{
+		return false;
+	}
+
+	fflush(mIndexFP);
+	S64 index_size = file_size(mIndexFP);
+	if (index_size < (S64)sizeof(LLLogVFSIndexHeader))
+	{
+		return false;
+	}
+
+	std::vector<U8> buffer(index_size);
+	fseek(mIndexFP, 0, SEEK_SET);
+	size_t nread = fread(&buffer[0], 1, index_size, mIndexFP);
+	fseek(mIndexFP, 0, SEEK_END);
+
+	LLLogVFSIndexHeader header;
+	memcpy(&header, &buffer[0], sizeof(header));
+	if (nread < sizeof(header) || header.mMagic != LOG_VFS_INDEX_MAGIC || header.mVersion != LOG_VFS_INDEX_VERSION)
+	{
+		LL_WARNS("VFS") << "Bad header in VFS index " << mIndexFilename << LL_ENDL;
+		return false;
+	}
+
+	size_t offset = sizeof(header);
+	num_records = 0;
+	while (offset + sizeof(Record) <= nread)
+	{
+		Record record;
+		memcpy(&record, &buffer[offset], sizeof(record));
+		if (record.mCRC != record_crc(&record, sizeof(record)))
+		{
+			// Torn write at a crash, drop the rest
+			LL_WARNS("VFS") << "Bad record " << num_records << " in VFS index " << mIndexFilename << ", ignoring the rest" << LL_ENDL;
+			break;
+		}
+
+		LLUUID id;
+		memcpy(id.mData, record.mFileID, UUID_BYTES);
+		LLVFSFileSpecifier spec(id, (LLAssetType::EType)record.mFileType);
+		if (record.mLength > 0)
+		{
+			records[spec] = record;
+		}
+		else
+		{
+			records.erase(spec);
+		}
+
+		offset += sizeof(record);
+		num_records++;
+	}
+	good_length = offset;
+	return true;
+}
+
+bool LLLogVFS::writeIndex()
+{
+	LLMutexLock lock(mIndexFileMutex);
+
+	// Windows won't rename over an open file
+	unlockAndClose(mIndexFP);
+	mIndexFP = NULL;
+	bool success = writeIndexFile(mIndexFilename);
+
+	mIndexFP = openAndLock(mIndexFilename, "r+b", FALSE);
+	if (mIndexFP)
+	{
+		fseek(mIndexFP, 0, SEEK_END);
+	}
+	mIndexRecords = success ? mEntries.size() : mIndexRecords;
+	return success && mIndexFP;
+}
+
+// Snapshot of mEntries, written beside filename and renamed over it once complete
+bool LLLogVFS::writeIndexFile(const std::string& filename)
+{
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");	/* Flawfinder: ignore */
+	if (!fp)
+	{
+		LL_WARNS("VFS") << "Couldn't write VFS index " << temp_filename << LL_ENDL;
+		return false;
+	}
+
+	LLLogVFSIndexHeader header;
+	header.mMagic = LOG_VFS_INDEX_MAGIC;
+	header.mVersion = LOG_VFS_INDEX_VERSION;
+	header.mCreationTime = (U32)time(NULL);
+	header.mPad = 0;
+
+	std::vector<Record> records(mEntries.size());
+	std::vector<Record>::iterator record = records.begin();
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter, ++record)
+	{
+		const Entry* entry = iter->second;
+		memset(&(*record), 0, sizeof(Record));
+		memcpy(record->mFileID, entry->mSpec.mFileID.mData, UUID_BYTES);
+		record->mFileType = entry->mSpec.mFileType;
+		record->mSize = entry->mSize;
+		record->mLength = entry->mLength;
+		record->mAccessTime = entry->mAccessTime;
+		record->mLocation = entry->mLocation;
+		record->mCRC = record_crc(&(*record), sizeof(Record));
+	}
+
+	bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+	if (success && !records.empty())
+	{
+		success = fwrite(&records[0], sizeof(Record), records.size(), fp) == records.size();
+	}
+	success = (fclose(fp) == 0) && success;
+
+	if (success)
+	{
+		LLFile::remove(filename, ENOENT);
+		success = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!success)
+	{
+		LL_WARNS("VFS") << "Couldn't replace VFS index " << filename << LL_ENDL;
+		LLFile::remove(temp_filename);
+	}
+	return success;
+}
+
+// Move a compacted data file and its index over the old pair.  The index is
+// written last by compact() and moved last here, so while it exists the
+// compacted data is complete, either beside it or already in place, and
+// this can be repeated after a crash part way through.  The caller closes
+// both files first.
+bool LLLogVFS::finishCompaction()
+{
+	std::string data_filename = mDataFilename + ".compact";
+	std::string index_filename = mIndexFilename + ".compact";
+
+	llstat file_info;
+	if (LLFile::stat(index_filename, &file_info))
+	{
+		// Nothing pending
+		return true;
+	}
+
+	if (!LLFile::stat(data_filename, &file_info))
+	{
+		LLFile::remove(mDataFilename, ENOENT);
+		if (LLFile::rename(data_filename, mDataFilename) != 0)
+		{
+			LL_WARNS("VFS") << "Couldn't move compacted vfs data file " << data_filename << " into place" << LL_ENDL;
+			return false;
+		}
+	}
+
+	LLFile::remove(mIndexFilename, ENOENT);
+	if (LLFile::rename(index_filename, mIndexFilename) != 0)
+	{
+		LL_WARNS("VFS") << "Couldn't move compacted vfs index " << index_filename << " into place" << LL_ENDL;
+		return false;
+	}
+	return true;
+}
+
+void LLLogVFS::appendRecord(const Entry* entry)
+{
+	LLMutexLock lock(mIndexFileMutex);
+
+	if (!mIndexFP)
+	{
+		return;
+	}
+
+	// Read the size under the mutex so the last record has the largest one
+	Record record;
+	memset(&record, 0, sizeof(record));
+	memcpy(record.mFileID, entry->mSpec.mFileID.mData, UUID_BYTES);
+	record.mFileType = entry->mSpec.mFileType;
+	record.mSize = entry->mSize;
+	record.mLength = entry->mLength;
+	record.mAccessTime = entry->mAccessTime;
+	record.mLocation = entry->mLocation;
+	record.mCRC = record_crc(&record, sizeof(record));
+
+	if (fwrite(&record, sizeof(record), 1, mIndexFP) != 1)
+	{
+		LL_WARNS("VFS") << "Short write to VFS index " << mIndexFilename << LL_ENDL;
+	}
+	mIndexRecords++;
+}
+
+void LLLogVFS::appendRemoveRecord(const LLVFSFileSpecifier& spec)
+{
+	LLMutexLock lock(mIndexFileMutex);
+
+	if (!mIndexFP)
+	{
+		return;
+	}
+
+	Record record;
+	memset(&record, 0, sizeof(record));
+	memcpy(record.mFileID, spec.mFileID.mData, UUID_BYTES);
+	record.mFileType = spec.mFileType;
+	record.mCRC = record_crc(&record, sizeof(record));
+
+	if (fwrite(&record, sizeof(record), 1, mIndexFP) != 1)
+	{
+		LL_WARNS("VFS") << "Short write to VFS index " << mIndexFilename << LL_ENDL;
+	}
+	mIndexRecords++;
+}
+
+// Remove least recently used, unlocked files until size more bytes fit
+bool LLLogVFS::makeRoom(S64 size, const Entry* immune)
+{
+	if (mMaxSize == 0 || mLiveBytes + size <= mMaxSize)
+	{
+		return true;
+	}
+
+	typedef std::pair<U32, LLVFSFileSpecifier> lru_pair_t;
+	std::vector<lru_pair_t> lru_list;
+	lru_list.reserve(mEntries.size());
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		const Entry* entry = iter->second;
+		if (entry != immune
+			&& !isLocked(entry->mSpec.mFileID, entry->mSpec.mFileType, VFSLOCK_READ)
+			&& !isLocked(entry->mSpec.mFileID, entry->mSpec.mFileType, VFSLOCK_APPEND)
+			&& !isLocked(entry->mSpec.mFileID, entry->mSpec.mFileType, VFSLOCK_OPEN))
+		{
+			lru_list.push_back(lru_pair_t(entry->mAccessTime, iter->first));
+		}
+	}
+	std::sort(lru_list.begin(), lru_list.end(), older_access);
+
+	for (std::vector<lru_pair_t>::iterator iter = lru_list.begin();
+		 iter != lru_list.end() && mLiveBytes + size > mMaxSize; ++iter)
+	{
+		LL_DEBUGS("VFS") << "LRU: Removing " << iter->second.mFileID << ":" << iter->second.mFileType << LL_ENDL;
+		removeEntry(mEntries.find(iter->second));
+	}
+
+	if (mLiveBytes + size > mMaxSize)
+	{
+		LL_WARNS() << "VFS: Can't make " << size << " bytes of free space in VFS, giving up" << LL_ENDL;
+		dumpLockCounts();
+		return false;
+	}
+
+	requestCompaction();
+	return true;
+}
+
+void LLLogVFS::removeEntry(entry_map_t::iterator iter)
+{
+	Entry* entry = iter->second;
+	mLiveBytes -= entry->mLength;
+	appendRemoveRecord(entry->mSpec);
+	mEntries.erase(iter);
+	delete entry;
+}
+
+bool LLLogVFS::copyData(LLFILE* src_fp, S64 src_location, LLFILE* dst_fp, S64 dst_location, S32 size)
+{
+	const S32 COPY_CHUNK_SIZE = 256 * 1024;
+	std::vector<U8> buffer(llmin(size, COPY_CHUNK_SIZE));
+	for (S32 copied = 0; copied < size; )
+	{
+		S32 chunk = llmin(size - copied, COPY_CHUNK_SIZE);
+		if (read_at(src_fp, &buffer[0], chunk, src_location + copied) != chunk
+			|| write_at(dst_fp, &buffer[0], chunk, dst_location + copied) != chunk)
+		{
+			return false;
+		}
+		copied += chunk;
+	}
+	return true;
+}
+
+// No two extents overlap and all are inside the data file
+bool LLLogVFS::checkExtents()
+{
+	typedef std::pair<S64, const Entry*> extent_t;
+	std::vector<extent_t> extents;
+	extents.reserve(mEntries.size());
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		extents.push_back(extent_t(iter->second->mLocation, iter->second));
+	}
+	std::sort(extents.begin(), extents.end());
+
+	bool success = true;
+	S64 end = 0;
+	for (std::vector<extent_t>::iterator iter = extents.begin(); iter != extents.end(); ++iter)
+	{
+		const Entry* entry = iter->second;
+		if (entry->mLocation < end || entry->mLocation + entry->mLength > mTail)
+		{
+			LL_WARNS("VFS") << "VFile " << entry->mSpec.mFileID << ":" << entry->mSpec.mFileType
+							<< " extent " << entry->mLocation << ":" << entry->mLength
+							<< " overlaps the previous one or the end of the data file" << LL_ENDL;
+			success = false;
+		}
+		end = llmax(end, entry->mLocation + entry->mLength);
+	}
+	return success;
+}
+
+void LLLogVFS::requestCompaction()
+{
+	if (mCompactThread && !mCompacting && mTail - mLiveBytes >= llmax(LOG_VFS_MIN_COMPACT_BYTES, mMaxSize / 4))
+	{
+		mCompactThread->request();
+	}
+}
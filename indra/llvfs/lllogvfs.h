@@ -0,0 +1,136 @@
+/** 
+ * @file lllogvfs.h
+ * @brief Log structured virtual file system backend
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLLOGVFS_H
+#define LL_LLLOGVFS_H
+
+#include <atomic>
+#include <shared_mutex>
+#include "llvfs.h"
+
+// Log structured backend behind the LLVFS interface used by LLVFile.
+//
+// Each file owns one extent of an append only data file.  Writes land in
+// place inside the extent; creating a file or growing one past its extent
+// appends a new extent at the tail, and the extents of removed, shrunk or
+// moved files are left as dead space.  Once enough of the data file is
+// dead a background thread copies the live extents into a fresh one.
+//
+// The index is held in memory behind a reader/writer lock and persisted as
+// a log of fixed size records, rewritten as a snapshot on compaction and
+// shutdown.  getData() and storeData() take the lock shared and use
+// positional I/O, so reads and writes of any number of files run at once.
+// Creating, resizing, renaming and removing files, appends (location -1)
+// and the last step of a compaction take it exclusive.
+//
+// File locks (incLock() and friends) are the ones in LLVFS.
+class LLLogVFS : public LLVFS
+{
+public:
+	// max_size caps the space reserved by live files, the least recently
+	// used ones are removed to make room.  Pass 0 for no cap.
+	static LLLogVFS* createLogVFS(const std::string& index_filename,
+			const std::string& data_filename,
+			const BOOL read_only,
+			const U32 max_size,
+			const BOOL remove_after_crash);
+
+	/*virtual*/ ~LLLogVFS();
+
+	/*virtual*/ BOOL getExists(const LLUUID &file_id, const LLAssetType::EType file_type);
+	/*virtual*/ S32	 getSize(const LLUUID &file_id, const LLAssetType::EType file_type);
+
+	/*virtual*/ BOOL checkAvailable(S32 max_size);
+
+	/*virtual*/ S32  getMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type);
+	/*virtual*/ BOOL setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type, S32 max_size);
+
+	/*virtual*/ void renameFile(const LLUUID &file_id, const LLAssetType::EType file_type,
+		const LLUUID &new_id, const LLAssetType::EType &new_type);
+	/*virtual*/ void removeFile(const LLUUID &file_id, const LLAssetType::EType file_type);
+
+	/*virtual*/ S32 getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length);
+	/*virtual*/ S32 storeData(const LLUUID &file_id, const LLAssetType::EType file_type, const U8 *buffer, S32 location, S32 length);
+
+	/*virtual*/ void pokeFiles();
+	/*virtual*/ void audit();
+	/*virtual*/ void checkMem();
+	/*virtual*/ void dumpMap();
+	/*virtual*/ void dumpStatistics();
+	/*virtual*/ void listFiles();
+	/*virtual*/ void dumpFiles();
+
+	// Copy the live extents into a new data file if enough of the current
+	// one is dead space, or always if force is set.  Normally run by the
+	// compaction thread.  Returns true if the data file was replaced.
+	bool compact(bool force = false);
+
+	S64 getLiveBytes();			// Space reserved by files
+	S64 getDataFileSize();		// Live and dead space
+
+private:
+	LLLogVFS(const std::string& index_filename,
+			const std::string& data_filename,
+			const BOOL read_only,
+			const U32 max_size,
+			const BOOL remove_after_crash);
+
+	class Entry;
+	class CompactThread;
+	struct Record;
+
+	typedef std::map<LLVFSFileSpecifier, Entry*> entry_map_t;
+	typedef std::map<LLVFSFileSpecifier, Record> record_map_t;
+
+	// mIndexLock must be held for all of these
+	bool loadIndex();
+	bool readIndex(record_map_t& records, U32& num_records, S64& good_length);
+	bool writeIndex();
+	bool writeIndexFile(const std::string& filename);
+	bool finishCompaction();
+	void appendRecord(const Entry* entry);
+	void appendRemoveRecord(const LLVFSFileSpecifier& spec);
+	bool makeRoom(S64 size, const Entry* immune);
+	void removeEntry(entry_map_t::iterator iter);
+	bool copyData(LLFILE* src_fp, S64 src_location, LLFILE* dst_fp, S64 dst_location, S32 size);
+	bool checkExtents();
+	void requestCompaction();
+
+	entry_map_t mEntries;
+	std::shared_timed_mutex mIndexLock;
+	LLMutex* mIndexFileMutex;		// Appends to mIndexFP, taken after mIndexLock
+
+	S64 mTail;				// End of the last extent in the data file
+	S64 mLiveBytes;			// Sum of the extent lengths
+	S64 mMaxSize;
+	U32 mIndexRecords;		// Records in the index file, live or not
+
+	bool mCompacting;
+	std::atomic<bool> mShuttingDown;
+	CompactThread* mCompactThread;
+};
+
+#endif
@@ -0,0 +1,170 @@
+/** 
+ * @file llmappedfile.cpp
+ * @brief Read-only memory mapping of a whole file
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmappedfile.h"
+
+#if LL_WINDOWS
+#include "llstring.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LLMappedFile::LLMappedFile()
+	: mData(NULL),
+	  mSize(0)
+#if LL_WINDOWS
+	  , mFile(INVALID_HANDLE_VALUE),
+	  mMapping(NULL)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+	close();
+}
+
+//static
+bool LLMappedFile::replace(const std::string& from, const std::string& to)
+{
+#if LL_WINDOWS
+	llutf16string utf16from = utf8str_to_utf16str(from);
+	llutf16string utf16to = utf8str_to_utf16str(to);
+	if (MoveFileExW((LPCWSTR)utf16from.c_str(), (LPCWSTR)utf16to.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		return true;
+	}
+
+	// A mapping keeps the target from being replaced or deleted, not from
+	// being moved aside: the mapping goes with it
+	llutf16string utf16aside = utf8str_to_utf16str(to + ".old");
+	DeleteFileW((LPCWSTR)utf16aside.c_str());
+	if (!MoveFileExW((LPCWSTR)utf16to.c_str(), (LPCWSTR)utf16aside.c_str(), 0))
+	{
+		return false;
+	}
+	if (!MoveFileExW((LPCWSTR)utf16from.c_str(), (LPCWSTR)utf16to.c_str(), 0))
+	{
+		MoveFileExW((LPCWSTR)utf16aside.c_str(), (LPCWSTR)utf16to.c_str(), 0);
+		return false;
+	}
+	// Fails while it is still mapped, the next replace() tries again
+	DeleteFileW((LPCWSTR)utf16aside.c_str());
+	return true;
+#else
+	return ::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool LLMappedFile::open(const std::string& filename)
+{
+	close();
+#if LL_WINDOWS
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	mFile = CreateFileW((LPCWSTR)utf16filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+						NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		return false;
+	}
+	mMapping = CreateFileMappingW(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mMapping)
+	{
+		return false;
+	}
+	mData = (const U8*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	mSize = mData ? size.QuadPart : 0;
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			mData = (const U8*)data;
+			mSize = st.st_size;
+		}
+	}
+	::close(fd);
+#endif
+	return mData != NULL;
+}
+
+void LLMappedFile::willNeed(U64 offset, U64 size) const
+{
+#if !LL_WINDOWS
+	if (!mData || offset >= mSize)
+	{
+		return;
+	}
+	// madvise() wants a page aligned start
+	U64 page_size = sysconf(_SC_PAGESIZE);
+	U64 start = offset - offset % page_size;
+	madvise((void*)(mData + start), llmin(offset + size, mSize) - start, MADV_WILLNEED);
+#endif
+}
+
+void LLMappedFile::close()
+{
+#if LL_WINDOWS
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mData)
+	{
+		munmap((void*)mData, mSize);
+	}
+#endif
+	mData = NULL;
+	mSize = 0;
+}
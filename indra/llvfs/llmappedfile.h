@@ -0,0 +1,74 @@
+/** 
+ * @file llmappedfile.h
+ * @brief Read-only memory mapping of a whole file
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#endif
+
+// Read-only mapping of a whole file.
+//
+// The mapping keeps showing the contents of the file that was opened.
+// Writers may grow a mapped file, but Windows refuses to rename over or
+// remove it while it is mapped, so files that may be mapped are swapped
+// for a new version with replace().
+class LLMappedFile
+{
+public:
+	LLMappedFile();
+	~LLMappedFile();
+
+	// Rename from over to, even while to is mapped.  On Windows a mapped to
+	// is moved aside to <to>.old first, and left there until a later
+	// replace() of the same file finds it unmapped.
+	static bool replace(const std::string& from, const std::string& to);
+
+	// Returns false for missing or empty files
+	bool open(const std::string& filename);
+	void close();
+
+	// Hint that a range is about to be read, so that it is paged in with
+	// one large read rather than one fault per page
+	void willNeed(U64 offset, U64 size) const;
+
+	const U8* getData() const	{ return mData; }
+	U64 getSize() const			{ return mSize; }
+
+private:
+	LLMappedFile(const LLMappedFile&);
+	LLMappedFile& operator=(const LLMappedFile&);
+
+	const U8* mData;
+	U64 mSize;
+#if LL_WINDOWS
+	HANDLE mFile;
+	HANDLE mMapping;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
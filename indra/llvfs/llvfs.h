@@ -79,8 +79,11 @@ private:
 			const BOOL read_only, 
 			const U32 presize, 
 			const BOOL remove_after_crash);
+protected:
+	// For other backends (see LLLogVFS), leaves this one empty and invalid
+	LLVFS();
 public:
-	~LLVFS();
+	virtual ~LLVFS();
 
 	// Use this function normally to create LLVFS files
 	// Pass 0 to not presize
@@ -94,20 +97,20 @@ public:
 	EVFSValid getValidState() const	{ return mValid; }
 
 	// ---------- The following fucntions lock/unlock mDataMutex ----------
-	BOOL getExists(const LLUUID &file_id, const LLAssetType::EType file_type);
-	S32	 getSize(const LLUUID &file_id, const LLAssetType::EType file_type);
+	virtual BOOL getExists(const LLUUID &file_id, const LLAssetType::EType file_type);
+	virtual S32	 getSize(const LLUUID &file_id, const LLAssetType::EType file_type);
 
-	BOOL checkAvailable(S32 max_size);
+	virtual BOOL checkAvailable(S32 max_size);
 	
-	S32  getMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type);
-	BOOL setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type, S32 max_size);
+	virtual S32  getMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type);
+	virtual BOOL setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type, S32 max_size);
 
-	void renameFile(const LLUUID &file_id, const LLAssetType::EType file_type,
+	virtual void renameFile(const LLUUID &file_id, const LLAssetType::EType file_type,
 		const LLUUID &new_id, const LLAssetType::EType &new_type);
-	void removeFile(const LLUUID &file_id, const LLAssetType::EType file_type);
+	virtual void removeFile(const LLUUID &file_id, const LLAssetType::EType file_type);
 
-	S32 getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length);
-	S32 storeData(const LLUUID &file_id, const LLAssetType::EType file_type, const U8 *buffer, S32 location, S32 length);
+	virtual S32 getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length);
+	virtual S32 storeData(const LLUUID &file_id, const LLAssetType::EType file_type, const U8 *buffer, S32 location, S32 length);
 
 	void incLock(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock);
 	void decLock(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock);
@@ -115,19 +118,19 @@ public:
 	// ----------------------------------------------------------------
 
 	// Used to trigger evil WinXP behavior of "preloading" entire file into memory.
-	void pokeFiles();
+	virtual void pokeFiles();
 
 	// Verify that the index file contents match the in-memory file structure
 	// Very slow, do not call routinely. JC
-	void audit();
+	virtual void audit();
 	// Check for uninitialized blocks.  Slow, do not call in release. JC
-	void checkMem();
+	virtual void checkMem();
 	// for debugging, prints a map of the vfs
-	void dumpMap();
+	virtual void dumpMap();
 	void dumpLockCounts();
-	void dumpStatistics();
-	void listFiles();
-	void dumpFiles();
+	virtual void dumpStatistics();
+	virtual void listFiles();
+	virtual void dumpFiles();
 	time_t creationTime();
 
 protected:
@@ -0,0 +1,353 @@
+/**
+ * @file lllogvfs_test.cpp
+ * @date 2026-10
+ * @brief LLLogVFS test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+#include "../lllogvfs.h"
+#include "lltimer.h"
+
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	// Fill a buffer with bytes derived from the file and offset, so any
+	// misplaced read shows up
+	void fill_pattern(std::vector<U8>& buffer, const LLUUID& id, S32 offset)
+	{
+		for (size_t i = 0; i < buffer.size(); ++i)
+		{
+			buffer[i] = (U8)(id.mData[(offset + i) % UUID_BYTES] + offset + i);
+		}
+	}
+
+	bool check_pattern(const std::vector<U8>& buffer, const LLUUID& id, S32 offset)
+	{
+		std::vector<U8> expected(buffer.size());
+		fill_pattern(expected, id, offset);
+		return expected == buffer;
+	}
+}
+
+namespace tut
+{
+	struct LLLogVFSFixture
+	{
+		LLLogVFSFixture()
+		{
+			std::string base = std::string(LLFile::tmpdir()) + "lllogvfs_test";
+			mIndexFilename = base + "_index.db2";
+			mDataFilename = base + "_data.db2";
+			removeFiles();
+		}
+
+		~LLLogVFSFixture()
+		{
+			removeFiles();
+		}
+
+		void removeFiles()
+		{
+			LLFile::remove(mIndexFilename, ENOENT);
+			LLFile::remove(mDataFilename, ENOENT);
+			LLFile::remove(mIndexFilename + ".compact", ENOENT);
+			LLFile::remove(mDataFilename + ".compact", ENOENT);
+		}
+
+		void copyFile(const std::string& from, const std::string& to)
+		{
+			std::ifstream in(from.c_str(), std::ios::binary);
+			std::ofstream out(to.c_str(), std::ios::binary);
+			out << in.rdbuf();
+		}
+
+		LLLogVFS* open(U32 max_size = 0)
+		{
+			return LLLogVFS::createLogVFS(mIndexFilename, mDataFilename, FALSE, max_size, FALSE);
+		}
+
+		// Create a file of size bytes in one setMaxSize() and storeData()
+		void store(LLLogVFS* vfs, const LLUUID& id, S32 size)
+		{
+			ensure("reserve", vfs->setMaxSize(id, LLAssetType::AT_MESH, size));
+			std::vector<U8> buffer(size);
+			fill_pattern(buffer, id, 0);
+			ensure_equals("store", vfs->storeData(id, LLAssetType::AT_MESH, &buffer[0], 0, size), size);
+		}
+
+		bool matches(LLLogVFS* vfs, const LLUUID& id, S32 size)
+		{
+			std::vector<U8> buffer(size);
+			return vfs->getSize(id, LLAssetType::AT_MESH) == size
+				&& vfs->getData(id, LLAssetType::AT_MESH, &buffer[0], 0, size) == size
+				&& check_pattern(buffer, id, 0);
+		}
+
+		std::string mIndexFilename;
+		std::string mDataFilename;
+	};
+	typedef test_group<LLLogVFSFixture> LLLogVFSTest_factory;
+	typedef LLLogVFSTest_factory::object LLLogVFSTest_t;
+	LLLogVFSTest_factory tf("LLLogVFS");
+
+	// Files read back, survive a restart and follow renames and removes
+	template<> template<>
+	void LLLogVFSTest_t::test<1>()
+	{
+		LLUUID a, b, c;
+		a.generate();
+		b.generate();
+		c.generate();
+
+		LLLogVFS* vfs = open();
+		ensure("created", vfs != NULL);
+		store(vfs, a, 5000);
+		store(vfs, b, 20000);
+		store(vfs, c, 300);
+		ensure("a", matches(vfs, a, 5000));
+		ensure("b", matches(vfs, b, 20000));
+
+		vfs->renameFile(c, LLAssetType::AT_MESH, a, LLAssetType::AT_MESH);
+		vfs->removeFile(b, LLAssetType::AT_MESH);
+		ensure("renamed over", !vfs->getExists(c, LLAssetType::AT_MESH));
+		ensure("removed", !vfs->getExists(b, LLAssetType::AT_MESH));
+		delete vfs;
+
+		vfs = open();
+		ensure("reopened", vfs != NULL);
+		ensure_equals("renamed size", vfs->getSize(a, LLAssetType::AT_MESH), 300);
+		std::vector<U8> buffer(300);
+		ensure_equals("renamed read", vfs->getData(a, LLAssetType::AT_MESH, &buffer[0], 0, 300), 300);
+		ensure("renamed data", check_pattern(buffer, c, 0));
+		ensure("still removed", !vfs->getExists(b, LLAssetType::AT_MESH));
+		delete vfs;
+	}
+
+	// Growing moves a file without losing its data, appends land at the end
+	template<> template<>
+	void LLLogVFSTest_t::test<2>()
+	{
+		LLUUID a, b;
+		a.generate();
+		b.generate();
+
+		LLLogVFS* vfs = open();
+		store(vfs, a, 1024);
+		store(vfs, b, 1024);
+
+		// a is no longer the last extent, so this moves it
+		ensure("grow", vfs->setMaxSize(a, LLAssetType::AT_MESH, 4096));
+		std::vector<U8> buffer(3072);
+		fill_pattern(buffer, a, 1024);
+		ensure_equals("append", vfs->storeData(a, LLAssetType::AT_MESH, &buffer[0], -1, 3072), 3072);
+		ensure("grown", matches(vfs, a, 4096));
+		ensure("neighbour", matches(vfs, b, 1024));
+		ensure("dead space", vfs->getDataFileSize() > vfs->getLiveBytes());
+		delete vfs;
+	}
+
+	// Compaction drops the dead space and keeps the data
+	template<> template<>
+	void LLLogVFSTest_t::test<3>()
+	{
+		std::vector<LLUUID> ids(64);
+		LLLogVFS* vfs = open();
+		for (size_t i = 0; i < ids.size(); ++i)
+		{
+			ids[i].generate();
+			store(vfs, ids[i], 8192);
+		}
+		for (size_t i = 0; i < ids.size(); i += 2)
+		{
+			vfs->removeFile(ids[i], LLAssetType::AT_MESH);
+		}
+
+		ensure("compacted", vfs->compact(true));
+		ensure_equals("no dead space", vfs->getDataFileSize(), vfs->getLiveBytes());
+		for (size_t i = 1; i < ids.size(); i += 2)
+		{
+			ensure("kept", matches(vfs, ids[i], 8192));
+		}
+		vfs->audit();
+		delete vfs;
+
+		vfs = open();
+		for (size_t i = 1; i < ids.size(); i += 2)
+		{
+			ensure("kept after restart", matches(vfs, ids[i], 8192));
+		}
+		delete vfs;
+	}
+
+	// The size cap removes the least recently used files
+	template<> template<>
+	void LLLogVFSTest_t::test<4>()
+	{
+		LLUUID a, b, c;
+		a.generate();
+		b.generate();
+		c.generate();
+
+		LLLogVFS* vfs = open(3 * 4096);
+		store(vfs, a, 4096);
+		store(vfs, b, 4096);
+		store(vfs, c, 4096);
+		ensure("over the cap", !vfs->setMaxSize(a, LLAssetType::AT_MESH, 4 * 4096));
+
+		LLUUID d;
+		d.generate();
+		vfs->incLock(a, LLAssetType::AT_MESH, VFSLOCK_OPEN);
+		store(vfs, d, 4096);
+		ensure("locked file kept", vfs->getExists(a, LLAssetType::AT_MESH));
+		ensure("one unlocked file removed", vfs->getExists(b, LLAssetType::AT_MESH) != vfs->getExists(c, LLAssetType::AT_MESH));
+		ensure("new file", matches(vfs, d, 4096));
+		vfs->decLock(a, LLAssetType::AT_MESH, VFSLOCK_OPEN);
+		delete vfs;
+	}
+
+	// Concurrent readers and writers, with compactions running under them
+	template<> template<>
+	void LLLogVFSTest_t::test<5>()
+	{
+		const S32 NUM_FILES = 32;
+		const S32 FILE_SIZE = 16384;
+		const S32 NUM_WRITERS = 2;
+		const S32 NUM_READERS = 4;
+
+		std::vector<LLUUID> ids(NUM_FILES);
+		LLLogVFS* vfs = open();
+		for (S32 i = 0; i < NUM_FILES; ++i)
+		{
+			ids[i].generate();
+			store(vfs, ids[i], FILE_SIZE);
+		}
+
+		std::atomic<bool> done(false);
+		std::atomic<S32> bad_reads(0);
+		std::vector<std::thread> threads;
+		for (S32 t = 0; t < NUM_WRITERS; ++t)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				// Rewrite the same bytes in place and churn scratch files
+				std::vector<U8> buffer(FILE_SIZE);
+				for (S32 n = 0; !done; ++n)
+				{
+					const LLUUID& id = ids[(n * NUM_WRITERS + t) % NUM_FILES];
+					fill_pattern(buffer, id, 0);
+					vfs->storeData(id, LLAssetType::AT_MESH, &buffer[0], 0, FILE_SIZE);
+
+					LLUUID scratch;
+					scratch.generate();
+					vfs->setMaxSize(scratch, LLAssetType::AT_TEXTURE, FILE_SIZE);
+					vfs->storeData(scratch, LLAssetType::AT_TEXTURE, &buffer[0], 0, FILE_SIZE);
+					vfs->removeFile(scratch, LLAssetType::AT_TEXTURE);
+				}
+			}));
+		}
+		for (S32 t = 0; t < NUM_READERS; ++t)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				std::vector<U8> buffer(FILE_SIZE);
+				for (S32 n = 0; !done; ++n)
+				{
+					const LLUUID& id = ids[(n + t) % NUM_FILES];
+					if (vfs->getData(id, LLAssetType::AT_MESH, &buffer[0], 0, FILE_SIZE) != FILE_SIZE
+						|| !check_pattern(buffer, id, 0))
+					{
+						bad_reads++;
+					}
+				}
+			}));
+		}
+
+		for (S32 i = 0; i < 4; ++i)
+		{
+			ms_sleep(50);
+			vfs->compact(true);
+		}
+		done = true;
+		for (size_t i = 0; i < threads.size(); ++i)
+		{
+			threads[i].join();
+		}
+
+		ensure_equals("bad reads", (S32)bad_reads, 0);
+		for (S32 i = 0; i < NUM_FILES; ++i)
+		{
+			ensure("intact", matches(vfs, ids[i], FILE_SIZE));
+		}
+		delete vfs;
+	}
+
+	// A crash part way through a compaction leaves a consistent pair
+	template<> template<>
+	void LLLogVFSTest_t::test<6>()
+	{
+		LLUUID a, b;
+		a.generate();
+		b.generate();
+
+		// Crashed before the compacted index was written, the data is dropped
+		LLLogVFS* vfs = open();
+		store(vfs, a, 4096);
+		delete vfs;
+		copyFile(mDataFilename, mDataFilename + ".compact");
+		vfs = open();
+		ensure("old pair", matches(vfs, a, 4096));
+		ensure("partial compaction dropped", !LLFile::isfile(mDataFilename + ".compact"));
+		store(vfs, b, 2048);
+		delete vfs;
+
+		// Crashed after it, the compacted pair is moved into place.  Stand in
+		// for it with a copy of the current pair and empty the old one.
+		copyFile(mDataFilename, mDataFilename + ".saved");
+		copyFile(mIndexFilename, mIndexFilename + ".saved");
+		vfs = open();
+		vfs->removeFile(a, LLAssetType::AT_MESH);
+		vfs->removeFile(b, LLAssetType::AT_MESH);
+		delete vfs;
+		LLFile::rename(mDataFilename + ".saved", mDataFilename + ".compact");
+		LLFile::rename(mIndexFilename + ".saved", mIndexFilename + ".compact");
+		vfs = open();
+		ensure("compacted a", matches(vfs, a, 4096));
+		ensure("compacted b", matches(vfs, b, 2048));
+		delete vfs;
+
+		// Same with the data file already moved
+		copyFile(mIndexFilename, mIndexFilename + ".saved");
+		vfs = open();
+		vfs->removeFile(a, LLAssetType::AT_MESH);
+		delete vfs;
+		LLFile::rename(mIndexFilename + ".saved", mIndexFilename + ".compact");
+		vfs = open();
+		ensure("moved data", matches(vfs, a, 4096));
+		ensure("compaction finished", !LLFile::isfile(mIndexFilename + ".compact"));
+		delete vfs;
+	}
+}
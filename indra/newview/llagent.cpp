@@ -88,6 +88,7 @@
 #include "llviewerparcelmgr.h"
 #include "llviewerregion.h"
 #include "llviewerstats.h"
+#include "llviewertexturelist.h"
 #include "llviewerwindow.h"
 #include "llvoavatarself.h"
 #include "llwindow.h"
@@ -4371,6 +4372,8 @@ void LLAgent::setTeleportState(ETeleportState state)
 	{
 		case TELEPORT_NONE:
 			mbTeleportKeepsLookAt = false;
+			// Arrival has already reported the prefetch, anything left belongs to a failed or cancelled teleport
+			gTextureList.clearRegionPrefetch();
 			break;
 
 		case TELEPORT_MOVING:
@@ -31,6 +31,7 @@
 // Viewer includes
 #include "llversioninfo.h"
 #include "llfeaturemanager.h"
+#include "llfetchtrace.h"
 #include "lluictrlfactory.h"
 #include "lltexteditor.h"
 #include "llenvironment.h"
@@ -118,6 +119,7 @@
 #include "llprimitive.h"
 #include "llurlaction.h"
 #include "llurlentry.h"
+#include "lllogvfs.h"
 #include "llvfile.h"
 #include "llvfsthread.h"
 #include "llvolumemgr.h"
@@ -438,6 +440,8 @@ void init_default_trans_args()
 // File scope definitons
 const char *VFS_DATA_FILE_BASE = "data.db2.x.";
 const char *VFS_INDEX_FILE_BASE = "index.db2.x.";
+const char *LOG_VFS_DATA_FILE_BASE = "logdata.db2.x.";
+const char *LOG_VFS_INDEX_FILE_BASE = "logindex.db2.x.";
 
 
 struct SettingsFile : public LLInitParam::Block<SettingsFile>
@@ -2094,6 +2098,7 @@ bool LLAppViewer::cleanup()
     sTextureFetch = NULL;
 	delete sImageDecodeThread;
     sImageDecodeThread = NULL;
+	LLFetchTrace::cleanupClass();
 	delete mFastTimerLogThread;
 	mFastTimerLogThread = NULL;
 
@@ -2223,12 +2228,20 @@ bool LLAppViewer::initThreads()
 	static const bool enable_threads = true;
 
 	LLImage::initClass(gSavedSettings.getBOOL("TextureNewByteRange"),gSavedSettings.getS32("TextureReverseByteRange"));
+	LLImageJ2C::setMaxAuxPassBytes(gSavedSettings.getU32("ImageDecodeAuxPassMB") * 1024 * 1024);
+	LLImageJ2C::setParallelDecode(gSavedSettings.getU32("ImageDecodeTileThreads"));
 
 	LLVFSThread::initClass(enable_threads && false);
 	LLLFSThread::initClass(enable_threads && false);
 
+	if (gSavedSettings.getBOOL("FetchTraceRecord"))
+	{
+		LLFetchTrace::initClass(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "fetch_trace.log"));
+	}
+
 	// Image decoding
-	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
+	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true, gSavedSettings.getU32("ImageDecodeThreads"));
+	LLAppViewer::sImageDecodeThread->setMaxQueueDepth(gSavedSettings.getS32("ImageDecodeQueueDepth"));
 	LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
 													sImageDecodeThread,
@@ -2870,6 +2883,7 @@ bool LLAppViewer::initConfiguration()
 	//LLVolumeMgr::initClass();
 	LLVolumeMgr* volume_manager = new LLVolumeMgr();
 	volume_manager->useMutex();	// LLApp and LLMutex magic must be manually enabled
+	volume_manager->startGenerationThreads(gSavedSettings.getU32("VolumeGenerationThreads"));
 	LLPrimitive::setVolumeManager(volume_manager);
 
 	// Note: this is where we used to initialize gFeatureManagerp.
@@ -4212,7 +4226,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
 	// Viewer object cache version, change if object update
 	// format changes. JC
-	const U32 INDRA_OBJECT_CACHE_VERSION = 15;
+	const U32 INDRA_OBJECT_CACHE_VERSION = 17;
 
 	return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -4311,6 +4325,17 @@ bool LLAppViewer::initCache()
 	}
 	LL_INFOS("AppCache") << "VFS CACHE SIZE: " << vfs_size / (1024*1024) << " MB" << LL_ENDL;
 
+	// The log structured backend has its own file format and names,
+	// drop the files of whichever backend isn't in use
+	const bool use_log_vfs = gSavedSettings.getBOOL("VFSLogStructured");
+	const char* vfs_data_file_base = use_log_vfs ? LOG_VFS_DATA_FILE_BASE : VFS_DATA_FILE_BASE;
+	const char* vfs_index_file_base = use_log_vfs ? LOG_VFS_INDEX_FILE_BASE : VFS_INDEX_FILE_BASE;
+	{
+		std::string dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "");
+		gDirUtilp->deleteFilesInDir(dir, std::string(use_log_vfs ? VFS_DATA_FILE_BASE : LOG_VFS_DATA_FILE_BASE) + "*");
+		gDirUtilp->deleteFilesInDir(dir, std::string(use_log_vfs ? VFS_INDEX_FILE_BASE : LOG_VFS_INDEX_FILE_BASE) + "*");
+	}
+
 	// This has to happen BEFORE starting the vfs
 	// time_t	ltime;
 	srand(time(NULL));		// Flawfinder: ignore
@@ -4336,7 +4361,7 @@ bool LLAppViewer::initCache()
 		} while(new_salt == old_salt);
 	}
 
-	old_vfs_data_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, VFS_DATA_FILE_BASE) + llformat("%u", old_salt);
+	old_vfs_data_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, vfs_data_file_base) + llformat("%u", old_salt);
 
 	// make sure this file exists
 	llstat s;
@@ -4345,7 +4370,7 @@ bool LLAppViewer::initCache()
 	{
 		// doesn't exist, look for a data file
 		std::string mask;
-		mask = VFS_DATA_FILE_BASE;
+		mask = vfs_data_file_base;
 		mask += "*";
 
 		std::string dir;
@@ -4366,7 +4391,7 @@ bool LLAppViewer::initCache()
 		}
 	}
 
-	old_vfs_index_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, VFS_INDEX_FILE_BASE) + llformat("%u", old_salt);
+	old_vfs_index_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, vfs_index_file_base) + llformat("%u", old_salt);
 
 	stat_result = LLFile::stat(old_vfs_index_file, &s);
 	if (stat_result)
@@ -4382,19 +4407,19 @@ bool LLAppViewer::initCache()
 		dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "");
 
 		std::string mask;
-		mask = VFS_DATA_FILE_BASE;
+		mask = vfs_data_file_base;
 		mask += "*";
 
 		gDirUtilp->deleteFilesInDir(dir, mask);
 
-		mask = VFS_INDEX_FILE_BASE;
+		mask = vfs_index_file_base;
 		mask += "*";
 
 		gDirUtilp->deleteFilesInDir(dir, mask);
 	}
 
-	new_vfs_data_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, VFS_DATA_FILE_BASE) + llformat("%u", new_salt);
-	new_vfs_index_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, VFS_INDEX_FILE_BASE) + llformat("%u", new_salt);
+	new_vfs_data_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, vfs_data_file_base) + llformat("%u", new_salt);
+	new_vfs_index_file = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, vfs_index_file_base) + llformat("%u", new_salt);
 
 	static_vfs_data_file = gDirUtilp->getExpandedFilename(LL_PATH_APP_SETTINGS, "static_data.db2");
 	static_vfs_index_file = gDirUtilp->getExpandedFilename(LL_PATH_APP_SETTINGS, "static_index.db2");
@@ -4419,7 +4444,14 @@ bool LLAppViewer::initCache()
 	gSavedSettings.setU32("VFSSalt", new_salt);
 
 	// Don't remove VFS after viewer crashes.  If user has corrupt data, they can reinstall. JC
-	gVFS = LLVFS::createLLVFS(new_vfs_index_file, new_vfs_data_file, false, vfs_size_u32, false);
+	if (use_log_vfs)
+	{
+		gVFS = LLLogVFS::createLogVFS(new_vfs_index_file, new_vfs_data_file, false, vfs_size_u32, false);
+	}
+	else
+	{
+		gVFS = LLVFS::createLLVFS(new_vfs_index_file, new_vfs_data_file, false, vfs_size_u32, false);
+	}
 	if (!gVFS)
 	{
 		return false;
@@ -4589,6 +4621,7 @@ void LLAppViewer::purgeCache()
 	LL_INFOS("AppCache") << "Purging Cache and Texture Cache..." << LL_ENDL;
 	LLAppViewer::getTextureCache()->purgeCache(LL_PATH_CACHE);
 	LLVOCache::getInstance()->removeCache(LL_PATH_CACHE);
+	gMeshRepo.mDecodedCache.removeCache(LL_PATH_CACHE);
 	std::string browser_cache = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "cef_cache");
 	if (LLFile::isdir(browser_cache))
 	{
@@ -4604,6 +4637,7 @@ void LLAppViewer::purgeCacheImmediate()
 	LL_INFOS("AppCache") << "Purging Object Cache and Texture Cache immediately..." << LL_ENDL;
 	LLAppViewer::getTextureCache()->purgeCache(LL_PATH_CACHE, false);
 	LLVOCache::getInstance()->removeCache(LL_PATH_CACHE, true);
+	gMeshRepo.mDecodedCache.removeCache(LL_PATH_CACHE);
 }
 
 std::string LLAppViewer::getSecondLifeTitle() const
@@ -4851,6 +4885,7 @@ void LLAppViewer::idle()
 	LLNotificationsUI::LLToast::updateClass();
 	LLSmoothInterpolation::updateInterpolants();
 	LLMortician::updateClass();
+	LLFetchTrace::updateClass();
 	LLFilePickerThread::clearDead();  //calls LLFilePickerThread::notify()
 	LLDirPickerThread::clearDead();
 	F32 dt_raw = idle_timer.getElapsedTimeAndResetF32();
@@ -5603,6 +5638,10 @@ void LLAppViewer::disconnectViewer()
 	}
 
 	saveNameCache();
+	if (gAgent.getRegion())
+	{
+		gTextureList.saveRegionWorkingSet(gAgent.getRegion()->getHandle());
+	}
 	if (LLExperienceCache::instanceExists())
 	{
 		// TODO: LLExperienceCache::cleanup() logic should be moved to
@@ -0,0 +1,312 @@
+/** 
+ * @file lldecodedmeshcache.cpp
+ * @brief On-disk cache of unpacked mesh LODs.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lldecodedmeshcache.h"
+
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llmappedfile.h"
+#include "llviewerstats.h"
+#include "llvolume.h"
+
+// Bump when the file header or LLVolume::packDecodedFaces() layout changes
+const U32 DECODED_MESH_CACHE_VERSION = 1;
+const U32 DECODED_MESH_CACHE_MAGIC = 0x4d444c4c; // "LLDM"
+const char DECODED_MESH_CACHE_DIR[] = "meshdecoded";
+const char DECODED_MESH_CACHE_EXT[] = ".ldm";
+
+// Purge down to this share of the maximum size once it is exceeded
+const F32 DECODED_MESH_CACHE_PURGE_RATIO = 0.9f;
+
+// Header of each cache file.  32 bytes, so the faces that follow start
+// 16 byte aligned in the mapping.
+struct LLDecodedMeshFileHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	S32 mLOD;
+	U32 mDataSize;
+	U8 mMeshID[UUID_BYTES];
+};
+
+bool LLDecodedMeshCache::Key::operator<(const Key& rhs) const
+{
+	if (mID != rhs.mID)
+	{
+		return mID < rhs.mID;
+	}
+	if (mLOD != rhs.mLOD)
+	{
+		return mLOD < rhs.mLOD;
+	}
+	return mSculptType < rhs.mSculptType;
+}
+
+LLDecodedMeshCache::LLDecodedMeshCache()
+	: mMaxSize(0),
+	  mTotalSize(0),
+	  mEnabled(false),
+	  mReadOnly(true)
+{
+	mMutex = new LLMutex();
+}
+
+LLDecodedMeshCache::~LLDecodedMeshCache()
+{
+	delete mMutex;
+	mMutex = NULL;
+}
+
+void LLDecodedMeshCache::initCache(ELLPath location, U64 max_size, bool read_only)
+{
+	mCacheDir = gDirUtilp->getExpandedFilename(location, DECODED_MESH_CACHE_DIR);
+	if (!read_only)
+	{
+		LLFile::mkdir(mCacheDir);
+	}
+	if (!LLFile::isdir(mCacheDir))
+	{
+		LL_WARNS("MeshCache") << "Decoded mesh cache disabled, no directory " << mCacheDir << LL_ENDL;
+		return;
+	}
+
+	LLMutexLock lock(mMutex);
+	mEntries.clear();
+	mTotalSize = 0;
+	mMaxSize = max_size;
+	mReadOnly = read_only;
+
+	std::string name;
+	LLDirIterator iter(mCacheDir, std::string("*") + DECODED_MESH_CACHE_EXT);
+	while (iter.next(name))
+	{
+		Key key;
+		llstat file_status;
+		std::string filename = gDirUtilp->add(mCacheDir, name);
+		if (parseFilename(name, key) && LLFile::stat(filename, &file_status) == 0)
+		{
+			Entry& entry = mEntries[key];
+			entry.mSize = file_status.st_size;
+			entry.mLastAccess = file_status.st_mtime;
+			mTotalSize += entry.mSize;
+		}
+	}
+
+	if (!mReadOnly)
+	{
+		// Left behind by a store that didn't finish, or replaced while mapped
+		gDirUtilp->deleteFilesInDir(mCacheDir, "*.tmp");
+		gDirUtilp->deleteFilesInDir(mCacheDir, "*.old");
+		if (mTotalSize > mMaxSize)
+		{
+			purgeEntries((U64)(mMaxSize * DECODED_MESH_CACHE_PURGE_RATIO));
+		}
+	}
+
+	mEnabled = true;
+	LL_INFOS("MeshCache") << "Decoded mesh cache: " << mEntries.size() << " entries, "
+						  << (mTotalSize >> 20) << " MB of " << (mMaxSize >> 20) << " MB" << LL_ENDL;
+}
+
+void LLDecodedMeshCache::removeCache(ELLPath location)
+{
+	std::string cache_dir = gDirUtilp->getExpandedFilename(location, DECODED_MESH_CACHE_DIR);
+	if (LLFile::isdir(cache_dir))
+	{
+		LL_INFOS("MeshCache") << "Removing decoded mesh cache at " << cache_dir << LL_ENDL;
+		gDirUtilp->deleteDirAndContents(cache_dir);
+	}
+
+	LLMutexLock lock(mMutex);
+	mEntries.clear();
+	mPendingStores.clear();
+	mTotalSize = 0;
+	mEnabled = false;
+}
+
+bool LLDecodedMeshCache::has(const LLUUID& mesh_id, S32 lod, U8 sculpt_type)
+{
+	Key key = { mesh_id, lod, sculpt_type };
+	LLMutexLock lock(mMutex);
+	return mEnabled && mEntries.find(key) != mEntries.end();
+}
+
+bool LLDecodedMeshCache::load(const LLUUID& mesh_id, S32 lod, LLVolume* volume)
+{
+	Key key = { mesh_id, lod, volume->getParams().getSculptType() };
+	{
+		LLMutexLock lock(mMutex);
+		entry_map_t::iterator iter = mEntries.find(key);
+		if (!mEnabled || iter == mEntries.end())
+		{
+			return false;
+		}
+		iter->second.mLastAccess = time(NULL);
+	}
+
+	LLMappedFile file;
+	bool success = false;
+	if (file.open(getFilename(key)) && file.getSize() >= sizeof(LLDecodedMeshFileHeader))
+	{
+		add(LLStatViewer::MESH_DECODED_CACHE_MAPPED, F64Bytes(file.getSize()));
+
+		LLDecodedMeshFileHeader header;
+		memcpy(&header, file.getData(), sizeof(header));
+		success = header.mMagic == DECODED_MESH_CACHE_MAGIC
+			&& header.mVersion == DECODED_MESH_CACHE_VERSION
+			&& header.mLOD == lod
+			&& !memcmp(header.mMeshID, mesh_id.mData, UUID_BYTES)
+			&& header.mDataSize == file.getSize() - sizeof(header)
+			&& volume->unpackDecodedFaces(file.getData() + sizeof(header), header.mDataSize);
+	}
+	file.close();
+
+	if (!success)
+	{
+		LL_DEBUGS("MeshCache") << "Dropping bad decoded mesh cache entry " << mesh_id << " LOD " << lod << LL_ENDL;
+		removeEntry(key);
+	}
+	return success;
+}
+
+void LLDecodedMeshCache::store(const LLUUID& mesh_id, S32 lod, const LLVolume* volume)
+{
+	Key key = { mesh_id, lod, volume->getParams().getSculptType() };
+	{
+		LLMutexLock lock(mMutex);
+		if (!mEnabled || mReadOnly
+			|| mEntries.find(key) != mEntries.end()
+			|| !mPendingStores.insert(key).second)
+		{
+			return;
+		}
+	}
+
+	std::vector<U8> data;
+	bool success = false;
+	std::string filename = getFilename(key);
+	std::string temp_filename = filename + ".tmp";
+	if (volume->packDecodedFaces(data))
+	{
+		LLDecodedMeshFileHeader header;
+		header.mMagic = DECODED_MESH_CACHE_MAGIC;
+		header.mVersion = DECODED_MESH_CACHE_VERSION;
+		header.mLOD = lod;
+		header.mDataSize = data.size();
+		memcpy(header.mMeshID, mesh_id.mData, UUID_BYTES);
+
+		LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+		if (fp)
+		{
+			success = fwrite(&header, sizeof(header), 1, fp) == 1
+				&& fwrite(&data[0], data.size(), 1, fp) == 1;
+			success = (fclose(fp) == 0) && success;
+			success = success && LLMappedFile::replace(temp_filename, filename);
+			if (!success)
+			{
+				LLFile::remove(temp_filename);
+			}
+		}
+	}
+
+	LLMutexLock lock(mMutex);
+	mPendingStores.erase(key);
+	if (success && mEnabled)
+	{
+		Entry& entry = mEntries[key];
+		entry.mSize = sizeof(LLDecodedMeshFileHeader) + data.size();
+		entry.mLastAccess = time(NULL);
+		mTotalSize += entry.mSize;
+		if (mTotalSize > mMaxSize)
+		{
+			purgeEntries((U64)(mMaxSize * DECODED_MESH_CACHE_PURGE_RATIO));
+		}
+	}
+}
+
+std::string LLDecodedMeshCache::getFilename(const Key& key) const
+{
+	return gDirUtilp->add(mCacheDir, llformat("%s_%d_%d%s", key.mID.asString().c_str(), key.mLOD, (S32)key.mSculptType, DECODED_MESH_CACHE_EXT));
+}
+
+bool LLDecodedMeshCache::parseFilename(const std::string& name, Key& key) const
+{
+	// <uuid>_<lod>_<sculpt type>.ldm
+	const size_t uuid_len = UUID_STR_LENGTH - 1;
+	if (name.size() <= uuid_len + 1 || name[uuid_len] != '_' || !LLUUID::validate(name.substr(0, uuid_len)))
+	{
+		return false;
+	}
+	S32 lod = -1;
+	S32 sculpt_type = -1;
+	if (sscanf(name.c_str() + uuid_len, "_%d_%d", &lod, &sculpt_type) != 2
+		|| lod < 0 || lod > 3 || sculpt_type < 0 || sculpt_type > 255)
+	{
+		return false;
+	}
+	key.mID.set(name.substr(0, uuid_len));
+	key.mLOD = lod;
+	key.mSculptType = (U8)sculpt_type;
+	return true;
+}
+
+void LLDecodedMeshCache::removeEntry(const Key& key)
+{
+	LLMutexLock lock(mMutex);
+	entry_map_t::iterator iter = mEntries.find(key);
+	if (iter != mEntries.end())
+	{
+		mTotalSize -= iter->second.mSize;
+		mEntries.erase(iter);
+		if (!mReadOnly)
+		{
+			LLFile::remove(getFilename(key));
+		}
+	}
+}
+
+void LLDecodedMeshCache::purgeEntries(U64 target_size)
+{
+	// Least recently used first
+	typedef std::pair<time_t, Key> age_pair_t;
+	std::vector<age_pair_t> ages;
+	ages.reserve(mEntries.size());
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		ages.push_back(age_pair_t(iter->second.mLastAccess, iter->first));
+	}
+	std::sort(ages.begin(), ages.end());
+
+	for (std::vector<age_pair_t>::iterator iter = ages.begin(); iter != ages.end() && mTotalSize > target_size; ++iter)
+	{
+		entry_map_t::iterator entry = mEntries.find(iter->second);
+		mTotalSize -= entry->second.mSize;
+		mEntries.erase(entry);
+		LLFile::remove(getFilename(iter->second));
+	}
+}
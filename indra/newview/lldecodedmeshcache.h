@@ -0,0 +1,97 @@
+/** 
+ * @file lldecodedmeshcache.h
+ * @brief On-disk cache of unpacked mesh LODs.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDECODEDMESHCACHE_H
+#define LL_LLDECODEDMESHCACHE_H
+
+#include "lluuid.h"
+#include "lldir.h"
+#include "llmutex.h"
+
+class LLVolume;
+
+// Second level cache behind the mesh assets held in the VFS.  Keeps the
+// faces of each mesh LOD as they are after unpackVolumeFaces() and
+// cacheOptimize() (see LLVolume::packDecodedFaces()), one file per mesh,
+// LOD and sculpt flags, so loading a mesh seen in an earlier session is a
+// map, validate and copy instead of inflate, parse and optimize.
+//
+// Threads:  initCache() and removeCache() on main, everything else on any
+// thread (the mesh repo and decode threads).
+class LLDecodedMeshCache
+{
+public:
+	LLDecodedMeshCache();
+	~LLDecodedMeshCache();
+
+	void initCache(ELLPath location, U64 max_size, bool read_only);
+	void removeCache(ELLPath location);
+
+	bool isEnabled() const { return mEnabled; }
+
+	// Index lookup only, no file access
+	bool has(const LLUUID& mesh_id, S32 lod, U8 sculpt_type);
+
+	// Fill volume with the cached faces.  An entry that fails to map or
+	// validate is removed from the cache.
+	bool load(const LLUUID& mesh_id, S32 lod, LLVolume* volume);
+
+	void store(const LLUUID& mesh_id, S32 lod, const LLVolume* volume);
+
+private:
+	struct Key
+	{
+		LLUUID mID;
+		S32 mLOD;
+		U8 mSculptType;
+
+		bool operator<(const Key& rhs) const;
+	};
+
+	struct Entry
+	{
+		U64 mSize;
+		time_t mLastAccess;
+	};
+
+	typedef std::map<Key, Entry> entry_map_t;
+
+	std::string getFilename(const Key& key) const;
+	bool parseFilename(const std::string& name, Key& key) const;
+	void removeEntry(const Key& key);
+	void purgeEntries(U64 target_size);		// mMutex must be held
+
+	LLMutex* mMutex;
+	entry_map_t mEntries;
+	std::set<Key> mPendingStores;
+	std::string mCacheDir;
+	U64 mMaxSize;
+	U64 mTotalSize;
+	bool mEnabled;
+	bool mReadOnly;
+};
+
+#endif // LL_LLDECODEDMESHCACHE_H
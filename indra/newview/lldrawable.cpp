@@ -885,24 +885,7 @@ void LLDrawable::updateDistance(LLCamera& camera, bool force_update)
 			
 			if (isState(LLDrawable::HAS_ALPHA))
 			{
-				for (S32 i = 0; i < getNumFaces(); i++)
-				{
-					LLFace* facep = getFace(i);
-					if (facep && 
-						(force_update || facep->getPoolType() == LLDrawPool::POOL_ALPHA))
-					{
-						LLVector4a box;
-						box.setSub(facep->mExtents[1], facep->mExtents[0]);
-						box.mul(0.25f);
-						LLVector3 v = (facep->mCenterLocal-camera.getOrigin());
-						const LLVector3& at = camera.getAtAxis();
-						for (U32 j = 0; j < 3; j++)
-						{
-							v.mV[j] -= box[j] * at.mV[j];
-						}
-						facep->mDistance = v * camera.getAtAxis();
-					}
-				}
+				updateFaceDistances(camera, force_update);
 			}	
 
 
@@ -936,6 +919,28 @@ void LLDrawable::updateDistance(LLCamera& camera, bool force_update)
 	}
 }
 
+void LLDrawable::updateFaceDistances(LLCamera& camera, bool force_update)
+{
+	for (S32 i = 0; i < getNumFaces(); i++)
+	{
+		LLFace* facep = getFace(i);
+		if (facep && 
+			(force_update || facep->getPoolType() == LLDrawPool::POOL_ALPHA))
+		{
+			LLVector4a box;
+			box.setSub(facep->mExtents[1], facep->mExtents[0]);
+			box.mul(0.25f);
+			LLVector3 v = (facep->mCenterLocal-camera.getOrigin());
+			const LLVector3& at = camera.getAtAxis();
+			for (U32 j = 0; j < 3; j++)
+			{
+				v.mV[j] -= box[j] * at.mV[j];
+			}
+			facep->mDistance = v * camera.getAtAxis();
+		}
+	}
+}
+
 void LLDrawable::updateTexture()
 {
 	if (isDead())
@@ -161,6 +161,7 @@ public:
 	void updateTexture();
 	void updateMaterial();
 	virtual void updateDistance(LLCamera& camera, bool force_update);
+	void updateFaceDistances(LLCamera& camera, bool force_update);
 	BOOL updateGeometry(BOOL priority);
 	void updateFaceSize(S32 idx);
 		
@@ -278,6 +279,7 @@ public:
  		NEARBY_LIGHT	= 0x00200000, // In gPipeline.mNearbyLightSet
 		BUILT			= 0x00400000,
 		FORCE_INVISIBLE = 0x00800000, // stay invis until CLEAR_INVISIBLE is set (set of orphaned)
+		LOD_UPDATED		= 0x01000000, // distance and LOD already set by LLVOVolume::updateLODBatch() this frame
 		REBUILD_SHADOW =  0x02000000,
 		HAS_ALPHA		= 0x04000000,
 		RIGGED			= 0x08000000,
@@ -437,15 +437,22 @@ void LLRenderPass::pushMaskBatches(U32 type, U32 mask, BOOL texture, BOOL batch_
 
 void LLRenderPass::applyModelMatrix(const LLDrawInfo& params)
 {
-	if (params.mModelMatrix != gGLLastMatrix)
+	// an instance matrix always goes with the same model matrix, so it
+	// identifies the combination
+	const LLMatrix4* last_matrix = params.mInstanceMatrix ? params.mInstanceMatrix : params.mModelMatrix;
+	if (last_matrix != gGLLastMatrix)
 	{
-		gGLLastMatrix = params.mModelMatrix;
+		gGLLastMatrix = last_matrix;
 		gGL.matrixMode(LLRender::MM_MODELVIEW);
 		gGL.loadMatrix(gGLModelView);
 		if (params.mModelMatrix)
 		{
 			gGL.multMatrix((GLfloat*) params.mModelMatrix->mMatrix);
 		}
+		if (params.mInstanceMatrix)
+		{
+			gGL.multMatrix((GLfloat*) params.mInstanceMatrix->mMatrix);
+		}
 		gPipeline.mMatrixOpCount++;
 	}
 }
@@ -161,6 +161,7 @@ void LLFace::init(LLDrawable* drawablep, LLViewerObject* objp)
 	mReferenceIndex = -1;
 
 	mTextureMatrix = NULL;
+	mInstanceSource = NULL;
 	mDrawInfo = NULL;
 
 	mFaceColor = LLColor4(1,0,0,1);
@@ -222,6 +223,16 @@ void LLFace::destroy()
 			}
 		}
 	}
+
+	if (isState(INSTANCE) && mDrawablep)
+	{ //draw infos of the group point at mInstanceMatrix
+		LLSpatialGroup* group = mDrawablep->getSpatialGroup();
+		if (group)
+		{
+			group->dirtyGeom();
+			gPipeline.markRebuild(group, TRUE);
+		}
+	}
 	
 	setDrawInfo(NULL);
 
@@ -562,6 +573,11 @@ void LLFace::renderSelected(LLViewerTexture *imagep, const LLColor4& color)
 			gGL.multMatrix((GLfloat*)mDrawablep->getRegion()->mRenderMatrix.mMatrix);
 		}
 
+		if (isState(INSTANCE))
+		{
+			gGL.multMatrix((GLfloat*)mInstanceMatrix.mMatrix);
+		}
+
 		gGL.diffuseColor4fv(color.mV);
 	
 		if (mDrawablep->isState(LLDrawable::RIGGED))
@@ -2656,7 +2672,14 @@ S32 LLFace::renderElements(const U16 *index_array) const
 {
 	S32 ret = 0;
 	
-	if (isState(GLOBAL))
+	if (isState(INSTANCE))
+	{ //the vertices are another face's, move them over
+		gGL.pushMatrix();
+		gGL.multMatrix((float*)mInstanceMatrix.mMatrix);
+		ret = pushVertices(index_array);
+		gGL.popMatrix();
+	}
+	else if (isState(GLOBAL))
 	{	
 		ret = pushVertices(index_array);
 	}
@@ -2758,6 +2781,7 @@ void LLFace::clearVertexBuffer()
 	}
 
 	mVertexBuffer = NULL;
+	clearState(INSTANCE | INSTANCE_SOURCE);
 }
 
 //static
@@ -79,6 +79,8 @@ public:
 		TEXTURE_ANIM	= 0x0020, 
 		RIGGED			= 0x0040,
 		PARTICLE		= 0x0080,
+		INSTANCE		= 0x0100,	// draws the vertices of another face through mInstanceMatrix
+		INSTANCE_SOURCE	= 0x0200,	// vertices are also drawn by INSTANCE faces
 	};
 
 	static void cacheFaceInVRAM(const LLVolumeFace& vf);
@@ -120,6 +122,7 @@ public:
 	void			setState(U32 state)			{ mState |= state; }
 	void			clearState(U32 state)		{ mState &= ~state; }
 	BOOL			isState(U32 state)	const	{ return ((mState & state) != 0) ? TRUE : FALSE; }
+	const LLMatrix4* getInstanceMatrix() const	{ return isState(INSTANCE) ? &mInstanceMatrix : NULL; }
 	void			setVirtualSize(F32 size) { mVSize = size; }
 	void			setPixelArea(F32 area)	{ mPixelArea = area; }
 	F32				getVirtualSize() const { return mVSize; }
@@ -260,6 +263,8 @@ public:
 	LLMatrix4*	mTextureMatrix;
 	LLMatrix4*	mSpecMapMatrix;
 	LLMatrix4*	mNormalMapMatrix;
+	LLMatrix4	mInstanceMatrix;	// region space vertices of the instance source to those of this face
+	LLFace*		mInstanceSource;	// only valid while LLVolumeGeometryManager::genDrawInfo() runs
 	LLDrawInfo* mDrawInfo;
 
 private:
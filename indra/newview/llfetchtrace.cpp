@@ -0,0 +1,230 @@
+/**
+ * @file llfetchtrace.cpp
+ * @brief Log of the texture and mesh fetches of a session.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llfetchtrace.h"
+
+#include "httpresponse.h"
+#include "llfile.h"
+#include "lltimer.h"
+
+#include <stdarg.h>
+
+// Relative move of a priority worth a line in the trace
+const F32 PRIORITY_TRACE_STEP = 0.125f;
+
+// Buffered trace written out past this, or this often
+const size_t TRACE_FLUSH_SIZE = 64 * 1024;
+const F32 TRACE_FLUSH_INTERVAL = 1.f;
+
+// Assets whose last priority is remembered before the table is reset
+const size_t TRACE_MAX_PRIORITIES = 16384;
+
+static const char ASSET_TYPE[] = { 'T', 'M' };
+
+LLFetchTrace* LLFetchTrace::sInstance = NULL;
+
+//static
+void LLFetchTrace::initClass(const std::string& filename)
+{
+	llassert(!sInstance);
+
+	LLFILE* file = LLFile::fopen(filename, "wb");
+	if (!file)
+	{
+		LL_WARNS() << "Could not open fetch trace " << filename << LL_ENDL;
+		return;
+	}
+
+	LL_INFOS() << "Recording fetch trace to " << filename << LL_ENDL;
+	sInstance = new LLFetchTrace(file);
+}
+
+//static
+void LLFetchTrace::cleanupClass()
+{
+	delete sInstance;
+	sInstance = NULL;
+}
+
+//static
+void LLFetchTrace::updateClass()
+{
+	if (!sInstance || !sInstance->mFlushTimer.hasExpired())
+	{
+		return;
+	}
+
+	sInstance->mFlushTimer.setTimerExpirySec(TRACE_FLUSH_INTERVAL);
+	LLMutexLock lock(&sInstance->mMutex);
+	sInstance->flush();
+}
+
+LLFetchTrace::LLFetchTrace(LLFILE* file)
+:	mMutex(),
+	mFile(file),
+	mStartTime(LLTimer::getTotalTime()),
+	mNextXfer(1)
+{
+	mBuffer = "# fetch trace 1\n";
+	mFlushTimer.setTimerExpirySec(TRACE_FLUSH_INTERVAL);
+}
+
+LLFetchTrace::~LLFetchTrace()
+{
+	flush();
+	fclose(mFile);
+}
+
+//static
+void LLFetchTrace::recordFetch(EAsset type, const LLUUID& id, F32 priority)
+{
+	if (!sInstance)
+	{
+		return;
+	}
+
+	LLMutexLock lock(&sInstance->mMutex);
+	if (sInstance->mPriorities.size() >= TRACE_MAX_PRIORITIES)
+	{
+		sInstance->mPriorities.clear();
+	}
+	sInstance->mPriorities[asset_key_t(id, type)] = priority;
+	sInstance->write("fetch %c %s %g", ASSET_TYPE[type], id.asString().c_str(), priority);
+}
+
+//static
+void LLFetchTrace::recordPriority(EAsset type, const LLUUID& id, F32 priority)
+{
+	if (!sInstance)
+	{
+		return;
+	}
+
+	LLMutexLock lock(&sInstance->mMutex);
+	if (sInstance->mPriorities.size() >= TRACE_MAX_PRIORITIES)
+	{
+		// Forgotten assets log their next change whatever its size
+		sInstance->mPriorities.clear();
+	}
+	F32& last = sInstance->mPriorities[asset_key_t(id, type)];
+	if (fabsf(priority - last) <= fabsf(last) * PRIORITY_TRACE_STEP)
+	{
+		return;
+	}
+	last = priority;
+	sInstance->write("prio %c %s %g", ASSET_TYPE[type], id.asString().c_str(), priority);
+}
+
+//static
+void LLFetchTrace::recordGet(LLCore::HttpHandle handle, EAsset type, const LLUUID& id,
+							 S32 offset, S32 size, U32 http_priority)
+{
+	if (!sInstance || LLCORE_HTTP_HANDLE_INVALID == handle)
+	{
+		return;
+	}
+
+	LLMutexLock lock(&sInstance->mMutex);
+	U32 xfer = sInstance->mNextXfer++;
+	sInstance->mXfers[handle] = xfer;
+	sInstance->write("get %u %c %s %d %d %u", xfer, ASSET_TYPE[type], id.asString().c_str(),
+					 offset, size, http_priority);
+}
+
+//static
+void LLFetchTrace::recordDone(LLCore::HttpHandle handle, LLCore::HttpResponse* response)
+{
+	if (!sInstance)
+	{
+		return;
+	}
+
+	LLMutexLock lock(&sInstance->mMutex);
+	xfer_map_t::iterator iter = sInstance->mXfers.find(handle);
+	if (iter == sInstance->mXfers.end())
+	{
+		return;
+	}
+	U32 xfer = iter->second;
+	sInstance->mXfers.erase(iter);
+
+	LLCore::HttpStatus status(response->getStatus());
+	unsigned int offset(0), length(0), full_length(0);
+	response->getRange(&offset, &length, &full_length);
+	sInstance->write("done %u %d %s %u %u", xfer, status ? 1 : 0, status.toTerseString().c_str(),
+					 (U32)response->getBodySize(), full_length);
+}
+
+//static
+void LLFetchTrace::recordCancel(LLCore::HttpHandle handle)
+{
+	if (!sInstance)
+	{
+		return;
+	}
+
+	LLMutexLock lock(&sInstance->mMutex);
+	xfer_map_t::iterator iter = sInstance->mXfers.find(handle);
+	if (iter == sInstance->mXfers.end())
+	{
+		return;
+	}
+	U32 xfer = iter->second;
+	sInstance->mXfers.erase(iter);
+	sInstance->write("cancel %u", xfer);
+}
+
+// Call with mMutex locked
+void LLFetchTrace::write(const char* format, ...)
+{
+	char line[256];
+	S32 len = snprintf(line, sizeof(line), "%llu ",
+					   (unsigned long long)(LLTimer::getTotalTime() - mStartTime));
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line + len, sizeof(line) - len, format, args);
+	va_end(args);
+
+	mBuffer += line;
+	mBuffer += '\n';
+	if (mBuffer.size() >= TRACE_FLUSH_SIZE)
+	{
+		flush();
+	}
+}
+
+void LLFetchTrace::flush()
+{
+	if (!mBuffer.empty())
+	{
+		fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+		fflush(mFile);
+		mBuffer.clear();
+	}
+}
@@ -0,0 +1,114 @@
+/**
+ * @file llfetchtrace.h
+ * @brief Log of the texture and mesh fetches of a session.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFETCHTRACE_H
+#define LL_LLFETCHTRACE_H
+
+#include "httpcommon.h"
+#include "llframetimer.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <map>
+
+namespace LLCore
+{
+	class HttpResponse;
+}
+
+// Records what LLTextureFetch and LLMeshRepoThread ask of the network,
+// with timestamps, so that a session can be replayed offline against
+// llcorehttp (see llcorehttp/examples/http_fetch_replay.cpp).
+//
+// The trace is a text file, one event per line, times in microseconds
+// from the start of the recording:
+//
+//   <time> fetch <T|M> <asset id> <priority>		the viewer wants an asset
+//   <time> prio <T|M> <asset id> <priority>		its priority changed
+//   <time> get <xfer> <T|M> <asset id> <offset> <size> <http priority>
+//   <time> done <xfer> <ok> <status> <bytes> <asset size>
+//   <time> cancel <xfer>							dropped while in flight
+//
+// A get is one HTTP transfer, <xfer> numbers them.  A size of 0 is a
+// request to the end of the asset.  The asset size is that of the
+// Content-Range header of the reply, 0 if unknown.  Priorities are only
+// logged when they move by more than an eighth, or when an asset is
+// seen again after the priority table filled up and was reset.
+//
+// Enabled by the FetchTraceRecord setting, the trace goes to
+// fetch_trace.log in the log directory.  Lines are buffered and written
+// out every second by updateClass(), or sooner once the buffer fills.
+//
+// Threads:  initClass(), updateClass() and cleanupClass() on main,
+// the first and last with no fetch thread running, the record methods
+// on any thread.
+class LLFetchTrace
+{
+public:
+	enum EAsset
+	{
+		TEXTURE = 0,
+		MESH
+	};
+
+	static void initClass(const std::string& filename);
+	static void cleanupClass();
+	static void updateClass();
+
+	static bool isRecording()	{ return sInstance != NULL; }
+
+	static void recordFetch(EAsset type, const LLUUID& id, F32 priority);
+	static void recordPriority(EAsset type, const LLUUID& id, F32 priority);
+	static void recordGet(LLCore::HttpHandle handle, EAsset type, const LLUUID& id,
+						  S32 offset, S32 size, U32 http_priority);
+	static void recordDone(LLCore::HttpHandle handle, LLCore::HttpResponse* response);
+	static void recordCancel(LLCore::HttpHandle handle);
+
+private:
+	LLFetchTrace(LLFILE* file);
+	~LLFetchTrace();
+
+	void write(const char* format, ...);
+	void flush();
+
+	// Asset id and type, priorities are tracked per asset
+	typedef std::pair<LLUUID, S32> asset_key_t;
+	typedef std::map<asset_key_t, F32> priority_map_t;
+	typedef std::map<LLCore::HttpHandle, U32> xfer_map_t;
+
+	static LLFetchTrace* sInstance;
+
+	LLMutex mMutex;
+	LLFILE* mFile;
+	std::string mBuffer;
+	U64 mStartTime;
+	U32 mNextXfer;
+	LLFrameTimer mFlushTimer;	// main thread only
+	priority_map_t mPriorities;	// last logged, reset past TRACE_MAX_PRIORITIES
+	xfer_map_t mXfers;			// transfers in flight by llcorehttp handle
+};
+
+#endif // LL_LLFETCHTRACE_H
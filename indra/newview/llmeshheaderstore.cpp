@@ -0,0 +1,197 @@
+/**
+ * @file llmeshheaderstore.cpp
+ * @brief Compact store of parsed mesh asset headers.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llmeshheaderstore.h"
+
+#include "llsd.h"
+
+// Keys of the blocks in the header, in LLMeshHeader::EBlock order
+static const char* const HEADER_BLOCKS[LLMeshHeader::NUM_BLOCKS] =
+{
+	"lowest_lod",
+	"low_lod",
+	"medium_lod",
+	"high_lod",
+	"skin",
+	"physics_convex",
+	"physics_mesh"
+};
+
+// Allocation overhead of a heap block, of a tree or list node, and of a hash
+// node and its bucket
+const U32 HEAP_BLOCK_OVERHEAD = 16;
+const U32 NODE_OVERHEAD = 4 * sizeof(void*);
+const U32 HASH_NODE_OVERHEAD = 2 * sizeof(void*) + sizeof(size_t);
+
+LLMeshHeader::LLMeshHeader()
+:	mVersion(0),
+	mHeaderSize(0),
+	m404(false),
+	mHasLowestLOD(false)
+{
+	memset(mOffset, 0, sizeof(mOffset));
+	memset(mSize, 0, sizeof(mSize));
+}
+
+void LLMeshHeader::init(const LLSD& header, U32 header_size)
+{
+	mVersion = header["version"].asInteger();
+	mHeaderSize = header_size;
+	for (S32 i = 0; i < NUM_BLOCKS; ++i)
+	{
+		const LLSD& block = header[HEADER_BLOCKS[i]];
+		mOffset[i] = block["offset"].asInteger();
+		mSize[i] = block["size"].asInteger();
+	}
+	m404 = header.has("404");
+	mHasLowestLOD = header.has("lowest_lod");
+}
+
+LLMeshHeaderStore::LLMeshHeaderStore(U32 max_headers)
+:	mMaxHeaders(llmax(max_headers, 1U)),
+	mNumEvicted(0),
+	mLLSDBytes(0)
+{
+}
+
+LLMeshHeader* LLMeshHeaderStore::find(const LLUUID& mesh_id)
+{
+	header_map_t::iterator iter = mHeaders.find(mesh_id);
+	if (iter == mHeaders.end())
+	{
+		return NULL;
+	}
+
+	if (!iter->second.mPinned)
+	{
+		mLRU.splice(mLRU.begin(), mLRU, iter->second.mLRU);
+	}
+	return &iter->second.mHeader;
+}
+
+void LLMeshHeaderStore::store(const LLUUID& mesh_id, const LLMeshHeader& header, U32 llsd_bytes)
+{
+	bool pinned = isPinned(header);
+
+	header_map_t::iterator iter = mHeaders.find(mesh_id);
+	if (iter != mHeaders.end())
+	{
+		Entry& entry = iter->second;
+		mLLSDBytes -= entry.mLLSDBytes;
+		entry.mHeader = header;
+		entry.mLLSDBytes = llsd_bytes;
+		mLLSDBytes += llsd_bytes;
+		if (!entry.mPinned && pinned)
+		{
+			mLRU.erase(entry.mLRU);
+		}
+		else if (!entry.mPinned)
+		{
+			mLRU.splice(mLRU.begin(), mLRU, entry.mLRU);
+		}
+		else if (!pinned)
+		{
+			if (mLRU.size() >= mMaxHeaders)
+			{
+				evictOldest();
+			}
+			mLRU.push_front(mesh_id);
+			entry.mLRU = mLRU.begin();
+		}
+		entry.mPinned = pinned;
+		return;
+	}
+
+	while (!pinned && mLRU.size() >= mMaxHeaders)
+	{
+		evictOldest();
+	}
+
+	Entry& entry = mHeaders[mesh_id];
+	entry.mHeader = header;
+	entry.mLLSDBytes = llsd_bytes;
+	entry.mPinned = pinned;
+	if (!pinned)
+	{
+		mLRU.push_front(mesh_id);
+		entry.mLRU = mLRU.begin();
+	}
+	mLLSDBytes += llsd_bytes;
+}
+
+void LLMeshHeaderStore::evictOldest()
+{
+	header_map_t::iterator oldest = mHeaders.find(mLRU.back());
+	mLLSDBytes -= oldest->second.mLLSDBytes;
+	mHeaders.erase(oldest);
+	mLRU.pop_back();
+	mNumEvicted++;
+}
+
+U64 LLMeshHeaderStore::getBytes() const
+{
+	U64 entry_bytes = sizeof(header_map_t::value_type) + HASH_NODE_OVERHEAD + HEAP_BLOCK_OVERHEAD;
+	U64 id_bytes = sizeof(LLUUID) + NODE_OVERHEAD + HEAP_BLOCK_OVERHEAD;
+	return (U64)mHeaders.size() * entry_bytes + (U64)mLRU.size() * id_bytes;
+}
+
+//static
+U32 LLMeshHeaderStore::getLLSDFootprint(const LLSD& sd)
+{
+	// The LLSD and its impl
+	U32 bytes = sizeof(LLSD) + 2 * sizeof(void*) + sizeof(S32) + HEAP_BLOCK_OVERHEAD;
+	switch (sd.type())
+	{
+	case LLSD::TypeMap:
+		for (LLSD::map_const_iterator iter = sd.beginMap(); iter != sd.endMap(); ++iter)
+		{
+			bytes += sizeof(LLSD::map_const_iterator::value_type) + NODE_OVERHEAD + HEAP_BLOCK_OVERHEAD
+				+ getLLSDFootprint(iter->second) - sizeof(LLSD);
+			if (iter->first.capacity() > 15)
+			{
+				bytes += iter->first.capacity() + HEAP_BLOCK_OVERHEAD;
+			}
+		}
+		break;
+	case LLSD::TypeArray:
+		for (LLSD::array_const_iterator iter = sd.beginArray(); iter != sd.endArray(); ++iter)
+		{
+			bytes += getLLSDFootprint(*iter);
+		}
+		break;
+	case LLSD::TypeString:
+		bytes += sd.asStringRef().capacity();
+		break;
+	case LLSD::TypeBinary:
+		bytes += sd.asBinary().capacity();
+		break;
+	default:
+		break;
+	}
+	return bytes;
+}
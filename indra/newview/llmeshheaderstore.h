@@ -0,0 +1,125 @@
+/**
+ * @file llmeshheaderstore.h
+ * @brief Compact store of parsed mesh asset headers.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESHHEADERSTORE_H
+#define LL_LLMESHHEADERSTORE_H
+
+#include "lluuid.h"
+
+#include <list>
+#include <boost/unordered_map.hpp>
+
+class LLSD;
+
+// What the viewer uses of a mesh asset header once it is parsed: the
+// version and where each block of the asset is.  See
+// http://wiki.secondlife.com/wiki/Mesh/Mesh_Asset_Format
+struct LLMeshHeader
+{
+	enum EBlock
+	{
+		LOWEST_LOD = 0,		// LOD blocks in LLModel LOD order
+		LOW_LOD,
+		MEDIUM_LOD,
+		HIGH_LOD,
+		SKIN,
+		PHYSICS_CONVEX,
+		PHYSICS_MESH,
+		NUM_BLOCKS
+	};
+
+	LLMeshHeader();
+
+	// header_size is the size of the serialized header, block offsets are
+	// from its end.  0 if the asset can not be used.
+	void init(const LLSD& header, U32 header_size);
+
+	// Offset of a block from the start of the asset
+	S32 getAssetOffset(S32 block) const	{ return mHeaderSize + mOffset[block]; }
+
+	S32 mVersion;
+	U32 mHeaderSize;
+	S32 mOffset[NUM_BLOCKS];
+	S32 mSize[NUM_BLOCKS];
+	bool m404;				// the asset does not exist or has no usable LOD
+	bool mHasLowestLOD;
+};
+
+// Mesh headers by mesh id.  Holds up to a set number of headers and drops
+// the least recently used ones past that, the repo thread reads them back
+// from the mesh assets in the VFS when they are asked for again.  No record
+// of dropped ids is kept, a miss for an asset the VFS has stands for one.  Headers
+// of missing assets (m404) and ones with no header size never make it to
+// the VFS, so they are pinned outside the LRU list and never dropped.
+//
+// Not thread safe, LLMeshRepoThread::mHeaderMutex covers it.
+class LLMeshHeaderStore
+{
+public:
+	LLMeshHeaderStore(U32 max_headers);
+
+	// NULL if the header is not in the store, marks it as recently used
+	LLMeshHeader* find(const LLUUID& mesh_id);
+
+	// llsd_bytes is what the header takes as parsed LLSD, for the stats
+	void store(const LLUUID& mesh_id, const LLMeshHeader& header, U32 llsd_bytes);
+
+	U32 getNumHeaders() const	{ return mHeaders.size(); }
+	U32 getNumPinned() const	{ return mHeaders.size() - mLRU.size(); }
+	U32 getMaxHeaders() const	{ return mMaxHeaders; }
+	U32 getNumEvicted() const	{ return mNumEvicted; }
+
+	// Memory taken by the stored headers, and by the same headers as LLSD
+	U64 getBytes() const;
+	U64 getLLSDBytes() const	{ return mLLSDBytes; }
+
+	// Rough heap footprint of a parsed LLSD
+	static U32 getLLSDFootprint(const LLSD& sd);
+
+private:
+	typedef std::list<LLUUID> lru_list_t;
+
+	struct Entry
+	{
+		LLMeshHeader mHeader;
+		U32 mLLSDBytes;
+		lru_list_t::iterator mLRU;
+		bool mPinned;			// not in mLRU
+	};
+
+	static bool isPinned(const LLMeshHeader& header)	{ return header.m404 || header.mHeaderSize == 0; }
+	void evictOldest();
+
+	typedef boost::unordered_map<LLUUID, Entry> header_map_t;
+
+	header_map_t mHeaders;
+	lru_list_t mLRU;		// most recently used first
+	U32 mMaxHeaders;
+	U32 mNumEvicted;
+	U64 mLLSDBytes;
+};
+
+#endif // LL_LLMESHHEADERSTORE_H
@@ -39,6 +39,7 @@
 #include "llcallbacklist.h"
 #include "lldatapacker.h"
 #include "lldeadmantimer.h"
+#include "llfetchtrace.h"
 #include "llfloatermodelpreview.h"
 #include "llfloaterperms.h"
 #include "llimagej2c.h"
@@ -56,6 +57,7 @@
 #include "llviewermessage.h"
 #include "llviewerobjectlist.h"
 #include "llviewerregion.h"
+#include "llviewerstats.h"
 #include "llviewertexturelist.h"
 #include "llvolume.h"
 #include "llvolumemgr.h"
@@ -76,6 +78,7 @@
 #include "llinventorypanel.h"
 #include "lluploaddialog.h"
 #include "llfloaterreg.h"
+#include "lltracethreadrecorder.h"
 
 #include "boost/lexical_cast.hpp"
 
@@ -99,7 +102,7 @@
 //     locking actions.  In particular, the following operations
 //     on LLMeshRepository are very averse to any stalls:
 //     * loadMesh
-//     * search in mMeshHeader (For structural details, see:
+//     * search in mMeshHeaders (For structural details, see:
 //       http://wiki.secondlife.com/wiki/Mesh/Mesh_Asset_Format)
 //     * notifyLoadedMeshes
 //     * getSkinInfo
@@ -109,6 +112,8 @@
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
 //   decom    Worker thread for mesh decomposition requests
+//   decodeN  1-N LLMeshDecodePool threads unpacking LOD, skin info and
+//            decomposition data read by the repo thread
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
 //
@@ -138,7 +143,7 @@
 //                               data copied
 //                               headerReceived() invoked
 //                                 LLSD parsed
-//                                 mMeshHeader, mMeshHeaderSize updated
+//                                 mMeshHeaders updated
 //                                 scan mPendingLOD for LOD request
 //                                 push LODRequest to mLODReqQ
 //                             ...
@@ -148,9 +153,13 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
-//                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                               Request submitted to mDecodePool
+//                             ...
+//                                                 decode thread
+//                                                 lodReceived() invoked
+//                                                   unpack data into LLVolume
+//                                                   append LoadedMesh to mLoadedQ
+//                                                 data written to VFS
 //                             ...
 //         notifyLoadedMeshes() invoked again
 //           scan mLoadedQ
@@ -221,9 +230,12 @@
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
 //     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
-//     sCacheBytesWritten              "
-//     sCacheReads                     "
-//     sCacheWrites                    "
+//     sCacheBytesWritten              atomic          rw.repo.atomic, rw.decode.atomic, ro.main.atomic
+//     sCacheReads                     none            rw.repo.none, ro.main.none [1]
+//     sCacheWrites                    atomic          rw.repo.atomic, rw.decode.atomic, ro.main.atomic
+//     sHeaderCount                    LLMeshRepoThread::mHeaderMutex  wo.any.mHeaderMutex, ro.main.none [1]
+//     sHeaderBytes                    "
+//     sHeaderLLSDBytes                "
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -245,22 +257,27 @@
 //     sActiveHeaderRequests    mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sActiveLODRequests       mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
-//     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
-//     mMeshHeaderSize          mHeaderMutex  rw.repo.mHeaderMutex
+//     mMeshHeaders             mHeaderMutex  rw.any.mHeaderMutex (lookups reorder the LRU list)
+//     mHeaderReloadQ           mHeaderMutex  rw.any.mHeaderMutex, ro.repo.none [3]
 //     mSkinRequests            mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.decode.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mDecompositionQ          mMutex        rw.repo.mMutex, rw.decode.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], rw.decode.mMutex, ro.main.none [5], rw.main.mMutex
+//     mLoadedQ                 mMutex        rw.decode.mMutex, ro.main.none [5], rw.main.mMutex
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMeshVersion          mMutex        rw.main.mMutex, ro.repo.mMutex
 //     mHttp*                   none          rw.repo.none
+//     mDecodeTangents          none          wo.main.none (constructor), ro.decode.none
+//
+//   LLMeshDecodePool:
+//
+//     mRequestQ                mMutex        rw.repo.mMutex, rw.decode.mMutex
 //
 //   LLMeshUploadThread:
 //
@@ -384,10 +401,13 @@ U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
 U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
+LLAtomicU32 LLMeshRepository::sCacheBytesWritten(0);
 U32 LLMeshRepository::sCacheReads = 0;
-U32 LLMeshRepository::sCacheWrites = 0;
+LLAtomicU32 LLMeshRepository::sCacheWrites(0);
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
+U32 LLMeshRepository::sHeaderCount = 0;
+U32 LLMeshRepository::sHeaderBytes = 0;
+U32 LLMeshRepository::sHeaderLLSDBytes = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
 
@@ -593,7 +613,9 @@ protected:
 	
 public:
 	virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response);
-	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size) = 0;
+	// Handlers may take ownership of data, which was allocated with new[],
+	// by setting it to NULL.
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 *& data, S32 data_size) = 0;
 	virtual void processFailure(LLCore::HttpStatus status) = 0;
 	
 public:
@@ -625,7 +647,7 @@ protected:
 	void operator=(const LLMeshHeaderHandler &);				// Not defined
 	
 public:
-	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 *& data, S32 data_size);
 	virtual void processFailure(LLCore::HttpStatus status);
 };
 
@@ -651,7 +673,7 @@ protected:
 	void operator=(const LLMeshLODHandler &);					// Not defined
 	
 public:
-	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 *& data, S32 data_size);
 	virtual void processFailure(LLCore::HttpStatus status);
 
 public:
@@ -677,7 +699,7 @@ protected:
 	void operator=(const LLMeshSkinInfoHandler &);				// Not defined
 
 public:
-	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 *& data, S32 data_size);
 	virtual void processFailure(LLCore::HttpStatus status);
 
 public:
@@ -703,7 +725,7 @@ protected:
 	void operator=(const LLMeshDecompositionHandler &);					// Not defined
 
 public:
-	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 *& data, S32 data_size);
 	virtual void processFailure(LLCore::HttpStatus status);
 
 public:
@@ -729,7 +751,7 @@ protected:
 	void operator=(const LLMeshPhysicsShapeHandler &);				// Not defined
 
 public:
-	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 *& data, S32 data_size);
 	virtual void processFailure(LLCore::HttpStatus status);
 
 public:
@@ -818,15 +840,172 @@ void log_upload_error(LLCore::HttpStatus status, const LLSD& content,
 	gMeshRepo.uploadError(args);
 }
 
+LLTrace::SampleStatHandle<> LLMeshDecodePool::sQueueDepth("mesh_decode_queue_depth", "Mesh assets waiting for a decode thread");
+LLTrace::EventStatHandle<F64Milliseconds> LLMeshDecodePool::sQueueWait("mesh_decode_queue_wait", "Time mesh data waited for a decode thread");
+LLTrace::EventStatHandle<F64Milliseconds> LLMeshDecodePool::sInflateTime("mesh_decode_inflate_time", "Time spent inflating a mesh LOD");
+LLTrace::EventStatHandle<F64Milliseconds> LLMeshDecodePool::sParseTime("mesh_decode_parse_time", "Time spent unpacking the faces of a mesh LOD");
+LLTrace::EventStatHandle<F64Milliseconds> LLMeshDecodePool::sOptimizeTime("mesh_decode_optimize_time", "Time spent cache optimizing a mesh LOD");
+LLTrace::EventStatHandle<F64Milliseconds> LLMeshDecodePool::sTangentTime("mesh_decode_tangent_time", "Time spent generating the tangents of a mesh LOD");
+
+// Upper bound for the automatically chosen number of decode threads
+const U32 MAX_AUTO_MESH_DECODE_THREADS = 4;
+
+LLMeshDecodePool::Request::Request(EType type, const LLVolumeParams& mesh_params, S32 lod,
+								   U8* data, S32 data_size, S32 offset, S32 requested_bytes, bool from_cache)
+	: mType(type),
+	  mMeshParams(mesh_params),
+	  mLOD(lod),
+	  mData(data),
+	  mDataSize(data_size),
+	  mOffset(offset),
+	  mRequestedBytes(requested_bytes),
+	  mFromCache(from_cache)
+{
+}
+
+LLMeshDecodePool::Request::~Request()
+{
+	delete [] mData;
+}
+
+LLMeshDecodePool::Worker::Worker(const std::string& name, LLMeshDecodePool* pool)
+	: LLThread(name),
+	  mPool(pool)
+{
+	start();
+}
+
+// virtual
+bool LLMeshDecodePool::Worker::runCondition()
+{
+	return isQuitting() || mPool->hasRequests();
+}
+
+// virtual
+void LLMeshDecodePool::Worker::run()
+{
+	while (1)
+	{
+		checkPause();
+
+		if (isQuitting() || LLApp::isQuitting())
+		{
+			LLTrace::get_thread_recorder()->pushToParent();
+			break;
+		}
+
+		Request* request = mPool->popRequest();
+		if (request)
+		{
+			record(sQueueWait, F64Seconds(request->mQueuedTimer.getElapsedTimeF64()));
+			mPool->mOwner->decodeRequest(*request);
+			delete request;
+
+			// hand the decode stats to the main thread as they come in
+			LLTrace::get_thread_recorder()->pushToParent();
+		}
+	}
+}
+
+LLMeshDecodePool::LLMeshDecodePool(LLMeshRepoThread* owner, U32 num_threads)
+	: mOwner(owner)
+{
+	mMutex = new LLMutex();
+
+	if (num_threads == 0)
+	{
+		// Leave most cores to the main, texture and repo threads
+		num_threads = llclamp(std::thread::hardware_concurrency() / 4, 1U, MAX_AUTO_MESH_DECODE_THREADS);
+	}
+	for (U32 i = 0; i < num_threads; ++i)
+	{
+		mWorkers.push_back(new Worker(llformat("mesh decode %d", i), this));
+	}
+	LL_INFOS(LOG_MESH) << "Mesh decode running on " << getNumThreads() << " thread(s)" << LL_ENDL;
+}
+
+LLMeshDecodePool::~LLMeshDecodePool()
+{
+	shutdown();
+
+	while (!mRequestQ.empty())
+	{
+		delete mRequestQ.front();
+		mRequestQ.pop();
+	}
+	delete mMutex;
+	mMutex = NULL;
+}
+
+void LLMeshDecodePool::shutdown()
+{
+	for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+		Worker* worker = *iter;
+		worker->shutdown();
+		delete worker;
+	}
+	mWorkers.clear();
+}
+
+void LLMeshDecodePool::submitRequest(Request* request)
+{
+	S32 depth;
+	{
+		LLMutexLock lock(mMutex);
+		mRequestQ.push(request);
+		depth = mRequestQ.size();
+	}
+	sample(sQueueDepth, depth);
+
+	for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+		(*iter)->wake();
+	}
+}
+
+S32 LLMeshDecodePool::getQueueDepth()
+{
+	LLMutexLock lock(mMutex);
+	return mRequestQ.size();
+}
+
+bool LLMeshDecodePool::hasRequests()
+{
+	LLMutexLock lock(mMutex);
+	return !mRequestQ.empty();
+}
+
+LLMeshDecodePool::Request* LLMeshDecodePool::popRequest()
+{
+	Request* request = NULL;
+	S32 depth;
+	{
+		LLMutexLock lock(mMutex);
+		if (mRequestQ.empty())
+		{
+			return NULL;
+		}
+		request = mRequestQ.front();
+		mRequestQ.pop();
+		depth = mRequestQ.size();
+	}
+	sample(sQueueDepth, depth);
+	return request;
+}
+
 LLMeshRepoThread::LLMeshRepoThread()
 : LLThread("mesh repo"),
+  mMeshHeaders(gSavedSettings.getU32("MeshMaxHeaders")),
   mHttpRequest(NULL),
   mHttpOptions(),
   mHttpLargeOptions(),
   mHttpHeaders(),
   mHttpPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
-  mHttpPriority(0)
+  mHttpPriority(0),
+  mDecodePool(NULL),
+  mDecodeTangents(gSavedSettings.getBOOL("MeshDecodeTangents"))
 {
 	LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
 
@@ -844,6 +1023,7 @@ LLMeshRepoThread::LLMeshRepoThread()
 	mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_VND_LL_MESH);
 	mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
 	mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+	mDecodePool = new LLMeshDecodePool(this, gSavedSettings.getU32("MeshDecodeThreads"));
 }
 
 
@@ -853,6 +1033,16 @@ LLMeshRepoThread::~LLMeshRepoThread()
 					   << ", Large GETs issued:  " << LLMeshRepository::sHTTPLargeRequestCount
 					   << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
 					   << LL_ENDL;
+	LL_INFOS(LOG_MESH) << "Mesh headers:  " << mMeshHeaders.getNumHeaders()
+					   << ", Pinned:  " << mMeshHeaders.getNumPinned()
+					   << ", Dropped:  " << mMeshHeaders.getNumEvicted()
+					   << ", Bytes:  " << mMeshHeaders.getBytes()
+					   << ", Bytes as LLSD:  " << mMeshHeaders.getLLSDBytes()
+					   << LL_ENDL;
+
+	// Decode threads push into our queues, stop them first
+	delete mDecodePool;
+	mDecodePool = NULL;
 
 	mHttpRequestSet.clear();
     mHttpHeaders.reset();
@@ -935,7 +1125,7 @@ void LLMeshRepoThread::run()
                     // failed to load before, wait a bit
                     incomplete.push_front(req);
                 }
-                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry()))
+                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry(), req.mSkipCache))
                 {
                     if (req.canRetry())
                     {
@@ -1007,6 +1197,21 @@ void LLMeshRepoThread::run()
             }
         }
 
+        // Headers dropped from mMeshHeaders that queries asked for again,
+        // read back from the VFS, no network involved
+        if (!mHeaderReloadQ.empty())
+        {
+            std::set<LLUUID> reload;
+            {
+                LLMutexLock locker(mHeaderMutex);
+                reload.swap(mHeaderReloadQ);
+            }
+            for (std::set<LLUUID>::iterator iter = reload.begin(); iter != reload.end(); ++iter)
+            {
+                reloadMeshHeader(*iter);
+            }
+        }
+
         // For the final three request lists, similar goal to above but
         // slightly different queue structures.  Stay off the mutex when
         // performing long-duration actions.
@@ -1131,6 +1336,9 @@ void LLMeshRepoThread::run()
             }
         }
 
+		// hand the decode queue depth and decoded cache hit rate to the main thread
+		LLTrace::get_thread_recorder()->pushToParent();
+
 		// For dev purposes only.  A dynamic change could make this false
 		// and that shouldn't assert.
 		// llassert_always(mHttpRequestSet.size() <= sRequestHighWater);
@@ -1178,8 +1386,12 @@ void LLMeshRepoThread::lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32
 void LLMeshRepoThread::loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 { //could be called from any thread
 	LLMutexLock lock(mMutex);
-	mesh_header_map::iterator iter = mMeshHeader.find(mesh_params.getSculptID());
-	if (iter != mMeshHeader.end())
+	bool has_header = false;
+	{
+		LLMutexLock header_lock(mHeaderMutex);
+		has_header = mMeshHeaders.find(mesh_params.getSculptID()) != NULL;
+	}
+	if (has_header)
 	{ //if we have the header, request LOD byte range
 		LODRequest req(mesh_params, lod);
 		{
@@ -1250,7 +1462,7 @@ void LLMeshRepoThread::constructUrl(LLUUID mesh_id, std::string * url)
 }
 
 // Issue an HTTP GET request with byte range using the right
-// policy class.  
+// policy class.  mesh_id is only used for the fetch trace.
 //
 // @return		Valid handle or LLCORE_HTTP_HANDLE_INVALID.
 //				If the latter, actual status is found in
@@ -1258,7 +1470,7 @@ void LLMeshRepoThread::constructUrl(LLUUID mesh_id, std::string * url)
 //				next call to this method.
 //
 // Thread:  repo
-LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url,
+LLCore::HttpHandle LLMeshRepoThread::getByteRange(const LLUUID & mesh_id, const std::string & url,
 												  size_t offset, size_t len,
 												  const LLCore::HttpHandler::ptr_t &handler)
 {
@@ -1302,6 +1514,10 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url,
 		// Something went wrong, capture the error code for caller.
 		mHttpStatus = mHttpRequest->getStatus();
 	}
+	else
+	{
+		LLFetchTrace::recordGet(handle, LLFetchTrace::MESH, mesh_id, offset, len, mHttpPriority);
+	}
 	return handle;
 }
 
@@ -1314,9 +1530,13 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 		return false;
 	}
 
+	//the header may have been dropped since the request was made
+	reloadMeshHeader(mesh_id);
+
 	mHeaderMutex->lock();
 
-	if (mMeshHeader.find(mesh_id) == mMeshHeader.end())
+	LLMeshHeader* header = mMeshHeaders.find(mesh_id);
+	if (!header)
 	{ //we have no header info for this mesh, do nothing
 		mHeaderMutex->unlock();
 		return false;
@@ -1324,13 +1544,13 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 
 	++LLMeshRepository::sMeshRequestCount;
 	bool ret = true;
-	U32 header_size = mMeshHeaderSize[mesh_id];
+	U32 header_size = header->mHeaderSize;
 	
 	if (header_size > 0)
 	{
-		S32 version = mMeshHeader[mesh_id]["version"].asInteger();
-		S32 offset = header_size + mMeshHeader[mesh_id]["skin"]["offset"].asInteger();
-		S32 size = mMeshHeader[mesh_id]["skin"]["size"].asInteger();
+		S32 version = header->mVersion;
+		S32 offset = header->getAssetOffset(LLMeshHeader::SKIN);
+		S32 size = header->mSize[LLMeshHeader::SKIN];
 
 		mHeaderMutex->unlock();
 
@@ -1377,7 +1597,7 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 			if (!http_url.empty())
 			{
                 LLMeshHandlerBase::ptr_t handler(new LLMeshSkinInfoHandler(mesh_id, offset, size));
-				LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
+				LLCore::HttpHandle handle = getByteRange(mesh_id, http_url, offset, size, handler);
 				if (LLCORE_HTTP_HANDLE_INVALID == handle)
 				{
 					LL_WARNS(LOG_MESH) << "HTTP GET request failed for skin info on mesh " << mID
@@ -1410,23 +1630,27 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
 		return false;
 	}
 
+	//the header may have been dropped since the request was made
+	reloadMeshHeader(mesh_id);
+
 	mHeaderMutex->lock();
 
-	if (mMeshHeader.find(mesh_id) == mMeshHeader.end())
+	LLMeshHeader* header = mMeshHeaders.find(mesh_id);
+	if (!header)
 	{ //we have no header info for this mesh, do nothing
 		mHeaderMutex->unlock();
 		return false;
 	}
 
 	++LLMeshRepository::sMeshRequestCount;
-	U32 header_size = mMeshHeaderSize[mesh_id];
+	U32 header_size = header->mHeaderSize;
 	bool ret = true;
 	
 	if (header_size > 0)
 	{
-		S32 version = mMeshHeader[mesh_id]["version"].asInteger();
-		S32 offset = header_size + mMeshHeader[mesh_id]["physics_convex"]["offset"].asInteger();
-		S32 size = mMeshHeader[mesh_id]["physics_convex"]["size"].asInteger();
+		S32 version = header->mVersion;
+		S32 offset = header->getAssetOffset(LLMeshHeader::PHYSICS_CONVEX);
+		S32 size = header->mSize[LLMeshHeader::PHYSICS_CONVEX];
 
 		mHeaderMutex->unlock();
 
@@ -1474,7 +1698,7 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
 			if (!http_url.empty())
 			{
                 LLMeshHandlerBase::ptr_t handler(new LLMeshDecompositionHandler(mesh_id, offset, size));
-				LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
+				LLCore::HttpHandle handle = getByteRange(mesh_id, http_url, offset, size, handler);
 				if (LLCORE_HTTP_HANDLE_INVALID == handle)
 				{
 					LL_WARNS(LOG_MESH) << "HTTP GET request failed for decomposition mesh " << mID
@@ -1507,23 +1731,27 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 		return false;
 	}
 
+	//the header may have been dropped since the request was made
+	reloadMeshHeader(mesh_id);
+
 	mHeaderMutex->lock();
 
-	if (mMeshHeader.find(mesh_id) == mMeshHeader.end())
+	LLMeshHeader* header = mMeshHeaders.find(mesh_id);
+	if (!header)
 	{ //we have no header info for this mesh, do nothing
 		mHeaderMutex->unlock();
 		return false;
 	}
 
 	++LLMeshRepository::sMeshRequestCount;
-	U32 header_size = mMeshHeaderSize[mesh_id];
+	U32 header_size = header->mHeaderSize;
 	bool ret = true;
 
 	if (header_size > 0)
 	{
-		S32 version = mMeshHeader[mesh_id]["version"].asInteger();
-		S32 offset = header_size + mMeshHeader[mesh_id]["physics_mesh"]["offset"].asInteger();
-		S32 size = mMeshHeader[mesh_id]["physics_mesh"]["size"].asInteger();
+		S32 version = header->mVersion;
+		S32 offset = header->getAssetOffset(LLMeshHeader::PHYSICS_MESH);
+		S32 size = header->mSize[LLMeshHeader::PHYSICS_MESH];
 
 		mHeaderMutex->unlock();
 
@@ -1570,7 +1798,7 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 			if (!http_url.empty())
 			{
                 LLMeshHandlerBase::ptr_t handler(new LLMeshPhysicsShapeHandler(mesh_id, offset, size));
-				LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
+				LLCore::HttpHandle handle = getByteRange(mesh_id, http_url, offset, size, handler);
 				if (LLCORE_HTTP_HANDLE_INVALID == handle)
 				{
 					LL_WARNS(LOG_MESH) << "HTTP GET request failed for physics shape on mesh " << mID
@@ -1633,26 +1861,10 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 {
 	++LLMeshRepository::sMeshRequestCount;
 
+	if (loadMeshHeaderFromCache(mesh_params))
 	{
-		//look for mesh in asset in vfs
-		LLVFile file(gVFS, mesh_params.getSculptID(), LLAssetType::AT_MESH);
-			
-		S32 size = file.getSize();
-
-		if (size > 0)
-		{
-			// *NOTE:  if the header size is ever more than 4KB, this will break
-			U8 buffer[MESH_HEADER_SIZE];
-			S32 bytes = llmin(size, MESH_HEADER_SIZE);
-			LLMeshRepository::sCacheBytesRead += bytes;	
-			++LLMeshRepository::sCacheReads;
-			file.read(buffer, bytes);
-			if (headerReceived(mesh_params, buffer, bytes) == MESH_OK)
-			{
-				// Found mesh in VFS cache
-				return true;
-			}
-		}
+		// Found mesh in VFS cache
+		return true;
 	}
 
 	//either cache entry doesn't exist or is corrupt, request header from simulator	
@@ -1667,7 +1879,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 		//NOTE -- this will break of headers ever exceed 4KB		
 
         LLMeshHandlerBase::ptr_t handler(new LLMeshHeaderHandler(mesh_params, 0, MESH_HEADER_SIZE));
-		LLCore::HttpHandle handle = getByteRange(http_url, 0, MESH_HEADER_SIZE, handler);
+		LLCore::HttpHandle handle = getByteRange(mesh_params.getSculptID(), http_url, 0, MESH_HEADER_SIZE, handler);
 		if (LLCORE_HTTP_HANDLE_INVALID == handle)
 		{
 			LL_WARNS(LOG_MESH) << "HTTP GET request failed for mesh header " << mID
@@ -1686,36 +1898,127 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 	return retval;
 }
 
+bool LLMeshRepoThread::loadMeshHeaderFromCache(const LLVolumeParams& mesh_params)
+{
+	//look for mesh in asset in vfs
+	LLVFile file(gVFS, mesh_params.getSculptID(), LLAssetType::AT_MESH);
+		
+	S32 size = file.getSize();
+
+	if (size > 0)
+	{
+		// *NOTE:  if the header size is ever more than 4KB, this will break
+		U8 buffer[MESH_HEADER_SIZE];
+		S32 bytes = llmin(size, MESH_HEADER_SIZE);
+		LLMeshRepository::sCacheBytesRead += bytes;	
+		++LLMeshRepository::sCacheReads;
+		file.read(buffer, bytes);
+		return headerReceived(mesh_params, buffer, bytes) == MESH_OK;
+	}
+
+	return false;
+}
+
+bool LLMeshRepoThread::reloadMeshHeader(const LLUUID& mesh_id)
+{
+	{
+		LLMutexLock lock(mHeaderMutex);
+		if (mMeshHeaders.find(mesh_id))
+		{
+			return true;
+		}
+		if (!mayHaveDroppedHeader(mesh_id))
+		{
+			return false;
+		}
+	}
+
+	// Only the id matters to the header, pending LOD requests are keyed by
+	// the full volume params and are not looked for here
+	LLVolumeParams mesh_params;
+	mesh_params.setSculptID(mesh_id, LL_SCULPT_TYPE_MESH);
+	// Gone from the VFS as well and the next request for it goes to the sim
+	return loadMeshHeaderFromCache(mesh_params);
+}
+
+bool LLMeshRepoThread::mayHaveDroppedHeader(const LLUUID& mesh_id)
+{
+	// Headers only leave the store once it is full, and every header that
+	// could have been dropped came from or went to a mesh asset in the VFS
+	return mMeshHeaders.getNumEvicted() > 0 && gVFS->getExists(mesh_id, LLAssetType::AT_MESH);
+}
+
+void LLMeshRepoThread::updateHeaderStats()
+{
+	LLMeshRepository::sHeaderCount = mMeshHeaders.getNumHeaders();
+	LLMeshRepository::sHeaderBytes = (U32)llmin(mMeshHeaders.getBytes(), (U64)U32_MAX);
+	LLMeshRepository::sHeaderLLSDBytes = (U32)llmin(mMeshHeaders.getLLSDBytes(), (U64)U32_MAX);
+}
+
+LLMeshHeader* LLMeshRepoThread::findHeader(const LLUUID& mesh_id)
+{
+	LLMeshHeader* header = mMeshHeaders.find(mesh_id);
+	if (!header && mayHaveDroppedHeader(mesh_id))
+	{
+		mHeaderReloadQ.insert(mesh_id);
+	}
+	return header;
+}
+
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry, bool skip_cache)
 {
 	if (!mHeaderMutex)
 	{
 		return false;
 	}
 
+	LLUUID mesh_id = mesh_params.getSculptID();
+
+	//the header may have been dropped since the request was made
+	reloadMeshHeader(mesh_id);
+
 	mHeaderMutex->lock();
 
+	LLMeshHeader* header = mMeshHeaders.find(mesh_id);
+	if (!header)
+	{ //not cached either, request it again along with the LOD
+		mHeaderMutex->unlock();
+		loadMeshLOD(mesh_params, lod);
+		return true;
+	}
+
 	++LLMeshRepository::sMeshRequestCount;
 	bool retval = true;
 
-	LLUUID mesh_id = mesh_params.getSculptID();
-	
-	U32 header_size = mMeshHeaderSize[mesh_id];
+	U32 header_size = header->mHeaderSize;
 
 	if (header_size > 0)
 	{
-		S32 version = mMeshHeader[mesh_id]["version"].asInteger();
-		S32 offset = header_size + mMeshHeader[mesh_id][header_lod[lod]]["offset"].asInteger();
-		S32 size = mMeshHeader[mesh_id][header_lod[lod]]["size"].asInteger();
+		S32 version = header->mVersion;
+		S32 offset = header->getAssetOffset(lod);
+		S32 size = header->mSize[lod];
 		mHeaderMutex->unlock();
 				
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
 		{
+			if (!skip_cache && gMeshRepo.mDecodedCache.isEnabled())
+			{
+				// Already unpacked in an earlier session?
+				bool hit = gMeshRepo.mDecodedCache.has(mesh_id, lod, mesh_params.getSculptType());
+				record(LLStatViewer::MESH_DECODED_CACHE_HIT_RATE, LLUnits::Ratio::fromValue(hit ? 1 : 0));
+				if (hit)
+				{
+					mDecodePool->submitRequest(
+						new LLMeshDecodePool::Request(LLMeshDecodePool::Request::DECODED_LOD, mesh_params, lod,
+													  NULL, 0, offset, size, true));
+					return true;
+				}
+			}
 
 			//check VFS for mesh asset
 			LLVFile file(gVFS, mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			if (!skip_cache && file.getSize() >= offset+size)
 			{
 				U8* buffer = new(std::nothrow) U8[size];
 				if (!buffer)
@@ -1738,12 +2041,11 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				}
 
 				if (!zero)
-				{ //attempt to parse
-					if (lodReceived(mesh_params, lod, buffer, size) == MESH_OK)
-					{
-						delete[] buffer;
-						return true;
-					}
+				{ //attempt to parse, the decode pool goes to the sim if that fails
+					mDecodePool->submitRequest(
+						new LLMeshDecodePool::Request(LLMeshDecodePool::Request::LOD, mesh_params, lod,
+													  buffer, size, offset, size, true));
+					return true;
 				}
 
 				delete[] buffer;
@@ -1756,7 +2058,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 			if (!http_url.empty())
 			{
                 LLMeshHandlerBase::ptr_t handler(new LLMeshLODHandler(mesh_params, lod, offset, size));
-				LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
+				LLCore::HttpHandle handle = getByteRange(mesh_id, http_url, offset, size, handler);
 				if (LLCORE_HTTP_HANDLE_INVALID == handle)
 				{
 					LL_WARNS(LOG_MESH) << "HTTP GET request failed for LOD on mesh " << mID
@@ -1858,9 +2160,13 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 	{
 		
 		{
+			LLMeshHeader mesh_header;
+			mesh_header.init(header, header_size);
+			U32 llsd_bytes = LLMeshHeaderStore::getLLSDFootprint(header);
+
 			LLMutexLock lock(mHeaderMutex);
-			mMeshHeaderSize[mesh_id] = header_size;
-			mMeshHeader[mesh_id] = header;
+			mMeshHeaders.store(mesh_id, mesh_header, llsd_bytes);
+			updateHeaderStats();
 		}
 
 		
@@ -1907,17 +2213,8 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	{
 		if (volume->getNumFaces() > 0)
 		{
-			LoadedMesh mesh(volume, mesh_params, lod);
-			{
-				LLMutexLock lock(mMutex);
-				mLoadedQ.push(mesh);
-				// LLPointer is not thread safe, since we added this pointer into
-				// threaded list, make sure counter gets decreased inside mutex lock
-				// and won't affect mLoadedQ processing
-				volume = NULL;
-				// might be good idea to turn mesh into pointer to avoid making a copy
-				mesh.mVolume = NULL;
-			}
+			gMeshRepo.mDecodedCache.store(mesh_params.getSculptID(), lod, volume);
+			queueLoadedMesh(volume, mesh_params, lod);
 			return MESH_OK;
 		}
 	}
@@ -1925,6 +2222,54 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	return MESH_UNKNOWN;
 }
 
+bool LLMeshRepoThread::decodedLODReceived(const LLVolumeParams& mesh_params, S32 lod)
+{
+	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+	if (gMeshRepo.mDecodedCache.load(mesh_params.getSculptID(), lod, volume) && volume->getNumFaces() > 0)
+	{
+		queueLoadedMesh(volume, mesh_params, lod);
+		return true;
+	}
+	return false;
+}
+
+void LLMeshRepoThread::queueLoadedMesh(LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, S32 lod)
+{
+	if (mDecodeTangents)
+	{
+		// Each decode thread has its own tangent scratch, and the faces go
+		// to the main thread with their tangents in copyVolumeFaces()
+		LLTimer timer;
+		bool generated = false;
+		for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+		{
+			LLVolumeFace& face = volume->getVolumeFace(i);
+			if (!face.mTangents)
+			{
+				face.createTangents();
+				generated = true;
+			}
+		}
+		if (generated)
+		{
+			// recorded on a decode thread, pushed by LLMeshDecodePool::Worker::run()
+			record(LLMeshDecodePool::sTangentTime, F64Seconds(timer.getElapsedTimeF64()));
+		}
+	}
+
+	LoadedMesh mesh(volume, mesh_params, lod);
+	{
+		LLMutexLock lock(mMutex);
+		mLoadedQ.push(mesh);
+		// LLPointer is not thread safe, since we added this pointer into
+		// threaded list, make sure counter gets decreased inside mutex lock
+		// and won't affect mLoadedQ processing
+		volume = NULL;
+		// might be good idea to turn mesh into pointer to avoid making a copy
+		mesh.mVolume = NULL;
+	}
+}
+
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD skin;
@@ -2076,6 +2421,99 @@ EMeshProcessingResult LLMeshRepoThread::physicsShapeReceived(const LLUUID& mesh_
 	return MESH_OK;
 }
 
+void LLMeshRepoThread::decodeRequest(const LLMeshDecodePool::Request& request)
+{
+	const LLUUID mesh_id = request.mMeshParams.getSculptID();
+	bool success = false;
+
+	switch (request.mType)
+	{
+	case LLMeshDecodePool::Request::LOD:
+		{
+			EMeshProcessingResult result = lodReceived(request.mMeshParams, request.mLOD, request.mData, request.mDataSize);
+			success = (result == MESH_OK);
+			if (success)
+			{
+				const LLVolume::UnpackTimes& times = LLVolume::getLastUnpackTimes();
+				record(LLMeshDecodePool::sInflateTime, F64Seconds(times.mInflate));
+				record(LLMeshDecodePool::sParseTime, F64Seconds(times.mParse));
+				record(LLMeshDecodePool::sOptimizeTime, F64Seconds(times.mOptimize));
+			}
+			else if (request.mFromCache)
+			{
+				// Cached copy didn't decode, fetch it from the sim instead
+				LODRequest req(request.mMeshParams, request.mLOD);
+				req.mSkipCache = true;
+				LLMutexLock lock(mMutex);
+				mLODReqQ.push(req);
+				++LLMeshRepository::sLODProcessing;
+			}
+			else
+			{
+				LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_id
+								   << ", Reason: " << result
+								   << " LOD: " << request.mLOD
+								   << " Data size: " << request.mDataSize
+								   << " Not retrying."
+								   << LL_ENDL;
+				LLMutexLock lock(mMutex);
+				mUnavailableQ.push(LODRequest(request.mMeshParams, request.mLOD));
+			}
+		}
+		break;
+
+	case LLMeshDecodePool::Request::DECODED_LOD:
+		success = decodedLODReceived(request.mMeshParams, request.mLOD);
+		if (!success)
+		{
+			// Bad entries are dropped from the cache, so this goes to the VFS
+			LLMutexLock lock(mMutex);
+			mLODReqQ.push(LODRequest(request.mMeshParams, request.mLOD));
+			++LLMeshRepository::sLODProcessing;
+		}
+		break;
+
+	case LLMeshDecodePool::Request::SKIN_INFO:
+		success = skinInfoReceived(mesh_id, request.mData, request.mDataSize);
+		if (!success)
+		{
+			LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+							   << ", Unknown reason.  Not retrying."
+							   << LL_ENDL;
+			// *TODO:  Mark mesh unavailable on error
+		}
+		break;
+
+	case LLMeshDecodePool::Request::DECOMPOSITION:
+		success = decompositionReceived(mesh_id, request.mData, request.mDataSize);
+		if (!success)
+		{
+			LL_WARNS(LOG_MESH) << "Error during mesh decomposition processing.  ID:  " << mesh_id
+							   << ", Unknown reason.  Not retrying."
+							   << LL_ENDL;
+			// *TODO:  Mark mesh unavailable on error
+		}
+		break;
+	}
+
+	if (success && !request.mFromCache)
+	{
+		// good fetch from sim, write to VFS for caching
+		LLVFile file(gVFS, mesh_id, LLAssetType::AT_MESH, LLVFile::WRITE);
+
+		S32 offset = request.mOffset;
+		S32 size = request.mRequestedBytes;
+
+		if (file.getSize() >= offset+size)
+		{
+			LLMeshRepository::sCacheBytesWritten += size;
+			++LLMeshRepository::sCacheWrites;
+			file.seek(offset);
+			file.write(request.mData, size);
+		}
+	}
+}
+
 LLMeshUploadThread::LLMeshUploadThread(LLMeshUploadThread::instance_list& data, LLVector3& scale, bool upload_textures,
 									   bool upload_skin, bool upload_joints, bool lock_scale_if_joint_position,
                                        const std::string & upload_url, bool do_upload,
@@ -2946,13 +3384,11 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 S32 LLMeshRepoThread::getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod) 
 { //only ever called from main thread
 	LLMutexLock lock(mHeaderMutex);
-	mesh_header_map::iterator iter = mMeshHeader.find(mesh_params.getSculptID());
+	LLMeshHeader* header = findHeader(mesh_params.getSculptID());
 
-	if (iter != mMeshHeader.end())
+	if (header)
 	{
-		LLSD& header = iter->second;
-
-		return LLMeshRepository::getActualMeshLOD(header, lod);
+		return LLMeshRepository::getActualMeshLOD(*header, lod);
 	}
 
 	return lod;
@@ -3003,9 +3439,53 @@ S32 LLMeshRepository::getActualMeshLOD(LLSD& header, S32 lod)
 	return -1;
 }
 
+//static
+S32 LLMeshRepository::getActualMeshLOD(LLMeshHeader& header, S32 lod)
+{
+	lod = llclamp(lod, 0, 3);
+
+	if (header.m404 || header.mVersion > MAX_MESH_VERSION)
+	{
+		return -1;
+	}
+
+	if (header.mSize[lod] > 0)
+	{
+		return lod;
+	}
+
+	//search down to find the next available lower lod
+	for (S32 i = lod-1; i >= 0; --i)
+	{
+		if (header.mSize[i] > 0)
+		{
+			return i;
+		}
+	}
+
+	//search up to find then ext available higher lod
+	for (S32 i = lod+1; i < 4; ++i)
+	{
+		if (header.mSize[i] > 0)
+		{
+			return i;
+		}
+	}
+
+	//header exists and no good lod found, treat as 404
+	header.m404 = true;
+	return -1;
+}
+
 void LLMeshRepository::cacheOutgoingMesh(LLMeshUploadData& data, LLSD& header)
 {
-	mThread->mMeshHeader[data.mUUID] = header;
+	LLMeshHeader mesh_header;
+	mesh_header.init(header, 0);
+	{
+		LLMutexLock lock(mThread->mHeaderMutex);
+		mThread->mMeshHeaders.store(data.mUUID, mesh_header, LLMeshHeaderStore::getLLSDFootprint(header));
+		mThread->updateHeaderStats();
+	}
 
 	// we cache the mesh for default parameters
 	LLVolumeParams volume_params;
@@ -3038,6 +3518,7 @@ void LLMeshRepository::cacheOutgoingMesh(LLMeshUploadData& data, LLSD& header)
 void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response)
 {
 	mProcessed = true;
+	LLFetchTrace::recordDone(handle, response);
 
 	unsigned int retries(0U);
 	response->getRetries(NULL, &retries);
@@ -3179,7 +3660,7 @@ void LLMeshHeaderHandler::processFailure(LLCore::HttpStatus status)
 }
 
 void LLMeshHeaderHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-									  U8 * data, S32 data_size)
+									  U8 *& data, S32 data_size)
 {
 	LLUUID mesh_id = mMeshParams.getSculptID();
     bool success = (!MESH_HEADER_PROCESS_FAILED)
@@ -3210,38 +3691,32 @@ void LLMeshHeaderHandler::processData(LLCore::BufferArray * /* body */, S32 /* b
 	{
 		// header was successfully retrieved from sim and parsed, cache in vfs
 		S32 header_bytes = 0;
-		LLSD header;
+		LLMeshHeader header;
 
 		gMeshRepo.mThread->mHeaderMutex->lock();
-		LLMeshRepoThread::mesh_header_map::iterator iter = gMeshRepo.mThread->mMeshHeader.find(mesh_id);
-		if (iter != gMeshRepo.mThread->mMeshHeader.end())
+		LLMeshHeader* stored_header = gMeshRepo.mThread->mMeshHeaders.find(mesh_id);
+		if (stored_header)
 		{
-			header_bytes = (S32)gMeshRepo.mThread->mMeshHeaderSize[mesh_id];
-			header = iter->second;
+			header_bytes = (S32)stored_header->mHeaderSize;
+			header = *stored_header;
 		}
+		gMeshRepo.mThread->mHeaderMutex->unlock();
 
 		if (header_bytes > 0
-			&& !header.has("404")
-			&& (!header.has("version") || header["version"].asInteger() <= MAX_MESH_VERSION))
+			&& !header.m404
+			&& header.mVersion <= MAX_MESH_VERSION)
 		{
-			std::stringstream str;
-
 			S32 lod_bytes = 0;
 
 			for (U32 i = 0; i < LLModel::LOD_PHYSICS; ++i)
 			{
 				// figure out how many bytes we'll need to reserve in the file
-				const std::string & lod_name = header_lod[i];
-				lod_bytes = llmax(lod_bytes, header[lod_name]["offset"].asInteger()+header[lod_name]["size"].asInteger());
+				lod_bytes = llmax(lod_bytes, header.mOffset[i] + header.mSize[i]);
 			}
 		
 			// just in case skin info or decomposition is at the end of the file (which it shouldn't be)
-			lod_bytes = llmax(lod_bytes, header["skin"]["offset"].asInteger() + header["skin"]["size"].asInteger());
-			lod_bytes = llmax(lod_bytes, header["physics_convex"]["offset"].asInteger() + header["physics_convex"]["size"].asInteger());
-
-            // Do not unlock mutex untill we are done with LLSD.
-            // LLSD is smart and can work like smart pointer, is not thread safe.
-            gMeshRepo.mThread->mHeaderMutex->unlock();
+			lod_bytes = llmax(lod_bytes, header.mOffset[LLMeshHeader::SKIN] + header.mSize[LLMeshHeader::SKIN]);
+			lod_bytes = llmax(lod_bytes, header.mOffset[LLMeshHeader::PHYSICS_CONVEX] + header.mSize[LLMeshHeader::PHYSICS_CONVEX]);
 
 			S32 bytes = lod_bytes + header_bytes; 
 
@@ -3278,8 +3753,6 @@ void LLMeshHeaderHandler::processData(LLCore::BufferArray * /* body */, S32 /* b
 		{
 			LL_WARNS(LOG_MESH) << "Trying to cache nonexistent mesh, mesh id: " << mesh_id << LL_ENDL;
 
-			gMeshRepo.mThread->mHeaderMutex->unlock();
-
 			// headerReceived() parsed header, but header's data is invalid so none of the LODs will be available
 			LLMutexLock lock(gMeshRepo.mThread->mMutex);
 			for (int i(0); i < 4; ++i)
@@ -3315,39 +3788,16 @@ void LLMeshLODHandler::processFailure(LLCore::HttpStatus status)
 }
 
 void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-								   U8 * data, S32 data_size)
+								   U8 *& data, S32 data_size)
 {
 	if ((!MESH_LOD_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
-		if (result == MESH_OK)
-		{
-			// good fetch from sim, write to VFS for caching
-			LLVFile file(gVFS, mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
-
-			S32 offset = mOffset;
-			S32 size = mRequestedBytes;
-
-			if (file.getSize() >= offset+size)
-			{
-				file.seek(offset);
-				file.write(data, size);
-				LLMeshRepository::sCacheBytesWritten += size;
-				++LLMeshRepository::sCacheWrites;
-			}
-		}
-		else
-		{
-			LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mMeshParams.getSculptID()
-							   << ", Reason: " << result
-							   << " LOD: " << mLOD
-							   << " Data size: " << data_size
-							   << " Not retrying."
-							   << LL_ENDL;
-			LLMutexLock lock(gMeshRepo.mThread->mMutex);
-			gMeshRepo.mThread->mUnavailableQ.push(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
-		}
+		// Unpacked and written to the VFS by the decode pool, see LLMeshRepoThread::decodeRequest()
+		gMeshRepo.mThread->mDecodePool->submitRequest(
+			new LLMeshDecodePool::Request(LLMeshDecodePool::Request::LOD, mMeshParams, mLOD,
+										  data, data_size, mOffset, mRequestedBytes, false));
+		data = NULL;
 	}
 	else
 	{
@@ -3381,25 +3831,17 @@ void LLMeshSkinInfoHandler::processFailure(LLCore::HttpStatus status)
 }
 
 void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-										U8 * data, S32 data_size)
+										U8 *& data, S32 data_size)
 {
 	if ((!MESH_SKIN_INFO_PROCESS_FAILED)
-		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-		&& gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
+		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		// good fetch from sim, write to VFS for caching
-		LLVFile file(gVFS, mMeshID, LLAssetType::AT_MESH, LLVFile::WRITE);
-
-		S32 offset = mOffset;
-		S32 size = mRequestedBytes;
-
-		if (file.getSize() >= offset+size)
-		{
-			LLMeshRepository::sCacheBytesWritten += size;
-			++LLMeshRepository::sCacheWrites;
-			file.seek(offset);
-			file.write(data, size);
-		}
+		LLVolumeParams mesh_params;
+		mesh_params.setSculptID(mMeshID, LL_SCULPT_TYPE_MESH);
+		gMeshRepo.mThread->mDecodePool->submitRequest(
+			new LLMeshDecodePool::Request(LLMeshDecodePool::Request::SKIN_INFO, mesh_params, 0,
+										  data, data_size, mOffset, mRequestedBytes, false));
+		data = NULL;
 	}
 	else
 	{
@@ -3429,25 +3871,17 @@ void LLMeshDecompositionHandler::processFailure(LLCore::HttpStatus status)
 }
 
 void LLMeshDecompositionHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-											 U8 * data, S32 data_size)
+											 U8 *& data, S32 data_size)
 {
 	if ((!MESH_DECOMP_PROCESS_FAILED)
-		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-		&& gMeshRepo.mThread->decompositionReceived(mMeshID, data, data_size))
+		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		// good fetch from sim, write to VFS for caching
-		LLVFile file(gVFS, mMeshID, LLAssetType::AT_MESH, LLVFile::WRITE);
-
-		S32 offset = mOffset;
-		S32 size = mRequestedBytes;
-
-		if (file.getSize() >= offset+size)
-		{
-			LLMeshRepository::sCacheBytesWritten += size;
-			++LLMeshRepository::sCacheWrites;
-			file.seek(offset);
-			file.write(data, size);
-		}
+		LLVolumeParams mesh_params;
+		mesh_params.setSculptID(mMeshID, LL_SCULPT_TYPE_MESH);
+		gMeshRepo.mThread->mDecodePool->submitRequest(
+			new LLMeshDecodePool::Request(LLMeshDecodePool::Request::DECOMPOSITION, mesh_params, 0,
+										  data, data_size, mOffset, mRequestedBytes, false));
+		data = NULL;
 	}
 	else
 	{
@@ -3476,7 +3910,7 @@ void LLMeshPhysicsShapeHandler::processFailure(LLCore::HttpStatus status)
 }
 
 void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-											U8 * data, S32 data_size)
+											U8 *& data, S32 data_size)
 {
 	if ((!MESH_PHYS_SHAPE_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
@@ -3535,6 +3969,12 @@ void LLMeshRepository::init()
 
 	metrics_teleport_started_signal = LLViewerMessage::getInstance()->setTeleportStartedCallback(teleport_started);
 	
+	if (gSavedSettings.getBOOL("MeshDecodedCacheEnabled"))
+	{
+		U64 max_size = (U64)gSavedSettings.getU32("MeshDecodedCacheSize") * 1024 * 1024;
+		mDecodedCache.initCache(LL_PATH_CACHE, max_size, LLAppViewer::instance()->isSecondInstance());
+	}
+
 	mThread = new LLMeshRepoThread();
 	mThread->start();
 }
@@ -3638,6 +4078,7 @@ S32 LLMeshRepository::loadMesh(LLVOVolume* vobj, const LLVolumeParams& mesh_para
 			mLoadingMeshes[detail][mesh_params].insert(vobj->getID());
 			mPendingRequests.push_back(LLMeshRepoThread::LODRequest(mesh_params, detail));
 			LLMeshRepository::sLODPending++;
+			LLFetchTrace::recordFetch(LLFetchTrace::MESH, mesh_params.getSculptID(), 0.f);
 		}
 	}
 
@@ -3885,6 +4326,7 @@ void LLMeshRepository::notifyLoadedMeshes()
 				for (std::vector<LLMeshRepoThread::LODRequest>::iterator iter = mPendingRequests.begin(); iter != mPendingRequests.end(); ++iter)
 				{
 					iter->mScore = score_map[iter->mMeshParams.getSculptID()];
+					LLFetchTrace::recordPriority(LLFetchTrace::MESH, iter->mMeshParams.getSculptID(), iter->mScore);
 				}
 
 				//sort by "score"
@@ -4171,17 +4613,10 @@ bool LLMeshRepository::hasPhysicsShape(const LLUUID& mesh_id)
 bool LLMeshRepoThread::hasPhysicsShapeInHeader(const LLUUID& mesh_id)
 {
     LLMutexLock lock(mHeaderMutex);
-    if (mMeshHeaderSize[mesh_id] > 0)
+    LLMeshHeader* header = findHeader(mesh_id);
+    if (header && header->mHeaderSize > 0 && header->mSize[LLMeshHeader::PHYSICS_MESH] > 0)
     {
-        mesh_header_map::iterator iter = mMeshHeader.find(mesh_id);
-        if (iter != mMeshHeader.end())
-        {
-            LLSD &mesh = iter->second;
-            if (mesh.has("physics_mesh") && mesh["physics_mesh"].has("size") && (mesh["physics_mesh"]["size"].asInteger() > 0))
-            {
-                return true;
-            }
-        }
+        return true;
     }
 
     return false;
@@ -4204,17 +4639,15 @@ S32 LLMeshRepository::getMeshSize(const LLUUID& mesh_id, S32 lod)
 	if (mThread && mesh_id.notNull() && LLPrimitive::NO_LOD != lod)
 	{
 		LLMutexLock lock(mThread->mHeaderMutex);
-		LLMeshRepoThread::mesh_header_map::iterator iter = mThread->mMeshHeader.find(mesh_id);
-		if (iter != mThread->mMeshHeader.end() && mThread->mMeshHeaderSize[mesh_id] > 0)
+		LLMeshHeader* header = mThread->findHeader(mesh_id);
+		if (header && header->mHeaderSize > 0)
 		{
-			LLSD& header = iter->second;
-
-			if (header.has("404"))
+			if (header->m404)
 			{
 				return -1;
 			}
 
-			S32 size = header[header_lod[lod]]["size"].asInteger();
+			S32 size = header->mSize[lod];
 			return size;
 		}
 
@@ -4310,10 +4743,10 @@ F32 LLMeshRepository::getStreamingCostLegacy(LLUUID mesh_id, F32 radius, S32* by
     if (mThread && mesh_id.notNull())
     {
         LLMutexLock lock(mThread->mHeaderMutex);
-        LLMeshRepoThread::mesh_header_map::iterator iter = mThread->mMeshHeader.find(mesh_id);
-        if (iter != mThread->mMeshHeader.end() && mThread->mMeshHeaderSize[mesh_id] > 0)
+        LLMeshHeader* header = mThread->findHeader(mesh_id);
+        if (header && header->mHeaderSize > 0)
         {
-            result  = getStreamingCostLegacy(iter->second, radius, bytes, bytes_visible, lod, unscaled_value);
+            result  = getStreamingCostLegacy(*header, radius, bytes, bytes_visible, lod, unscaled_value);
         }
     }
     if (result > 0.f)
@@ -4350,11 +4783,11 @@ F32 LLMeshRepository::getStreamingCostLegacy(LLUUID mesh_id, F32 radius, S32* by
 
 // FIXME replace with calc based on LLMeshCostData
 //static
-F32 LLMeshRepository::getStreamingCostLegacy(LLSD& header, F32 radius, S32* bytes, S32* bytes_visible, S32 lod, F32 *unscaled_value)
+F32 LLMeshRepository::getStreamingCostLegacy(LLMeshHeader& header, F32 radius, S32* bytes, S32* bytes_visible, S32 lod, F32 *unscaled_value)
 {
-	if (header.has("404")
-		|| !header.has("lowest_lod")
-		|| (header.has("version") && header["version"].asInteger() > MAX_MESH_VERSION))
+	if (header.m404
+		|| !header.mHasLowestLOD
+		|| header.mVersion > MAX_MESH_VERSION)
 	{
 		return 0.f;
 	}
@@ -4373,10 +4806,10 @@ F32 LLMeshRepository::getStreamingCostLegacy(LLSD& header, F32 radius, S32* byte
 	F32 minimum_size = (F32)minimum_size_ch;
 	F32 bytes_per_triangle = (F32)bytes_per_triangle_ch;
 
-	S32 bytes_lowest = header["lowest_lod"]["size"].asInteger();
-	S32 bytes_low = header["low_lod"]["size"].asInteger();
-	S32 bytes_mid = header["medium_lod"]["size"].asInteger();
-	S32 bytes_high = header["high_lod"]["size"].asInteger();
+	S32 bytes_lowest = header.mSize[LLMeshHeader::LOWEST_LOD];
+	S32 bytes_low = header.mSize[LLMeshHeader::LOW_LOD];
+	S32 bytes_mid = header.mSize[LLMeshHeader::MEDIUM_LOD];
+	S32 bytes_high = header.mSize[LLMeshHeader::HIGH_LOD];
 
 	if (bytes_high == 0)
 	{
@@ -4406,10 +4839,10 @@ F32 LLMeshRepository::getStreamingCostLegacy(LLSD& header, F32 radius, S32* byte
 	if (bytes)
 	{
 		*bytes = 0;
-		*bytes += header["lowest_lod"]["size"].asInteger();
-		*bytes += header["low_lod"]["size"].asInteger();
-		*bytes += header["medium_lod"]["size"].asInteger();
-		*bytes += header["high_lod"]["size"].asInteger();
+		*bytes += header.mSize[LLMeshHeader::LOWEST_LOD];
+		*bytes += header.mSize[LLMeshHeader::LOW_LOD];
+		*bytes += header.mSize[LLMeshHeader::MEDIUM_LOD];
+		*bytes += header.mSize[LLMeshHeader::HIGH_LOD];
 	}
 
 	if (bytes_visible)
@@ -4417,7 +4850,7 @@ F32 LLMeshRepository::getStreamingCostLegacy(LLSD& header, F32 radius, S32* byte
 		lod = LLMeshRepository::getActualMeshLOD(header, lod);
 		if (lod >= 0 && lod <= 3)
 		{
-			*bytes_visible = header[header_lod[lod]]["size"].asInteger();
+			*bytes_visible = header.mSize[lod];
 		}
 	}
 
@@ -4467,6 +4900,13 @@ LLMeshCostData::LLMeshCostData()
 }
 
 bool LLMeshCostData::init(const LLSD& header)
+{
+    LLMeshHeader mesh_header;
+    mesh_header.init(header, 0);
+    return init(mesh_header);
+}
+
+bool LLMeshCostData::init(const LLMeshHeader& header)
 {
     mSizeByLOD.resize(4);
     mEstTrisByLOD.resize(4);
@@ -4474,18 +4914,18 @@ bool LLMeshCostData::init(const LLSD& header)
     std::fill(mSizeByLOD.begin(), mSizeByLOD.end(), 0);
     std::fill(mEstTrisByLOD.begin(), mEstTrisByLOD.end(), 0.f);
     
-    S32 bytes_high = header["high_lod"]["size"].asInteger();
-    S32 bytes_med = header["medium_lod"]["size"].asInteger();
+    S32 bytes_high = header.mSize[LLMeshHeader::HIGH_LOD];
+    S32 bytes_med = header.mSize[LLMeshHeader::MEDIUM_LOD];
     if (bytes_med == 0)
     {
         bytes_med = bytes_high;
     }
-    S32 bytes_low = header["low_lod"]["size"].asInteger();
+    S32 bytes_low = header.mSize[LLMeshHeader::LOW_LOD];
     if (bytes_low == 0)
     {
         bytes_low = bytes_med;
     }
-    S32 bytes_lowest = header["lowest_lod"]["size"].asInteger();
+    S32 bytes_lowest = header.mSize[LLMeshHeader::LOWEST_LOD];
     if (bytes_lowest == 0)
     {
         bytes_lowest = bytes_low;
@@ -4625,17 +5065,15 @@ bool LLMeshRepository::getCostData(LLUUID mesh_id, LLMeshCostData& data)
     if (mThread && mesh_id.notNull())
     {
         LLMutexLock lock(mThread->mHeaderMutex);
-        LLMeshRepoThread::mesh_header_map::iterator iter = mThread->mMeshHeader.find(mesh_id);
-        if (iter != mThread->mMeshHeader.end() && mThread->mMeshHeaderSize[mesh_id] > 0)
+        LLMeshHeader* header = mThread->findHeader(mesh_id);
+        if (header && header->mHeaderSize > 0)
         {
-            LLSD& header = iter->second;
-
-            bool header_invalid = (header.has("404")
-                                   || !header.has("lowest_lod")
-                                   || (header.has("version") && header["version"].asInteger() > MAX_MESH_VERSION));
+            bool header_invalid = (header->m404
+                                   || !header->mHasLowestLOD
+                                   || header->mVersion > MAX_MESH_VERSION);
             if (!header_invalid)
             {
-                return getCostData(header, data);
+                return getCostData(*header, data);
             }
 
             return true;
@@ -4656,6 +5094,18 @@ bool LLMeshRepository::getCostData(LLSD& header, LLMeshCostData& data)
     return true;
 }
 
+bool LLMeshRepository::getCostData(LLMeshHeader& header, LLMeshCostData& data)
+{
+    data = LLMeshCostData();
+
+    if (!data.init(header))
+    {
+        return false;
+    }
+    
+    return true;
+}
+
 LLPhysicsDecomp::LLPhysicsDecomp()
 : LLThread("Physics Decomp")
 {
@@ -33,12 +33,17 @@
 #include "llviewertexture.h"
 #include "llvolume.h"
 #include "lldeadmantimer.h"
+#include "lldecodedmeshcache.h"
+#include "llmeshheaderstore.h"
 #include "httpcommon.h"
 #include "httprequest.h"
 #include "httpoptions.h"
 #include "httpheaders.h"
 #include "httphandler.h"
+#include "llatomic.h"
 #include "llthread.h"
+#include "lltimer.h"
+#include "lltrace.h"
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -194,6 +199,88 @@ private:
     LLFrameTimer mTimer;
 };
 
+class LLMeshRepoThread;
+
+// Pool of threads that unpack mesh data read by LLMeshRepoThread, from
+// the VFS or over HTTP, so that decoding many meshes at once isn't
+// serialised behind the repo thread.  Decoded results go to the same
+// LLMeshRepoThread queues that notifyLoadedMeshes() drains.
+class LLMeshDecodePool
+{
+public:
+	class Request
+	{
+	public:
+		enum EType
+		{
+			LOD,
+			SKIN_INFO,
+			DECOMPOSITION,
+			DECODED_LOD		// No data, load from the decoded mesh cache
+		};
+
+		// Takes ownership of data, which must have been allocated with new[]
+		Request(EType type, const LLVolumeParams& mesh_params, S32 lod,
+				U8* data, S32 data_size, S32 offset, S32 requested_bytes, bool from_cache);
+		~Request();
+
+		EType mType;
+		LLVolumeParams mMeshParams;
+		S32 mLOD;
+		U8* mData;
+		S32 mDataSize;
+		S32 mOffset;			// Range of the asset the data was requested for,
+		S32 mRequestedBytes;	// used to write it back to the VFS
+		bool mFromCache;	// Read from the VFS rather than received over HTTP
+		LLTimer mQueuedTimer;
+
+	private:
+		Request(const Request&);				// Not defined
+		void operator=(const Request&);			// Not defined
+	};
+
+	// num_threads of 0 picks a count based on the number of hardware threads
+	LLMeshDecodePool(LLMeshRepoThread* owner, U32 num_threads);
+	~LLMeshDecodePool();
+
+	void shutdown();
+
+	// Takes ownership of request
+	void submitRequest(Request* request);
+	S32 getQueueDepth();
+	U32 getNumThreads() const { return mWorkers.size(); }
+
+	static LLTrace::SampleStatHandle<> sQueueDepth;
+	static LLTrace::EventStatHandle<F64Milliseconds> sQueueWait;
+	static LLTrace::EventStatHandle<F64Milliseconds> sInflateTime;
+	static LLTrace::EventStatHandle<F64Milliseconds> sParseTime;
+	static LLTrace::EventStatHandle<F64Milliseconds> sOptimizeTime;
+	static LLTrace::EventStatHandle<F64Milliseconds> sTangentTime;
+
+private:
+	class Worker : public LLThread
+	{
+	public:
+		Worker(const std::string& name, LLMeshDecodePool* pool);
+
+	protected:
+		/*virtual*/ bool runCondition();
+		/*virtual*/ void run();
+
+	private:
+		LLMeshDecodePool* mPool;
+	};
+	friend class Worker;
+
+	Request* popRequest();
+	bool hasRequests();
+
+	LLMeshRepoThread* mOwner;
+	LLMutex* mMutex;
+	std::queue<Request*> mRequestQ;
+	std::vector<Worker*> mWorkers;
+};
+
 class LLMeshRepoThread : public LLThread
 {
 public:
@@ -209,11 +296,11 @@ public:
 	LLMutex*	mHeaderMutex;
 	LLCondition* mSignal;
 
-	//map of known mesh headers
-	typedef std::map<LLUUID, LLSD> mesh_header_map;
-	mesh_header_map mMeshHeader;
-	
-	std::map<LLUUID, U32> mMeshHeaderSize;
+	//known mesh headers
+	LLMeshHeaderStore mMeshHeaders;
+
+	//headers dropped from mMeshHeaders and asked for again, read back from the VFS by run()
+	std::set<LLUUID> mHeaderReloadQ;
 
 	class HeaderRequest : public RequestStats
 	{ 
@@ -237,9 +324,10 @@ public:
 		LLVolumeParams  mMeshParams;
 		S32 mLOD;
 		F32 mScore;
+		bool mSkipCache;	// Cached copy failed to decode, go straight to the sim
 
 		LODRequest(const LLVolumeParams&  mesh_params, S32 lod)
-			: RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f)
+			: RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f), mSkipCache(false)
 		{
 		}
 	};
@@ -328,6 +416,12 @@ public:
 
 	std::string mGetMeshCapability;
 
+	LLMeshDecodePool* mDecodePool;
+
+	// Generate tangents on the decode threads rather than when a material
+	// first needs them on the main thread
+	bool mDecodeTangents;
+
 	LLMeshRepoThread();
 	~LLMeshRepoThread();
 
@@ -337,14 +431,48 @@ public:
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
-	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+
+	// Parse the header of a mesh asset held in the VFS.  Returns false if
+	// the asset is not there or its header is corrupt.
+	//
+	// Threads:  repo
+	bool loadMeshHeaderFromCache(const LLVolumeParams& mesh_params);
+
+	// Make sure the header of a mesh is in mMeshHeaders, reading it back
+	// from the VFS if it was dropped.  Returns false if it is in neither.
+	//
+	// Threads:  repo
+	bool reloadMeshHeader(const LLUUID& mesh_id);
+
+	// Header of a mesh for a query, NULL if it is not known.  A header that
+	// was dropped is queued to be read back.
+	//
+	// Mutex:  mHeaderMutex must be held
+	LLMeshHeader* findHeader(const LLUUID& mesh_id);
+
+	// True if the store has dropped headers and the mesh asset is in the
+	// VFS to read this one back from
+	//
+	// Mutex:  mHeaderMutex must be held
+	bool mayHaveDroppedHeader(const LLUUID& mesh_id);
+
+	// Mutex:  mHeaderMutex must be held
+	void updateHeaderStats();
+	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true, bool skip_cache = false);
 	EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
 	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+	bool decodedLODReceived(const LLVolumeParams& mesh_params, S32 lod);
+	void queueLoadedMesh(LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, S32 lod);
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool hasPhysicsShapeInHeader(const LLUUID& mesh_id);
 
+	// Unpack data handed to mDecodePool and act on the result.
+	//
+	// Threads:  decode pool
+	void decodeRequest(const LLMeshDecodePool::Request& request);
+
 	void notifyLoadedMeshes();
 	S32 getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 	
@@ -385,7 +513,7 @@ private:
 	// or dispose of handler.
 	//
 	// Threads:  Repo thread only
-	LLCore::HttpHandle getByteRange(const std::string & url, 
+	LLCore::HttpHandle getByteRange(const LLUUID & mesh_id, const std::string & url,
 									size_t offset, size_t len, 
 									const LLCore::HttpHandler::ptr_t &handler);
 };
@@ -499,6 +627,7 @@ public:
     LLMeshCostData();
 
     bool init(const LLSD& header);
+    bool init(const LLMeshHeader& header);
     
     // Size for given LOD
     S32 getSizeByLOD(S32 lod);
@@ -553,10 +682,13 @@ public:
 	static U32 sLODPending;
 	static U32 sLODProcessing;
 	static U32 sCacheBytesRead;
-	static U32 sCacheBytesWritten;
+	static LLAtomicU32 sCacheBytesWritten;		// Also written by the decode threads
 	static U32 sCacheReads;						
-	static U32 sCacheWrites;
+	static LLAtomicU32 sCacheWrites;
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
+	static U32 sHeaderCount;					// Mesh headers held in memory
+	static U32 sHeaderBytes;					// Memory they take
+	static U32 sHeaderLLSDBytes;				// Memory they would take as parsed LLSD
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
 
@@ -564,9 +696,10 @@ public:
     F32 getEstTrianglesMax(LLUUID mesh_id);
     F32 getEstTrianglesStreamingCost(LLUUID mesh_id);
 	F32 getStreamingCostLegacy(LLUUID mesh_id, F32 radius, S32* bytes = NULL, S32* visible_bytes = NULL, S32 detail = -1, F32 *unscaled_value = NULL);
-	static F32 getStreamingCostLegacy(LLSD& header, F32 radius, S32* bytes = NULL, S32* visible_bytes = NULL, S32 detail = -1, F32 *unscaled_value = NULL);
+	static F32 getStreamingCostLegacy(LLMeshHeader& header, F32 radius, S32* bytes = NULL, S32* visible_bytes = NULL, S32 detail = -1, F32 *unscaled_value = NULL);
     bool getCostData(LLUUID mesh_id, LLMeshCostData& data);
     bool getCostData(LLSD& header, LLMeshCostData& data);
+    bool getCostData(LLMeshHeader& header, LLMeshCostData& data);
 
 	LLMeshRepository();
 
@@ -585,6 +718,7 @@ public:
 
 	S32 getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 	static S32 getActualMeshLOD(LLSD& header, S32 lod);
+	static S32 getActualMeshLOD(LLMeshHeader& header, S32 lod);
 	const LLMeshSkinInfo* getSkinInfo(const LLUUID& mesh_id, const LLVOVolume* requesting_obj);
 	LLModel::Decomposition* getDecomposition(const LLUUID& mesh_id);
 	void fetchPhysicsShape(const LLUUID& mesh_id);
@@ -651,6 +785,8 @@ public:
 	std::vector<LLMeshUploadThread*> mUploadWaitList;
 
 	LLPhysicsDecomp* mDecompThread;
+
+	LLDecodedMeshCache mDecodedCache;
 	
 	class inventory_data
 	{
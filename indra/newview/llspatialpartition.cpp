@@ -1217,7 +1217,7 @@ public:
 				
 			if (mRes)
 			{ //at least partially in, run on down
-				OctreeTraveler::traverse(n);
+				traverseChildren(n);
 			}
 
 			mRes = 0;
@@ -1592,12 +1592,24 @@ void pushVerts(LLFace* face, U32 mask)
 
 		if (buffer && (face->getGeomCount() >= 3))
 		{
+			const LLMatrix4* instance_matrix = face->getInstanceMatrix();
+			if (instance_matrix)
+			{
+				gGL.pushMatrix();
+				gGL.multMatrix((F32*) instance_matrix->mMatrix);
+			}
+
 			buffer->setBuffer(mask);
 			U16 start = face->getGeomStart();
 			U16 end = start + face->getGeomCount()-1;
 			U32 count = face->getIndicesCount();
 			U16 offset = face->getIndicesStart();
 			buffer->drawRange(LLRender::TRIANGLES, start, end, count, offset);
+
+			if (instance_matrix)
+			{
+				gGL.popMatrix();
+			}
 		}
 	}
 }
@@ -4028,6 +4040,7 @@ LLDrawInfo::LLDrawInfo(U16 start, U16 end, U32 count, U32 offset,
 	mTexture(texture),
 	mTextureMatrix(NULL),
 	mModelMatrix(NULL),
+	mInstanceMatrix(NULL),
 	mStart(start),
 	mEnd(end),
 	mCount(count),
@@ -90,6 +90,7 @@ public:
 	S32 mDebugColor;
 	const LLMatrix4* mTextureMatrix;
 	const LLMatrix4* mModelMatrix;
+	const LLMatrix4* mInstanceMatrix; //applied after mModelMatrix, see LLFace::getInstanceMatrix()
 	U16 mStart;
 	U16 mEnd;
 	U32 mCount;
@@ -1249,6 +1249,7 @@ bool idle_startup()
 		//
 		LLViewerStatsRecorder::instance(); // Since textures work in threads
 		gTextureList.doPrefetchImages();		
+		gTextureList.doPrefetchRegionImages(gFirstSimHandle);
 		display_startup();
 
 		LLSurface::initClasses();
@@ -828,6 +828,15 @@ void LLTextureCacheWorker::endWork(S32 param, bool aborted)
 
 //////////////////////////////////////////////////////////////////////////////
 
+// The presence filter counts two slots per id, picked from the (random) uuid bytes.
+static inline void presence_filter_slots(const LLUUID& id, U32 size, U32& slot1, U32& slot2)
+{
+	U32 words[2];
+	memcpy(words, id.mData, sizeof(words));
+	slot1 = words[0] & (size - 1);
+	slot2 = words[1] & (size - 1);
+}
+
 LLTextureCache::LLTextureCache(bool threaded)
 	: LLWorkerThread("TextureCache", threaded),
 	  mWorkersMutex(),
@@ -840,9 +849,15 @@ LLTextureCache::LLTextureCache(bool threaded)
 	  mDoPurge(FALSE),
 	  mFastCachep(NULL),
 	  mFastCachePoolp(NULL),
-	  mFastCachePadBuffer(NULL)
+	  mFastCachePadBuffer(NULL),
+	  mPresenceFilter(NULL)
 {
     mHeaderAPRFilePoolp = new LLVolatileAPRPool(); // is_local = true, because this pool is for headers, headers are under own mutex
+	mPresenceFilter = new LLAtomicU32[PRESENCE_FILTER_SIZE];
+	for (U32 i = 0; i < PRESENCE_FILTER_SIZE; ++i)
+	{
+		mPresenceFilter[i] = 0;
+	}
 }
 
 LLTextureCache::~LLTextureCache()
@@ -853,6 +868,7 @@ LLTextureCache::~LLTextureCache()
 	delete mFastCachePoolp;
 	delete mHeaderAPRFilePoolp;
 	ll_aligned_free_16(mFastCachePadBuffer);
+	delete[] mPresenceFilter;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1337,7 +1353,7 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 		bool update_header = false ;
 		if(entry.mImageSize < 0) //is a brand-new entry
 		{
-			mHeaderIDMap[entry.mID] = idx;
+			addHeaderID(entry.mID, idx);
 			mTexturesSizeMap[entry.mID] = new_body_size ;
 			mTexturesSizeTotal += new_body_size ;
 			
@@ -1377,7 +1393,7 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 {
 	U32 num_entries = mHeaderEntriesInfo.mEntries;
 
-	mHeaderIDMap.clear();
+	clearHeaderIDs();
 	mTexturesSizeMap.clear();
 	mFreeList.clear();
 	mTexturesSizeTotal = 0;
@@ -1412,7 +1428,7 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 // 		LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
 		if(entry.mImageSize > entry.mBodySize)
 		{
-			mHeaderIDMap[entry.mID] = idx;
+			addHeaderID(entry.mID, idx);
 			mTexturesSizeMap[entry.mID] = entry.mBodySize;
 			mTexturesSizeTotal += entry.mBodySize;
 		}
@@ -1663,7 +1679,7 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 			LLFile::rmdir(mTexturesDirName);
 		}
 	}
-	mHeaderIDMap.clear();
+	clearHeaderIDs();
 	mTexturesSizeMap.clear();
 	mTexturesSizeTotal = 0;
 	mFreeList.clear();
@@ -1733,6 +1749,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 			{
 				cache_size -= entries[idx].mBodySize;
 				mPurgeEntryList.push_back(std::pair<S32, Entry>(idx, entries[idx]));
+				++mPendingIDs[entries[idx].mID];
 			}
 			else
 			{
@@ -1750,6 +1767,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 			S32 idx = mPurgeEntryList.back().first;
 			Entry entry = mPurgeEntryList.back().second;
 			mPurgeEntryList.pop_back();
+			releasePendingID(entry.mID);
 			// make sure record is still valid
 			id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
 			if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
@@ -1980,6 +1998,98 @@ LLTextureCache::handle_t LLTextureCache::readFromCache(const LLUUID& id, U32 pri
 	return handle;
 }
 
+// Threads:  any, does not take mHeaderMutex
+bool LLTextureCache::mayBeInCache(const LLUUID& id) const
+{
+	U32 slot1, slot2;
+	presence_filter_slots(id, PRESENCE_FILTER_SIZE, slot1, slot2);
+	return mPresenceFilter[slot1].CurrentValue() > 0 && mPresenceFilter[slot2].CurrentValue() > 0;
+}
+
+// Same layout as LLTextureCacheRemoteWorker::doRead() with a zero offset: the first
+// TEXTURE_CACHE_ENTRY_SIZE bytes come from the header cache, the rest from the body file.
+// pool must belong to the calling thread.
+S32 LLTextureCache::readFromCacheDirect(const LLUUID& id, S32 size, U8*& data, S32& imagesize, LLVolatileAPRPool* pool)
+{
+	data = NULL;
+	imagesize = 0;
+	if (size <= 0 || !mayBeInCache(id))
+	{
+		return 0;
+	}
+
+	Entry entry;
+	S32 idx;
+	{
+		LLMutexLock lock(&mHeaderMutex);
+		if (mPendingIDs.find(id) != mPendingIDs.end())
+		{
+			// Header and body may be rewritten or removed under us, let the cache thread read it
+			return -1;
+		}
+		idx = openAndReadEntry(id, entry, false);
+		if (idx < 0)
+		{
+			return 0;
+		}
+		updateEntryTimeStamp(idx, entry);
+	}
+
+	S32 header_size = llmin(size, TEXTURE_CACHE_ENTRY_SIZE);
+	S32 body_size = 0;
+	std::string filename;
+	if (size > TEXTURE_CACHE_ENTRY_SIZE && entry.mBodySize > 0)
+	{
+		filename = getTextureFileName(id);
+		S32 filesize = LLAPRFile::size(filename, pool);
+		if (filesize != entry.mBodySize)
+		{
+			LL_WARNS() << "Direct read of " << id << " found a body of " << filesize << " bytes, expected " << entry.mBodySize << LL_ENDL;
+			return -1;
+		}
+		body_size = llclamp(size - TEXTURE_CACHE_ENTRY_SIZE, 0, filesize);
+	}
+
+	S32 datasize = header_size + body_size;
+	data = (U8*)ll_aligned_malloc_16(datasize);
+	if (!data)
+	{
+		LL_WARNS() << "Failed to allocate memory for direct read: " << id << " Size: " << datasize << LL_ENDL;
+		return -1;
+	}
+
+	S32 bytes_read = LLAPRFile::readEx(mHeaderDataFileName, data, idx * TEXTURE_CACHE_ENTRY_SIZE, header_size, pool);
+	if (bytes_read == header_size && body_size > 0)
+	{
+		bytes_read += LLAPRFile::readEx(filename, data + header_size, 0, body_size, pool);
+	}
+	if (bytes_read != datasize)
+	{
+		LL_WARNS() << "Direct read of " << id << " returned " << bytes_read << " / " << datasize << " bytes" << LL_ENDL;
+		ll_aligned_free_16(data);
+		data = NULL;
+		return -1;
+	}
+
+	{
+		// A write or purge that started while the files were read unlocked shows up here,
+		// either still pending or as a changed entry
+		LLMutexLock lock(&mHeaderMutex);
+		Entry check;
+		if (mPendingIDs.find(id) != mPendingIDs.end()
+			|| openAndReadEntry(id, check, false) != idx
+			|| check.mBodySize != entry.mBodySize
+			|| check.mImageSize != entry.mImageSize)
+		{
+			ll_aligned_free_16(data);
+			data = NULL;
+			return -1;
+		}
+	}
+
+	imagesize = entry.mImageSize;
+	return datasize;
+}
 
 bool LLTextureCache::readComplete(handle_t handle, bool abort)
 {
@@ -2027,6 +2137,7 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id, U32 prio
 		purgeTexturesLazy(TEXTURE_LAZY_PURGE_TIME_LIMIT);
 		mDoPurge = !mPurgeEntryList.empty();
 	}
+	addPendingID(id);
 	LLMutexLock lock(&mWorkersMutex);
 	LLTextureCacheWorker* worker = new LLTextureCacheRemoteWorker(this, priority, id,
 																  data, datasize, 0,
@@ -2089,6 +2200,7 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 		closeFastCache();
 	}
 	LLPointer<LLImageRaw> raw = new LLImageRaw(data, head[0], head[1], head[2], true);
+	raw->setMemoryCategory(LLImageMemory::FAST_CACHE);
 
 	return raw;
 }
@@ -2230,6 +2342,7 @@ bool LLTextureCache::writeComplete(handle_t handle, bool abort)
 		{
 			mWriters.erase(handle);
 			unlockWorkers();
+			removePendingID(worker->mID);
 			worker->scheduleDelete();
 			return true;
 		}
@@ -2262,12 +2375,51 @@ void LLTextureCache::removeCachedTexture(const LLUUID& id)
 		mTexturesSizeTotal -= mTexturesSizeMap[id] ;
 		mTexturesSizeMap.erase(id);
 	}
-	mHeaderIDMap.erase(id);
+	eraseHeaderID(id);
 	// We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
 	// but getLocalAPRFilePool() is not safe, it might be in use by worker
 	LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
 }
 
+//called after mHeaderMutex is locked.
+void LLTextureCache::addHeaderID(const LLUUID& id, S32 idx)
+{
+	std::pair<id_map_t::iterator, bool> res = mHeaderIDMap.insert(std::make_pair(id, idx));
+	if (res.second)
+	{
+		U32 slot1, slot2;
+		presence_filter_slots(id, PRESENCE_FILTER_SIZE, slot1, slot2);
+		mPresenceFilter[slot1]++;
+		mPresenceFilter[slot2]++;
+	}
+	else
+	{
+		res.first->second = idx;
+	}
+}
+
+//called after mHeaderMutex is locked.
+void LLTextureCache::eraseHeaderID(const LLUUID& id)
+{
+	if (mHeaderIDMap.erase(id) > 0)
+	{
+		U32 slot1, slot2;
+		presence_filter_slots(id, PRESENCE_FILTER_SIZE, slot1, slot2);
+		mPresenceFilter[slot1]--;
+		mPresenceFilter[slot2]--;
+	}
+}
+
+//called after mHeaderMutex is locked.
+void LLTextureCache::clearHeaderIDs()
+{
+	mHeaderIDMap.clear();
+	for (U32 i = 0; i < PRESENCE_FILTER_SIZE; ++i)
+	{
+		mPresenceFilter[i] = 0;
+	}
+}
+
 //called after mHeaderMutex is locked.
 void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 {
@@ -2293,7 +2445,7 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 
 		entry.mImageSize = -1;
 		entry.mBodySize = 0;
-		mHeaderIDMap.erase(entry.mID);
+		eraseHeaderID(entry.mID);
 		mTexturesSizeMap.erase(entry.mID);		
 		mFreeList.insert(idx);	
 	}
@@ -2304,6 +2456,28 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 	}
 }
 
+void LLTextureCache::addPendingID(const LLUUID& id)
+{
+	LLMutexLock lock(&mHeaderMutex);
+	++mPendingIDs[id];
+}
+
+void LLTextureCache::removePendingID(const LLUUID& id)
+{
+	LLMutexLock lock(&mHeaderMutex);
+	releasePendingID(id);
+}
+
+//mHeaderMutex is locked before calling this.
+void LLTextureCache::releasePendingID(const LLUUID& id)
+{
+	pending_map_t::iterator iter = mPendingIDs.find(id);
+	if (iter != mPendingIDs.end() && --iter->second <= 0)
+	{
+		mPendingIDs.erase(iter);
+	}
+}
+
 bool LLTextureCache::removeFromCache(const LLUUID& id)
 {
 	//LL_WARNS() << "Removing texture from cache: " << id << LL_ENDL;
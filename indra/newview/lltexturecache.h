@@ -125,6 +125,13 @@ public:
 	handle_t readFromCache(const LLUUID& id, U32 priority, S32 offset, S32 size,
 						   ReadResponder* responder);
 	bool readComplete(handle_t handle, bool abort);
+
+	// Lock-free test used by the fetch thread before queueing a read.
+	// May return false positives but never false negatives.
+	bool mayBeInCache(const LLUUID& id) const;
+	// Reads an entry from offset 0 on the calling thread instead of queueing a worker.
+	// Returns the number of bytes read into data (caller owns it), 0 if not cached, -1 on error.
+	S32 readFromCacheDirect(const LLUUID& id, S32 size, U8*& data, S32& imagesize, LLVolatileAPRPool* pool);
 	handle_t writeToCache(const LLUUID& id, U32 priority, U8* data, S32 datasize, S32 imagesize, LLPointer<LLImageRaw> rawimage, S32 discardlevel,
 						  WriteResponder* responder);
 	LLPointer<LLImageRaw> readFromFastCache(const LLUUID& id, S32& discardlevel);
@@ -179,6 +186,12 @@ private:
 	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
 	void removeEntry(S32 idx, Entry& entry, std::string& filename);
 	void removeCachedTexture(const LLUUID& id) ;
+	void addHeaderID(const LLUUID& id, S32 idx);
+	void eraseHeaderID(const LLUUID& id);
+	void clearHeaderIDs();
+	void addPendingID(const LLUUID& id);
+	void removePendingID(const LLUUID& id);
+	void releasePendingID(const LLUUID& id);
 	S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
 	S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
 	void writeUpdatedEntries() ;
@@ -225,6 +238,13 @@ private:
 	std::set<LLUUID> mLRU;
 	typedef std::map<LLUUID, S32> id_map_t;
 	id_map_t mHeaderIDMap;
+	// Ids with a write in flight or an entry on mPurgeEntryList, with a count of each;
+	// readFromCacheDirect() leaves these to the cache thread. Guarded by mHeaderMutex.
+	typedef std::map<LLUUID, S32> pending_map_t;
+	pending_map_t mPendingIDs;
+	// Counting filter mirroring mHeaderIDMap, readable without mHeaderMutex
+	static const U32 PRESENCE_FILTER_SIZE = 1 << 18;
+	LLAtomicU32* mPresenceFilter;
 
 	LLAPRFile*   mFastCachep;
 	LLFrameTimer mFastCacheTimer;
@@ -41,6 +41,7 @@
 #include "message.h"
 
 #include "llagent.h"
+#include "llfetchtrace.h"
 #include "lltexturecache.h"
 #include "llviewercontrol.h"
 #include "llviewertexturelist.h"
@@ -69,6 +70,8 @@ LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheAttempt("texture_cache_attem
 LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > LLTextureFetch::sCacheHitRate("texture_cache_hits");
 
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheReadLatency("texture_cache_read_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheHitLatency("texture_cache_hit_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheMissLatency("texture_cache_miss_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexDecodeLatency("texture_decode_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFetchLatency("texture_fetch_latency");
 
@@ -409,6 +412,12 @@ public:
 						bool partial, bool success);
 
 	// Threads:  Ttc
+	// Reads the cache entry on this thread instead of queueing it on the cache thread.
+	// Returns false if the queued read should be used instead.
+	// Threads:  Ttf
+	// Locks:  Mw
+	bool readFromCacheDirect(S32 size);
+
 	void callbackCacheRead(bool success, LLImageFormatted* image,
 						   S32 imagesize, BOOL islocal);
 
@@ -988,6 +997,7 @@ LLTextureFetchWorker::~LLTextureFetchWorker()
 	{
 		// Issue a cancel on a live request...
         mFetcher->getHttpRequest().requestCancel(mHttpHandle, LLCore::HttpHandler::ptr_t());
+		LLFetchTrace::recordCancel(mHttpHandle);
 	}
 	if (mCacheReadHandle != LLTextureCache::nullHandle() && mFetcher->mTextureCache)
 	{
@@ -1247,13 +1257,23 @@ bool LLTextureFetchWorker::doWork(S32 param)
 			}
 			else if ((mUrl.empty() || mFTType==FTT_SERVER_BAKE) && mFetcher->canLoadFromCache())
 			{
-				setPriority(LLWorkerThread::PRIORITY_LOW | mWorkPriority); // Set priority first since Responder may change it
+				static LLCachedControl<bool> direct_read(gSavedSettings, "TextureFetchDirectCacheRead", true);
 
-				++mCacheReadCount;
-				CacheReadResponder* responder = new CacheReadResponder(mFetcher, mID, mFormattedImage);
-				mCacheReadHandle = mFetcher->mTextureCache->readFromCache(mID, cache_priority,
-																		  offset, size, responder);
 				mCacheReadTimer.reset();
+				if (direct_read && offset == 0 && readFromCacheDirect(size))
+				{
+					// Hit or certain miss, CACHE_POST decides between decode and network
+					setState(CACHE_POST);
+				}
+				else
+				{
+					setPriority(LLWorkerThread::PRIORITY_LOW | mWorkPriority); // Set priority first since Responder may change it
+
+					++mCacheReadCount;
+					CacheReadResponder* responder = new CacheReadResponder(mFetcher, mID, mFormattedImage);
+					mCacheReadHandle = mFetcher->mTextureCache->readFromCache(mID, cache_priority,
+																			  offset, size, responder);
+				}
 			}
 			else if(!mUrl.empty() && mCanUseHTTP)
 			{
@@ -1286,7 +1306,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				return false;
 			}
 		}
-		else
+		else if (mState != CACHE_POST)
 		{
 			return false;
 		}
@@ -1623,6 +1643,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
 																	  mFetcher->mHttpHeaders,
                                                                       LLCore::HttpHandler::ptr_t(this, &NoOpDeletor));
 		}
+		LLFetchTrace::recordGet(mHttpHandle, LLFetchTrace::TEXTURE, mID,
+								disable_range_req ? 0 : mRequestedOffset,
+								disable_range_req ? 0 : mRequestedSize,
+								mWorkPriority);
 		if (LLCORE_HTTP_HANDLE_INVALID == mHttpHandle)
 		{
 			LLCore::HttpStatus status(mFetcher->mHttpRequest->getStatus());
@@ -1889,6 +1913,12 @@ bool LLTextureFetchWorker::doWork(S32 param)
 			return true;
 		}
 
+		if (mFetcher->mImageDecodeThread->isQueueFull())
+		{
+			// Decode stage is backed up, hold on to the data until it drains
+			return false;
+		}
+
 		mRawImage = NULL;
 		mAuxImage = NULL;
 		llassert_always(mFormattedImage.notNull());
@@ -2042,6 +2072,7 @@ void LLTextureFetchWorker::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRe
 	LLMutexLock lock(&mWorkMutex);										// +Mw
 
 	mHttpActive = false;
+	LLFetchTrace::recordDone(handle, response);
 	
 	if (log_to_viewer_log || log_to_sim)
 	{
@@ -2450,6 +2481,38 @@ void LLTextureFetchWorker::callbackCacheRead(bool success, LLImageFormatted* ima
 	setPriority(LLWorkerThread::PRIORITY_HIGH | mWorkPriority);
 }																		// -Mw
 
+// Threads:  Ttf
+// Locks:  Mw
+bool LLTextureFetchWorker::readFromCacheDirect(S32 size)
+{
+	U8* data = NULL;
+	S32 imagesize = 0;
+	S32 datasize = mFetcher->mTextureCache->readFromCacheDirect(mID, size, data, imagesize,
+																 mFetcher->getLocalAPRFilePool());
+	if (datasize < 0)
+	{
+		// Read error, let the cache thread try
+		return false;
+	}
+	if (datasize > 0)
+	{
+		if (mFormattedImage.isNull())
+		{
+			mFormattedImage = LLImageFormatted::createFromType(IMG_CODEC_J2C);
+		}
+		mFormattedImage->appendData(data, datasize); // takes ownership of data
+		mFileSize = imagesize;
+		mImageCodec = mFormattedImage->getCodec();
+		mInLocalCache = FALSE;
+		if (mFileSize != 0 && mFormattedImage->getDataSize() >= mFileSize)
+		{
+			mHaveAllData = TRUE;
+		}
+		add(LLTextureFetch::sCacheHit, 1.0);
+	}
+	return true;
+}
+
 // Threads:  Ttc
 void LLTextureFetchWorker::callbackCacheWrite(bool success)
 {
@@ -2753,6 +2816,7 @@ bool LLTextureFetch::createRequest(FTType f_type, const std::string& url, const
 	else
 	{
 		worker = new LLTextureFetchWorker(this, f_type, url, id, host, priority, desired_discard, desired_size);
+		LLFetchTrace::recordFetch(LLFetchTrace::TEXTURE, id, priority);
 		lockQueue();													// +Mfq
 		mRequestMap[id] = worker;
 		unlockQueue();													// -Mfq
@@ -2974,6 +3038,7 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 			sample(sTexDecodeLatency, worker->mDecodeTime);
             sample(sTexFetchLatency, worker->mFetchTime);
             sample(sCacheReadLatency, worker->mCacheReadTime);
+            sample(worker->mInCache ? sCacheHitLatency : sCacheMissLatency, worker->mFetchTime);
             worker->mCacheReadTimer.reset();
             worker->mDecodeTimer.reset();
             worker->mFetchTimer.reset();
@@ -3013,6 +3078,7 @@ bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
 		worker->lockWorkMutex();										// +Mw
 		worker->setImagePriority(priority);
 		worker->unlockWorkMutex();										// -Mw
+		LLFetchTrace::recordPriority(LLFetchTrace::TEXTURE, id, priority);
 		res = true;
 	}
 	return res;
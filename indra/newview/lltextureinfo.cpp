@@ -220,7 +220,7 @@ void LLTextureInfo::setRequestCompleteTimeAndLog(const LLUUID& id, U64Microsecon
 				object_cache["vo_region_misscount"] = ll_sd_from_U64(region_miss_count);
 				object_cache["vo_region_hitrate"] = LLSD::Real(region_vocache_hit_rate);
 				object_cache["mesh_reads"] = LLSD::Integer(LLMeshRepository::sCacheReads);
-				object_cache["mesh_writes"] = LLSD::Integer(LLMeshRepository::sCacheWrites);
+				object_cache["mesh_writes"] = LLSD::Integer(LLMeshRepository::sCacheWrites.CurrentValue());
 				texture_data["object_cache"] = object_cache;
 
 				send_texture_stats_to_sim(texture_data);
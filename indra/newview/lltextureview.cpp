@@ -549,13 +549,17 @@ void LLGLTexMemBar::draw()
     U32 texFetchLatMed = U32(recording.getMean(LLTextureFetch::sTexFetchLatency).value() * 1000.0f);
     U32 texFetchLatMax = U32(recording.getMax(LLTextureFetch::sTexFetchLatency).value() * 1000.0f);
 
-	text = llformat("GL Tot: %d/%d MB Bound: %4d/%4d MB FBO: %d MB Raw Tot: %d MB Bias: %.2f Cache: %.1f/%.1f MB",
+    U32 cacheHitLatMed = U32(recording.getMean(LLTextureFetch::sCacheHitLatency).value() * 1000.0f);
+    U32 cacheMissLatMed = U32(recording.getMean(LLTextureFetch::sCacheMissLatency).value() * 1000.0f);
+
+	text = llformat("GL Tot: %d/%d MB Bound: %4d/%4d MB FBO: %d MB Raw Tot: %d/%d MB Bias: %.2f Cache: %.1f/%.1f MB",
 					total_mem.value(),
 					max_total_mem.value(),
 					bound_mem.value(),
 					max_bound_mem.value(),
 					LLRenderTarget::sBytesAllocated/(1024*1024),
-					LLImageRaw::sGlobalRawMemory >> 20,
+					LLImageRaw::sGlobalRawMemory.CurrentValue() >> 20,
+					LLImageMemory::getBudget() >> 20,
 					discard_bias,
 					cache_usage,
 					cache_max_usage);
@@ -580,7 +584,7 @@ void LLGLTexMemBar::draw()
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*5,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
-    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d",
+    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d Hit/Miss: %d/%d",
                     cacheHitRate,
                     cacheReadLatMin,
                     cacheReadLatMed,
@@ -590,7 +594,9 @@ void LLGLTexMemBar::draw()
                     texDecodeLatMax,
                     texFetchLatMin,
                     texFetchLatMed,
-                    texFetchLatMax);
+                    texFetchLatMax,
+                    cacheHitLatMed,
+                    cacheMissLatMed);
 
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*4,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
@@ -603,9 +609,9 @@ void LLGLTexMemBar::draw()
 					LLAppViewer::getTextureFetch()->mPacketCount, LLAppViewer::getTextureFetch()->mBadPacketCount, 
 					LLAppViewer::getTextureCache()->getNumReads(), LLAppViewer::getTextureCache()->getNumWrites(),
 					LLLFSThread::sLocal->getPending(),
-					LLImageRaw::sRawImageCount,
+					LLImageRaw::sRawImageCount.CurrentValue(),
 					LLAppViewer::getTextureFetch()->getNumHTTPRequests(),
-					LLAppViewer::getImageDecodeThread()->getPending(), 
+					LLAppViewer::getImageDecodeThread()->getQueueDepth(), 
 					gTextureList.mCreateTextureList.size());
 
 	x_right = 550.0;
@@ -626,7 +632,7 @@ void LLGLTexMemBar::draw()
 	text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
 					LLMeshRepository::sMeshRequestCount, LLMeshRepository::sHTTPRequestCount, LLMeshRepository::sHTTPLargeRequestCount,
 					LLMeshRepository::sHTTPRetryCount, LLMeshRepository::sHTTPErrorCount,
-					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites,
+					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites.CurrentValue(),
 					LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater);
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*2,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
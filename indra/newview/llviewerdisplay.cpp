@@ -443,6 +443,10 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 			// Transition to REQUESTED.  Viewer has sent some kind
 			// of TeleportRequest to the source simulator
 			gTeleportDisplayTimer.reset();
+			if (gAgent.getRegion())
+			{
+				gTextureList.saveRegionWorkingSet(gAgent.getRegion()->getHandle());
+			}
 			gViewerWindow->setShowProgress(TRUE);
 			gViewerWindow->setProgressPercent(llmin(teleport_percent, 0.0f));
 			LL_INFOS("Teleport") << "A teleport request has been sent, setting state to TELEPORT_REQUESTED" << LL_ENDL;
@@ -476,6 +480,7 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 				LLAgent::sTeleportProgressMessages["arriving"]);
 			gAgent.sheduleTeleportIM();
 			gTextureList.mForceResetTextureStats = TRUE;
+			gTextureList.reportRegionPrefetch();
 			gAgentCamera.resetView(TRUE, TRUE);
 			
 			break;
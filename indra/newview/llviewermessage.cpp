@@ -99,6 +99,7 @@
 #include "llviewerparcelmgr.h"
 #include "llviewerstats.h"
 #include "llviewertexteditor.h"
+#include "llviewertexturelist.h"
 #include "llviewerthrottle.h"
 #include "llviewerwindow.h"
 #include "llvlmanager.h"
@@ -2962,6 +2963,7 @@ void process_teleport_finish(LLMessageSystem* msg, void**)
 	// Viewer trusts the simulator.
 	gMessageSystem->enableCircuit(sim_host, TRUE);
 	LLViewerRegion* regionp =  LLWorld::getInstance()->addRegion(region_handle, sim_host);
+	gTextureList.doPrefetchRegionImages(region_handle);
 
 /*
 	// send camera update to new region
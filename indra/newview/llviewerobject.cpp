@@ -688,6 +688,27 @@ U32 LLViewerObject::unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id)
 	return parent_id;
 }
 
+//size of the leading fields of a compressed update that are unique to the object (ID, position, owner, parent...),
+//the rest is the same for copies of the object.
+//static 
+U32 LLViewerObject::getUniqueDataSize(LLDataPackerBinaryBuffer* dp)
+{
+	U32 value;
+	unpackU32(dp, value, "SpecialCode");
+
+	S32 size = sObjectDataMap["Omega"];
+	if(value & 0x80)
+	{
+		size += sizeof(LLVector3);
+	}
+	if(value & 0x20)
+	{
+		size += sizeof(U32);
+	}
+
+	return llmin(size, dp->getBufferSize());
+}
+
 // Replaces all name value pairs with data from \n delimited list
 // Does not update server
 void LLViewerObject::setNameValueList(const std::string& name_value_list)
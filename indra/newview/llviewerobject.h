@@ -600,6 +600,7 @@ public:
 	static void unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name);
 	static void unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name);
 	static U32 unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id);
+	static U32 getUniqueDataSize(LLDataPackerBinaryBuffer* dp);
 
 public:
 	//counter-translation
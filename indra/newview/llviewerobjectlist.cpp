@@ -968,6 +968,9 @@ void LLViewerObjectList::update(LLAgent &agent)
 	// update max computed render cost
 	LLVOVolume::updateRenderComplexity();
 
+	// quantize the faces of volumes nobody has looked at in a while
+	LLVOVolume::updateCompactVolumes();
+
 	// compute all sorts of time-based stats
 	// don't factor frames that were paused into the stats
 	if (! mWasPaused)
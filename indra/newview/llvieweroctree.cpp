@@ -1373,18 +1373,89 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 				
 		if (mRes)
 		{ //at least partially in, run on down
-			OctreeTraveler::traverse(n);
+			traverseChildren(n);
 		}
 
 		mRes = 0;
 	}
 }
+
+void LLViewerOctreeCull::traverseChildren(const OctreeNode* n)
+{
+	n->accept(this);
+
+	ChildBatch batch(n);
+	ChildBatch* parent_batch = mBatch;
+	for (U32 i = 0; i < n->getChildCount(); i++)
+	{
+		//the child checks its bounds first thing, before any of its own
+		//children can replace the batch
+		mBatch = &batch;
+		mBatchChild = i;
+		traverse(n->getChild(i));
+	}
+	mBatch = parent_batch;
+}
+
+S32 LLViewerOctreeCull::checkGroupBounds(const LLViewerOctreeGroup* group, U32 check)
+{
+	if (!mBatch || mBatch->mNode->getChild(mBatchChild) != group->mOctreeNode)
+	{ //not a child of the node being traversed, check it alone
+		switch (check)
+		{
+		case CHECK_AGENT:
+			return mCamera->AABBInFrustum(group->mBounds[0], group->mBounds[1]);
+		case CHECK_AGENT_NO_FAR_CLIP:
+			return mCamera->AABBInFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
+		case CHECK_REGION:
+			return mCamera->AABBInRegionFrustum(group->mBounds[0], group->mBounds[1]);
+		default:
+			return mCamera->AABBInRegionFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
+		}
+	}
+
+	if (!(mBatch->mDone & (1 << check)))
+	{
+		const LLVector4a* bounds[8];
+		U32 count = mBatch->mNode->getChildCount();
+		for (U32 i = 0; i < count; i++)
+		{
+			bounds[i] = ((LLViewerOctreeGroup*) mBatch->mNode->getChild(i)->getListener(0))->mBounds;
+		}
+
+		LLCamera::BatchPlanes& planes = mBatchPlanes[check];
+		if (!(mBatchPlanesDone & (1 << check)))
+		{
+			switch (check)
+			{
+			case CHECK_AGENT:
+				mCamera->getBatchPlanes(planes);
+				break;
+			case CHECK_AGENT_NO_FAR_CLIP:
+				mCamera->getBatchPlanes(planes, NULL, false);
+				break;
+			case CHECK_REGION:
+				mCamera->getRegionBatchPlanes(planes);
+				break;
+			default:
+				mCamera->getRegionBatchPlanes(planes, false);
+				break;
+			}
+			mBatchPlanesDone |= 1 << check;
+		}
+
+		LLCamera::AABBInFrustumBatch(planes, bounds, count, mBatch->mResults[check]);
+		mBatch->mDone |= 1 << check;
+	}
+
+	return mBatch->mResults[check][mBatchChild];
+}
 	
 //------------------------------------------
 //agent space group culling
 S32 LLViewerOctreeCull::AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
 {
-	return mCamera->AABBInFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
+	return checkGroupBounds(group, CHECK_AGENT_NO_FAR_CLIP);
 }
 
 S32 LLViewerOctreeCull::AABBSphereIntersectGroupExtents(const LLViewerOctreeGroup* group)
@@ -1394,7 +1465,7 @@ S32 LLViewerOctreeCull::AABBSphereIntersectGroupExtents(const LLViewerOctreeGrou
 
 S32 LLViewerOctreeCull::AABBInFrustumGroupBounds(const LLViewerOctreeGroup* group)
 {
-	return mCamera->AABBInFrustum(group->mBounds[0], group->mBounds[1]);
+	return checkGroupBounds(group, CHECK_AGENT);
 }
 //------------------------------------------
 
@@ -1420,12 +1491,12 @@ S32 LLViewerOctreeCull::AABBInFrustumObjectBounds(const LLViewerOctreeGroup* gro
 //local regional space group culling
 S32 LLViewerOctreeCull::AABBInRegionFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
 {
-	return mCamera->AABBInRegionFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
+	return checkGroupBounds(group, CHECK_REGION_NO_FAR_CLIP);
 }
 
 S32 LLViewerOctreeCull::AABBInRegionFrustumGroupBounds(const LLViewerOctreeGroup* group)
 {
-	return mCamera->AABBInRegionFrustum(group->mBounds[0], group->mBounds[1]);
+	return checkGroupBounds(group, CHECK_REGION);
 }
 
 S32 LLViewerOctreeCull::AABBRegionSphereIntersectGroupExtents(const LLViewerOctreeGroup* group, const LLVector3& shift)
@@ -45,6 +45,10 @@ class LLViewerOctreeGroup;
 class LLViewerOctreeEntry;
 class LLViewerOctreePartition;
 
+// The spatial partitions and the object cache octrees churn their nodes
+// every frame, keep them together (see lloctreepool.h)
+template <> struct LLOctreeUsePool<LLViewerOctreeEntry> { static const bool value = true; };
+
 typedef LLOctreeListener<LLViewerOctreeEntry>	OctreeListener;
 typedef LLTreeNode<LLViewerOctreeEntry>			TreeNode;
 typedef LLOctreeNode<LLViewerOctreeEntry>		OctreeNode;
@@ -365,11 +369,15 @@ class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
 	LLViewerOctreeCull(LLCamera* camera)
-		: mCamera(camera), mRes(0) { }
+		: mCamera(camera), mRes(0), mBatch(NULL), mBatchChild(0), mBatchPlanesDone(0) { }
 	
 	virtual void traverse(const OctreeNode* n);
 
 protected:
+	//accept n then traverse its children, sharing one batched frustum check
+	//of their group bounds
+	void traverseChildren(const OctreeNode* n);
+
 	virtual bool earlyFail(LLViewerOctreeGroup* group);	
 	
 	//agent space group cull
@@ -401,9 +409,40 @@ protected:
 	virtual void processGroup(LLViewerOctreeGroup* group);
 	virtual void visit(const OctreeNode* branch);
 	
+private:
+	enum
+	{
+		CHECK_AGENT = 0,
+		CHECK_AGENT_NO_FAR_CLIP,
+		CHECK_REGION,
+		CHECK_REGION_NO_FAR_CLIP,
+		NUM_CHECKS
+	};
+
+	//group bounds check results of the children of one node, each kind of
+	//check done for all of them the first time one of them needs it
+	struct ChildBatch
+	{
+		ChildBatch(const OctreeNode* node) : mNode(node), mDone(0) { }
+
+		const OctreeNode* mNode;
+		U32 mDone;
+		S32 mResults[NUM_CHECKS][8];
+	};
+
+	S32 checkGroupBounds(const LLViewerOctreeGroup* group, U32 check);
+
 protected:
 	LLCamera *mCamera;
 	S32 mRes;
+
+private:
+	ChildBatch* mBatch;
+	U32 mBatchChild;
+
+	//camera planes of each kind of check, splatted once per traversal
+	LLCamera::BatchPlanes mBatchPlanes[NUM_CHECKS];
+	U32 mBatchPlanesDone;
 };
 
 //scan the octree, output the info of each node for debug use.
@@ -2343,8 +2343,12 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 	LLVector3 scale;
 	LLQuaternion rot;
 
-	//decode spatial info and parent info
-	U32 parent_id = LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot);
+	//decode spatial info and parent info, entries fresh from the cache file carry it without decoding their data
+	U32 parent_id = 0;
+	if(!entry->getCachedExtents(parent_id, pos, scale))
+	{
+		parent_id = LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot);
+	}
 	
 	U32 old_parent_id = entry->getParentID();
 	bool same_old_parent = false;
@@ -55,6 +55,7 @@
 #include "llviewerregion.h"
 #include "llvoavatar.h"
 #include "llvoavatarself.h"
+#include "llvocache.h"
 #include "llworld.h"
 #include "llfeaturemanager.h"
 #include "llviewernetwork.h"
@@ -91,7 +92,10 @@ LLTrace::CountStatHandle<>	FPS("FPS", "Frames rendered"),
 							FRAMETIME_DOUBLED("frametimedoubled", "Ratio of frames 2x longer than previous"),
 							TEX_BAKES("texbakes", "Number of times avatar textures have been baked"),
 							TEX_REBAKES("texrebakes", "Number of times avatar textures have been forced to rebake"),
-							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache");
+							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache"),
+							TEXTURE_PREFETCH_COUNT("textureprefetchcount", "Textures requested from a recorded region working set"),
+							VOLUME_LOD_CHANGES("volumelodchanges", "Volumes that changed LOD"),
+							VOLUME_INSTANCED_FACES("volumeinstancedfaces", "Volume faces drawn from the vertices of an identical face");
 
 LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > 
 							TRIANGLES_DRAWN("trianglesdrawnstat");
@@ -99,12 +103,17 @@ LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> >
 LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Kilotriangles> >
 							TRIANGLES_DRAWN_PER_FRAME("trianglesdrawnperframestat");
 
+LLTrace::EventStatHandle<>	VOLUME_LOD_CHANGES_PER_FRAME("volumelodchangesperframe", "Volumes that changed LOD in a frame");
+
 LLTrace::CountStatHandle<F64Kilobytes >	
 							ACTIVE_MESSAGE_DATA_RECEIVED("activemessagedatareceived", "Message system data received on all active regions"),
 							LAYERS_NETWORK_DATA_RECEIVED("layersdatareceived", "Network data received for layer data (terrain)"),
 							OBJECT_NETWORK_DATA_RECEIVED("objectdatareceived", "Network data received for objects"),
 							ASSET_UDP_DATA_RECEIVED("assetudpdatareceived", "Network data received for assets (animations, sounds) over UDP message system"),
 							TEXTURE_NETWORK_DATA_RECEIVED("texturedatareceived", "Network data received for textures"),
+							MESH_DECODED_CACHE_MAPPED("meshdecodedcachemapped", "Decoded mesh cache data mapped from disk"),
+							OBJECT_CACHE_DATA_WRITTEN("objectcachedatawritten", "Region object cache data written to disk"),
+							VOLUME_INSTANCE_DATA_SAVED("volumeinstancedatasaved", "Vertex and index data not copied because faces drew the vertices of an identical face"),
 							MESSAGE_SYSTEM_DATA_IN("messagedatain", "Incoming message system network data"),
 							MESSAGE_SYSTEM_DATA_OUT("messagedataout", "Outgoing message system network data");
 
@@ -147,6 +156,8 @@ LLTrace::SampleStatHandle<>	FPS_SAMPLE("fpssample"),
 							SHADER_OBJECTS("shaderobjects", "Object Shaders"),
 							DRAW_DISTANCE("drawdistance", "Draw Distance"),
 							PENDING_VFS_OPERATIONS("vfspendingoperations"),
+							TEXTURE_CACHE_QUEUE("texturecachequeue", "Texture cache reads and writes waiting"),
+							TEXTURE_CREATE_QUEUE("texturecreatequeue", "Decoded textures waiting for GL creation"),
 							WINDOW_WIDTH("windowwidth", "Window width"),
 							WINDOW_HEIGHT("windowheight", "Window height");
 
@@ -159,9 +170,13 @@ static LLTrace::SampleStatHandle<bool>
 LLTrace::SampleStatHandle<F64Megabytes >	GL_TEX_MEM("gltexmemstat"),
 															GL_BOUND_MEM("glboundmemstat"),
 															RAW_MEM("rawmemstat"),
-															FORMATTED_MEM("formattedmemstat");
+															FORMATTED_MEM("formattedmemstat"),
+															VERTEX_BUFFER_MEM("vertexbuffermem", "Vertex and index data allocated for vertex buffers");
 LLTrace::SampleStatHandle<F64Kilobytes >	DELTA_BANDWIDTH("deltabandwidth", "Increase/Decrease in bandwidth based on packet loss"),
-															MAX_BANDWIDTH("maxbandwidth", "Max bandwidth setting");
+															MAX_BANDWIDTH("maxbandwidth", "Max bandwidth setting"),
+															OBJECT_CACHE_BODY_REFERENCED("objectcachebodyreferenced", "Object update bodies referenced by the region object caches"),
+															OBJECT_CACHE_BODY_STORED("objectcachebodystored", "Memory taken by object update bodies once identical ones are shared"),
+															COMPACT_VOLUME_SAVINGS("compactvolumesavings", "Memory saved by keeping idle volume faces in quantized form");
 
 	
 SimMeasurement<F64Milliseconds >	SIM_FRAME_TIME("simframemsec", "", LL_SIM_STAT_FRAMEMS),
@@ -196,7 +211,11 @@ LLTrace::EventStatHandle<F64Milliseconds >	REGION_CROSSING_TIME("regioncrossingt
 																NETWORK_STACKTIME("networkstacktime", "NETWORK_SECS"),
 																IMAGE_STACKTIME("imagestacktime", "IMAGE_SECS"),
 																REBUILD_STACKTIME("rebuildstacktime", "REBUILD_SECS"),
-																RENDER_STACKTIME("renderstacktime", "RENDER_SECS");
+																RENDER_STACKTIME("renderstacktime", "RENDER_SECS"),
+																TEXTURE_CREATE_TIME("texturecreatetime", "Time spent creating a GL texture from a decoded image"),
+																OBJECT_CACHE_WRITE_TIME("objectcachewritetime", "Time spent writing the object cache of a region"),
+																VOLUME_LOD_PASS_TIME("volumelodpasstime", "Time spent updating the volume LODs of a spatial group in one batch"),
+																VOLUME_REBUILD_TIME("volumerebuildtime", "Time spent rebuilding the vertex buffers of a spatial group");
 	
 LLTrace::EventStatHandle<F64Seconds >	AVATAR_EDIT_TIME("avataredittime", "Seconds in Edit Appearance"),
 															TOOLBOX_TIME("toolboxtime", "Seconds using Toolbox"),
@@ -206,6 +225,8 @@ LLTrace::EventStatHandle<F64Seconds >	AVATAR_EDIT_TIME("avataredittime", "Second
 															FPS_2_TIME("fps2time", "Seconds below 2 FPS");
 
 LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > OBJECT_CACHE_HIT_RATE("object_cache_hits");
+LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > MESH_DECODED_CACHE_HIT_RATE("mesh_decoded_cache_hits", "Mesh LOD requests served from the decoded mesh cache");
+LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > TEXTURE_PREFETCH_WARM("texture_prefetch_warm", "Share of the prefetched region working set decoded before the first frame");
 
 }
 
@@ -342,6 +363,7 @@ void update_statistics()
 	LLTrace::Recording& last_frame_recording = LLTrace::get_frame_recording().getLastRecording();
 
 	record(LLStatViewer::TRIANGLES_DRAWN_PER_FRAME, last_frame_recording.getSum(LLStatViewer::TRIANGLES_DRAWN));
+	record(LLStatViewer::VOLUME_LOD_CHANGES_PER_FRAME, last_frame_recording.getSum(LLStatViewer::VOLUME_LOD_CHANGES));
 
 	sample(LLStatViewer::ENABLE_VBO,      (F64)gSavedSettings.getBOOL("RenderVBOEnable"));
 	sample(LLStatViewer::LIGHTING_DETAIL, (F64)gPipeline.getLightingDetail());
@@ -385,6 +407,9 @@ void update_statistics()
 	add(LLStatViewer::LAYERS_NETWORK_DATA_RECEIVED, layer_bits);
 	add(LLStatViewer::OBJECT_NETWORK_DATA_RECEIVED, gObjectData);
 	sample(LLStatViewer::PENDING_VFS_OPERATIONS, LLVFile::getVFSThread()->getPending());
+	sample(LLStatViewer::OBJECT_CACHE_BODY_REFERENCED, F64Bytes(LLVOCacheBody::getReferencedBytes()));
+	sample(LLStatViewer::OBJECT_CACHE_BODY_STORED, F64Bytes(LLVOCacheBody::getStoredBytes()));
+	sample(LLStatViewer::VERTEX_BUFFER_MEM, F64Bytes(LLVertexBuffer::sAllocatedBytes + LLVertexBuffer::sAllocatedIndexBytes));
 	add(LLStatViewer::ASSET_UDP_DATA_RECEIVED, F64Bits(gTransferManager.getTransferBitsIn(LLTCT_ASSET)));
 	gTransferManager.resetTransferBitsIn(LLTCT_ASSET);
 
@@ -138,7 +138,10 @@ extern LLTrace::CountStatHandle<>			FPS,
 											FRAMETIME_DOUBLED,
 											TEX_BAKES,
 											TEX_REBAKES,
-											NUM_NEW_OBJECTS;
+											NUM_NEW_OBJECTS,
+											TEXTURE_PREFETCH_COUNT,
+											VOLUME_LOD_CHANGES,
+											VOLUME_INSTANCED_FACES;
 
 extern LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > TRIANGLES_DRAWN;
 
@@ -147,6 +150,9 @@ extern LLTrace::CountStatHandle<F64Kilobytes >	ACTIVE_MESSAGE_DATA_RECEIVED,
 																	OBJECT_NETWORK_DATA_RECEIVED,
 																	ASSET_UDP_DATA_RECEIVED,
 																	TEXTURE_NETWORK_DATA_RECEIVED,
+																	MESH_DECODED_CACHE_MAPPED,
+																	OBJECT_CACHE_DATA_WRITTEN,
+																	VOLUME_INSTANCE_DATA_SAVED,
 																	MESSAGE_SYSTEM_DATA_IN,
 																	MESSAGE_SYSTEM_DATA_OUT;
 
@@ -187,6 +193,8 @@ extern LLTrace::SampleStatHandle<>		FPS_SAMPLE,
 										SHADER_OBJECTS,
 										DRAW_DISTANCE,
 										PENDING_VFS_OPERATIONS,
+										TEXTURE_CACHE_QUEUE,
+										TEXTURE_CREATE_QUEUE,
 										WINDOW_WIDTH,
 										WINDOW_HEIGHT;
 
@@ -195,9 +203,13 @@ extern LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > PACKETS_LOST_PE
 extern LLTrace::SampleStatHandle<F64Megabytes >	GL_TEX_MEM,
 																	GL_BOUND_MEM,
 																	RAW_MEM,
-																	FORMATTED_MEM;
+																	FORMATTED_MEM,
+																	VERTEX_BUFFER_MEM;
 extern LLTrace::SampleStatHandle<F64Kilobytes >	DELTA_BANDWIDTH,
-																	MAX_BANDWIDTH;
+																	MAX_BANDWIDTH,
+																	OBJECT_CACHE_BODY_REFERENCED,
+																	OBJECT_CACHE_BODY_STORED,
+																	COMPACT_VOLUME_SAVINGS;
 extern SimMeasurement<F64Milliseconds >	SIM_FRAME_TIME,
 															SIM_NET_TIME,
 															SIM_OTHER_TIME,
@@ -231,7 +243,11 @@ extern LLTrace::EventStatHandle<F64Milliseconds >	REGION_CROSSING_TIME,
 														NETWORK_STACKTIME,
 														IMAGE_STACKTIME,
 														REBUILD_STACKTIME,
-														RENDER_STACKTIME;
+														RENDER_STACKTIME,
+														TEXTURE_CREATE_TIME,
+														OBJECT_CACHE_WRITE_TIME,
+														VOLUME_LOD_PASS_TIME,
+														VOLUME_REBUILD_TIME;
 
 extern LLTrace::EventStatHandle<F64Seconds >	AVATAR_EDIT_TIME,
 																TOOLBOX_TIME,
@@ -240,7 +256,9 @@ extern LLTrace::EventStatHandle<F64Seconds >	AVATAR_EDIT_TIME,
 																FPS_8_TIME,
 																FPS_2_TIME;
 
-extern LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > OBJECT_CACHE_HIT_RATE;
+extern LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > OBJECT_CACHE_HIT_RATE,
+																TEXTURE_PREFETCH_WARM,
+																MESH_DECODED_CACHE_HIT_RATE;
 
 }
 
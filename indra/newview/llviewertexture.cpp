@@ -1098,6 +1098,7 @@ void LLViewerFetchedTexture::init(bool firstinit)
 	mCanUseHTTP = true;
 	mDesiredDiscardLevel = MAX_DISCARD_LEVEL + 1;
 	mMinDesiredDiscardLevel = MAX_DISCARD_LEVEL + 1;
+	mPrefetchDiscardLevel = -1;
 	
 	mDecodingAux = FALSE;
 
@@ -1734,6 +1735,11 @@ F32 LLViewerFetchedTexture::calcDecodePriority()
 			// Always want high boosted images
 			priority = 1.f;
 		}
+		else if (mPrefetchDiscardLevel >= 0)
+		{
+			// Only wanted by a region prefetch, rank below anything on screen
+			priority = 1.f;
+		}
 		else
 		{
 			priority = -5.f; //stop fetching
@@ -2015,11 +2021,16 @@ bool LLViewerFetchedTexture::updateFetch()
 		// keep in mind that fetcher still might need raw image, don't modify original
 		bool finished = LLAppViewer::getTextureFetch()->getRequestFinished(getID(), fetch_discard, mRawImage, mAuxRawImage,
 																		   mLastHttpGetStatus);
-		if (mRawImage.notNull()) sRawCount++;
+		if (mRawImage.notNull())
+		{
+			sRawCount++;
+			mRawImage->setMemoryCategory(getRawImageCategory(LLImageMemory::FETCHED));
+		}
 		if (mAuxRawImage.notNull())
 		{
 			mHasAux = TRUE;
 			sAuxCount++;
+			mAuxRawImage->setMemoryCategory(getRawImageCategory(LLImageMemory::FETCHED));
 		}
 		if (finished)
 		{
@@ -2826,6 +2837,12 @@ LLImageRaw* LLViewerFetchedTexture::reloadRawImage(S8 discard_level)
 	}
 	else
 	{		
+		if(mCachedRawImage.isNull())
+		{
+			//evicted to stay in the image memory budget
+			return NULL;
+		}
+
 		//force to fetch raw image again if cached raw image is not good enough.
 		if(mCachedRawDiscardLevel > discard_level)
 		{
@@ -2933,6 +2950,7 @@ void LLViewerFetchedTexture::setCachedRawImage(S32 discard_level, LLImageRaw* im
         {
             mCachedRawImage = imageraw;
         }
+		mCachedRawImage->setMemoryCategory(getRawImageCategory(LLImageMemory::CACHED));
 		mCachedRawDiscardLevel = discard_level;
 		mCachedRawImageReady = TRUE;
 	}
@@ -2993,6 +3011,7 @@ void LLViewerFetchedTexture::setCachedRawImage()
 			}
 		}
 		mCachedRawImage = mRawImage;
+		mCachedRawImage->setMemoryCategory(getRawImageCategory(LLImageMemory::CACHED));
 		mRawDiscardLevel += i;
 		mCachedRawDiscardLevel = mRawDiscardLevel;			
 	}
@@ -3039,6 +3058,7 @@ void LLViewerFetchedTexture::saveRawImage()
     {
         mSavedRawImage = new LLImageRaw(mRawImage->getData(), mRawImage->getWidth(), mRawImage->getHeight(), mRawImage->getComponents());
     }
+	mSavedRawImage->setMemoryCategory(getRawImageCategory(LLImageMemory::SAVED));
 
 	if(mForceToSaveRawImage && mSavedRawDiscardLevel <= mDesiredSavedRawDiscardLevel)
 	{
@@ -3106,6 +3126,13 @@ void LLViewerFetchedTexture::destroySavedRawImage()
 
 	clearCallbackEntryList();
 	
+	resetSavedRawImage(false);
+}
+
+//drop the saved raw image and what was asked of it, and the aux raw image
+//unless keep_aux_for_raw is set and a raw image still goes with it.
+void LLViewerFetchedTexture::resetSavedRawImage(bool keep_aux_for_raw)
+{
 	mSavedRawImage = NULL ;
 	mForceToSaveRawImage  = FALSE ;
 	mSaveRawImage = FALSE ;
@@ -3114,7 +3141,7 @@ void LLViewerFetchedTexture::destroySavedRawImage()
 	mLastReferencedSavedRawImageTime = 0.0f ;
 	mKeptSavedRawImageTime = 0.f ;
 	
-	if(mAuxRawImage.notNull())
+	if(mAuxRawImage.notNull() && !(keep_aux_for_raw && mRawImage.notNull()))
 	{
 		sAuxCount--;
 		mAuxRawImage = NULL;
@@ -3138,6 +3165,94 @@ F32 LLViewerFetchedTexture::getElapsedLastReferencedSavedRawImageTime() const
 	return sCurrentTime - mLastReferencedSavedRawImageTime;
 }
 
+S32 LLViewerFetchedTexture::getRawImageCategory(S32 category) const
+{
+	return mBoostLevel == LLGLTexture::BOOST_UI ? LLImageMemory::UI : category;
+}
+
+bool LLViewerFetchedTexture::canEvictSavedRawImage() const
+{
+	//nobody waits on it, nobody else holds it and it outlived its kept time
+	return mSavedRawImage.notNull()
+		&& mSavedRawImage != mRawImage
+		&& mSavedRawImage->getNumRefs() == 1
+		&& !mForceToSaveRawImage
+		&& mLoadedCallbackList.empty()
+		&& getElapsedLastReferencedSavedRawImageTime() > mKeptSavedRawImageTime;
+}
+
+bool LLViewerFetchedTexture::canEvictCachedRawImage() const
+{
+	//sculpts and terrain build from the cached raw image, and without a
+	//GL texture it is all there is to show
+	return mCachedRawImage.notNull()
+		&& mCachedRawImage != mRawImage
+		&& mCachedRawImage->getNumRefs() == 1
+		&& mLoadedCallbackList.empty()
+		&& !mForSculpt
+		&& mBoostLevel != LLGLTexture::BOOST_TERRAIN
+		&& hasGLTexture()
+		&& getDiscardLevel() >= 0;
+}
+
+//virtual
+S32 LLViewerFetchedTexture::getEvictableImageMemory()
+{
+	S32 bytes = 0;
+	if (canEvictSavedRawImage())
+	{
+		bytes += mSavedRawImage->getDataSize();
+		if (mAuxRawImage.notNull() && mRawImage.isNull())
+		{
+			bytes += mAuxRawImage->getDataSize();
+		}
+	}
+	if (canEvictCachedRawImage())
+	{
+		bytes += mCachedRawImage->getDataSize();
+	}
+	return bytes;
+}
+
+//virtual
+F32 LLViewerFetchedTexture::getImageMemoryIdleTime()
+{
+	F32 idle = mLastReferencedTimer.getElapsedTimeF32();
+	if (mSavedRawImage.notNull())
+	{
+		idle = llmin(idle, getElapsedLastReferencedSavedRawImageTime());
+	}
+	return idle;
+}
+
+//virtual
+F32 LLViewerFetchedTexture::getImageMemoryCost()
+{
+	//the cached raw image is a copy of the GL texture, the saved one takes a fetch and a decode
+	F32 cost = canEvictSavedRawImage() ? 4.f : 1.f;
+	if (mBoostLevel >= LLGLTexture::BOOST_HIGH)
+	{
+		//boosted textures are wanted back right away
+		cost *= 2.f;
+	}
+	return cost;
+}
+
+//virtual
+void LLViewerFetchedTexture::evictImageMemory()
+{
+	if (canEvictSavedRawImage())
+	{
+		resetSavedRawImage(true);
+	}
+	if (canEvictCachedRawImage())
+	{
+		mCachedRawImage = NULL;
+		mCachedRawDiscardLevel = -1;
+		mCachedRawImageReady = FALSE;
+	}
+}
+
 //----------------------------------------------------------------------------------------------
 //end of LLViewerFetchedTexture
 //----------------------------------------------------------------------------------------------
@@ -3201,7 +3316,12 @@ void LLViewerLODTexture::processTextureStats()
 	else if (mBoostLevel < LLGLTexture::BOOST_HIGH && mMaxVirtualSize <= 10.f)
 	{
 		// If the image has not been significantly visible in a while, we don't want it
+		// unless a region prefetch asked for it
 		mDesiredDiscardLevel = llmin(mMinDesiredDiscardLevel, (S8)(MAX_DISCARD_LEVEL + 1));
+		if (mPrefetchDiscardLevel >= 0)
+		{
+			mDesiredDiscardLevel = llmin(mDesiredDiscardLevel, mPrefetchDiscardLevel);
+		}
 	}
 	else if (!mFullWidth  || !mFullHeight)
 	{
@@ -28,6 +28,7 @@
 #define LL_LLVIEWERTEXTURE_H
 
 #include "llgltexture.h"
+#include "llimagememory.h"
 #include "lltimer.h"
 #include "llframetimer.h"
 #include "llhost.h"
@@ -268,7 +269,7 @@ const std::string& fttype_to_string(const FTType& fttype);
 //raw image data is fetched from remote or local cache
 //but the raw image this texture pointing to is fixed.
 //
-class LLViewerFetchedTexture : public LLViewerTexture
+class LLViewerFetchedTexture : public LLViewerTexture, public LLImageMemoryHolder
 {
 	friend class LLTextureBar; // debug info only
 	friend class LLTextureView; // debug info only
@@ -348,6 +349,8 @@ public:
 
 	S32  getDesiredDiscardLevel()			 { return mDesiredDiscardLevel; }
 	void setMinDiscardLevel(S32 discard) 	{ mMinDesiredDiscardLevel = llmin(mMinDesiredDiscardLevel,(S8)discard); }
+	// Discard level wanted by a region prefetch while nothing on screen uses the texture, -1 for none
+	void setPrefetchDiscardLevel(S32 discard) { mPrefetchDiscardLevel = (S8)discard; }
 
 	bool updateFetch();
 	bool setDebugFetching(S32 debug_level);
@@ -412,6 +415,12 @@ public:
 	LLImageRaw* getSavedRawImage() ;
 	BOOL        hasSavedRawImage() const ;
 	F32         getElapsedLastReferencedSavedRawImageTime() const ;
+
+	// LLImageMemoryHolder, gives back the saved and cached raw images
+	/*virtual*/ S32 getEvictableImageMemory();
+	/*virtual*/ F32 getImageMemoryIdleTime();
+	/*virtual*/ F32 getImageMemoryCost();
+	/*virtual*/ void evictImageMemory();
 	BOOL		isFullyLoaded() const;
 
 	BOOL        hasFetcher() const { return mHasFetcher;}
@@ -433,7 +442,11 @@ private:
 	void cleanup() ;
 
 	void saveRawImage() ;
+	void resetSavedRawImage(bool keep_aux_for_raw) ;
 	void setCachedRawImage() ;
+	bool canEvictSavedRawImage() const;
+	bool canEvictCachedRawImage() const;
+	S32  getRawImageCategory(S32 category) const;
 
 	//for atlas
 	void resetFaceAtlas() ;
@@ -471,6 +484,7 @@ protected:
 	S32	mMinDiscardLevel;
 	S8  mDesiredDiscardLevel;			// The discard level we'd LIKE to have - if we have it and there's space	
 	S8  mMinDesiredDiscardLevel;	// The minimum discard level we'd like to have
+	S8  mPrefetchDiscardLevel;		// Discard level requested by a region prefetch, -1 if none
 
 	S8  mNeedsAux;					// We need to decode the auxiliary channels
 	S8  mHasAux;                    // We have aux channels
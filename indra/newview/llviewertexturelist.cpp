@@ -30,6 +30,7 @@
 
 #include "llviewertexturelist.h"
 
+#include "llagent.h"
 #include "llgl.h" // fot gathering stats from GL
 #include "llimagegl.h"
 #include "llimagebmp.h"
@@ -54,6 +55,7 @@
 #include "llviewermedia.h"
 #include "llviewerregion.h"
 #include "llviewerstats.h"
+#include "llvocache.h"
 #include "pipeline.h"
 #include "llappviewer.h"
 #include "llxuiparser.h"
@@ -94,6 +96,7 @@ LLViewerTextureList::LLViewerTextureList()
 	: mForceResetTextureStats(FALSE),
 	mMaxResidentTexMemInMegaBytes(0),
 	mMaxTotalTextureMemInMegaBytes(0),
+	mRegionPrefetchHandle(0),
 	mInitialized(FALSE)
 {
 }
@@ -250,18 +253,9 @@ void LLViewerTextureList::doPrefetchImages()
     LL_DEBUGS() << "fetched " << texture_count << " images from " << filename << LL_ENDL;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-LLViewerTextureList::~LLViewerTextureList()
-{
-}
-
-void LLViewerTextureList::shutdown()
+// Collects the recently bound fetched textures, largest first.
+S32 LLViewerTextureList::getWorkingSet(LLSD& imagelist, S32 max_count)
 {
-	// clear out preloads
-	mImagePreloads.clear();
-
-	// Write out list of currently loaded textures for precaching on startup
 	typedef std::set<std::pair<S32,LLViewerFetchedTexture*> > image_area_list_t;
 	image_area_list_t image_area_list;
 	for (image_priority_list_t::iterator iter = mImageList.begin();
@@ -288,22 +282,157 @@ void LLViewerTextureList::shutdown()
 			image_area_list.insert(std::make_pair(pixel_area, image));
 		}
 	}
-	
-	LLSD imagelist;
-	const S32 max_count = 1000;
+
 	S32 count = 0;
-	S32 image_type ;
 	for (image_area_list_t::reverse_iterator riter = image_area_list.rbegin();
 		 riter != image_area_list.rend(); ++riter)
 	{
 		LLViewerFetchedTexture* image = riter->second;
-		image_type = (S32)image->getType() ;
 		imagelist[count]["area"] = riter->first;
 		imagelist[count]["uuid"] = image->getID();
-		imagelist[count]["type"] = image_type;
+		imagelist[count]["type"] = (S32)image->getType();
+		imagelist[count]["discard"] = image->getDesiredDiscardLevel();
 		if (++count >= max_count)
 			break;
 	}
+	return count;
+}
+
+void LLViewerTextureList::saveRegionWorkingSet(U64 region_handle)
+{
+	if (!LLVOCache::instanceExists())
+	{
+		return;
+	}
+
+	static LLCachedControl<U32> max_count(gSavedSettings, "TextureRegionPrefetchMax", 2000);
+	if (max_count == 0)
+	{
+		return;
+	}
+
+	LLSD imagelist;
+	if (getWorkingSet(imagelist, (S32)max_count) > 0)
+	{
+		LLVOCache::getInstance()->writeTextureList(region_handle, imagelist);
+	}
+}
+
+void LLViewerTextureList::doPrefetchRegionImages(U64 region_handle)
+{
+	clearRegionPrefetch();
+
+	static LLCachedControl<U32> max_count(gSavedSettings, "TextureRegionPrefetchMax", 2000);
+	if (max_count == 0 || !LLVOCache::instanceExists() || LLAppViewer::instance()->getPurgeCache())
+	{
+		return;
+	}
+
+	LLSD imagelist;
+	if (!LLVOCache::getInstance()->readTextureList(region_handle, imagelist))
+	{
+		return;
+	}
+
+	// Requests go through the normal fetch queue at the lowest priority a fetch can have
+	// (see calcDecodePriority()), so textures the new scene actually asks for outrank them.
+	for (LLSD::array_iterator iter = imagelist.beginArray();
+		 iter != imagelist.endArray() && mRegionPrefetchList.size() < max_count; ++iter)
+	{
+		const LLSD& imagesd = *iter;
+		LLUUID uuid = imagesd["uuid"];
+		S32 texture_type = imagesd["type"];
+		S32 discard = imagesd["discard"];
+
+		if (LLViewerTexture::FETCHED_TEXTURE == texture_type || LLViewerTexture::LOD_TEXTURE == texture_type)
+		{
+			LLViewerFetchedTexture* image = LLViewerTextureManager::getFetchedTexture(uuid, FTT_DEFAULT, MIPMAP_TRUE, LLGLTexture::BOOST_NONE, texture_type);
+			if (image)
+			{
+				image->setPrefetchDiscardLevel(llclamp(discard, 0, MAX_DISCARD_LEVEL));
+				mRegionPrefetchList.push_back(std::make_pair(uuid, discard));
+			}
+		}
+	}
+	mRegionPrefetchHandle = region_handle;
+	mRegionPrefetchTimer.reset();
+	add(LLStatViewer::TEXTURE_PREFETCH_COUNT, (F64)mRegionPrefetchList.size());
+	LL_DEBUGS() << "prefetching " << mRegionPrefetchList.size() << " images for region " << region_handle << LL_ENDL;
+}
+
+void LLViewerTextureList::reportRegionPrefetch()
+{
+	if (mRegionPrefetchList.empty())
+	{
+		return;
+	}
+
+	S32 warm = 0;
+	for (region_prefetch_list_t::iterator iter = mRegionPrefetchList.begin();
+		 iter != mRegionPrefetchList.end(); ++iter)
+	{
+		LLViewerFetchedTexture* image = findImage(iter->first, TEX_LIST_STANDARD);
+		S32 discard = image ? image->getDiscardLevel() : -1;
+		if (discard >= 0 && discard <= iter->second)
+		{
+			++warm;
+		}
+	}
+	record(LLStatViewer::TEXTURE_PREFETCH_WARM, LLUnits::Ratio::fromValue((F32)warm / (F32)mRegionPrefetchList.size()));
+	LL_INFOS() << warm << " of " << mRegionPrefetchList.size() << " prefetched region textures were ready on arrival" << LL_ENDL;
+
+	clearRegionPrefetch();
+}
+
+void LLViewerTextureList::clearRegionPrefetch()
+{
+	for (region_prefetch_list_t::iterator iter = mRegionPrefetchList.begin();
+		 iter != mRegionPrefetchList.end(); ++iter)
+	{
+		LLViewerFetchedTexture* image = findImage(iter->first, TEX_LIST_STANDARD);
+		if (image)
+		{
+			image->setPrefetchDiscardLevel(-1);
+		}
+	}
+	mRegionPrefetchList.clear();
+	mRegionPrefetchHandle = 0;
+}
+
+void LLViewerTextureList::updateRegionPrefetch()
+{
+	if (mRegionPrefetchList.empty())
+	{
+		return;
+	}
+
+	// A prefetch that was not consumed by an arrival in time, or whose region we are not
+	// in once no teleport is underway (login prefetch followed by a region crossing), is dropped.
+	const F32 REGION_PREFETCH_TIMEOUT = 60.f;
+	LLViewerRegion* regionp = gAgent.getRegion();
+	if (mRegionPrefetchTimer.getElapsedTimeF32() > REGION_PREFETCH_TIMEOUT
+		|| (gAgent.getTeleportState() == LLAgent::TELEPORT_NONE && regionp && regionp->getHandle() != mRegionPrefetchHandle))
+	{
+		LL_DEBUGS() << "dropping prefetch of " << mRegionPrefetchList.size() << " images for region " << mRegionPrefetchHandle << LL_ENDL;
+		clearRegionPrefetch();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+LLViewerTextureList::~LLViewerTextureList()
+{
+}
+
+void LLViewerTextureList::shutdown()
+{
+	// clear out preloads
+	mImagePreloads.clear();
+	clearRegionPrefetch();
+
+	// Write out list of currently loaded textures for precaching on startup
+	LLSD imagelist;
+	S32 count = getWorkingSet(imagelist, 1000);
 	
 	if (count > 0 && !gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "").empty())
 	{
@@ -772,16 +901,26 @@ void LLViewerTextureList::updateImages(F32 max_time)
 	}
 	cleared = FALSE;
 
+	updateRegionPrefetch();
+
 	LLAppViewer::getTextureFetch()->setTextureBandwidth(LLTrace::get_frame_recording().getPeriodMeanPerSec(LLStatViewer::TEXTURE_NETWORK_DATA_RECEIVED).value());
 
 	{
 		using namespace LLStatViewer;
 		sample(NUM_IMAGES, sNumImages);
-		sample(NUM_RAW_IMAGES, LLImageRaw::sRawImageCount);
+		sample(NUM_RAW_IMAGES, LLImageRaw::sRawImageCount.CurrentValue());
 		sample(GL_TEX_MEM, LLImageGL::sGlobalTextureMemory);
 		sample(GL_BOUND_MEM, LLImageGL::sBoundTextureMemory);
-		sample(RAW_MEM, F64Bytes(LLImageRaw::sGlobalRawMemory));
-		sample(FORMATTED_MEM, F64Bytes(LLImageFormatted::sGlobalFormattedMemory));
+		sample(RAW_MEM, F64Bytes(LLImageRaw::sGlobalRawMemory.CurrentValue()));
+		sample(FORMATTED_MEM, F64Bytes(LLImageFormatted::sGlobalFormattedMemory.CurrentValue()));
+		sample(TEXTURE_CACHE_QUEUE, LLAppViewer::getTextureCache()->getPending());
+		sample(TEXTURE_CREATE_QUEUE, (S32)mCreateTextureList.size());
+	}
+
+	{
+		static LLCachedControl<U32> image_memory_budget(gSavedSettings, "ImageMemoryBudgetMB", 512);
+		LLImageMemory::setBudget((S32)(llmin((U32)image_memory_budget, 2047U) << 20));
+		LLImageMemory::update();
 	}
 
 	{
@@ -1039,7 +1178,9 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
 		image_list_t::iterator curiter = iter++;
 		enditer = iter;
 		LLViewerFetchedTexture *imagep = *curiter;
+		F64 start_time = create_timer.getElapsedTimeF64();
 		imagep->createTexture();
+		record(LLStatViewer::TEXTURE_CREATE_TIME, F64Seconds(create_timer.getElapsedTimeF64() - start_time));
 		if (create_timer.getElapsedTimeF32() > max_time)
 		{
 			break;
@@ -132,6 +132,13 @@ public:
 	
 	void doPreloadImages();
 	void doPrefetchImages();
+	// Per-region working set, saved when leaving a region and prefetched when returning to it
+	void saveRegionWorkingSet(U64 region_handle);
+	void doPrefetchRegionImages(U64 region_handle);
+	// Records how much of the prefetched working set is ready, called on arrival
+	void reportRegionPrefetch();
+	// Drops the outstanding region prefetch, called when a teleport ends or fails
+	void clearRegionPrefetch();
 
 	void clearFetchingRequests();
 	void setDebugFetching(LLViewerFetchedTexture* tex, S32 debug_level);
@@ -145,6 +152,7 @@ private:
 	F32  updateImagesFetchTextures(F32 max_time);
 	void updateImagesUpdateStats();
 	F32  updateImagesLoadingFastCache(F32 max_time);
+	S32  getWorkingSet(LLSD& imagelist, S32 max_count);
 
 	void addImage(LLViewerFetchedTexture *image, ETexListType tex_type);
 	void deleteImage(LLViewerFetchedTexture *image);
@@ -221,6 +229,15 @@ private:
 	// simply holds on to LLViewerFetchedTexture references to stop them from being purged too soon
 	std::set<LLPointer<LLViewerFetchedTexture> > mImagePreloads;
 
+	void updateRegionPrefetch();
+
+	// textures requested by doPrefetchRegionImages() with their recorded discard level,
+	// held by id so that an abandoned prefetch does not keep them loaded
+	typedef std::vector<std::pair<LLUUID, S32> > region_prefetch_list_t;
+	region_prefetch_list_t mRegionPrefetchList;
+	U64 mRegionPrefetchHandle;
+	LLFrameTimer mRegionPrefetchTimer;
+
 	BOOL mInitialized ;
 	S32Megabytes	mMaxResidentTexMemInMegaBytes;
 	S32Megabytes mMaxTotalTextureMemInMegaBytes;
@@ -778,7 +778,12 @@ public:
 				addText(xpos, ypos, llformat("%d/%d Mesh LOD Pending/Processing", LLMeshRepository::sLODPending, LLMeshRepository::sLODProcessing));
 				ypos += y_inc;
 
-				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten/(1024.f*1024.f)));
+				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten.CurrentValue()/(1024.f*1024.f)));
+
+				ypos += y_inc;
+
+				addText(xpos, ypos, llformat("%d Mesh Headers, %.3f MB (%.3f MB as LLSD)", LLMeshRepository::sHeaderCount,
+					LLMeshRepository::sHeaderBytes/(1024.f*1024.f), LLMeshRepository::sHeaderLLSDBytes/(1024.f*1024.f)));
 
 				ypos += y_inc;
 			}
@@ -35,6 +35,12 @@
 #include "pipeline.h"
 #include "llagentcamera.h"
 #include "llmemory.h"
+#include "llsdserialize.h"
+#include "llthread.h"
+#include "lltracethreadrecorder.h"
+#include "llviewerstats.h"
+
+#include <queue>
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -55,6 +61,55 @@ BOOL check_write(LLAPRFile* apr_file, void* src, S32 n_bytes)
 }
 
 
+//---------------------------------------------------------------------------
+// LLVOCacheBody
+//---------------------------------------------------------------------------
+
+LLVOCacheBody::body_map_t LLVOCacheBody::sBodies;
+U64 LLVOCacheBody::sReferencedBytes = 0;
+U64 LLVOCacheBody::sStoredBytes = 0;
+
+//static 
+LLVOCacheBody* LLVOCacheBody::get(const U8* data, U32 size)
+{
+	U32 hash = LLVOCacheFile::hashBody(data, size);
+	std::pair<body_map_t::iterator, body_map_t::iterator> range = sBodies.equal_range(hash);
+	for(body_map_t::iterator iter = range.first; iter != range.second; ++iter)
+	{
+		LLVOCacheBody* body = iter->second;
+		if(body->mSize == size && !memcmp(body->mData, data, size))
+		{
+			return body;
+		}
+	}
+	return new LLVOCacheBody(data, size, hash);
+}
+
+LLVOCacheBody::LLVOCacheBody(const U8* data, U32 size, U32 hash)
+:	mSize(size),
+	mHash(hash)
+{
+	mData = new U8[size];
+	memcpy(mData, data, size);
+	sBodies.insert(std::make_pair(hash, this));
+	sStoredBytes += size;
+}
+
+LLVOCacheBody::~LLVOCacheBody()
+{
+	std::pair<body_map_t::iterator, body_map_t::iterator> range = sBodies.equal_range(mHash);
+	for(body_map_t::iterator iter = range.first; iter != range.second; ++iter)
+	{
+		if(iter->second == this)
+		{
+			sBodies.erase(iter);
+			break;
+		}
+	}
+	sStoredBytes -= mSize;
+	delete[] mData;
+}
+
 //---------------------------------------------------------------------------
 // LLVOCacheEntry
 //---------------------------------------------------------------------------
@@ -68,15 +123,23 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
 	mHitCount(0),
 	mDupeCount(0),
 	mCRCChangeCount(0),
+	mBuffer(NULL),
+	mHead(NULL),
+	mHeadSize(0),
 	mState(INACTIVE),
 	mSceneContrib(0.f),
 	mValid(TRUE),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mCachedSlot(NULL),
+	mCacheSlotIndex(-1),
+	mCacheOffset(0),
+	mCacheCapacity(0),
+	mCacheBody(0),
+	mCacheDirty(true)
 {
-	mBuffer = new U8[dp.getBufferSize()];
-	mDP.assignBuffer(mBuffer, dp.getBufferSize());
-	mDP = dp;
+	mDP.assignBuffer(mBuffer, 0);
+	setData(dp);
 }
 
 LLVOCacheEntry::LLVOCacheEntry()
@@ -89,94 +152,58 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mDupeCount(0),
 	mCRCChangeCount(0),
 	mBuffer(NULL),
+	mHead(NULL),
+	mHeadSize(0),
 	mState(INACTIVE),
 	mSceneContrib(0.f),
 	mValid(TRUE),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mCachedSlot(NULL),
+	mCacheSlotIndex(-1),
+	mCacheOffset(0),
+	mCacheCapacity(0),
+	mCacheBody(0),
+	mCacheDirty(true)
 {
 	mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(LLVOCacheFile* cache_file, U32 slot_index)
 :	LLTrace::MemTrackable<LLVOCacheEntry, 16>("LLVOCacheEntry"),
 	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY), 
 	mBuffer(NULL),
+	mHead(NULL),
 	mUpdateFlags(-1),
 	mState(INACTIVE),
 	mSceneContrib(0.f),
 	mValid(FALSE),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mCacheFile(cache_file),
+	mCachedSlot(&cache_file->getSlot(slot_index)),
+	mCacheSlotIndex(slot_index),
+	mCacheDirty(false)
 {
-	S32 size = -1;
-	BOOL success;
-
 	mDP.assignBuffer(mBuffer, 0);
-	
-	success = check_read(apr_file, &mLocalID, sizeof(U32));
-	if(success)
-	{
-		success = check_read(apr_file, &mCRC, sizeof(U32));
-	}
-	if(success)
-	{
-		success = check_read(apr_file, &mHitCount, sizeof(S32));
-	}
-	if(success)
-	{
-		success = check_read(apr_file, &mDupeCount, sizeof(S32));
-	}
-	if(success)
-	{
-		success = check_read(apr_file, &mCRCChangeCount, sizeof(S32));
-	}
-	if(success)
-	{
-		success = check_read(apr_file, &size, sizeof(S32));
 
-		// Corruption in the cache entries
-		if ((size > 10000) || (size < 1))
-		{
-			// We've got a bogus size, skip reading it.
-			// We won't bother seeking, because the rest of this file
-			// is likely bogus, and will be tossed anyway.
-			LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
-			success = FALSE;
-		}
-	}
-	if(success && size > 0)
-	{
-		mBuffer = new U8[size];
-		success = check_read(apr_file, mBuffer, size);
-
-		if(success)
-		{
-			mDP.assignBuffer(mBuffer, size);
-		}
-		else
-		{
-			delete[] mBuffer ;
-			mBuffer = NULL ;
-		}
-	}
-
-	if(!success)
-	{
-		mLocalID = 0;
-		mCRC = 0;
-		mHitCount = 0;
-		mDupeCount = 0;
-		mCRCChangeCount = 0;
-		mBuffer = NULL;
-		mEntry = NULL;
-		mState = INACTIVE;
-	}
+	//the slot was checked when the file was opened, the data is only copied out by getDP()
+	mLocalID = mCachedSlot->mLocalID;
+	mCRC = mCachedSlot->mCRC;
+	mHitCount = mCachedSlot->mHitCount;
+	mDupeCount = mCachedSlot->mDupeCount;
+	mCRCChangeCount = mCachedSlot->mCRCChangeCount;
+	mCacheOffset = mCachedSlot->mOffset;
+	mCacheCapacity = mCachedSlot->mCapacity;
+	mCacheBody = mCachedSlot->mBody;
+	mHeadSize = mCachedSlot->mSize;
 }
 
 LLVOCacheEntry::~LLVOCacheEntry()
 {
 	mDP.freeBuffer();
+	delete[] mHead;
+	setBody(NULL);
 }
 
 void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
@@ -187,12 +214,41 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
 		mCRCChangeCount++;
 	}
 
-	mDP.freeBuffer();
+	mCacheFile = NULL;
+	mCachedSlot = NULL;
+	mCacheDirty = true;
 
 	llassert_always(dp.getBufferSize() > 0);
-	mBuffer = new U8[dp.getBufferSize()];
-	mDP.assignBuffer(mBuffer, dp.getBufferSize());
-	mDP = dp;
+	setData(dp);
+}
+
+//keep the data unique to the object, and share the rest with its copies.
+//the whole data is only assembled again when getDP() is called.
+void LLVOCacheEntry::setData(LLDataPackerBinaryBuffer &dp)
+{
+	mDP.freeBuffer();
+	mBuffer = NULL;
+	delete[] mHead;
+
+	mHeadSize = LLViewerObject::getUniqueDataSize(&dp);
+	mHead = new U8[mHeadSize];
+	memcpy(mHead, dp.getBuffer(), mHeadSize);
+
+	U32 body_size = dp.getBufferSize() - mHeadSize;
+	setBody(body_size > 0 ? LLVOCacheBody::get(dp.getBuffer() + mHeadSize, body_size) : NULL);
+}
+
+void LLVOCacheEntry::setBody(LLVOCacheBody* body)
+{
+	if(mBody.notNull())
+	{
+		LLVOCacheBody::sReferencedBytes -= mBody->getSize();
+	}
+	mBody = body;
+	if(mBody.notNull())
+	{
+		LLVOCacheBody::sReferencedBytes += mBody->getSize();
+	}
 }
 
 void LLVOCacheEntry::setParentID(U32 id) 
@@ -223,10 +279,13 @@ void LLVOCacheEntry::removeAllChildren()
 //virtual 
 void LLVOCacheEntry::setOctreeEntry(LLViewerOctreeEntry* entry)
 {
-	if(!entry && mDP.getBufferSize() > 0)
+	//the ID leads the data unique to the object
+	U8* head = mDP.getBufferSize() > 0 ? mBuffer : mHead;
+	if(!entry && head)
 	{
 		LLUUID fullid;
-		LLViewerObject::unpackUUID(&mDP, fullid, "ID");
+		LLDataPackerBinaryBuffer dp(head, mHeadSize);
+		LLViewerObject::unpackUUID(&dp, fullid, "ID");
 		
 		LLViewerObject* obj = gObjectList.findObject(fullid);
 		if(obj && obj->mDrawable)
@@ -320,6 +379,33 @@ LLVOCacheEntry* LLVOCacheEntry::getChild()
 
 LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 {
+	if (mDP.getBufferSize() == 0 && mCachedSlot)
+	{
+		//first use of an entry read from the cache file
+		U32 body_size = mCacheFile->getBodySize(*mCachedSlot);
+		mBuffer = new U8[mHeadSize + body_size];
+		memcpy(mBuffer, mCacheFile->getData(*mCachedSlot), mHeadSize);
+		if (body_size > 0)
+		{
+			memcpy(mBuffer + mHeadSize, mCacheFile->getBodyData(*mCachedSlot), body_size);
+		}
+		mDP.assignBuffer(mBuffer, mHeadSize + body_size);
+	}
+	else if (mDP.getBufferSize() == 0 && mHead)
+	{
+		//first use since the entry was updated, put the data back together
+		U32 body_size = mBody.notNull() ? mBody->getSize() : 0;
+		mBuffer = new U8[mHeadSize + body_size];
+		memcpy(mBuffer, mHead, mHeadSize);
+		if (body_size > 0)
+		{
+			memcpy(mBuffer + mHeadSize, mBody->getData(), body_size);
+		}
+		mDP.assignBuffer(mBuffer, mHeadSize + body_size);
+		delete[] mHead;
+		mHead = NULL;
+	}
+
 	if (mDP.getBufferSize() == 0)
 	{
 		//LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
@@ -345,26 +431,80 @@ void LLVOCacheEntry::dump() const
 		<< LL_ENDL;
 }
 
-BOOL LLVOCacheEntry::writeToFile(LLAPRFile* apr_file) const
+//the spatial extents of the entry without assembling its data: stored with the entry in the cache file
+//while its data is unchanged, or decoded from the data unique to the object after an update
+bool LLVOCacheEntry::getCachedExtents(U32& parent_id, LLVector3& pos, LLVector3& scale)
 {
-    static const S32 data_buffer_size = 6 * sizeof(S32);
-    static U8 data_buffer[data_buffer_size];
-    S32 size = mDP.getBufferSize();
+	if (mCachedSlot)
+	{
+		parent_id = mCachedSlot->mParentID;
+		pos.set(mCachedSlot->mPosition);
+		scale.set(mCachedSlot->mScale);
+		return true;
+	}
 
-    memcpy(data_buffer, &mLocalID, sizeof(U32));
-    memcpy(data_buffer + sizeof(U32), &mCRC, sizeof(U32));
-    memcpy(data_buffer + (2 * sizeof(U32)), &mHitCount, sizeof(S32));
-    memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
-    memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
-    memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
+	if (!mHead)
+	{
+		return false;
+	}
+
+	LLQuaternion rot;
+	LLDataPackerBinaryBuffer dp(mHead, mHeadSize);
+	parent_id = LLViewerObject::extractSpatialExtents(&dp, pos, scale, rot);
+	return true;
+}
 
-    BOOL success = check_write(apr_file, (void*)data_buffer, data_buffer_size);
-    if (success)
-    {
-        success = check_write(apr_file, (void*)mBuffer, size);
-    }
+//describe the entry for LLVOCacheFile::write(), returns false if it has no data to store
+bool LLVOCacheEntry::fillCacheRecord(LLVOCacheFile::Record& record)
+{
+	record.mSlot.mLocalID = mLocalID;
+	record.mSlot.mCRC = mCRC;
+	record.mSlot.mHitCount = mHitCount;
+	record.mSlot.mDupeCount = mDupeCount;
+	record.mSlot.mCRCChangeCount = mCRCChangeCount;
+	record.mSlot.mOffset = mCacheOffset;
+	record.mSlot.mCapacity = mCacheCapacity;
+	record.mSlot.mBody = mCacheBody;
+	record.mSlotIndex = mCacheSlotIndex;
+	record.mDirty = mCacheDirty;
+
+	if (mCachedSlot)
+	{
+		record.mData = mCacheFile->getData(*mCachedSlot);
+		record.mSlot.mSize = mCachedSlot->mSize;
+		record.mBodyData = mCacheFile->getBodyData(*mCachedSlot);
+		record.mBodySize = mCacheFile->getBodySize(*mCachedSlot);
+		record.mBodyHash = mCacheFile->getBodyHash(*mCachedSlot);
+		record.mSlot.mParentID = mCachedSlot->mParentID;
+		memcpy(record.mSlot.mPosition, mCachedSlot->mPosition, sizeof(record.mSlot.mPosition));
+		memcpy(record.mSlot.mScale, mCachedSlot->mScale, sizeof(record.mSlot.mScale));
+		return true;
+	}
+
+	//the head is at the start of mBuffer once the data is assembled
+	const U8* head = mDP.getBufferSize() > 0 ? mBuffer : mHead;
+	if (!head)
+	{
+		return false;
+	}
 
-    return success;
+	record.mData = head;
+	record.mSlot.mSize = mHeadSize;
+	if (mBody.notNull())
+	{
+		record.mBodyData = mBody->getData();
+		record.mBodySize = mBody->getSize();
+		record.mBodyHash = mBody->getHash();
+	}
+
+	LLVector3 pos;
+	LLVector3 scale;
+	LLQuaternion rot;
+	LLDataPackerBinaryBuffer dp(const_cast<U8*>(head), mHeadSize);
+	record.mSlot.mParentID = LLViewerObject::extractSpatialExtents(&dp, pos, scale, rot);
+	memcpy(record.mSlot.mPosition, pos.mV, sizeof(record.mSlot.mPosition));
+	memcpy(record.mSlot.mScale, scale.mV, sizeof(record.mSlot.mScale));
+	return true;
 }
 
 //static 
@@ -1025,6 +1165,8 @@ void LLVOCachePartition::removeOccluder(LLVOCacheGroup* group)
 //-------------------------------------------------------------------
 // Format string used to construct filename for the object cache
 static const char OBJECT_CACHE_FILENAME[] = "objects_%d_%d.slc";
+// Format string used to construct filename for the region texture working set
+static const char TEXTURE_LIST_FILENAME[] = "textures_%d_%d.llsd";
 
 const U32 MAX_NUM_OBJECT_ENTRIES = 128 ;
 const U32 MIN_ENTRIES_TO_PURGE = 16 ;
@@ -1032,12 +1174,294 @@ const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
 
+// Writes the cache files in the background.  Requests are handled in the
+// order they were submitted, so that a region file removed by a purge is
+// not brought back by an earlier write, and each one carries everything
+// it needs: the main thread keeps changing its region caches and header
+// entries while the writer works.
+class LLVOCache::Writer : public LLThread
+{
+public:
+	struct Request
+	{
+		enum EType
+		{
+			WRITE_OBJECTS,		// region object cache file
+			WRITE_TEXTURE_LIST,	// region texture working set
+			REMOVE_REGION,		// both files of a region
+			WRITE_HEADER_ENTRY,	// one entry of the header file
+			WRITE_HEADER		// the whole header file
+		};
+
+		Request(EType type, U64 handle) : mType(type), mHandle(handle), mNumDirty(0) {}
+
+		bool isRegionRequest() const { return mType <= REMOVE_REGION; }
+
+		EType mType;
+		U64 mHandle;
+		std::string mFilename;
+		std::string mTextureListFilename;
+		LLUUID mCacheID;
+		LLVOCacheFile::record_list_t mRecords;
+		std::vector<U8> mData;							// changed objects, or serialized texture list
+		std::vector<LLPointer<LLVOCacheFile> > mFiles;	// mappings the unchanged objects are in
+		U32 mNumDirty;
+		HeaderMetaInfo mMetaInfo;
+		std::vector<HeaderEntryInfo> mHeaderEntries;
+	};
+
+	Writer();
+	~Writer();
+
+	void submitRequest(Request* request);
+
+	// Wait until every request, or every request about a region, is done
+	void flush();
+	void flushRegion(U64 handle);
+
+	// A header write failed since the last call
+	bool checkFailed();
+
+	/*virtual*/ bool runCondition();
+	/*virtual*/ void run();
+
+private:
+	Request* popRequest();
+	void processRequest(Request& request);
+	bool writeObjects(Request& request);
+	bool writeHeader(const Request& request);
+
+	LLMutex* mMutex;						// guards the members below
+	std::queue<Request*> mRequestQ;
+	std::map<U64, S32> mPendingRegions;
+	S32 mPending;
+	bool mFailed;
+	LLVolatileAPRPool* mLocalAPRFilePoolp;	// only used by the writer thread
+};
+
+LLVOCache::Writer::Writer()
+	: LLThread("object cache writer"),
+	  mPending(0),
+	  mFailed(false)
+{
+	mMutex = new LLMutex();
+	mLocalAPRFilePoolp = new LLVolatileAPRPool();
+	start();
+}
+
+LLVOCache::Writer::~Writer()
+{
+	// Stopping the thread finishes the queued requests first
+	shutdown();
+
+	delete mLocalAPRFilePoolp;
+	delete mMutex;
+}
+
+void LLVOCache::Writer::submitRequest(Request* request)
+{
+	{
+		LLMutexLock lock(mMutex);
+		mRequestQ.push(request);
+		mPending++;
+		if (request->isRegionRequest())
+		{
+			mPendingRegions[request->mHandle]++;
+		}
+	}
+	wake();
+}
+
+void LLVOCache::Writer::flush()
+{
+	while (1)
+	{
+		{
+			LLMutexLock lock(mMutex);
+			if (mPending == 0)
+			{
+				return;
+			}
+		}
+		ms_sleep(1);
+	}
+}
+
+void LLVOCache::Writer::flushRegion(U64 handle)
+{
+	while (1)
+	{
+		{
+			LLMutexLock lock(mMutex);
+			if (mPendingRegions.find(handle) == mPendingRegions.end())
+			{
+				return;
+			}
+		}
+		ms_sleep(1);
+	}
+}
+
+bool LLVOCache::Writer::checkFailed()
+{
+	LLMutexLock lock(mMutex);
+	bool failed = mFailed;
+	mFailed = false;
+	return failed;
+}
+
+// virtual
+bool LLVOCache::Writer::runCondition()
+{
+	LLMutexLock lock(mMutex);
+	return isQuitting() || !mRequestQ.empty();
+}
+
+// virtual
+void LLVOCache::Writer::run()
+{
+	while (1)
+	{
+		checkPause();
+
+		Request* request = popRequest();
+		if (!request)
+		{
+			if (isQuitting())
+			{
+				LLTrace::get_thread_recorder()->pushToParent();
+				break;
+			}
+			continue;
+		}
+
+		processRequest(*request);
+		// hand the write time and byte counts to the main thread as they come in
+		LLTrace::get_thread_recorder()->pushToParent();
+
+		{
+			LLMutexLock lock(mMutex);
+			mPending--;
+			if (request->isRegionRequest())
+			{
+				std::map<U64, S32>::iterator iter = mPendingRegions.find(request->mHandle);
+				if (--iter->second == 0)
+				{
+					mPendingRegions.erase(iter);
+				}
+			}
+		}
+		delete request;
+	}
+}
+
+LLVOCache::Writer::Request* LLVOCache::Writer::popRequest()
+{
+	LLMutexLock lock(mMutex);
+	if (mRequestQ.empty())
+	{
+		return NULL;
+	}
+	Request* request = mRequestQ.front();
+	mRequestQ.pop();
+	return request;
+}
+
+void LLVOCache::Writer::processRequest(Request& request)
+{
+	switch (request.mType)
+	{
+	case Request::WRITE_OBJECTS:
+		if (!writeObjects(request))
+		{
+			// The header entry is dropped when the region cache fails to read
+			LLAPRFile::remove(request.mFilename, mLocalAPRFilePoolp);
+		}
+		break;
+
+	case Request::WRITE_TEXTURE_LIST:
+		{
+			LLAPRFile apr_file(request.mFilename, APR_CREATE|APR_WRITE|APR_TRUNCATE|APR_BINARY, mLocalAPRFilePoolp);
+			if (!apr_file.getFileHandle()
+				|| !check_write(&apr_file, &request.mData[0], request.mData.size()))
+			{
+				LL_WARNS() << "Failed to write texture list " << request.mFilename << LL_ENDL;
+			}
+		}
+		break;
+
+	case Request::REMOVE_REGION:
+		LLAPRFile::remove(request.mFilename, mLocalAPRFilePoolp);
+		LLFile::remove(request.mTextureListFilename, ENOENT);
+		break;
+
+	case Request::WRITE_HEADER_ENTRY:
+	case Request::WRITE_HEADER:
+		if (!writeHeader(request))
+		{
+			LL_WARNS() << "Failed to write object cache header " << request.mFilename << LL_ENDL;
+			LLMutexLock lock(mMutex);
+			mFailed = true;
+		}
+		break;
+	}
+}
+
+bool LLVOCache::Writer::writeObjects(Request& request)
+{
+	LLTimer timer;
+	LLVOCacheFile::WriteStats stats;
+	bool success = LLVOCacheFile::write(request.mFilename, request.mCacheID, request.mRecords, mLocalAPRFilePoolp, &stats);
+	F64Seconds elapsed(timer.getElapsedTimeF64());
+	record(LLStatViewer::OBJECT_CACHE_WRITE_TIME, elapsed);
+	add(LLStatViewer::OBJECT_CACHE_DATA_WRITTEN, F64Bytes(stats.mBytes));
+
+	U32 region_x, region_y;
+	grid_from_region_handle(request.mHandle, &region_x, &region_y);
+	LL_INFOS() << "Object cache of region " << region_x << ", " << region_y << ": "
+		<< request.mNumDirty << " of " << request.mRecords.size() << " objects changed, "
+		<< stats.mBytes << " bytes written" << (stats.mRewritten ? " (rewritten)" : "") << ", "
+		<< stats.mBodies << " distinct bodies, " << stats.mSharedBodies << " shared"
+		<< " in " << F64Milliseconds(elapsed).value() << " ms" << LL_ENDL;
+	return success;
+}
+
+bool LLVOCache::Writer::writeHeader(const Request& request)
+{
+	if (request.mType == Request::WRITE_HEADER_ENTRY)
+	{
+		const HeaderEntryInfo& entry = request.mHeaderEntries[0];
+		LLAPRFile apr_file(request.mFilename, APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
+		apr_file.seek(APR_SET, entry.mIndex * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)) ;
+		return check_write(&apr_file, (void*)&entry, sizeof(HeaderEntryInfo));
+	}
+
+	LLAPRFile apr_file(request.mFilename, APR_CREATE|APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
+
+	//write the meta element, the entries, then fill the rest with the default entry.
+	HeaderMetaInfo meta_info = request.mMetaInfo;
+	bool success = check_write(&apr_file, &meta_info, sizeof(HeaderMetaInfo));
+	for (U32 i = 0; success && i < request.mHeaderEntries.size(); i++)
+	{
+		success = check_write(&apr_file, (void*)&request.mHeaderEntries[i], sizeof(HeaderEntryInfo));
+	}
+	HeaderEntryInfo entry;
+	entry.mTime = INVALID_TIME;
+	for (U32 i = request.mHeaderEntries.size(); success && i < MAX_NUM_OBJECT_ENTRIES; i++)
+	{
+		success = check_write(&apr_file, &entry, sizeof(HeaderEntryInfo));
+	}
+	return success;
+}
+
+
 
 LLVOCache::LLVOCache(bool read_only) :
 	mInitialized(false),
 	mReadOnly(read_only),
 	mNumEntries(0),
-	mCacheSize(1)
+	mCacheSize(1),
+	mWriter(NULL)
 {
 	mEnabled = gSavedSettings.getBOOL("ObjectCacheEnabled");
 	mLocalAPRFilePoolp = new LLVolatileAPRPool() ;
@@ -1050,6 +1474,12 @@ LLVOCache::~LLVOCache()
 		writeCacheHeader();
 		clearCacheInMemory();
 	}
+	if(mWriter)
+	{
+		//the header goes last, after the region caches queued before it.
+		mWriter->flush();
+		delete mWriter;
+	}
 	delete mLocalAPRFilePoolp;
 }
 
@@ -1078,6 +1508,10 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
 	if (!mReadOnly)
 	{
 		LLFile::mkdir(mObjectCacheDirName);
+		if(!mWriter)
+		{
+			mWriter = new Writer();
+		}
 	}
 	mCacheSize = llclamp(size, MIN_ENTRIES_TO_PURGE, MAX_NUM_OBJECT_ENTRIES);
 	mMetaInfo.mVersion = cache_version;
@@ -1122,6 +1556,10 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 	}	
 
 	LL_INFOS() << "about to remove the object cache due to settings." << LL_ENDL ;
+	if(mWriter)
+	{
+		mWriter->flush();
+	}
 
 	std::string mask = "*";
 	std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
@@ -1147,6 +1585,11 @@ void LLVOCache::removeCache()
 		return ;
 	}
 
+	if(mWriter)
+	{
+		mWriter->flush();
+	}
+
 	std::string mask = "*";
 	LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
@@ -1216,6 +1659,62 @@ void LLVOCache::getObjectCacheFilename(U64 handle, std::string& filename)
 	return ;
 }
 
+void LLVOCache::getTextureListFilename(U64 handle, std::string& filename)
+{
+	U32 region_x, region_y;
+
+	grid_from_region_handle(handle, &region_x, &region_y);
+	filename = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, object_cache_dirname,
+			   llformat(TEXTURE_LIST_FILENAME, region_x, region_y));
+}
+
+bool LLVOCache::readTextureList(U64 handle, LLSD& texture_list)
+{
+	if(!mEnabled || !mInitialized)
+	{
+		return false;
+	}
+
+	if(mWriter)
+	{
+		mWriter->flushRegion(handle);
+	}
+
+	std::string filename;
+	getTextureListFilename(handle, filename);
+	llifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	if (LLSDSerialize::fromBinary(texture_list, file, LLSDSerialize::SIZE_UNLIMITED) <= 0 || !texture_list.isArray())
+	{
+		LL_WARNS() << "Removing invalid texture list " << filename << LL_ENDL;
+		file.close();
+		LLFile::remove(filename);
+		texture_list.clear();
+		return false;
+	}
+	return true;
+}
+
+void LLVOCache::writeTextureList(U64 handle, const LLSD& texture_list)
+{
+	if(!mEnabled || !mInitialized || mReadOnly)
+	{
+		return;
+	}
+
+	std::ostringstream stream;
+	LLSDSerialize::toBinary(texture_list, stream);
+	const std::string& data = stream.str();
+
+	Writer::Request* request = new Writer::Request(Writer::Request::WRITE_TEXTURE_LIST, handle);
+	getTextureListFilename(handle, request->mFilename);
+	request->mData.assign(data.begin(), data.end());
+	mWriter->submitRequest(request);
+}
+
 void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 {
 	if(mReadOnly)
@@ -1224,9 +1723,10 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
-	std::string filename;
-	getObjectCacheFilename(entry->mHandle, filename);
-	LLAPRFile::remove(filename, mLocalAPRFilePoolp);
+	Writer::Request* request = new Writer::Request(Writer::Request::REMOVE_REGION, entry->mHandle);
+	getObjectCacheFilename(entry->mHandle, request->mFilename);
+	getTextureListFilename(entry->mHandle, request->mTextureListFilename);
+	mWriter->submitRequest(request);
 	entry->mTime = INVALID_TIME ;
 	updateEntry(entry) ; //update the head file.
 }
@@ -1328,50 +1828,43 @@ void LLVOCache::writeCacheHeader()
 		return;
 	}
 
-	bool success = true ;
+	if(!mWriter)
 	{
-		LLAPRFile apr_file(mHeaderFileName, APR_CREATE|APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
-
-		//write the meta element
-		success = check_write(&apr_file, &mMetaInfo, sizeof(HeaderMetaInfo)) ;
-
-
-		mNumEntries = 0 ;	
-		for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ; success && iter != mHeaderEntryQueue.end(); ++iter)
-		{
-			(*iter)->mIndex = mNumEntries++ ;
-			success = check_write(&apr_file, (void*)*iter, sizeof(HeaderEntryInfo));
-		}
-	
-		mNumEntries = mHeaderEntryQueue.size() ;
-		if(success && mNumEntries < MAX_NUM_OBJECT_ENTRIES)
-		{
-			HeaderEntryInfo* entry = new HeaderEntryInfo() ;
-			entry->mTime = INVALID_TIME ;
-			for(S32 i = mNumEntries ; success && i < MAX_NUM_OBJECT_ENTRIES ; i++)
-			{
-				//fill the cache with the default entry.
-				success = check_write(&apr_file, entry, sizeof(HeaderEntryInfo)) ;			
-
-			}
-			delete entry ;
-		}
+		return; //not initialized
 	}
 
-	if(!success)
+	Writer::Request* request = new Writer::Request(Writer::Request::WRITE_HEADER, 0);
+	request->mFilename = mHeaderFileName;
+	request->mMetaInfo = mMetaInfo;
+	request->mHeaderEntries.reserve(mHeaderEntryQueue.size());
+
+	mNumEntries = 0 ;	
+	for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ; iter != mHeaderEntryQueue.end(); ++iter)
 	{
-		clearCacheInMemory() ;
-		mReadOnly = TRUE ; //disable the cache.
+		(*iter)->mIndex = mNumEntries++ ;
+		request->mHeaderEntries.push_back(**iter);
 	}
+	mWriter->submitRequest(request);
 	return ;
 }
 
-BOOL LLVOCache::updateEntry(const HeaderEntryInfo* entry)
+void LLVOCache::updateEntry(const HeaderEntryInfo* entry)
 {
-	LLAPRFile apr_file(mHeaderFileName, APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
-	apr_file.seek(APR_SET, entry->mIndex * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)) ;
+	Writer::Request* request = new Writer::Request(Writer::Request::WRITE_HEADER_ENTRY, entry->mHandle);
+	request->mFilename = mHeaderFileName;
+	request->mHeaderEntries.push_back(*entry);
+	mWriter->submitRequest(request);
+}
 
-	return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
+//a failed header write disables the cache, as the header no longer matches the files.
+void LLVOCache::checkWriteFailure()
+{
+	if(mWriter && mWriter->checkFailed())
+	{
+		LL_WARNS() << "Failed to write the object cache header, the cache is now read-only." << LL_ENDL;
+		clearCacheInMemory() ;
+		mReadOnly = TRUE ; //disable the cache.
+	}
 }
 
 void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) 
@@ -1390,44 +1883,31 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 		return ;
 	}
 
+	//a write of the region cache may still be queued
+	if(mWriter)
+	{
+		mWriter->flushRegion(handle);
+	}
+
 	bool success = true ;
 	{
 		std::string filename;
 		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-	
-		LLUUID cache_id ;
-		success = check_read(&apr_file, cache_id.mData, UUID_BYTES) ;
-	
-		if(success)
-		{		
-			if(cache_id != id)
-			{
-				LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-				success = false ;
-			}
 
-			if(success)
+		//map the file, the entries only read their slot until their data is needed.
+		LLPointer<LLVOCacheFile> cache_file = new LLVOCacheFile();
+		success = cache_file->open(filename, id);
+		if(success)
+		{
+			for (U32 i = 0; i < cache_file->getNumSlots(); i++)
 			{
-				S32 num_entries;
-				success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-	
-				if(success)
+				if (cache_file->getSlot(i).mLocalID)
 				{
-					for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
-					{
-						LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-						if (!entry->getLocalID())
-						{
-							LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-							success = false ;
-							break ;
-						}
-						cache_entry_map[entry->getLocalID()] = entry;
-					}
+					LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(cache_file, i);
+					cache_entry_map[entry->getLocalID()] = entry;
 				}
 			}
-		}		
+		}
 	}
 	
 	if(!success)
@@ -1464,6 +1944,7 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 	}
 	llassert_always(mInitialized);
 
+	checkWriteFailure();
 	if(mReadOnly)
 	{
 		LL_WARNS() << "Not writing cache for handle " << handle << "): Cache is currently in read-only mode." << LL_ENDL;
@@ -1499,11 +1980,7 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 	}
 
 	//update cache header
-	if(!updateEntry(entry))
-	{
-		LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
-		return ; //update failed.
-	}
+	updateEntry(entry);
 
 	if(!dirty_cache)
 	{
@@ -1511,40 +1988,83 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		return ; //nothing changed, no need to update.
 	}
 
-	//write to cache file
-	bool success = true ;
+	//snapshot the entries for the writer, only the entries that changed are written out.
+	//their data is copied, each shared body once, the others stay in the mapped cache file they were read from.
+	struct CopiedRecord
 	{
-		std::string filename;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES) ;
+		U32 mIndex;
+		U32 mHeadOffset;
+		U32 mBodyOffset;
+	};
+	std::vector<CopiedRecord> copied_records;
+	std::map<const U8*, U32> body_offsets;
 
-	
-		if(success)
+	Writer::Request* request = new Writer::Request(Writer::Request::WRITE_OBJECTS, handle);
+	getObjectCacheFilename(handle, request->mFilename);
+	request->mCacheID = id;
+	LLVOCacheFile::record_list_t& records = request->mRecords;
+	records.reserve(cache_entry_map.size());
+	for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
+	{
+		LLVOCacheEntry* cache_entry = iter->second;
+		if(!removal_enabled || cache_entry->isValid())
 		{
-			S32 num_entries = cache_entry_map.size() ;
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
+			records.push_back(LLVOCacheFile::Record());
+			LLVOCacheFile::Record& record = records.back();
+			if (!cache_entry->fillCacheRecord(record))
+			{
+				records.pop_back();
+				continue;
+			}
 
-			// This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-			for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
+			LLVOCacheFile* cache_file = cache_entry->getCacheFile();
+			if (cache_file)
+			{
+				if (request->mFiles.empty() || request->mFiles.back() != cache_file)
+				{
+					request->mFiles.push_back(cache_file);
+				}
+			}
+			else
 			{
-				if(!removal_enabled || iter->second->isValid())
+				CopiedRecord copied;
+				copied.mIndex = records.size() - 1;
+				copied.mHeadOffset = request->mData.size();
+				copied.mBodyOffset = 0;
+				request->mData.insert(request->mData.end(), record.mData, record.mData + record.mSlot.mSize);
+				if (record.mBodyData)
 				{
-					success = iter->second->writeToFile(&apr_file) ;
-					if(!success)
+					std::map<const U8*, U32>::iterator body_iter = body_offsets.find(record.mBodyData);
+					if (body_iter == body_offsets.end())
 					{
-						break;
+						copied.mBodyOffset = request->mData.size();
+						request->mData.insert(request->mData.end(), record.mBodyData, record.mBodyData + record.mBodySize);
+						body_offsets[record.mBodyData] = copied.mBodyOffset;
+					}
+					else
+					{
+						copied.mBodyOffset = body_iter->second;
 					}
 				}
+				copied_records.push_back(copied);
+			}
+			if (record.mDirty)
+			{
+				request->mNumDirty++;
 			}
 		}
 	}
 
-	if(!success)
+	//the copy is complete, point the copied records at it.
+	for (std::vector<CopiedRecord>::iterator copied_iter = copied_records.begin(); copied_iter != copied_records.end(); ++copied_iter)
 	{
-		removeEntry(entry) ;
+		LLVOCacheFile::Record& record = records[copied_iter->mIndex];
+		record.mData = request->mData.data() + copied_iter->mHeadOffset;
+		if (record.mBodyData)
+		{
+			record.mBodyData = request->mData.data() + copied_iter->mBodyOffset;
+		}
 	}
-
-	return ;
+	//a failed write removes the file, the header entry is dropped when the region is read next.
+	mWriter->submitRequest(request);
 }
@@ -32,11 +32,47 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
+#include "llvocachefile.h"
 
 //---------------------------------------------------------------------------
 // Cache entries
 class LLCamera;
 
+// Object update data that copies of an object have in common: everything
+// after the fields unique to each copy, see LLViewerObject::getUniqueDataSize().
+// Identical bodies are stored once and shared by the cache entries of all
+// regions, shops and sandboxes are full of copies of the same objects.
+class LLVOCacheBody : public LLRefCount
+{
+	friend class LLVOCacheEntry;
+public:
+	// The body identical to data, created if there is none yet
+	static LLVOCacheBody* get(const U8* data, U32 size);
+
+	const U8* getData() const	{ return mData; }
+	U32 getSize() const			{ return mSize; }
+	U32 getHash() const			{ return mHash; }
+
+	// Body bytes of all cache entries, and what they take once shared
+	static U64 getReferencedBytes()	{ return sReferencedBytes; }
+	static U64 getStoredBytes()		{ return sStoredBytes; }
+
+protected:
+	~LLVOCacheBody();
+
+private:
+	LLVOCacheBody(const U8* data, U32 size, U32 hash);
+
+	U8* mData;
+	U32 mSize;
+	U32 mHash;
+
+	typedef std::multimap<U32, LLVOCacheBody*> body_map_t;
+	static body_map_t sBodies;	// by hash
+	static U64 sReferencedBytes;
+	static U64 sStoredBytes;
+};
+
 class LLVOCacheEntry 
 :	public LLViewerOctreeEntryData,
 	public LLTrace::MemTrackable<LLVOCacheEntry, 16>
@@ -83,7 +119,7 @@ protected:
 	~LLVOCacheEntry();
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-	LLVOCacheEntry(LLAPRFile* apr_file);
+	LLVOCacheEntry(LLVOCacheFile* cache_file, U32 slot_index);
 	LLVOCacheEntry();	
 
 	void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -106,8 +142,10 @@ public:
 	F32 getSceneContribution() const             { return mSceneContrib;}
 
 	void dump() const;
-	BOOL writeToFile(LLAPRFile* apr_file) const;
 	LLDataPackerBinaryBuffer *getDP();
+	bool getCachedExtents(U32& parent_id, LLVector3& pos, LLVector3& scale);
+	bool fillCacheRecord(LLVOCacheFile::Record& record);
+	LLVOCacheFile* getCacheFile() const { return mCachedSlot ? mCacheFile.get() : NULL; }
 	void recordHit();
 	void recordDupe() { mDupeCount++; }
 	
@@ -138,6 +176,8 @@ public:
 
 private:
 	void updateParentBoundingInfo(const LLVOCacheEntry* child);	
+	void setData(LLDataPackerBinaryBuffer &dp);
+	void setBody(LLVOCacheBody* body);
 
 public:
 	typedef std::map<U32, LLPointer<LLVOCacheEntry> >	   vocache_entry_map_t;
@@ -153,8 +193,19 @@ protected:
 	S32							mHitCount;
 	S32							mDupeCount;
 	S32							mCRCChangeCount;
-	LLDataPackerBinaryBuffer	mDP;
+	LLDataPackerBinaryBuffer	mDP; //the whole update data, assembled on first use
 	U8							*mBuffer;
+	U8							*mHead; //update data unique to the object until mDP is assembled, mBuffer holds it after.
+	U32                         mHeadSize;
+	LLPointer<LLVOCacheBody>    mBody; //rest of the update data, shared with copies of the object.
+
+	LLPointer<LLVOCacheFile>    mCacheFile; //mapped region cache file the entry was read from, until the entry changes.
+	const LLVOCacheSlot*        mCachedSlot; //slot of the entry in mCacheFile, its data is copied to mDP on first use.
+	S32                         mCacheSlotIndex; //where the entry was last stored in the region cache file, -1 if never.
+	U32                         mCacheOffset;
+	U32                         mCacheCapacity;
+	U32                         mCacheBody;
+	bool                        mCacheDirty; //mDP changed since the entry was last stored.
 
 	F32                         mSceneContrib; //projected scene contributuion of this object.
 	U32                         mState; //high 16 bits reserved for special use.
@@ -219,7 +270,9 @@ private:
 };
 
 //
-//Note: LLVOCache is not thread-safe
+//Note: LLVOCache is not thread-safe, it is only used from the main thread.
+//Cache files are written by a background writer, from snapshots of the
+//region caches and of the header.
 //
 class LLVOCache : public LLParamSingleton<LLVOCache>
 {
@@ -258,6 +311,8 @@ private:
 	typedef std::set<HeaderEntryInfo*, header_entry_less> header_entry_queue_t;
 	typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
 
+	class Writer;
+
 public:
 	// We need this init to be separate from constructor, since we might construct cache, purge it, then init.
 	void initCache(ELLPath location, U32 size, U32 cache_version);
@@ -267,6 +322,10 @@ public:
 	void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache, bool removal_enabled);
 	void removeEntry(U64 handle) ;
 
+	// Textures that were in use when the agent last left the region, stored next to its object cache
+	bool readTextureList(U64 handle, LLSD& texture_list);
+	void writeTextureList(U64 handle, const LLSD& texture_list);
+
 	U32 getCacheEntries() { return mNumEntries; }
 	U32 getCacheEntriesMax() { return mCacheSize; }
 
@@ -274,6 +333,7 @@ private:
 	void setDirNames(ELLPath location);	
 	// determine the cache filename for the region from the region handle	
 	void getObjectCacheFilename(U64 handle, std::string& filename);
+	void getTextureListFilename(U64 handle, std::string& filename);
 	void removeFromCache(HeaderEntryInfo* entry);
 	void readCacheHeader();
 	void writeCacheHeader();
@@ -281,7 +341,8 @@ private:
 	void removeCache() ;
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
-	BOOL updateEntry(const HeaderEntryInfo* entry);
+	void updateEntry(const HeaderEntryInfo* entry);
+	void checkWriteFailure();
 	
 private:
 	bool                 mEnabled;
@@ -293,6 +354,7 @@ private:
 	std::string          mHeaderFileName ;
 	std::string          mObjectCacheDirName;
 	LLVolatileAPRPool*   mLocalAPRFilePoolp ; 	
+	Writer*              mWriter;
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
 };
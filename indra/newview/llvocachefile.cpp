@@ -0,0 +1,521 @@
+/**
+ * @file llvocachefile.cpp
+ * @brief Indexed on-disk format of a region's object cache.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvocachefile.h"
+
+#include "llapr.h"
+#include "llcrc.h"
+
+#include <map>
+#include <set>
+
+// Bump when LLVOCacheFileHeader, LLVOCacheSlot or LLVOCacheBodyHeader change
+const U32 VO_CACHE_FILE_VERSION = 2;
+const U32 VO_CACHE_FILE_MAGIC = 0x434f564c; // "LVOC"
+
+// Object update data larger than this is taken as a corrupt file
+const U32 VO_CACHE_MAX_ENTRY_SIZE = 10000;
+// Extents are aligned to this and given an eighth of their size to grow
+const U32 VO_CACHE_DATA_ALIGN = 16;
+// The slot table is a multiple of this, with room for a quarter more objects
+const U32 VO_CACHE_SLOT_GRANULARITY = 64;
+// Rewrite the file once more of the data area is unused than used, past this size
+const U32 VO_CACHE_MIN_DEAD_BYTES = 256 * 1024;
+// Slots closer than this are written back in one go
+const U32 VO_CACHE_SLOT_RUN_GAP = 16;
+
+// Header of a region cache file.  32 bytes.
+struct LLVOCacheFileHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U8 mCacheID[UUID_BYTES];
+	U32 mNumSlots;
+	U32 mDataEnd;	// end of the last extent, the file may be longer
+};
+
+// Header of a body extent, the body follows.  8 bytes.
+struct LLVOCacheBodyHeader
+{
+	U32 mSize;
+	U32 mHash;
+};
+
+namespace
+{
+	// A body in the file, or about to be written to it
+	struct BodyRef
+	{
+		U32 mOffset;
+		const U8* mData;
+		U32 mSize;
+	};
+	typedef std::multimap<U32, BodyRef> body_map_t;
+
+	U32 data_start(U32 num_slots)
+	{
+		return sizeof(LLVOCacheFileHeader) + num_slots * sizeof(LLVOCacheSlot);
+	}
+
+	U32 extent_capacity(U32 size)
+	{
+		return (size + size / 8 + VO_CACHE_DATA_ALIGN - 1) & ~(VO_CACHE_DATA_ALIGN - 1);
+	}
+
+	bool check_header(const LLVOCacheFileHeader& header, const LLUUID& cache_id, U64 file_size)
+	{
+		return header.mMagic == VO_CACHE_FILE_MAGIC
+			&& header.mVersion == VO_CACHE_FILE_VERSION
+			&& !memcmp(header.mCacheID, cache_id.mData, UUID_BYTES)
+			&& header.mNumSlots > 0
+			&& (U64)data_start(header.mNumSlots) <= header.mDataEnd
+			&& header.mDataEnd <= file_size;
+	}
+
+	bool check_slot(const LLVOCacheSlot& slot, const LLVOCacheFileHeader& header)
+	{
+		return slot.mSize > 0
+			&& slot.mSize <= VO_CACHE_MAX_ENTRY_SIZE
+			&& slot.mCapacity >= slot.mSize
+			&& slot.mOffset >= data_start(header.mNumSlots)
+			&& (U64)slot.mOffset + slot.mCapacity <= header.mDataEnd;
+	}
+
+	U32 body_capacity(U32 size)
+	{
+		return (sizeof(LLVOCacheBodyHeader) + size + VO_CACHE_DATA_ALIGN - 1) & ~(VO_CACHE_DATA_ALIGN - 1);
+	}
+
+	bool check_body(const U8* file_data, U32 offset, const LLVOCacheFileHeader& header)
+	{
+		if (offset < data_start(header.mNumSlots) || (U64)offset + sizeof(LLVOCacheBodyHeader) > header.mDataEnd)
+		{
+			return false;
+		}
+		LLVOCacheBodyHeader body;
+		memcpy(&body, file_data + offset, sizeof(body));
+		return body.mSize > 0
+			&& body.mSize <= VO_CACHE_MAX_ENTRY_SIZE
+			&& (U64)offset + sizeof(body) + body.mSize <= header.mDataEnd;
+	}
+
+	// Offset of a body identical to data, 0 if there is none
+	U32 find_body(const body_map_t& bodies, const U8* data, U32 size, U32 hash)
+	{
+		std::pair<body_map_t::const_iterator, body_map_t::const_iterator> range = bodies.equal_range(hash);
+		for (body_map_t::const_iterator iter = range.first; iter != range.second; ++iter)
+		{
+			if (iter->second.mSize == size && !memcmp(iter->second.mData, data, size))
+			{
+				return iter->second.mOffset;
+			}
+		}
+		return 0;
+	}
+
+	void add_body(body_map_t& bodies, U32 offset, const U8* data, U32 size, U32 hash)
+	{
+		BodyRef body = { offset, data, size };
+		bodies.insert(std::make_pair(hash, body));
+	}
+
+	// Body extent with its header, as written to the file
+	void append_body(std::vector<U8>& buffer, const U8* data, U32 size, U32 hash)
+	{
+		LLVOCacheBodyHeader body = { size, hash };
+		const U8* header = (const U8*)&body;
+		U32 start = buffer.size();
+		buffer.insert(buffer.end(), header, header + sizeof(body));
+		buffer.insert(buffer.end(), data, data + size);
+		buffer.resize(start + body_capacity(size), 0);
+	}
+
+	void count_bodies(const LLVOCacheFile::record_list_t& records, LLVOCacheFile::WriteStats& stats)
+	{
+		std::set<U32> bodies;
+		U32 with_body = 0;
+		for (LLVOCacheFile::record_list_t::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+		{
+			if (iter->mSlot.mBody)
+			{
+				bodies.insert(iter->mSlot.mBody);
+				with_body++;
+			}
+		}
+		stats.mBodies = bodies.size();
+		stats.mSharedBodies = with_body - bodies.size();
+	}
+
+	bool write_at(LLAPRFile& file, U32 offset, const void* data, U32 size, U32& bytes)
+	{
+		bytes += size;
+		return file.seek(APR_SET, offset) == (S32)offset && file.write(data, size) == (S32)size;
+	}
+
+	// Write the runs of slots that differ between on_disk and wanted, and
+	// make on_disk match
+	bool write_slots(LLAPRFile& file, std::vector<LLVOCacheSlot>& on_disk, const std::vector<LLVOCacheSlot>& wanted, U32& bytes)
+	{
+		U32 num_slots = on_disk.size();
+		for (U32 i = 0; i < num_slots; ++i)
+		{
+			if (!memcmp(&on_disk[i], &wanted[i], sizeof(LLVOCacheSlot)))
+			{
+				continue;
+			}
+			U32 end = i + 1;
+			for (U32 j = end; j < num_slots && j < end + VO_CACHE_SLOT_RUN_GAP; ++j)
+			{
+				if (memcmp(&on_disk[j], &wanted[j], sizeof(LLVOCacheSlot)))
+				{
+					end = j + 1;
+				}
+			}
+			if (!write_at(file, sizeof(LLVOCacheFileHeader) + i * sizeof(LLVOCacheSlot), &wanted[i], (end - i) * sizeof(LLVOCacheSlot), bytes))
+			{
+				return false;
+			}
+			memcpy(&on_disk[i], &wanted[i], (end - i) * sizeof(LLVOCacheSlot));
+			i = end - 1;
+		}
+		return true;
+	}
+}
+
+LLVOCacheFile::LLVOCacheFile()
+	: mSlots(NULL),
+	  mNumSlots(0)
+{
+}
+
+LLVOCacheFile::~LLVOCacheFile()
+{
+}
+
+bool LLVOCacheFile::open(const std::string& filename, const LLUUID& cache_id)
+{
+	if (!mFile.open(filename) || mFile.getSize() < sizeof(LLVOCacheFileHeader))
+	{
+		mFile.close();
+		return false;
+	}
+
+	LLVOCacheFileHeader header;
+	memcpy(&header, mFile.getData(), sizeof(header));
+	if (!check_header(header, cache_id, mFile.getSize()))
+	{
+		LL_INFOS() << "Cache ID doesn't match or bad header for " << filename << ", discarding" << LL_ENDL;
+		mFile.close();
+		return false;
+	}
+
+	// The whole slot table is walked on region arrival
+	mFile.willNeed(0, data_start(header.mNumSlots));
+	mSlots = (const LLVOCacheSlot*)(mFile.getData() + sizeof(header));
+	mNumSlots = header.mNumSlots;
+	for (U32 i = 0; i < mNumSlots; ++i)
+	{
+		if (mSlots[i].mLocalID
+			&& (!check_slot(mSlots[i], header) || (mSlots[i].mBody && !check_body(mFile.getData(), mSlots[i].mBody, header))))
+		{
+			LL_WARNS() << "Bogus cache slot " << i << ", size " << mSlots[i].mSize << " in " << filename << LL_ENDL;
+			mFile.close();
+			mSlots = NULL;
+			mNumSlots = 0;
+			return false;
+		}
+	}
+	return true;
+}
+
+//static
+U32 LLVOCacheFile::hashBody(const U8* data, U32 size)
+{
+	LLCRC crc;
+	crc.update(data, size);
+	return crc.getCRC();
+}
+
+const U8* LLVOCacheFile::getBodyData(const LLVOCacheSlot& slot) const
+{
+	return slot.mBody ? mFile.getData() + slot.mBody + sizeof(LLVOCacheBodyHeader) : NULL;
+}
+
+U32 LLVOCacheFile::getBodySize(const LLVOCacheSlot& slot) const
+{
+	LLVOCacheBodyHeader body = { 0, 0 };
+	if (slot.mBody)
+	{
+		memcpy(&body, mFile.getData() + slot.mBody, sizeof(body));
+	}
+	return body.mSize;
+}
+
+U32 LLVOCacheFile::getBodyHash(const LLVOCacheSlot& slot) const
+{
+	LLVOCacheBodyHeader body = { 0, 0 };
+	if (slot.mBody)
+	{
+		memcpy(&body, mFile.getData() + slot.mBody, sizeof(body));
+	}
+	return body.mHash;
+}
+
+//static
+bool LLVOCacheFile::write(const std::string& filename, const LLUUID& cache_id, record_list_t& records,
+						  LLVolatileAPRPool* pool, WriteStats* stats)
+{
+	WriteStats local_stats;
+	if (!stats)
+	{
+		stats = &local_stats;
+	}
+	*stats = WriteStats();
+
+	// Read back the header and slot table of the current file, if it is still ours
+	LLVOCacheFileHeader header;
+	std::vector<LLVOCacheSlot> slots;
+	LLAPRFile file;
+	S32 file_size = 0;
+	bool in_place = LLAPRFile::isExist(filename, pool)
+		&& file.open(filename, APR_READ|APR_WRITE|APR_BINARY, pool, &file_size) == APR_SUCCESS
+		&& file.read(&header, sizeof(header)) == sizeof(header)
+		&& check_header(header, cache_id, file_size)
+		&& header.mNumSlots >= records.size();
+	if (in_place)
+	{
+		slots.resize(header.mNumSlots);
+		in_place = file.read(&slots[0], slots.size() * sizeof(LLVOCacheSlot)) == (S32)(slots.size() * sizeof(LLVOCacheSlot));
+	}
+
+	// Objects that are still where their slot says keep it, and unchanged
+	// ones keep their body, which the others can share
+	std::vector<LLVOCacheSlot> new_slots;
+	body_map_t bodies;
+	std::set<U32> live_bodies;
+	U64 live_bytes = 0;
+	if (in_place)
+	{
+		LLVOCacheSlot empty;
+		memset(&empty, 0, sizeof(empty));
+		new_slots.resize(header.mNumSlots, empty);
+		for (record_list_t::iterator iter = records.begin(); iter != records.end(); ++iter)
+		{
+			S32 index = iter->mSlotIndex;
+			if (index >= 0 && index < (S32)header.mNumSlots
+				&& !new_slots[index].mLocalID
+				&& slots[index].mLocalID == iter->mSlot.mLocalID
+				&& slots[index].mOffset == iter->mSlot.mOffset
+				&& slots[index].mCapacity == iter->mSlot.mCapacity
+				&& slots[index].mBody == iter->mSlot.mBody
+				&& check_slot(slots[index], header))
+			{
+				new_slots[index] = iter->mSlot;
+				live_bytes += iter->mSlot.mCapacity;
+				if (!iter->mDirty && iter->mSlot.mBody && live_bodies.insert(iter->mSlot.mBody).second)
+				{
+					live_bytes += body_capacity(iter->mBodySize);
+					add_body(bodies, iter->mSlot.mBody, iter->mBodyData, iter->mBodySize, iter->mBodyHash);
+				}
+			}
+			else
+			{
+				iter->mSlotIndex = -1;
+			}
+		}
+
+		U64 dead_bytes = header.mDataEnd - data_start(header.mNumSlots) - live_bytes;
+		in_place = dead_bytes < VO_CACHE_MIN_DEAD_BYTES || dead_bytes < live_bytes;
+	}
+
+	if (!in_place)
+	{
+		file.close();
+		stats->mRewritten = true;
+		return writeAll(filename, cache_id, records, pool, *stats);
+	}
+
+	// Rewrite changed objects inside their extent, append the others
+	U32 data_end = header.mDataEnd;
+	std::vector<U8> appended;
+	std::vector<Record*> overwritten;
+	std::vector<LLVOCacheSlot> invalidated;
+	U32 next_free = 0;
+	bool success = true;
+	for (record_list_t::iterator iter = records.begin(); iter != records.end(); ++iter)
+	{
+		if (iter->mSlotIndex >= 0 && !iter->mDirty)
+		{
+			continue;
+		}
+		if (iter->mSlotIndex >= 0 && iter->mSlot.mSize <= iter->mSlot.mCapacity)
+		{
+			if (invalidated.empty())
+			{
+				invalidated = slots;
+			}
+			memset(&invalidated[iter->mSlotIndex], 0, sizeof(LLVOCacheSlot));
+			overwritten.push_back(&*iter);
+		}
+		else
+		{
+			if (iter->mSlotIndex < 0)
+			{
+				while (new_slots[next_free].mLocalID)
+				{
+					++next_free;
+				}
+				iter->mSlotIndex = next_free;
+			}
+			iter->mSlot.mOffset = data_end + appended.size();
+			iter->mSlot.mCapacity = extent_capacity(iter->mSlot.mSize);
+			appended.insert(appended.end(), iter->mData, iter->mData + iter->mSlot.mSize);
+			appended.resize(appended.size() + iter->mSlot.mCapacity - iter->mSlot.mSize, 0);
+		}
+
+		// Share an identical body, or append it
+		iter->mSlot.mBody = 0;
+		if (iter->mBodySize)
+		{
+			iter->mSlot.mBody = find_body(bodies, iter->mBodyData, iter->mBodySize, iter->mBodyHash);
+			if (!iter->mSlot.mBody)
+			{
+				iter->mSlot.mBody = data_end + appended.size();
+				append_body(appended, iter->mBodyData, iter->mBodySize, iter->mBodyHash);
+				add_body(bodies, iter->mSlot.mBody, iter->mBodyData, iter->mBodySize, iter->mBodyHash);
+			}
+		}
+		new_slots[iter->mSlotIndex] = iter->mSlot;
+	}
+
+	// Free the slots of the objects rewritten in place before touching
+	// their extent, so that a write cut short leaves them missing from the
+	// cache rather than passing a stale CRC over half written data.
+	// Appended objects and bodies go to space no slot points to yet.
+	if (!overwritten.empty())
+	{
+		success = write_slots(file, slots, invalidated, stats->mBytes);
+		for (std::vector<Record*>::iterator iter = overwritten.begin(); success && iter != overwritten.end(); ++iter)
+		{
+			success = write_at(file, (*iter)->mSlot.mOffset, (*iter)->mData, (*iter)->mSlot.mSize, stats->mBytes);
+		}
+	}
+	if (success && !appended.empty())
+	{
+		success = write_at(file, data_end, &appended[0], appended.size(), stats->mBytes);
+		data_end += appended.size();
+	}
+
+	// Then grow the data area over what was appended, and point the slots
+	// at the new data
+	if (success && data_end != header.mDataEnd)
+	{
+		header.mDataEnd = data_end;
+		success = write_at(file, 0, &header, sizeof(header), stats->mBytes);
+	}
+	success = success && write_slots(file, slots, new_slots, stats->mBytes);
+
+	if (success)
+	{
+		for (record_list_t::iterator iter = records.begin(); iter != records.end(); ++iter)
+		{
+			iter->mDirty = false;
+		}
+		count_bodies(records, *stats);
+	}
+	return success;
+}
+
+//static
+bool LLVOCacheFile::writeAll(const std::string& filename, const LLUUID& cache_id, record_list_t& records,
+							 LLVolatileAPRPool* pool, WriteStats& stats)
+{
+	LLVOCacheFileHeader header;
+	header.mMagic = VO_CACHE_FILE_MAGIC;
+	header.mVersion = VO_CACHE_FILE_VERSION;
+	memcpy(header.mCacheID, cache_id.mData, UUID_BYTES);
+	header.mNumSlots = records.size() + records.size() / 4 + VO_CACHE_SLOT_GRANULARITY;
+	header.mNumSlots -= header.mNumSlots % VO_CACHE_SLOT_GRANULARITY;
+
+	// Build the whole file in memory, it is written in one go.  Each body
+	// follows the first object that has it.
+	std::vector<U8> buffer(data_start(header.mNumSlots), 0);
+	body_map_t bodies;
+	for (U32 i = 0; i < records.size(); ++i)
+	{
+		Record& record = records[i];
+		record.mSlot.mOffset = buffer.size();
+		record.mSlot.mCapacity = extent_capacity(record.mSlot.mSize);
+		buffer.insert(buffer.end(), record.mData, record.mData + record.mSlot.mSize);
+		buffer.resize(record.mSlot.mOffset + record.mSlot.mCapacity, 0);
+
+		record.mSlot.mBody = 0;
+		if (record.mBodySize)
+		{
+			record.mSlot.mBody = find_body(bodies, record.mBodyData, record.mBodySize, record.mBodyHash);
+			if (!record.mSlot.mBody)
+			{
+				record.mSlot.mBody = buffer.size();
+				append_body(buffer, record.mBodyData, record.mBodySize, record.mBodyHash);
+				add_body(bodies, record.mSlot.mBody, record.mBodyData, record.mBodySize, record.mBodyHash);
+			}
+		}
+	}
+	header.mDataEnd = buffer.size();
+	memcpy(&buffer[0], &header, sizeof(header));
+	LLVOCacheSlot* slots = (LLVOCacheSlot*)&buffer[sizeof(header)];
+	for (U32 i = 0; i < records.size(); ++i)
+	{
+		slots[i] = records[i].mSlot;
+	}
+
+	// Write next to the current file and swap them, whoever still maps
+	// the current one keeps seeing it
+	std::string temp_filename = filename + ".tmp";
+	bool success;
+	{
+		LLAPRFile file(temp_filename, APR_CREATE|APR_WRITE|APR_TRUNCATE|APR_BINARY, pool);
+		success = file.getFileHandle() && file.write(&buffer[0], buffer.size()) == (S32)buffer.size();
+	}
+	stats.mBytes = buffer.size();
+	success = success && LLMappedFile::replace(temp_filename, filename);
+	if (!success)
+	{
+		LL_WARNS() << "Failed to write object cache file " << filename << LL_ENDL;
+		LLAPRFile::remove(temp_filename, pool);
+		return false;
+	}
+
+	for (U32 i = 0; i < records.size(); ++i)
+	{
+		records[i].mSlotIndex = i;
+		records[i].mDirty = false;
+	}
+	count_bodies(records, stats);
+	return true;
+}
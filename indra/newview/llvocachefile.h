@@ -0,0 +1,161 @@
+/**
+ * @file llvocachefile.h
+ * @brief Indexed on-disk format of a region's object cache.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOCACHEFILE_H
+#define LL_LLVOCACHEFILE_H
+
+#include "llmappedfile.h"
+#include "llpointer.h"
+#include "llrefcount.h"
+#include "lluuid.h"
+
+class LLVolatileAPRPool;
+
+// Index slot of one object in a region cache file.  64 bytes.
+struct LLVOCacheSlot
+{
+	U32 mLocalID;		// 0 for a free slot
+	U32 mCRC;
+	S32 mHitCount;
+	S32 mDupeCount;
+	S32 mCRCChangeCount;
+	U32 mOffset;		// of the object update data unique to the object, from the start of the file
+	U32 mSize;
+	U32 mCapacity;		// bytes reserved at mOffset, at least mSize
+
+	// Spatial extents of the object, as found in its update data, so that
+	// it can go in the region's cache octree without decoding the data
+	U32 mParentID;
+	F32 mPosition[3];
+	F32 mScale[3];
+
+	U32 mBody;			// offset of the body, 0 if the object has none
+};
+
+// A region cache file is a 32 byte header, a table of LLVOCacheSlot and
+// the object update data.  Each object owns an extent of the data area
+// with some room to grow.
+//
+// The update data of an object is split in two: the fields unique to the
+// object (ID, position, parent...) go in its extent, and the rest, its
+// body, goes in a body extent shared by all objects with the same body.
+// Copies of an object, common in shops and sandboxes, store their shape,
+// textures and extra parameters once.  Body extents are never rewritten,
+// an object whose body changed points to another one.
+//
+// Reading maps the file: the slot table is walked once on region arrival
+// and an object's data is only copied out when the object is created.
+//
+// Writing updates the file in place: changed objects are rewritten inside
+// their extent, or appended at the end of the data area when they outgrew
+// it, and only the slots that changed are written back.  An object is
+// rewritten inside its extent only while its slot is written as free, so
+// an interrupted write loses objects but never pairs a slot with data it
+// does not describe.  The file is
+// rewritten from scratch when it does not exist yet, the slot table is
+// full or too much of the data area is left unused.
+//
+// Files are shared with the object cache writer thread, which copies the
+// unchanged objects of a region out of the mapping it was read from, see
+// open() for what stays valid while it writes.
+class LLVOCacheFile : public LLThreadSafeRefCount
+{
+public:
+	// One object to store, see write()
+	struct Record
+	{
+		Record() : mSlotIndex(-1), mData(NULL), mBodyData(NULL), mBodySize(0), mBodyHash(0), mDirty(true)
+		{
+			memset(&mSlot, 0, sizeof(mSlot));
+		}
+
+		LLVOCacheSlot mSlot;	// Where the object was last stored, updated by write()
+		S32 mSlotIndex;			// -1 if the object was never stored, updated by write()
+		const U8* mData;		// mSlot.mSize bytes of object update data unique to the object
+		const U8* mBodyData;	// mBodySize bytes of the rest of the data, NULL if none
+		U32 mBodySize;
+		U32 mBodyHash;			// hashBody() of the body
+		bool mDirty;			// the data differs from what was last stored, cleared by write()
+	};
+	typedef std::vector<Record> record_list_t;
+
+	// What write() did to the file
+	struct WriteStats
+	{
+		WriteStats() : mBytes(0), mRewritten(false), mBodies(0), mSharedBodies(0) {}
+
+		U32 mBytes;			// written to disk, data and slots
+		bool mRewritten;	// the file was rewritten from scratch
+		U32 mBodies;		// distinct bodies in the file
+		U32 mSharedBodies;	// objects whose body is shared with another object
+	};
+
+	// Hash that bodies are looked up by, in memory and in the file
+	static U32 hashBody(const U8* data, U32 size);
+
+	LLVOCacheFile();
+
+	// Map a region cache file and check its header and slot table.  The
+	// mapping stays readable as long as this object lives, write() only
+	// grows a file in place or renames a new one over it.  What it shows
+	// is not a snapshot though: an in-place write() goes through the same
+	// file and changes the slots and extents of the records it stores dirty
+	// or moves, and a changed slot can point past the end of the mapping.
+	// The slots and data of the records it leaves alone, and all bodies,
+	// keep their bytes.  So a slot and its data may only be read while its
+	// object is unchanged, LLVOCacheEntry::updateEntry() drops them.
+	bool open(const std::string& filename, const LLUUID& cache_id);
+
+	U32 getNumSlots() const							{ return mNumSlots; }
+	const LLVOCacheSlot& getSlot(U32 index) const	{ return mSlots[index]; }
+	const U8* getData(const LLVOCacheSlot& slot) const	{ return mFile.getData() + slot.mOffset; }
+
+	// Body of an object, NULL and 0 if it has none
+	const U8* getBodyData(const LLVOCacheSlot& slot) const;
+	U32 getBodySize(const LLVOCacheSlot& slot) const;
+	U32 getBodyHash(const LLVOCacheSlot& slot) const;
+
+	// Store the objects of a region in its cache file.  Records that are
+	// not dirty are left untouched on disk if the file still holds them
+	// where their slot says.  Bodies already in the file, or written for an
+	// earlier record, are shared.  Returns false if the file could not be
+	// written, in which case it should be removed.
+	static bool write(const std::string& filename, const LLUUID& cache_id, record_list_t& records,
+					  LLVolatileAPRPool* pool = NULL, WriteStats* stats = NULL);
+
+protected:
+	~LLVOCacheFile();
+
+private:
+	static bool writeAll(const std::string& filename, const LLUUID& cache_id, record_list_t& records,
+						 LLVolatileAPRPool* pool, WriteStats& stats);
+
+	LLMappedFile mFile;
+	const LLVOCacheSlot* mSlots;
+	U32 mNumSlots;
+};
+
+#endif // LL_LLVOCACHEFILE_H
@@ -85,10 +85,14 @@
 #include "llviewerinventory.h"
 #include "llcallstack.h"
 #include "llsculptidsize.h"
+#include "llviewerstats.h"
 #include "llavatarappearancedefines.h"
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
+const U32 COMPACT_IDLE_FRAMES = 300;		// frames a volume's faces go untouched before they get quantized
+const U32 COMPACT_GROUPS_PER_FRAME = 32;	// volume groups visited by each idle sweep
+const F32 COMPACT_REPORT_PERIOD = 60.f;	// seconds between reports of the memory saved
 U32 JOINT_COUNT_REQUIRED_FOR_FULLRIG = 1;
 
 BOOL gAnimateTextures = TRUE;
@@ -108,6 +112,7 @@ static LLTrace::BlockTimerStatHandle FTM_GEN_VOLUME("Generate Volumes");
 static LLTrace::BlockTimerStatHandle FTM_VOLUME_TEXTURES("Volume Textures");
 
 extern BOOL gGLDebugLoggingEnabled;
+extern bool gShiftFrame;
 
 // Implementation class of LLMediaDataClientObject.  See llmediadataclient.h
 class LLMediaDataClientObjectImpl : public LLMediaDataClientObject
@@ -228,6 +233,7 @@ LLVOVolume::LLVOVolume(const LLUUID &id, const LLPCode pcode, LLViewerRegion *re
 	mVObjRadius = LLVector3(1,1,0.5f).length();
 	mNumFaces = 0;
 	mLODChanged = FALSE;
+	mLODPending = FALSE;
 	mSculptChanged = FALSE;
 	mSpotLightPriority = 0.f;
 
@@ -1030,6 +1036,17 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 
 	}
 
+	// A plain prim changing LOD keeps drawing the LOD it has until the
+	// new one is built on a generation thread, updateLOD() picks it up
+	mLODPending = FALSE;
+	if (!mSculptChanged && !mVolumeImpl && NO_LOD != lod && !isSculpted()
+		&& mVolumep.notNull() && last_lod != lod && volume_params == mVolumep->getParams()
+		&& !LLPrimitive::getVolumeManager()->requestVolume(volume_params, lod))
+	{
+		mLODPending = TRUE;
+		return FALSE;
+	}
+
 	if ((LLPrimitive::setVolume(volume_params, lod, (mVolumeImpl && mVolumeImpl->isVolumeUnique()))) || mSculptChanged)
 	{
 		mFaceMappingChanged = TRUE;
@@ -1266,6 +1283,37 @@ void LLVOVolume::sculpt()
 	}
 }
 
+// Fraction the LOD angle must drop below a threshold before the volume goes
+// down to the lower LOD
+static F32 get_lod_hysteresis()
+{
+	static LLCachedControl<F32> lod_hysteresis(gSavedSettings, "RenderVolumeLODHysteresis", 0.1f);
+	return llmax((F32) lod_hysteresis, 0.f);
+}
+
+// ll_round(v, 0.01f) of four non negative values
+static inline LLQuad round_hundredths(const LLQuad& v)
+{
+	LLQuad t = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(1.f / 0.01f)), _mm_set1_ps(0.5f));
+	LLQuad floored = _mm_cvtepi32_ps(_mm_cvttps_epi32(t));
+	// from 2^23 up floats are whole already, and too large to convert
+	LLQuad whole = _mm_cmpge_ps(t, _mm_set1_ps(8388608.f));
+	floored = _mm_or_ps(_mm_and_ps(whole, t), _mm_andnot_ps(whole, floored));
+	return _mm_mul_ps(floored, _mm_set1_ps(0.01f));
+}
+
+// LLVolumeLODGroup::getDetailFromTan() of four angles, the thresholds going up
+static inline __m128i detail_from_tan(const LLQuad& tan_angle)
+{
+	__m128i detail = _mm_setzero_si128();
+	for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS - 1; ++i)
+	{
+		LLQuad above = _mm_cmpgt_ps(tan_angle, _mm_set1_ps(LLVolumeLODGroup::getDetailThreshold(i)));
+		detail = _mm_sub_epi32(detail, _mm_castps_si128(above));
+	}
+	return detail;
+}
+
 S32	LLVOVolume::computeLODDetail(F32 distance, F32 radius, F32 lod_factor)
 {
 	S32	cur_detail;
@@ -1274,6 +1322,11 @@ S32	LLVOVolume::computeLODDetail(F32 distance, F32 radius, F32 lod_factor)
 		// We've got LOD in the profile, and in the twist.  Use radius.
 		F32 tan_angle = (lod_factor*radius)/distance;
 		cur_detail = LLVolumeLODGroup::getDetailFromTan(ll_round(tan_angle, 0.01f));
+		if (cur_detail < mLOD)
+		{ //keep the higher LOD until the angle is clearly past its threshold
+			S32 lower_detail = LLVolumeLODGroup::getDetailFromTan(ll_round(tan_angle * (1.f + get_lod_hysteresis()), 0.01f));
+			cur_detail = llmin(mLOD, lower_detail);
+		}
 	}
 	else
 	{
@@ -1458,10 +1511,15 @@ BOOL LLVOVolume::calcLOD()
         setDebugText(llformat("%d", cur_detail));
 	}
 
+	return setLODDetail(cur_detail);
+}
+
+BOOL LLVOVolume::setLODDetail(S32 cur_detail)
+{
 	if (cur_detail != mLOD)
 	{
         LL_DEBUGS("DynamicBox","CalcLOD") << "new LOD " << cur_detail << " change from " << mLOD 
-                             << " distance " << distance << " radius " << radius << " rampDist " << rampDist
+                             << " distance " << mLODAdjustedDistance << " radius " << mLODRadius
                              << " drawable rigged? " << (mDrawable ? (S32) mDrawable->isState(LLDrawable::RIGGED) : (S32) -1)
 							 << " mRiggedVolume " << (void*)getRiggedVolume()
                              << " distanceWRTCamera " << (mDrawable ? mDrawable->mDistanceWRTCamera : -1.f)
@@ -1494,6 +1552,17 @@ BOOL LLVOVolume::updateLOD()
 		return FALSE;
 	}
 
+	return finishLODUpdate(lod_changed);
+}
+
+BOOL LLVOVolume::finishLODUpdate(BOOL lod_changed)
+{
+	if (!lod_changed && mLODPending
+		&& LLPrimitive::getVolumeManager()->requestVolume(getVolume()->getParams(), mLOD))
+	{ //the LOD setVolume() left to a generation thread is ready
+		lod_changed = TRUE;
+	}
+
 	if (lod_changed)
 	{
         if (debugLoggingEnabled("AnimatedObjectsLinkset"))
@@ -1508,6 +1577,7 @@ BOOL LLVOVolume::updateLOD()
 
 		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_VOLUME, FALSE);
 		mLODChanged = TRUE;
+		add(LLStatViewer::VOLUME_LOD_CHANGES, 1);
 	}
 	else
 	{
@@ -1524,6 +1594,181 @@ BOOL LLVOVolume::updateLOD()
 	return lod_changed;
 }
 
+//static
+void LLVOVolume::updateLODBatch(LLSpatialGroup* group, LLCamera& camera)
+{
+	static LLCachedControl<bool> debug_lods(gSavedSettings, "DebugObjectLODs", false);
+	if (gShiftFrame || debug_lods
+		|| gPipeline.hasRenderDebugMask(LLPipeline::RENDER_DEBUG_TRIANGLE_COUNT | LLPipeline::RENDER_DEBUG_LOD_INFO))
+	{ //debug text is set one volume at a time by calcLOD()
+		return;
+	}
+
+	LLTimer timer;
+	BOOL hide_selected = LLSelectMgr::getInstance()->mHideSelectedObjects;
+	LLVOVolume* volumes[4];
+	U32 count = 0;
+	U32 total = 0;
+	for (LLSpatialGroup::element_iter i = group->getDataBegin(); i != group->getDataEnd(); ++i)
+	{
+		LLDrawable* drawablep = (LLDrawable*)(*i)->getDrawable();
+		LLVOVolume* volume = drawablep ? drawablep->getVOVolume() : NULL;
+
+		// Rigged, attached and HUD volumes, and the drawables LLPipeline::stateSort()
+		// skips, are left to LLDrawable::updateDistance()
+		if (!volume || !volume->getVolume()
+			|| drawablep->isDead()
+			|| drawablep == LLPipeline::RenderSpotLight
+			|| drawablep->isActive()
+			|| drawablep->isState(LLDrawable::RIGGED)
+			|| !gPipeline.hasRenderType(drawablep->getRenderType())
+			|| (hide_selected && volume->isSelected())
+			|| volume->mResetDebugText
+			|| volume->isHUDAttachment()
+			|| volume->getAvatar())
+		{
+			if (drawablep)
+			{
+				drawablep->clearState(LLDrawable::LOD_UPDATED);
+			}
+			continue;
+		}
+
+		const LLVolumeParams& params = volume->getVolume()->getParams();
+		if (params.isSculpt() && LLSculptIDSize::instance().isUnloaded(params.getSculptID()))
+		{
+			drawablep->clearState(LLDrawable::LOD_UPDATED);
+			continue;
+		}
+
+		drawablep->setState(LLDrawable::LOD_UPDATED);
+		if (drawablep->isState(LLDrawable::HAS_ALPHA))
+		{
+			drawablep->updateFaceDistances(camera, false);
+		}
+
+		volumes[count++] = volume;
+		if (count == 4)
+		{
+			updateLODQuad(volumes, count, camera);
+			total += count;
+			count = 0;
+		}
+	}
+
+	if (count)
+	{
+		updateLODQuad(volumes, count, camera);
+		total += count;
+	}
+
+	if (total)
+	{
+		record(LLStatViewer::VOLUME_LOD_PASS_TIME, F64Seconds(timer.getElapsedTimeF64()));
+	}
+}
+
+// Same math as LLDrawable::updateDistance() and calcLOD(), for four volumes side by side
+//static
+void LLVOVolume::updateLODQuad(LLVOVolume* const* volumes, U32 count, LLCamera& camera)
+{
+	// Positions and LOD scaled sizes of the volumes, the last one repeated past count
+	LLQuad px, py, pz, pw;
+	LLQuad sx, sy, sz, sw;
+	{
+		LLVector4a pos[4];
+		LLVector4a size[4];
+		for (U32 k = 0; k < 4; ++k)
+		{
+			LLVOVolume* volume = volumes[llmin(k, count - 1)];
+			pos[k] = volume->mDrawable->getPositionGroup();
+			size[k].load3(volume->getVolume()->mLODScaleBias.scaledVec(volume->getScale()).mV);
+		}
+		px = pos[0]; py = pos[1]; pz = pos[2]; pw = pos[3];
+		_MM_TRANSPOSE4_PS(px, py, pz, pw);
+		sx = size[0]; sy = size[1]; sz = size[2]; sw = size[3];
+		_MM_TRANSPOSE4_PS(sx, sy, sz, sw);
+	}
+
+	const LLVector3& origin = camera.getOrigin();
+	LLQuad dx = _mm_sub_ps(px, _mm_set1_ps(origin.mV[0]));
+	LLQuad dy = _mm_sub_ps(py, _mm_set1_ps(origin.mV[1]));
+	LLQuad dz = _mm_sub_ps(pz, _mm_set1_ps(origin.mV[2]));
+	LLQuad distance = round_hundredths(_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))));
+	LLQuad radius = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, sx), _mm_mul_ps(sy, sy)), _mm_mul_ps(sz, sz)));
+	LLQuad zero = _mm_setzero_ps();
+	S32 valid = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(distance, zero), _mm_cmpgt_ps(radius, zero)));
+
+	// Boost LOD when you're REALLY close
+	F32 ramp_dist = sLODFactor * 2;
+	LLQuad adjusted = _mm_mul_ps(distance, _mm_set1_ps(sDistanceFactor));
+	LLQuad ramped = _mm_mul_ps(adjusted, _mm_set1_ps(1.0f / ramp_dist));
+	ramped = _mm_mul_ps(_mm_mul_ps(ramped, ramped), _mm_set1_ps(ramp_dist));
+	LLQuad close = _mm_cmplt_ps(adjusted, _mm_set1_ps(ramp_dist));
+	adjusted = _mm_or_ps(_mm_and_ps(close, ramped), _mm_andnot_ps(close, adjusted));
+	adjusted = _mm_mul_ps(adjusted, _mm_set1_ps(F_PI/3.f));
+
+	F32 lod_factor = sLODFactor;
+	static LLCachedControl<bool> ignore_fov_zoom(gSavedSettings,"IgnoreFOVZoomForLODs");
+	if (!ignore_fov_zoom)
+	{
+		lod_factor *= DEFAULT_FIELD_OF_VIEW / LLViewerCamera::getInstance()->getDefaultFOV();
+	}
+
+	LLQuad lod_radius = round_hundredths(radius);
+	__m128i detail;
+	__m128i lower_detail;
+	if (LLPipeline::sDynamicLOD)
+	{
+		LLQuad tan_angle = _mm_div_ps(_mm_mul_ps(_mm_set1_ps(lod_factor), lod_radius), round_hundredths(adjusted));
+		detail = detail_from_tan(round_hundredths(tan_angle));
+		lower_detail = detail_from_tan(round_hundredths(_mm_mul_ps(tan_angle, _mm_set1_ps(1.f + get_lod_hysteresis()))));
+	}
+	else
+	{
+		LLQuad scaled = _mm_mul_ps(_mm_mul_ps(_mm_sqrt_ps(lod_radius), _mm_set1_ps(lod_factor)), _mm_set1_ps(4.f));
+		detail = _mm_cvttps_epi32(scaled);
+		detail = _mm_andnot_si128(_mm_cmplt_epi32(detail, _mm_setzero_si128()), detail);
+		__m128i max_detail = _mm_set1_epi32(3);
+		__m128i above = _mm_cmpgt_epi32(detail, max_detail);
+		detail = _mm_or_si128(_mm_and_si128(above, max_detail), _mm_andnot_si128(above, detail));
+		lower_detail = detail;
+	}
+
+	LL_ALIGN_16(F32 distances[4]);
+	LL_ALIGN_16(F32 radii[4]);
+	LL_ALIGN_16(F32 adjusted_distances[4]);
+	LL_ALIGN_16(S32 details[4]);
+	LL_ALIGN_16(S32 lower_details[4]);
+	_mm_store_ps(distances, distance);
+	_mm_store_ps(radii, radius);
+	_mm_store_ps(adjusted_distances, adjusted);
+	_mm_store_si128((__m128i*) details, detail);
+	_mm_store_si128((__m128i*) lower_details, lower_detail);
+
+	for (U32 k = 0; k < count; ++k)
+	{
+		LLVOVolume* volume = volumes[k];
+		volume->mDrawable->mDistanceWRTCamera = distances[k];
+
+		BOOL lod_changed = FALSE;
+		if (valid & (1 << k))
+		{
+			volume->mLODDistance = distances[k];
+			volume->mLODRadius = radii[k];
+			volume->mLODAdjustedDistance = adjusted_distances[k];
+
+			S32 cur_detail = details[k];
+			if (cur_detail < volume->mLOD)
+			{
+				cur_detail = llmin(volume->mLOD, lower_details[k]);
+			}
+			lod_changed = volume->setLODDetail(cur_detail);
+		}
+		volume->finishLODUpdate(lod_changed);
+	}
+}
+
 BOOL LLVOVolume::setDrawableParent(LLDrawable* parentp)
 {
 	if (!LLViewerObject::setDrawableParent(parentp))
@@ -4206,6 +4451,56 @@ void LLVOVolume::updateRenderComplexity()
 	mRenderComplexity_current = 0;
 }
 
+// static
+void LLVOVolume::updateCompactVolumes()
+{
+	static LLCachedControl<bool> compact_faces(gSavedSettings, "RenderCompactVolumeFaces", false);
+	if (!compact_faces)
+	{
+		return;
+	}
+
+	LLPrimitive::getVolumeManager()->compactIdleVolumes(COMPACT_IDLE_FRAMES, COMPACT_GROUPS_PER_FRAME);
+
+	static LLFrameTimer report_timer;
+	if (report_timer.getElapsedTimeF32() < COMPACT_REPORT_PERIOD)
+	{
+		return;
+	}
+	report_timer.reset();
+
+	// volumes are shared between objects, count each one once against the
+	// region of the first object found using it
+	std::set<LLVolume*> counted;
+	std::map<LLViewerRegion*, S64> region_savings;
+	S64 total_savings = 0;
+	for (S32 i = 0; i < gObjectList.getNumObjects(); ++i)
+	{
+		LLViewerObject* objectp = gObjectList.getObject(i);
+		if (!objectp || objectp->isDead() || objectp->getPCode() != LL_PCODE_VOLUME)
+		{
+			continue;
+		}
+
+		LLVolume* volume = objectp->getVolume();
+		if (!volume || !volume->isCompact() || !counted.insert(volume).second)
+		{
+			continue;
+		}
+
+		S64 savings = volume->getCompactSavings();
+		region_savings[objectp->getRegion()] += savings;
+		total_savings += savings;
+	}
+
+	for (std::map<LLViewerRegion*, S64>::iterator iter = region_savings.begin(); iter != region_savings.end(); ++iter)
+	{
+		LL_INFOS("CompactVolumes") << (iter->first ? iter->first->getName() : std::string("(no region)"))
+			<< ": " << (iter->second >> 10) << " KB saved by compact volume faces" << LL_ENDL;
+	}
+	sample(LLStatViewer::COMPACT_VOLUME_SAVINGS, F64Bytes((F64) total_savings));
+}
+
 U32 LLVOVolume::getTriangleCount(S32* vcount) const
 {
 	U32 count = 0;
@@ -4744,7 +5039,6 @@ void LLVOVolume::updateRiggedVolume(bool force_update)
 }
 
 static LLTrace::BlockTimerStatHandle FTM_SKIN_RIGGED("Skin");
-static LLTrace::BlockTimerStatHandle FTM_RIGGED_OCTREE("Octree");
 
 void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, const LLVolume* volume)
 {
@@ -4883,17 +5177,10 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 
 			}
 
-			{
-				LL_RECORD_BLOCK_TIME(FTM_RIGGED_OCTREE);
-				delete dst_face.mOctree;
-				dst_face.mOctree = NULL;
-
-				LLVector4a size;
-				size.setSub(dst_face.mExtents[1], dst_face.mExtents[0]);
-				size.splat(size.getLength3().getF32()*0.5f);
-			
-				dst_face.createOctree(1.f);
-			}
+			//skinned positions moved, ray casts rebuild the BVH on demand
+			delete dst_face.mOctree;
+			dst_face.mOctree = NULL;
+			dst_face.destroyBVH();
 		}
 	}
     mExtraDebugText = llformat("rigged %d/%d - box (%f %f %f) (%f %f %f)",
@@ -4985,6 +5272,136 @@ bool can_batch_texture(LLFace* facep)
 	return true;
 }
 
+// Matches up the faces going into one vertex buffer whose vertices come out
+// the same but for a rotation and translation: faces of static objects with
+// the same volume, face, scale and texture entry.  Only the first of them
+// gets its vertices copied, the others draw those through their instance
+// matrix.
+class LLFaceInstanceMatcher
+{
+public:
+	LLFaceInstanceMatcher(bool enabled) : mEnabled(enabled) {}
+
+	void clear() { mSources.clear(); }
+
+	// Points the instance source of facep at an earlier face with the same
+	// vertices.  Returns false if there is none and facep needs its own.
+	bool match(LLFace* facep);
+
+private:
+	static bool canInstance(LLFace* facep);
+
+	struct Key
+	{
+		const LLVolume* mVolume;
+		S32 mFace;
+		LLVector3 mScale;
+		U8 mTextureIndex;
+
+		bool operator<(const Key& rhs) const
+		{
+			if (mVolume != rhs.mVolume)
+			{
+				return mVolume < rhs.mVolume;
+			}
+			if (mFace != rhs.mFace)
+			{
+				return mFace < rhs.mFace;
+			}
+			if (mTextureIndex != rhs.mTextureIndex)
+			{
+				return mTextureIndex < rhs.mTextureIndex;
+			}
+			return std::lexicographical_compare(mScale.mV, mScale.mV + 3, rhs.mScale.mV, rhs.mScale.mV + 3);
+		}
+	};
+
+	typedef std::map<Key, std::vector<LLFace*> > source_map_t;
+	source_map_t mSources;
+	bool mEnabled;
+};
+
+// static
+bool LLFaceInstanceMatcher::canInstance(LLFace* facep)
+{
+	LLDrawable* drawablep = facep->getDrawable();
+	LLVOVolume* vobj = drawablep->getVOVolume();
+	const LLTextureEntry* te = facep->getTextureEntry();
+
+	// Active and animated objects draw in a frame of their own, flexis have a
+	// volume of their own, and legacy bump offsets, planar mapping and baked
+	// texture animation depend on more than the volume and texture entry.
+	return vobj && te
+		&& drawablep->isStatic()
+		&& !drawablep->isState(LLDrawable::ANIMATED_CHILD | LLDrawable::RIGGED)
+		&& !facep->isState(LLFace::RIGGED | LLFace::TEXTURE_ANIM)
+		&& !vobj->isVolumeGlobal()
+		&& !vobj->mTextureAnimp
+		&& !vobj->getVolume()->isUnique()
+		&& !te->getBumpmap()
+		&& te->getTexGen() == LLTextureEntry::TEX_GEN_DEFAULT;
+}
+
+bool LLFaceInstanceMatcher::match(LLFace* facep)
+{
+	facep->mInstanceSource = NULL;
+
+	if (!mEnabled || !canInstance(facep))
+	{
+		return false;
+	}
+
+	LLVOVolume* vobj = facep->getDrawable()->getVOVolume();
+
+	Key key;
+	key.mVolume = vobj->getVolume();
+	key.mFace = facep->getTEOffset();
+	key.mScale = vobj->getScale();
+	key.mTextureIndex = facep->getTextureIndex();
+
+	std::vector<LLFace*>& sources = mSources[key];
+	const LLTextureEntry* te = facep->getTextureEntry();
+	for (U32 i = 0; i < sources.size(); ++i)
+	{
+		LLFace* sourcep = sources[i];
+		if (*sourcep->getTextureEntry() == *te
+			&& sourcep->getPoolType() == facep->getPoolType()
+			&& sourcep->getGeomCount() == facep->getGeomCount()
+			&& sourcep->getIndicesCount() == facep->getIndicesCount())
+		{
+			facep->mInstanceSource = sourcep;
+			return true;
+		}
+	}
+
+	sources.push_back(facep);
+	return false;
+}
+
+// getRelativeXform() of a static volume without the scale
+static LLMatrix4 get_rigid_relative_xform(const LLVOVolume* vobj)
+{
+	LLMatrix4 mat = vobj->getRelativeXform();
+	for (U32 i = 0; i < 3; ++i)
+	{
+		LLVector3 axis(mat.mMatrix[i]);
+		axis.normalize();
+		mat.mMatrix[i][VX] = axis.mV[VX];
+		mat.mMatrix[i][VY] = axis.mV[VY];
+		mat.mMatrix[i][VZ] = axis.mV[VZ];
+	}
+	return mat;
+}
+
+// Transform from the region space vertices of sourcep to those of facep.
+// Both have the same scale, which leaves a rotation and a translation.
+static void calc_instance_matrix(const LLFace* sourcep, LLFace* facep)
+{
+	facep->mInstanceMatrix = get_rigid_relative_xform(sourcep->getDrawable()->getVOVolume());
+	facep->mInstanceMatrix.invert();
+	facep->mInstanceMatrix *= get_rigid_relative_xform(facep->getDrawable()->getVOVolume());
+}
+
 const static U32 MAX_FACE_COUNT = 4096U;
 int32_t LLVolumeGeometryManager::sInstanceCount = 0;
 LLFace** LLVolumeGeometryManager::sFullbrightFaces = NULL;
@@ -5109,6 +5526,8 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 		model_mat = &(drawable->getRegion()->mRenderMatrix);
 	}
 
+	const LLMatrix4* instance_mat = facep->getInstanceMatrix();
+
 	//drawable->getVObj()->setDebugText(llformat("%d", drawable->isState(LLDrawable::ANIMATED_CHILD)));
 
 	U8 bump = (type == LLRenderPass::PASS_BUMP || type == LLRenderPass::PASS_POST_BUMP) ? facep->getTextureEntry()->getBumpmap() : 0;
@@ -5177,6 +5596,7 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 		(!mat || (draw_vec[idx]->mShiny == shiny)) && // need to break batches when a material is shared, but legacy settings are different
 		draw_vec[idx]->mTextureMatrix == tex_mat &&
 		draw_vec[idx]->mModelMatrix == model_mat &&
+		draw_vec[idx]->mInstanceMatrix == instance_mat &&
 		draw_vec[idx]->mShaderMask == shader_mask &&
 		draw_vec[idx]->mSelected == selected)
 	{
@@ -5206,6 +5626,7 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 		draw_vec.push_back(draw_info);
 		draw_info->mTextureMatrix = tex_mat;
 		draw_info->mModelMatrix = model_mat;
+		draw_info->mInstanceMatrix = instance_mat;
 		
 		draw_info->mBump  = bump;
 		draw_info->mShiny = shiny;
@@ -5411,6 +5832,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 	}
 
 	LL_RECORD_BLOCK_TIME(FTM_REBUILD_VOLUME_VB);
+	LLTimer rebuild_timer;
 
 	group->mBuilt = 1.f;
 	
@@ -6017,6 +6439,8 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 	}
 
 	mFaceList.clear();
+
+	record(LLStatViewer::VOLUME_REBUILD_TIME, F64Seconds(rebuild_timer.getElapsedTimeF64()));
 }
 
 static LLTrace::BlockTimerStatHandle FTM_REBUILD_MESH_FLUSH("Flush Mesh");
@@ -6074,6 +6498,13 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
 						{
 							llassert(!face->isState(LLFace::RIGGED));
 
+							if (face->isState(LLFace::INSTANCE | LLFace::INSTANCE_SOURCE))
+							{ //other faces draw these vertices too, match them up again
+								group->dirtyGeom();
+								gPipeline.markRebuild(group, TRUE);
+								continue;
+							}
+
 							if (!face->getGeometryVolume(*volume, face->getTEOffset(), 
 								vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), face->getGeomIndex()))
 							{ //something's gone wrong with the vertex buffer accounting, rebuild this group 
@@ -6267,6 +6698,12 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 	//NEVER use more than 16 texture index channels (workaround for prevalent driver bug)
 	texture_index_channels = llmin(texture_index_channels, 16);
 
+	//faces sorted by distance are drawn one by one, and delayed updates write
+	//each face's vertices later on its own
+	static LLCachedControl<bool> use_instancing(gSavedSettings, "RenderVolumeInstancing", false);
+	LLFaceInstanceMatcher instancer(use_instancing && !distance_sort && !LLPipeline::sDelayVBUpdate);
+	U32 vertex_size = LLVertexBuffer::calcVertexSize(mask);
+
 	bool flexi = false;
 
 	while (face_iter != end_faces)
@@ -6296,6 +6733,9 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 		U32 index_count = facep->getIndicesCount();
 		U32 geom_count = facep->getGeomCount();
 
+		//instances only share vertices within one buffer
+		instancer.clear();
+
 		flexi = flexi || facep->getViewerObject()->getVolume()->isUnique();
 
 		//sum up vertices needed for this render batch
@@ -6313,6 +6753,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			{
 				U8 cur_tex = 0;
 				facep->setTextureIndex(cur_tex);
+				instancer.match(facep);
 				if (texture_count < MAX_TEXTURE_COUNT)
 				{
 					texture_list[texture_count++] = tex;
@@ -6370,7 +6811,10 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 							}
 						}
 
-						if (geom_count + facep->getGeomCount() > max_vertices)
+						facep->setTextureIndex(cur_tex);
+						bool instance = instancer.match(facep);
+
+						if (!instance && geom_count + facep->getGeomCount() > max_vertices)
 						{ //cut batches on geom count too big
 							break;
 						}
@@ -6379,10 +6823,11 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 
 						flexi = flexi || facep->getViewerObject()->getVolume()->isUnique();
 
-						index_count += facep->getIndicesCount();
-						geom_count += facep->getGeomCount();
-
-						facep->setTextureIndex(cur_tex);
+						if (!instance)
+						{
+							index_count += facep->getIndicesCount();
+							geom_count += facep->getGeomCount();
+						}
 					}
 				}
 				else
@@ -6394,6 +6839,8 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			}
 			else
 			{
+				instancer.match(facep);
+
 				while (i != end_faces && 
 					(LLPipeline::sTextureBindTest || 
 						(distance_sort || 
@@ -6406,15 +6853,19 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 					//face has no texture index
 					facep->mDrawInfo = NULL;
 					facep->setTextureIndex(FACE_DO_NOT_BATCH_TEXTURES);
+					bool instance = instancer.match(facep);
 
-					if (geom_count + facep->getGeomCount() > max_vertices)
+					if (!instance && geom_count + facep->getGeomCount() > max_vertices)
 					{ //cut batches on geom count too big
 						break;
 					}
 
 					++i;
-					index_count += facep->getIndicesCount();
-					geom_count += facep->getGeomCount();
+					if (!instance)
+					{
+						index_count += facep->getIndicesCount();
+						geom_count += facep->getGeomCount();
+					}
 
 					flexi = flexi || facep->getViewerObject()->getVolume()->isUnique();
 				}
@@ -6457,6 +6908,9 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 		{
 			//update face indices for new buffer
 			facep = *face_iter;
+			LLFace* sourcep = facep->mInstanceSource;
+			facep->mInstanceSource = NULL;
+			facep->clearState(LLFace::INSTANCE | LLFace::INSTANCE_SOURCE);
 			if (buffer.isNull())
 			{
 				// Bulk allocation failed
@@ -6465,16 +6919,32 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 				++face_iter;
 				continue;
 			}
-			facep->setIndicesIndex(indices_index);
-			facep->setGeomIndex(index_offset);
-			facep->setVertexBuffer(buffer);	
 			
 			if (batch_textures && facep->getTextureIndex() == FACE_DO_NOT_BATCH_TEXTURES)
 			{
 				LL_ERRS() << "Invalid texture index." << LL_ENDL;
 			}
 			
+			if (sourcep)
+			{ //draw the vertices of an identical face, nothing to copy
+				facep->setIndicesIndex(sourcep->getIndicesStart());
+				facep->setGeomIndex(sourcep->getGeomIndex());
+				facep->setVertexBuffer(buffer);
+				facep->updateRebuildFlags();
+
+				calc_instance_matrix(sourcep, facep);
+				facep->setState(LLFace::INSTANCE);
+				sourcep->setState(LLFace::INSTANCE_SOURCE);
+
+				add(LLStatViewer::VOLUME_INSTANCED_FACES, 1);
+				add(LLStatViewer::VOLUME_INSTANCE_DATA_SAVED, F64Bytes(facep->getGeomCount() * vertex_size + facep->getIndicesCount() * sizeof(U16)));
+			}
+			else
 			{
+				facep->setIndicesIndex(indices_index);
+				facep->setGeomIndex(index_offset);
+				facep->setVertexBuffer(buffer);	
+
 				//for debugging, set last time face was updated vs moved
 				facep->updateRebuildFlags();
 
@@ -6504,10 +6974,10 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 						vobj->updateRelativeXform(false);
 					}
 				}
-			}
 
-			index_offset += facep->getGeomCount();
-			indices_index += facep->getIndicesCount();
+				index_offset += facep->getGeomCount();
+				indices_index += facep->getIndicesCount();
+			}
 
 			//append face to appropriate render batch
 
@@ -46,6 +46,8 @@ class LLObjectMediaDataClient;
 class LLObjectMediaNavigateClient;
 class LLVOAvatar;
 class LLMeshSkinInfo;
+class LLSpatialGroup;
+class LLCamera;
 
 typedef std::vector<viewer_media_t> media_list_t;
 
@@ -227,6 +229,9 @@ public:
 	/*virtual*/ BOOL	updateGeometry(LLDrawable *drawable);
 	/*virtual*/ void	updateFaceSize(S32 idx);
 	/*virtual*/ BOOL	updateLOD();
+	// Distance and LOD of the static volumes of a spatial group, four at a
+	// time, in place of one LLDrawable::updateDistance() call each
+	static		void	updateLODBatch(LLSpatialGroup* group, LLCamera& camera);
 				void	updateRadius();
 	/*virtual*/ void	updateTextures();
 				void	updateTextureVirtualSize(bool forced = false);
@@ -377,6 +382,9 @@ public:
 protected:
 	S32	computeLODDetail(F32 distance, F32 radius, F32 lod_factor);
 	BOOL calcLOD();
+	BOOL setLODDetail(S32 cur_detail);
+	BOOL finishLODUpdate(BOOL lod_changed);
+	static void updateLODQuad(LLVOVolume* const* volumes, U32 count, LLCamera& camera);
 	LLFace* addFace(S32 face_index);
 	void updateTEData();
 
@@ -396,6 +404,7 @@ public:
 
 	static S32 getRenderComplexityMax() {return mRenderComplexity_last;}
 	static void updateRenderComplexity();
+	static void updateCompactVolumes();
 
 	LLViewerTextureAnim *mTextureAnimp;
 	U8 mTexAnimMode;
@@ -410,6 +419,7 @@ private:
 	LLFrameTimer mTextureUpdateTimer;
 	S32			mLOD;
 	BOOL		mLODChanged;
+	BOOL		mLODPending;	// mLOD is being built on a volume generation thread
 	BOOL		mSculptChanged;
 	F32			mSpotLightPriority;
 	LLMatrix4	mRelativeXform;
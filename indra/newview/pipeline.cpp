@@ -3472,6 +3472,11 @@ void LLPipeline::stateSort(LLSpatialGroup* group, LLCamera& camera)
 {
 	if (group->changeLOD())
 	{
+		if (LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD)
+		{ //distances and LODs of the static volumes in one pass
+			LLVOVolume::updateLODBatch(group, camera);
+		}
+
 		for (LLSpatialGroup::element_iter i = group->getDataBegin(); i != group->getDataEnd(); ++i)
 		{
             LLDrawable* drawablep = (LLDrawable*)(*i)->getDrawable();            
@@ -3550,7 +3555,11 @@ void LLPipeline::stateSort(LLDrawable* drawablep, LLCamera& camera)
 	{
 		//if (drawablep->isVisible()) isVisible() check here is redundant, if it wasn't visible, it wouldn't be here
 		{
-			if (!drawablep->isActive())
+			if (drawablep->isState(LLDrawable::LOD_UPDATED))
+			{ //LLVOVolume::updateLODBatch() did it for the whole spatial group
+				drawablep->clearState(LLDrawable::LOD_UPDATED);
+			}
+			else if (!drawablep->isActive())
 			{
 				bool force_update = false;
 				drawablep->updateDistance(camera, force_update);